@@ -0,0 +1,117 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Asynchronous output: wraps another Tangle2OutputBackend so that the
+// event loop only copies each selected event into a lock-free single
+// producer, single consumer ring.  One writer thread, shared by all
+// the Tangle2AsyncOutputs open in the process, drains the rings in
+// batches and does all serialisation and compression through the
+// wrapped backends.
+//
+// A worker only waits when its ring is full (back-pressure), so memory
+// stays bounded at capacity records per thread.  Close waits for the
+// writer to drain the ring and close the wrapped backend.
+//
+// Only for backends that may be written from another thread: hdf5 and
+// rntuple, not g4root (G4AnalysisManager is per thread).  GetSeconds()
+// is then the time the event loop spent in output; GetStatistics()
+// gives the ring occupancy, stalls and writer lag for tuning the
+// capacity.
+
+#ifndef Tangle2AsyncOutput_hh
+#define Tangle2AsyncOutput_hh 1
+
+#include "Tangle2OutputBackend.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+class Tangle2AsyncOutput : public Tangle2OutputBackend
+{
+public:
+  // Takes ownership of output.  capacity is rounded up to a power of 2.
+  explicit Tangle2AsyncOutput(Tangle2OutputBackend* output,
+			      std::size_t capacity = kDefaultCapacity);
+  virtual ~Tangle2AsyncOutput();
+
+  virtual const char* GetName() const { return fpOutput->GetName(); }
+
+  static const std::size_t kDefaultCapacity = 4096;
+  // Records written per pass of the writer thread, per ring
+  static const std::size_t kBatchSize = 512;
+
+  // Complete after Close
+  struct Statistics
+  {
+    std::size_t capacity;
+    std::size_t maxOccupancy;    // records waiting, at most
+    double      meanOccupancy;   // seen by the worker after each push
+    long        nStalls;         // pushes that found the ring full
+    double      stallSeconds;    // worker time waiting for space
+    double      meanLagSeconds;  // push to write by the writer thread
+    double      maxLagSeconds;
+    long        nBatches;        // passes that wrote something
+    double      writerSeconds;   // wrapped backend, on the writer thread
+  };
+  const Statistics& GetStatistics() const { return fStatistics; }
+
+protected:
+  virtual std::string DoOpen(const std::string& fileName);
+  virtual void DoWrite(const Tangle2EventRecord&);
+  virtual void DoClose();
+
+private:
+  friend class Tangle2AsyncWriter;
+
+  typedef std::chrono::steady_clock Clock;
+
+  struct Slot
+  {
+    Tangle2EventRecord record;
+    Clock::time_point  pushed;
+  };
+
+  // Writer thread: writes up to kBatchSize records, returns how many
+  std::size_t Drain();
+
+  Tangle2OutputBackend* fpOutput;
+
+  std::vector<Slot> fSlots;
+  std::size_t fMask;
+
+  // Producer and consumer positions, on separate cache lines
+  char fPad0[64];
+  std::atomic<std::size_t> fHead;  // next to push
+  char fPad1[64];
+  std::atomic<std::size_t> fTail;  // next to write
+  char fPad2[64];
+
+  std::atomic<bool> fClosing;  // set by the worker
+  std::atomic<bool> fClosed;   // set by the writer thread
+
+  // Worker side
+  double fOccupancySum;
+  long   fNPushes;
+
+  // Writer side
+  double fLagSum;
+  long   fNWritten;
+
+  Statistics fStatistics;
+};
+
+#endif
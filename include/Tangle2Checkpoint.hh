@@ -0,0 +1,125 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Checkpoints during long runs, set with /tangle2/checkpoint/ (see
+// Tangle2CheckpointMessenger):
+//
+// Every N events (over all threads) or T minutes a new checkpoint is
+// started.  Each thread, at the start of its next event, closes its
+// hdf5/rntuple output and opens <name>_t<thread>_c<checkpoint>, saves
+// its engine status to <name>_t<thread>.rndm and its /tangle2/hist/
+// histograms so far to <name>_t<thread>_c<checkpoint>.hist, and adds
+// its totals to <name>_checkpoint.txt: the merged counters and the
+// list of closed files and histogram files, so every event counted
+// there is in a complete file and in the histograms.
+//
+// /tangle2/checkpoint/resume continues a run from that file: the
+// remaining events of the original /run/beamOn, the counters carried
+// on, and fresh seeds derived from the master engine status at the
+// start of the previous run (<name>_master.rndm) and the number of
+// resumes.  (In multi-threaded mode the workers are reseeded by the
+// master for each event, so the master engine is what matters; the
+// worker files record where each worker was.)  The histograms of the
+// runs before are added to those of the resumed run at its end.
+//
+// g4root writes its files only at the end of the run, so a checkpoint
+// could not tell which events are in a file: with g4root output there
+// are no checkpoints and no resume.
+
+#ifndef Tangle2Checkpoint_hh
+#define Tangle2Checkpoint_hh 1
+
+#include "globals.hh"
+
+#include <atomic>
+#include <vector>
+
+// The merged state, as written at each checkpoint
+struct Tangle2CheckpointState
+{
+  Tangle2CheckpointState();
+  
+  G4bool Write(const G4String& fileName) const;
+  G4bool Read(const G4String& fileName);
+  
+  // Counters, or those of one thread
+  struct Counts {
+    Counts();
+    void Add(const Counts&);
+    G4long nEvents;
+    G4long nEventsPh;
+    G4long nEventsRejected;
+    G4long nEventsRejectedPh;
+    G4long nDirectionTrials;
+    G4long nRows;
+  };
+  
+  G4int    checkpoint;   // number of the last one
+  G4int    resumes;
+  G4bool   complete;     // the run finished
+  G4long   runEvents;    // asked for by the original /run/beamOn
+  Counts   counts;
+  std::vector<G4String> files;       // closed output files
+  std::vector<G4String> histograms;  // Tangle2Histogram::WriteContents
+};
+
+class Tangle2Checkpoint
+{
+public:
+  Tangle2Checkpoint();
+  
+  // False if the output can not be checkpointed (g4root)
+  static G4bool IsPossible();
+  
+  // Master, start of run; resume is null unless resuming
+  void BeginOfRun(G4long nEventsToBeProcessed,
+		  const Tangle2CheckpointState* resume);
+  G4bool IsEnabled() const { return fEnabled; }
+  // The checkpoint number at the start of the run
+  G4int GetFirst() const { return fFirst; }
+  
+  // Any thread, at the start of each event: the current checkpoint
+  // number, which the thread compares with the last one it did
+  G4int Count();
+  
+  // Any thread, with the run action lock held: this thread's totals so
+  // far, the file it has just closed, if any, and its histograms so far,
+  // if any (replacing its previous ones); rewrites the file
+  void Record(G4int threadID, const Tangle2CheckpointState::Counts&,
+	      const G4String& closedFile, const G4String& histogramFile);
+  
+  // Master, end of run, after the workers' last Record
+  void EndOfRun();
+  
+  // Master, for /tangle2/checkpoint/resume
+  static G4String StateFileName();
+  static G4String MasterEngineFileName();
+  
+private:
+  G4bool   fEnabled;
+  G4int    fFirst;
+  G4long   fEveryEvents;
+  G4double fEveryMinutes;
+  std::atomic<G4long> fNEvents;
+  std::atomic<G4int>  fCheckpoint;
+  std::atomic<G4long> fLastMillis;  // time of the last checkpoint
+  
+  Tangle2CheckpointState fBase;     // previous runs, when resuming
+  Tangle2CheckpointState fState;    // as written
+  std::vector<Tangle2CheckpointState::Counts> fThreadCounts;
+  std::vector<G4String> fThreadHistograms;
+};
+
+#endif
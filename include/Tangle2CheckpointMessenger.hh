@@ -0,0 +1,60 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// /tangle2/checkpoint/events <N>     every N events, 0 off (default)
+// /tangle2/checkpoint/minutes <T>    every T minutes, 0 off (default)
+// /tangle2/checkpoint/resume         continue an interrupted run
+//
+// e.g. for a batch queue with a time limit, first job:
+//
+//   /tangle2/checkpoint/minutes 30
+//   /run/beamOn 2000000000
+//
+// and the jobs after it (same configuration, after /run/initialize):
+//
+//   /tangle2/checkpoint/minutes 30
+//   /tangle2/checkpoint/resume
+//
+// See Tangle2Checkpoint.
+
+#ifndef Tangle2CheckpointMessenger_hh
+#define Tangle2CheckpointMessenger_hh 1
+
+#include "G4UImessenger.hh"
+
+class G4UIdirectory;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithADouble;
+class G4UIcmdWithoutParameter;
+
+class Tangle2CheckpointMessenger : public G4UImessenger
+{
+public:
+  Tangle2CheckpointMessenger();
+  virtual ~Tangle2CheckpointMessenger();
+
+  virtual void SetNewValue(G4UIcommand*, G4String);
+  virtual G4String GetCurrentValue(G4UIcommand*);
+
+private:
+  void Resume();
+  
+  G4UIdirectory*           fpDirectory;
+  G4UIcmdWithAnInteger*    fpEventsCmd;
+  G4UIcmdWithADouble*      fpMinutesCmd;
+  G4UIcmdWithoutParameter* fpResumeCmd;
+};
+
+#endif
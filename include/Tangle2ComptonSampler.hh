@@ -0,0 +1,122 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Polarised Klein-Nishina Compton scattering on a free electron, shared
+// by Tangle2CrystalFastModel and the standalone engine.  The energy
+// fraction is sampled as G4KleinNishinaCompton, the azimuth with
+// respect to the polarisation as G4LivermorePolarizedComptonModel, and
+// the new polarisation, parallel or perpendicular, after Dan Xu, IEEE
+// TNS 52 (2005) 1160.
+//
+// Plain numbers and no Geant4, like Tangle2DirectionSampler.  Energies
+// in MeV.  The caller supplies the uniform random numbers as a functor
+// returning one in [0,1) per call - the rejection loops take a varying
+// number of them.
+
+#ifndef Tangle2ComptonSampler_hh
+#define Tangle2ComptonSampler_hh 1
+
+#include <cmath>
+
+namespace Tangle2ComptonSampler {
+
+  const double kElectronMass = 0.51099895;  // MeV
+  const double kPi           = 3.14159265358979323846;
+
+  // Updates energy, direction and polarisation (unit vectors)
+  template <class Uniform>
+  void Sample(double& energy, double direction[3], double polarisation[3],
+	      Uniform uniform);
+
+  // The part of polarisation perpendicular to direction, normalised;
+  // false if there is none
+  bool PerpendicularPolarisation(const double direction[3],
+				 const double polarisation[3],
+				 double pol0[3]);
+
+  // A unit vector perpendicular to direction, at azimuth phi0
+  void RandomPolarisation(const double direction[3], double phi0,
+			  double pol0[3]);
+
+  // From the frame x = pol0, z = direction back to the lab
+  void Scatter(double cosTheta, double sinTheta,
+	       double cosPhi, double sinPhi, double cosBeta, double sinBeta,
+	       const double pol0[3],
+	       double direction[3], double polarisation[3]);
+}
+
+template <class Uniform>
+void Tangle2ComptonSampler::Sample(double& energy,
+				   double direction[3],
+				   double polarisation[3],
+				   Uniform uniform)
+{
+  // Polarisation must be perpendicular to the direction;
+  // pick one at random if there is none
+  double pol0[3];
+  if (!PerpendicularPolarisation(direction, polarisation, pol0))
+    RandomPolarisation(direction, 2.*kPi*uniform(), pol0);
+  
+  // Scattered energy fraction epsilon
+  const double E0_m       = energy/kElectronMass;
+  const double eps0       = 1./(1. + 2.*E0_m);
+  const double epsilon0sq = eps0*eps0;
+  const double alpha1     = -std::log(eps0);
+  const double alpha2     = alpha1 + 0.5*(1. - epsilon0sq);
+  
+  double epsilon, epsilonsq, onecost, sint2, greject;
+  do {
+    if (alpha1 > alpha2*uniform()) {
+      epsilon   = std::exp(-alpha1*uniform());
+      epsilonsq = epsilon*epsilon;
+    } else {
+      epsilonsq = epsilon0sq + (1. - epsilon0sq)*uniform();
+      epsilon   = std::sqrt(epsilonsq);
+    }
+    onecost = (1. - epsilon)/(epsilon*E0_m);
+    sint2   = onecost*(2. - onecost);
+    greject = 1. - epsilon*sint2/(1. + epsilonsq);
+  } while (greject < uniform());
+  
+  if (sint2 < 0.) sint2 = 0.;
+  const double cosTheta = 1. - onecost;
+  const double sinTheta = std::sqrt(sint2);
+  
+  // Azimuth with respect to the polarisation
+  const double a = 2.*sint2;
+  const double b = epsilon + 1./epsilon;
+  double phi, cosPhi;
+  do {
+    phi    = 2.*kPi*uniform();
+    cosPhi = std::cos(phi);
+  } while (uniform() > 1. - (a/b)*cosPhi*cosPhi);
+  const double sinPhi = std::sin(phi);
+  
+  // New polarisation, perpendicular or parallel
+  const double cosSqrPhi = cosPhi*cosPhi;
+  double beta;
+  if (uniform() < (b - 2.)/(2.*b - 4.*sint2*cosSqrPhi))
+    beta = (uniform() < 0.5) ? 0.5*kPi : 1.5*kPi;
+  else
+    beta = (uniform() < 0.5) ? 0. : kPi;
+  const double cosBeta = std::cos(beta);
+  const double sinBeta = std::sqrt(1. - cosBeta*cosBeta);
+  
+  Scatter(cosTheta, sinTheta, cosPhi, sinPhi, cosBeta, sinBeta, pol0,
+	  direction, polarisation);
+  energy *= epsilon;
+}
+
+#endif
@@ -0,0 +1,88 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Run configuration: beam, detector, physics and output choices that
+// used to be edited into tangle2.cc.  Set in PreInit with
+// /tangle2/config/ (see Tangle2ConfigMessenger), frozen at
+// /run/initialize, then read by all threads as Tangle2::config.
+
+#ifndef Tangle2Config_hh
+#define Tangle2Config_hh 1
+
+#include "globals.hh"
+
+class Tangle2Config
+{
+public:
+  Tangle2Config();  // the defaults
+
+  // Beam
+  G4bool positrons;         // else back to back gammas
+  G4bool fixedAxis;         // gammas along a fixed axis
+  G4bool perpPol;           // perpendicular polarisation
+  G4bool polYZ;             // polarisation in y,z (implies perpPol)
+  // True: back to back gamma axes that would miss either crystal
+  // array are redrawn, and events get the array acceptance as weight
+  // (ntuple column "weight"). See Tangle2DirectionSampler.
+  G4bool acceptanceSampling;
+
+  // Physics
+  G4bool polarisedCompton;  // G4EmLivermorePolarizedPhysics
+
+  // Detector
+  // True: arrays 90 cm apart (45 cm from source)
+  // False: arrays 6 cm apart (3 cm from source)
+  G4bool fullPET;
+
+  // Performance
+  // True: abort the event as soon as the first gamma out has
+  // finished without a Compton scatter, since it can then never
+  // pass the selection. Ignored, with a warning, for a selection
+  // that does not need the scatters (Tangle2Selection::NeedsScatter).
+  // Rejected events are counted apart, and those already QET when
+  // aborted apart from the QET events tracked to the end.
+  G4bool fastReject;
+
+  // Output
+  // Format of the selected-event output: Tangle2::kOutputG4Root
+  // (Tangle2.root), kOutputHdf5 or kOutputRNTuple (one file per
+  // thread, when built WITH_TANGLE2_HDF5/WITH_TANGLE2_RNTUPLE, else
+  // g4root is used)
+  G4int  outputFormat;
+  // True: hdf5 and rntuple are written by a separate thread, so the
+  // event loop only waits when the writer falls behind (g4root is
+  // always written by the worker itself). See Tangle2AsyncOutput.
+  G4bool asyncOutput;
+
+  void Print() const;
+
+  // Set a field by its /tangle2/config/ name, e.g. ("perpPol", "true");
+  // false if the name or value is not known
+  G4bool Set(const G4String& name, const G4String& value);
+
+  // The shared instance, for the master in PreInit only
+  static Tangle2Config& Modify();
+  // At /run/initialize (Tangle2DetectorConstruction::Construct)
+  static void Freeze();
+  static G4bool IsFrozen();
+
+  // Master only, between runs (the workers wait for the next run, see
+  // Tangle2Sweep).  Beam, output and fastReject can change; fullPET
+  // too, when the caller then reinitialises the geometry; the physics
+  // (polarisedCompton) can not, false is returned.
+  static G4bool Reconfigure(const Tangle2Config&, G4bool& geometryChanged);
+};
+
+#endif
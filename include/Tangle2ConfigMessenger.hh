@@ -0,0 +1,72 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// /tangle2/config/ sets Tangle2Config, in PreInit only (before
+// /run/initialize), so one binary serves every setup:
+//
+//   /tangle2/config/positrons true|false     else back to back gammas
+//   /tangle2/config/fixedAxis true|false
+//   /tangle2/config/perpPol true|false
+//   /tangle2/config/polYZ true|false
+//   /tangle2/config/acceptanceSampling true|false
+//   /tangle2/config/polarisedCompton true|false
+//   /tangle2/config/fullPET true|false
+//   /tangle2/config/fastReject true|false
+//   /tangle2/config/output g4root|hdf5|rntuple
+//   /tangle2/config/asyncOutput true|false
+//   /tangle2/config/print
+//
+// polarisedCompton swaps the EM physics of the physics list given.
+
+#ifndef Tangle2ConfigMessenger_hh
+#define Tangle2ConfigMessenger_hh 1
+
+#include "G4UImessenger.hh"
+#include "Tangle2Config.hh"
+
+#include <vector>
+
+class G4UIdirectory;
+class G4UIcmdWithABool;
+class G4UIcmdWithAString;
+class G4UIcmdWithoutParameter;
+class G4VModularPhysicsList;
+
+class Tangle2ConfigMessenger : public G4UImessenger
+{
+public:
+  Tangle2ConfigMessenger(G4VModularPhysicsList*);
+  virtual ~Tangle2ConfigMessenger();
+
+  virtual void SetNewValue(G4UIcommand*, G4String);
+  virtual G4String GetCurrentValue(G4UIcommand*);
+
+  // Replace the EM physics according to polarisedCompton
+  void SetEmPhysics();
+
+private:
+  void AddBool(const char* name, G4bool Tangle2Config::* flag,
+	       const char* guidance);
+
+  G4VModularPhysicsList*          fpPhysList;
+  G4UIdirectory*                  fpDirectory;
+  std::vector<G4UIcmdWithABool*>  fBoolCmds;
+  std::vector<G4bool Tangle2Config::*> fBoolFlags;
+  G4UIcmdWithABool*               fpPolarisedComptonCmd;
+  G4UIcmdWithAString*             fpOutputCmd;
+  G4UIcmdWithoutParameter*        fpPrintCmd;
+};
+
+#endif
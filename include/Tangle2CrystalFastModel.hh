@@ -0,0 +1,75 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Parameterised transport of photons through one LYSO crystal.
+//
+// The envelope is the "CrystalArrays" region, whose root logical volume
+// is CrystalLV, so the model is triggered each time a gamma enters a
+// crystal.  Inside the crystal it samples, directly:
+//   - photoabsorption: all energy deposited, photon killed
+//   - Compton scattering: Klein-Nishina on free electrons with linear
+//     polarisation (Tangle2ComptonSampler, as the standalone engine:
+//     G4LivermorePolarizedComptonModel without the scattering function
+//     or Doppler broadening); the electron energy is deposited on the spot
+//   - escape: the photon is moved to the crystal surface and handed
+//     back to Geant4, so it may enter a neighbouring crystal
+// Attenuation coefficients for "compt" and "phot" are tabulated from
+// the physics list with G4EmCalculator on first use.  Rayleigh
+// scattering, fluorescence and the entanglement correlations of the
+// modified Livermore model are not simulated.
+//
+// Interactions are reported to Tangle2SteppingAction exactly as for
+// full simulation, and the deposit goes to Tangle2CrystalSD through
+// the fast step, so all output quantities are filled as before.
+//
+// Selected with /tangle2/fastSim/mode (see Tangle2FastSimMessenger).
+
+#ifndef Tangle2CrystalFastModel_hh
+#define Tangle2CrystalFastModel_hh 1
+
+#include "G4VFastSimulationModel.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+
+class G4Material;
+class Tangle2SteppingAction;
+
+class Tangle2CrystalFastModel : public G4VFastSimulationModel
+{
+public:
+  Tangle2CrystalFastModel(const G4String& name, G4Region* envelope);
+  virtual ~Tangle2CrystalFastModel();
+
+  virtual G4bool IsApplicable(const G4ParticleDefinition&);
+  virtual G4bool ModelTrigger(const G4FastTrack&);
+  virtual void   DoIt(const G4FastTrack&, G4FastStep&);
+
+private:
+  void BuildTables(const G4Material*);
+  void GetMu(G4double energy, G4double& muCompt, G4double& muPhot) const;
+
+  const G4Material* fpTableMaterial;
+  G4double fLogEMin, fLogEMax, fDLogE;
+  std::vector<G4double> fMuCompt;
+  std::vector<G4double> fMuPhot;
+
+  // Photons below this are absorbed where they are
+  G4double fEnergyCut;
+
+  Tangle2SteppingAction* fpSteppingAction;
+};
+
+#endif
@@ -0,0 +1,61 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Energy deposited in one LYSO crystal in one event.  Tangle2CrystalSD
+// creates one hit per crystal at the start of each event and the hit
+// index is the crystal copy number.
+
+#ifndef Tangle2CrystalHit_hh
+#define Tangle2CrystalHit_hh 1
+
+#include "G4VHit.hh"
+#include "G4THitsCollection.hh"
+#include "G4Allocator.hh"
+#include "globals.hh"
+
+class Tangle2CrystalHit : public G4VHit
+{
+public:
+  Tangle2CrystalHit();
+  virtual ~Tangle2CrystalHit();
+
+  inline void* operator new(size_t);
+  inline void  operator delete(void*);
+
+  void AddEdep(G4double de) { fEdep += de; }
+
+  G4double GetEdep() const { return fEdep; }
+
+private:
+  G4double fEdep;
+};
+
+typedef G4THitsCollection<Tangle2CrystalHit> Tangle2CrystalHitsCollection;
+
+extern G4ThreadLocal G4Allocator<Tangle2CrystalHit>* Tangle2CrystalHitAllocator;
+
+inline void* Tangle2CrystalHit::operator new(size_t)
+{
+  if(!Tangle2CrystalHitAllocator)
+    Tangle2CrystalHitAllocator = new G4Allocator<Tangle2CrystalHit>;
+  return (void*) Tangle2CrystalHitAllocator->MallocSingle();
+}
+
+inline void Tangle2CrystalHit::operator delete(void* hit)
+{
+  Tangle2CrystalHitAllocator->FreeSingle((Tangle2CrystalHit*) hit);
+}
+
+#endif
@@ -0,0 +1,46 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Sensitive detector attached to CrystalLV only, so that steps in the
+// World (or anywhere else) cost nothing in user code.  Energy is
+// accumulated in one Tangle2CrystalHit per crystal, indexed by the copy
+// number of the pre-step volume, and read by Tangle2EventAction.
+
+#ifndef Tangle2CrystalSD_hh
+#define Tangle2CrystalSD_hh 1
+
+#include "G4VSensitiveDetector.hh"
+#include "Tangle2CrystalHit.hh"
+
+class G4Step;
+class G4HCofThisEvent;
+
+class Tangle2CrystalSD : public G4VSensitiveDetector
+{
+public:
+  Tangle2CrystalSD(const G4String& name,
+		   const G4String& hitsCollectionName,
+		   G4int nCrystals);
+  virtual ~Tangle2CrystalSD();
+  
+  virtual void   Initialize(G4HCofThisEvent*);
+  virtual G4bool ProcessHits(G4Step*, G4TouchableHistory*);
+
+private:
+  Tangle2CrystalHitsCollection* fHitsCollection;
+  G4int fNCrystals;
+};
+
+#endif
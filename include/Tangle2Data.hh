@@ -9,25 +9,82 @@
 
 #include "g4root.hh"
 #include "G4ThreeVector.hh"
+#include "Tangle2Histogram.hh"
+#include "Tangle2Selection.hh"
+#include "Tangle2Config.hh"
+
+#include <vector>
 
 class G4VPhysicalVolume;
+struct Tangle2CheckpointState;
 
 // This is a lazy way of sharing memory. To avoid polluting the global
 // namespace we define our own distinctive namespace.
 namespace Tangle2 {
 
-  extern G4bool positrons;
-  extern G4bool fixedAxis;
-  extern G4bool perpPol;
-  extern G4bool polYZ;
-  extern G4bool fullPET;
+  // Frozen at /run/initialize, see Tangle2Config
+  extern const Tangle2Config& config;
+
+  // Fast simulation of gammas in the crystals
+  enum { kFastSimOff = 0, kFastSimOn, kFastSimValidate };
+  extern G4int fastSimMode;
+  
+  // Format of the selected-event output, see Tangle2OutputBackend
+  enum { kOutputG4Root = 0, kOutputHdf5, kOutputRNTuple };
+  // False: no per-event output, only the histograms
+  extern G4bool ntupleOutput;
+  // Base name of the output files, "Tangle2" or per sweep point
+  extern G4String outputName;
+  // Checkpoints, see Tangle2Checkpoint; 0 is off
+  extern G4long checkpointEvents;
+  extern G4double checkpointMinutes;
+  // Set for the run started by /tangle2/checkpoint/resume
+  extern const Tangle2CheckpointState* checkpointResume;
+  // Progress reports, see Tangle2Telemetry; 0 is off
+  extern G4double telemetryInterval;
+  extern G4bool telemetryConsole;
+  // Step profile, see Tangle2StepProfiler
+  extern G4bool profileSteps;
+  // tangle2 --shard i/N, see Tangle2Shard; nShards 0 is off
+  extern G4int  shardIndex;
+  extern G4int  nShards;
+  extern G4long campaignSeed;
+  // Added to the event IDs written out, set by the master each run
+  extern G4long eventIDOffset;
+  // In a process forked by Tangle2ForkRunManager: its number, and the
+  // first event of its share and the events of the whole run; -1 and
+  // 0 otherwise
+  extern G4int  forkProcess;
+  extern G4long forkFirstEvent;
+  extern G4long forkRunEvents;
+  // Set with /tangle2/select/ on the master, copied by each thread
+  extern Tangle2Selection selection;
+  // Booked with /tangle2/hist/ on the master, copied by each thread
+  extern std::vector<Tangle2Histogram> histograms;
   
-  extern G4int nMasterEvents;
-  extern G4int nMasterEventsPh;  
+  extern G4long nMasterEvents;
+  extern G4long nMasterEventsPh;  
+  extern G4long nMasterEventsRejected;
+  extern G4long nMasterEventsRejectedPh;
+  extern G4long nMasterEventsSelected;
+  extern G4long nMasterDirectionTrials;
+  extern G4long nMasterOutputRows;
+  extern G4long nMasterOutputBytes;
+  extern G4double masterOutputSeconds;
+  // Master BeginOfRunAction to EndOfRunAction, i.e. without the
+  // geometry and physics initialisation
+  extern G4double masterEventSeconds;
   
   // Worker quantities
-  extern G4ThreadLocal G4int nEvents;
-  extern G4ThreadLocal G4int nEventsPh;
+  extern G4ThreadLocal G4long nEvents;
+  extern G4ThreadLocal G4long nEventsPh;
+  extern G4ThreadLocal G4long nEventsRejected;
+  // rejected events already QET when given up on
+  extern G4ThreadLocal G4long nEventsRejectedPh;
+  extern G4ThreadLocal G4long nEventsSelected;
+  extern G4ThreadLocal G4bool fastSimEvent;
+  extern G4ThreadLocal G4long nDirectionTrials;
+  extern G4ThreadLocal G4double eventWeight;
   extern G4ThreadLocal G4double eDepEvent;
   extern G4ThreadLocal G4double eDepCryst[18];
   extern G4ThreadLocal G4double eDepColl1;
@@ -63,10 +120,10 @@ namespace Tangle2 {
   extern G4ThreadLocal G4double dphiA2B1;
   extern G4ThreadLocal G4double dphiA2B2;
 
-  extern G4ThreadLocal G4int nA1B1;
-  extern G4ThreadLocal G4int nA2B1;
-  extern G4ThreadLocal G4int nA1B2;
-  extern G4ThreadLocal G4int nA2B2;
+  extern G4ThreadLocal G4long nA1B1;
+  extern G4ThreadLocal G4long nA2B1;
+  extern G4ThreadLocal G4long nA1B2;
+  extern G4ThreadLocal G4long nA2B2;
   
 }
 
@@ -29,6 +29,7 @@ public:
   virtual ~Tangle2DetectorConstruction();
 
   virtual G4VPhysicalVolume* Construct();
+  virtual void ConstructSDandField();
 
 private:
   void DefineMaterials();
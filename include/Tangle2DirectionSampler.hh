@@ -0,0 +1,63 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Beam axis sampling for back to back photons, shared by
+// Tangle2PrimaryGeneratorAction and the standalone engine.
+//
+// The axis is isotropic within BeamThetaMax of the x axis and is drawn
+// directly on the cone: cos(theta) uniform on [cos(thetaMax),1].  This
+// is the distribution the old loop (cos(theta) uniform on [-1,1],
+// rejected until theta < thetaMax) produced, without its ~1% (lab) or
+// ~0.005% (fullPET) acceptance.
+//
+// Optionally the axis is also ray-cast, both ways from the origin,
+// against the bounding boxes of the two crystal arrays, and redrawn
+// until both photons point at an array.  Every event then stands for
+// 1/Acceptance() cone events, so it carries the weight Acceptance() -
+// sums of weights are per cone event, as without the ray-cast.
+//
+// Plain numbers and no Geant4, like Tangle2Geometry.  The caller
+// supplies the uniform random numbers.
+
+#ifndef Tangle2DirectionSampler_hh
+#define Tangle2DirectionSampler_hh 1
+
+class Tangle2DirectionSampler
+{
+public:
+  explicit Tangle2DirectionSampler(bool fullPET);
+
+  // Unit vector on the cone, from two uniform numbers in [0,1)
+  void SampleCone(double u1, double u2, double dir[3]) const;
+
+  // True if a photon along dir and one along -dir, both from the
+  // origin, each enter one of the crystal array bounding boxes
+  bool HitsArrays(const double dir[3]) const;
+
+  // Fraction of the cone for which HitsArrays is true, from a fixed
+  // stratified grid (so the same on every thread), computed on first use
+  double Acceptance() const;
+
+private:
+  bool HitsBox(const double lo[3], const double hi[3],
+	       const double dir[3]) const;
+
+  double fCosThetaMax;
+  double fLoA[3], fHiA[3];
+  double fLoB[3], fHiB[3];
+  mutable double fAcceptance;
+};
+
+#endif
@@ -19,6 +19,7 @@
 
 #include "G4UserEventAction.hh"
 #include "globals.hh"
+#include "Tangle2EventRecord.hh"
 
 class Tangle2RunAction;
 class Tangle2VSteppingAction;
@@ -27,7 +28,7 @@ class Tangle2EventAction : public G4UserEventAction
 {
 public:
 
-  Tangle2EventAction(Tangle2VSteppingAction*);
+  Tangle2EventAction(Tangle2VSteppingAction*, Tangle2RunAction*);
 
   virtual ~Tangle2EventAction();
 
@@ -37,6 +38,17 @@ public:
 private:
   
   Tangle2VSteppingAction* fpTangle2VSteppingAction;
+  Tangle2RunAction* fpRunAction;  // owns the output backend
+  
+  // Filled for each selected event, reused
+  Tangle2EventRecord fRecord;
+
+  // Crystal hits collection ID - looked up on first use
+  G4int fCrystalHCID;
+  
+  // Fast simulation validation histograms - looked up on first use
+  G4int fDphiFullH1ID;
+  G4int fDphiFastH1ID;
 };
 
 #endif
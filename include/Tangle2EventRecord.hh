@@ -0,0 +1,71 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// One selected event, as written out by the Tangle2OutputBackends:
+// the columns of the Tangle2 ntuple in compact types.  Energies in MeV,
+// positions in mm, angles in degrees.  Float keeps positions to better
+// than 0.1 micron and angles to 1e-5 degrees; the interaction counts
+// fit int16.  nEvents counts per thread; eventID is the global event
+// number, so rows from all threads can be put back in event order.
+// Both are 64 bit, so the event IDs of a campaign of many shards stay
+// unique; through Get and Set (double) they are exact up to 2^53.
+//
+// Columns() lists name, type and place of each column in the order of
+// the original ntuple, so backends book and fill generically and no
+// list of column names is kept anywhere else.  No Geant4 dependence,
+// so the standalone engine writes the same records.
+
+#ifndef Tangle2EventRecord_hh
+#define Tangle2EventRecord_hh 1
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct Tangle2EventRecord
+{
+  float   edep[18];
+  float   edepColl[2];
+  int16_t nb_Compt[18];
+  float   posA_1[3], posA_2[3], posB_1[3], posB_2[3];
+  float   thetaA, phiA, thetaB, phiB, dphi;
+  float   thetaA2, phiA2, thetaB2, phiB2;
+  float   dphiA1B2, dphiA2B1, dphiA2B2;
+  float   thetaPolA, thetaPolB;
+  int64_t nEvents;
+  int16_t nb_Photo[18];
+  float   posA_P1[3], posA_P2[3], posB_P1[3], posB_P2[3];
+  float   weight;
+  int64_t eventID;   // G4Event::GetEventID, global over threads and shards
+  int16_t threadID;  // -1 for the master (sequential mode)
+
+  enum Type { kFloat, kInt16, kInt64 };
+
+  struct Column
+  {
+    std::string name;
+    Type        type;
+    std::size_t offset;
+  };
+
+  static const std::vector<Column>& Columns();
+  static std::size_t Size(Type);
+
+  double Get(const Column&) const;
+  void   Set(const Column&, double);
+};
+
+#endif
@@ -0,0 +1,48 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// /tangle2/fastSim/mode off|on|validate
+//
+//   off      - full Geant4 tracking in the crystals (default)
+//   on       - Tangle2CrystalFastModel for all gammas in the crystals
+//   validate - fast model for even event IDs, full simulation for odd
+//              ones; dphi is histogrammed separately for each and the
+//              two distributions are compared at the end of the run
+//
+// Sets Tangle2::fastSimMode on the master; workers only read it.
+
+#ifndef Tangle2FastSimMessenger_hh
+#define Tangle2FastSimMessenger_hh 1
+
+#include "G4UImessenger.hh"
+
+class G4UIdirectory;
+class G4UIcmdWithAString;
+
+class Tangle2FastSimMessenger : public G4UImessenger
+{
+public:
+  Tangle2FastSimMessenger();
+  virtual ~Tangle2FastSimMessenger();
+
+  virtual void SetNewValue(G4UIcommand*, G4String);
+  virtual G4String GetCurrentValue(G4UIcommand*);
+
+private:
+  G4UIdirectory*      fpDirectory;
+  G4UIcmdWithAString* fpModeCmd;
+};
+
+#endif
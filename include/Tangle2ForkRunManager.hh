@@ -0,0 +1,117 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// A sequential run manager that runs each /run/beamOn in N forked
+// processes (tangle2 -f N):
+//
+// The parent closes the geometry and builds the physics tables (the
+// Livermore polarised data included) with a beamOn of no events, then
+// forks.  The processes share those pages copy-on-write, and each has
+// its own allocator, caches and output, so there is neither lock nor
+// thread-local lookup between them and a crash takes down one process
+// only.
+//
+// Process k runs its share of the events (about n/N) with seeds drawn
+// for it by the parent engine, as <name>_p<k>: output files, histograms
+// and the log <name>_p<k>.log; event IDs are offset by the events of
+// the processes before it, so the files merge in event order with
+// tangle2_merge.  At the end it writes <name>_p<k>_process.txt: its
+// counters, files, histogram contents and memory (Rss, Pss, shared and
+// private, from /proc/self/smaps_rollup).
+//
+// The parent waits for all of them, reruns a process that fails or
+// stops short (same seeds, so the same events) up to maxRestarts times,
+// then adds up counters and histograms, writes <name>_hist_<h>.txt and,
+// with --shard, the shard manifest, and prints the memory of each
+// process.  Results depend on N, as they do on the shard count, but
+// not on restarts.  Checkpoints are per process; a failed process is
+// rerun rather than resumed.  POSIX only; not with a graphics session,
+// whose threads do not survive fork.
+
+#ifndef Tangle2ForkRunManager_hh
+#define Tangle2ForkRunManager_hh 1
+
+#include "G4RunManager.hh"
+#include "Tangle2Histogram.hh"
+#include "Tangle2Topology.hh"
+
+#include <chrono>
+#include <vector>
+
+class Tangle2ForkRunManager : public G4RunManager
+{
+public:
+  explicit Tangle2ForkRunManager(G4int nProcesses);
+  virtual ~Tangle2ForkRunManager();
+
+  // Process k placed as worker thread k would be (tangle2 -p)
+  void SetPlacement(Tangle2Topology::Policy policy) { fPolicy = policy; }
+  // Reruns of a failed process before giving up on it (default 2)
+  void SetMaxRestarts(G4int n) { fMaxRestarts = n; }
+
+  virtual void BeamOn(G4int n_event, const char* macroFile = 0,
+		      G4int n_select = -1);
+
+private:
+  // From /proc/self/smaps_rollup (or status), MB
+  struct Memory {
+    Memory() : rss(0.), pss(0.), shared(0.), priv(0.) {}
+    G4double rss, pss, shared, priv;
+  };
+  struct Process {
+    G4int    index;
+    G4long   firstEvent;
+    G4long   nEvents;
+    G4long   seeds[2];
+    long     pid;
+    G4int    restarts;
+    G4bool   done;
+    std::chrono::steady_clock::time_point start;
+    G4double seconds;  // of the last attempt
+    G4double maxRSS;   // MB
+  };
+  // As written by the process at the end of its run
+  struct Result {
+    Result();
+    G4long nEvents, nEventsPh, nEventsRejected, nEventsRejectedPh;
+    G4long nEventsSelected;
+    G4long nDirectionTrials, nRows, nBytes;
+    G4double outputSeconds;
+    Memory memory;
+    std::vector<G4String> files;
+    std::vector<Tangle2Histogram> histograms;
+  };
+
+  // False if it could not be forked
+  G4bool Start(Process&, const char* macroFile, G4int n_select);
+  // In the child; does not return
+  void RunProcess(const Process&, const char* macroFile, G4int n_select);
+  G4bool WriteResult(const G4String& fileName) const;
+  G4bool ReadResult(const G4String& fileName, Result&) const;
+  // Parent: counters, histograms, shard manifest and memory
+  void Report(const std::vector<Process>&, const std::vector<Result>&,
+	      const Memory& parent, G4double seconds);
+
+  static G4String ProcessName(G4int index);
+  static Memory ReadMemory();
+
+  G4int fNProcesses;
+  G4int fMaxRestarts;
+  G4long fRunEvents;
+  Tangle2Topology fTopology;
+  Tangle2Topology::Policy fPolicy;
+};
+
+#endif
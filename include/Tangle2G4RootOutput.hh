@@ -0,0 +1,41 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Selected events to the Tangle2 ntuple through G4AnalysisManager
+// (g4root), as before the output backends: int16 columns are booked
+// as int, all others as double, and the doubles are filled from the
+// Tangle2:: quantities, not the float record, so existing analysis
+// code reads the files unchanged and gets the same values.
+
+#ifndef Tangle2G4RootOutput_hh
+#define Tangle2G4RootOutput_hh 1
+
+#include "Tangle2OutputBackend.hh"
+
+class Tangle2G4RootOutput : public Tangle2OutputBackend
+{
+public:
+  Tangle2G4RootOutput();
+  virtual ~Tangle2G4RootOutput();
+
+  virtual const char* GetName() const { return "g4root"; }
+
+protected:
+  virtual std::string DoOpen(const std::string& fileName);
+  virtual void DoWrite(const Tangle2EventRecord&);
+  virtual void DoClose();
+};
+
+#endif
@@ -0,0 +1,63 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Crystal layout and source acceptance shared by
+// Tangle2DetectorConstruction, Tangle2PrimaryGeneratorAction and the
+// standalone transport engine (standalone/).  Plain numbers, lengths
+// in mm and angles in degrees, so that it has no Geant4 dependence.
+//
+// Two 3x3 arrays of LYSO crystals, long side along x, with inner faces
+// at +-ringDiameter/2.  Copy numbers 0-8 are array A (x > 0), 9-17
+// array B (x < 0); 4 and 13 are the central crystals.
+
+#ifndef Tangle2Geometry_hh
+#define Tangle2Geometry_hh 1
+
+namespace Tangle2Geometry {
+
+  // Crystal full dimensions
+  const double cryst_dX = 22.;
+  const double cryst_dY = 4.;
+  const double cryst_dZ = 4.;
+
+  const int nCrystals = 18;
+
+  // Arrays 6 cm apart (lab) or 90 cm apart (human PET)
+  inline double RingDiameter(bool fullPET)
+  { return fullPET ? 900. : 60.; }
+
+  // A 1 mm gap is left between the crystals and the world edge
+  inline double WorldSizeX(bool fullPET)
+  { return RingDiameter(fullPET) + 2*cryst_dX + 2.; }
+  const double worldSizeYZ = 20.;
+
+  // Centre of crystal copyNo
+  inline void CrystalCentre(int copyNo, bool fullPET, double centre[3])
+  {
+    const double pos_dX = 0.5*(WorldSizeX(fullPET) - cryst_dX - 2.);
+    const int    i      = copyNo%9;
+    centre[0] = (copyNo < 9) ? pos_dX : -pos_dX;
+    centre[1] = (i%3 - 1)*cryst_dY;
+    centre[2] = (1 - i/3)*cryst_dZ;
+  }
+
+  // Back to back photons are generated within this angle of the
+  // x axis - just outside the outer edge of the outer crystals
+  inline double BeamThetaMax(bool fullPET)
+  { return fullPET ? 0.8 : 12.; }
+
+}
+
+#endif
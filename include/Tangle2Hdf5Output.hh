@@ -0,0 +1,69 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Selected events to HDF5: group /Tangle2 with one extendible dataset
+// per column of Tangle2EventRecord, float32, int16 or int64, chunked
+// along the rows with shuffle and deflate.  Rows are buffered and
+// appended a chunk at a time.
+//
+// Needs cmake -DWITH_TANGLE2_HDF5=ON (defines TANGLE2_WITH_HDF5);
+// otherwise Open fails.  The HDF5 library is called under one lock,
+// Mutex(), since it is not usually built thread-safe.
+
+#ifndef Tangle2Hdf5Output_hh
+#define Tangle2Hdf5Output_hh 1
+
+#include "Tangle2OutputBackend.hh"
+
+#include <mutex>
+#include <vector>
+
+class Tangle2Hdf5Output : public Tangle2OutputBackend
+{
+public:
+  Tangle2Hdf5Output();
+  virtual ~Tangle2Hdf5Output();
+
+  virtual const char* GetName() const { return "hdf5"; }
+
+  // Built with HDF5
+  static bool IsAvailable();
+
+  // Held for every call to the HDF5 library, by readers too
+  static std::mutex& Mutex();
+
+  // Rows per chunk, and per write to the file
+  static const std::size_t kChunkRows = 8192;
+
+protected:
+  virtual std::string DoOpen(const std::string& fileName);
+  virtual void DoWrite(const Tangle2EventRecord&);
+  virtual void DoClose();
+
+private:
+  void Flush();
+
+  // hid_t, kept as int64_t so that hdf5.h is not needed here
+  int64_t fFile;
+  int64_t fGroup;
+  std::vector<int64_t> fDatasets;
+
+  // Column-wise buffer of up to kChunkRows rows
+  std::vector<std::vector<char> > fBuffers;
+  std::size_t fBufferedRows;
+  unsigned long long fWrittenRows;
+};
+
+#endif
@@ -0,0 +1,95 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// A 1D or 2D histogram of Tangle2EventRecord columns, filled in the
+// event loop instead of writing rows and histogramming them afterwards
+// (see tips).  E.g. dPhi_1st, PhiA_1st vs PhiB_1st, or dPhi_1st for
+// events with both first scatters in a theta window:
+//
+//   Tangle2Histogram h("dphi80", "dPhi_1st", 360, 0., 360.);
+//   h.SetThetaWindow(80., 90.);
+//
+// Entries are weighted by the weight column.  Bins 0 and n+1 of each
+// axis are under- and overflow.  Booked from a macro with
+// /tangle2/hist/ (Tangle2HistogramMessenger); each worker fills its
+// own copy and the master adds them in thread order at the end of the
+// run (Tangle2RunAction), so no lock is taken while filling and the
+// sums do not depend on which thread finished first.
+
+#ifndef Tangle2Histogram_hh
+#define Tangle2Histogram_hh 1
+
+#include "Tangle2EventRecord.hh"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class Tangle2Histogram
+{
+public:
+  // 1D if yColumn is empty.  Check IsValid for unknown column names.
+  Tangle2Histogram(const std::string& name,
+		   const std::string& xColumn, int nx, double xMin, double xMax,
+		   const std::string& yColumn = "",
+		   int ny = 0, double yMin = 0., double yMax = 0.);
+
+  // Only events with ThetaA_1st and ThetaB_1st in (min, max), degrees
+  void SetThetaWindow(double min, double max);
+
+  bool IsValid() const;
+
+  void Fill(const Tangle2EventRecord&);
+
+  // Same binning assumed (a copy of the same booking)
+  void Add(const Tangle2Histogram&);
+  void Reset();
+
+  // Text for gnuplot, as whist.pl: 1D "xLow xHigh sum error" per bin
+  // ("plot with steps"), 2D "x y sum" per bin with rows separated by
+  // blank lines ("splot")
+  bool Write(const std::string& fileName) const;
+  
+  // Name, entries and every bin with under- and overflow and the sum of
+  // squared weights, exactly (hexadecimal floating point), for
+  // Tangle2ForkRunManager to add up the histograms of its processes.
+  // ReadContents expects the same booking.
+  void WriteContents(std::FILE*) const;
+  bool ReadContents(std::FILE*);
+
+  const std::string& GetName() const { return fName; }
+  long   GetEntries() const { return fEntries; }
+  double GetSum() const;  // in range
+
+private:
+  static const Tangle2EventRecord::Column* FindColumn(const std::string&);
+  static int Bin(double value, int n, double min, double max);
+
+  std::string fName;
+  const Tangle2EventRecord::Column* fpX;
+  const Tangle2EventRecord::Column* fpY;  // null for 1D
+  int    fNx, fNy;
+  double fXMin, fXMax, fYMin, fYMax;
+
+  bool   fThetaWindow;
+  double fThetaMin, fThetaMax;
+  const Tangle2EventRecord::Column* fpThetaA;
+  const Tangle2EventRecord::Column* fpThetaB;
+
+  long fEntries;
+  std::vector<double> fSumW, fSumW2;  // (nx+2)*(ny+2), x fastest
+};
+
+#endif
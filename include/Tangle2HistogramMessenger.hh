@@ -0,0 +1,66 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Histograms filled in the event loop (see Tangle2Histogram), in place
+// of writing every row and histogramming afterwards:
+//
+//   /tangle2/hist/h1 <name> <column> <nBins> <min> <max>
+//   /tangle2/hist/h2 <name> <xColumn> <nx> <xMin> <xMax>
+//                           <yColumn> <ny> <yMin> <yMax>
+//   /tangle2/hist/thetaWindow <name> <min> <max>
+//   /tangle2/hist/ntupleOutput false
+//   /tangle2/hist/clear
+//   /tangle2/hist/list
+//
+// Columns are those of the Tangle2 ntuple, angles in degrees, e.g.
+//
+//   /tangle2/hist/h1 dphi dPhi_1st 360 0 360
+//   /tangle2/hist/h2 phiAB PhiA_1st 40 -200 200 PhiB_1st 40 -200 200
+//   /tangle2/hist/h1 dphi80 dPhi_1st 360 0 360
+//   /tangle2/hist/thetaWindow dphi80 80 90
+//
+// Written to Tangle2_hist_<name>.txt at the end of each run.  Books into
+// Tangle2::histograms on the master; workers copy it at begin of run.
+
+#ifndef Tangle2HistogramMessenger_hh
+#define Tangle2HistogramMessenger_hh 1
+
+#include "G4UImessenger.hh"
+
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithABool;
+class G4UIcmdWithoutParameter;
+
+class Tangle2HistogramMessenger : public G4UImessenger
+{
+public:
+  Tangle2HistogramMessenger();
+  virtual ~Tangle2HistogramMessenger();
+
+  virtual void SetNewValue(G4UIcommand*, G4String);
+  virtual G4String GetCurrentValue(G4UIcommand*);
+
+private:
+  G4UIdirectory*           fpDirectory;
+  G4UIcommand*             fpH1Cmd;
+  G4UIcommand*             fpH2Cmd;
+  G4UIcommand*             fpThetaWindowCmd;
+  G4UIcmdWithABool*        fpNtupleOutputCmd;
+  G4UIcmdWithoutParameter* fpClearCmd;
+  G4UIcmdWithoutParameter* fpListCmd;
+};
+
+#endif
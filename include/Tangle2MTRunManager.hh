@@ -0,0 +1,70 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// G4MTRunManager with guided, cost-adaptive event chunks in place of
+// the fixed eventModulo.  Each time a worker asks for events
+// (SetUpNEvents) it gets
+//
+//   min(chunkSeconds/(seconds per event), remaining/(2 nThreads))
+//
+// events, at least one: chunks of about chunkSeconds of work while
+// there is plenty left, shrinking towards the end of the run so that
+// no worker is left with a long last chunk on a slow or shared core.
+// The seconds per event are measured over the run so far (wall time
+// times threads over events handed out); until chunkSeconds have
+// passed there is no estimate and chunks are single events.
+//
+// Seeds are still drawn per event, in event order, so the results do
+// not depend on the chunking.  Selected with tangle2 -r adaptive.
+
+#ifndef Tangle2MTRunManager_hh
+#define Tangle2MTRunManager_hh 1
+
+#ifdef G4MULTITHREADED
+
+#include "G4MTRunManager.hh"
+
+#include <chrono>
+
+class Tangle2MTRunManager : public G4MTRunManager
+{
+public:
+  Tangle2MTRunManager();
+  virtual ~Tangle2MTRunManager();
+
+  // Seconds of work per chunk aimed at (default 0.05)
+  void SetChunkSeconds(G4double seconds) { fChunkSeconds = seconds; }
+
+  virtual size_t SetUpNEvents(G4Event*, G4SeedsQueue* seedsQueue,
+			      G4bool reseedRequired = true);
+  virtual void InitializeEventLoop(G4int n_event,
+				   const char* macroFile = 0,
+				   G4int n_select = -1);
+  virtual void RunTermination();
+
+private:
+  G4int ChunkSize() const;
+
+  typedef std::chrono::steady_clock Clock;
+
+  G4double fChunkSeconds;
+  Clock::time_point fStart;
+  G4int fNChunks;
+  G4int fMinChunk, fMaxChunk;
+};
+
+#endif
+
+#endif
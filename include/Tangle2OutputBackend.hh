@@ -0,0 +1,79 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Where selected events go.  Tangle2RunAction creates one backend per
+// thread (each thread writes its own file, as g4root does) according
+// to Tangle2::config.outputFormat:
+//
+//   g4root   - Tangle2G4RootOutput, the Tangle2 ntuple through
+//              G4AnalysisManager, column types as before (double/int)
+//   hdf5     - Tangle2Hdf5Output, one chunked, compressed dataset per
+//              column in compact types (cmake -DWITH_TANGLE2_HDF5=ON)
+//   rntuple  - Tangle2RNTupleOutput, ROOT RNTuple in compact types
+//              (cmake -DWITH_TANGLE2_RNTUPLE=ON, ROOT 6.34 or later)
+//
+// tangle2_merge puts the per-thread files back together in event
+// order (standalone/tangle2_merge.cc).
+//
+// hdf5 and rntuple are wrapped in a Tangle2AsyncOutput, written by a
+// separate thread, if Tangle2::config.asyncOutput.
+//
+// The base class counts rows, times the writing and measures the file
+// after Close, for the bytes per event and throughput reported at the
+// end of the run.
+
+#ifndef Tangle2OutputBackend_hh
+#define Tangle2OutputBackend_hh 1
+
+#include "Tangle2EventRecord.hh"
+
+#include <string>
+
+class Tangle2OutputBackend
+{
+public:
+  Tangle2OutputBackend();
+  virtual ~Tangle2OutputBackend();
+
+  // fileName without extension; returns false if it can not be opened
+  bool Open(const std::string& fileName);
+  void Write(const Tangle2EventRecord&);
+  void Close();
+
+  virtual const char* GetName() const = 0;
+
+  // With extension, once open
+  const std::string& GetFileName() const { return fFileName; }
+
+  // Statistics, complete after Close
+  long   GetNRows()    const { return fNRows; }
+  long   GetNBytes()   const { return fNBytes; }
+  double GetSeconds()  const { return fSeconds; }
+
+protected:
+  // Returns the name of the file written, with extension, or ""
+  virtual std::string DoOpen(const std::string& fileName) = 0;
+  virtual void DoWrite(const Tangle2EventRecord&) = 0;
+  virtual void DoClose() = 0;
+
+private:
+  std::string fFileName;
+  bool   fOpen;
+  long   fNRows;
+  long   fNBytes;
+  double fSeconds;
+};
+
+#endif
@@ -18,6 +18,7 @@
 #define Tangle2PrimaryGeneratorAction_hh 1
 
 #include "G4VUserPrimaryGeneratorAction.hh"
+#include "Tangle2DirectionSampler.hh"
 
 #include "G4ParticleGun.hh"
 #include "G4GeneralParticleSource.hh"
@@ -41,6 +42,16 @@ private:
   //G4GeneralParticleSource*  fParticleGun;
   
   G4ParticleGun*  fParticleGun;
+  
+  // Back to back beam axis, set up on the first event (the
+  // configuration is final only from /run/initialize) and again
+  // if a sweep changes fullPET
+  Tangle2DirectionSampler fDirectionSampler;
+  G4bool                  fDirectionSamplerSet;
+  G4bool                  fDirectionSamplerFullPET;
+  
+  // Events aborted for want of a direction hitting the arrays
+  G4long                  fNTrialLimitReached;
 };
 
 #endif
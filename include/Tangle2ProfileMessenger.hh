@@ -0,0 +1,42 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// /tangle2/profile/enable true|false   default false
+//
+// See Tangle2StepProfiler.  Needs a build with -DWITH_TANGLE2_PROFILE=ON.
+
+#ifndef Tangle2ProfileMessenger_hh
+#define Tangle2ProfileMessenger_hh 1
+
+#include "G4UImessenger.hh"
+
+class G4UIdirectory;
+class G4UIcmdWithABool;
+
+class Tangle2ProfileMessenger : public G4UImessenger
+{
+public:
+  Tangle2ProfileMessenger();
+  virtual ~Tangle2ProfileMessenger();
+
+  virtual void SetNewValue(G4UIcommand*, G4String);
+  virtual G4String GetCurrentValue(G4UIcommand*);
+
+private:
+  G4UIdirectory*    fpDirectory;
+  G4UIcmdWithABool* fpEnableCmd;
+};
+
+#endif
@@ -0,0 +1,53 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Selected events to a ROOT RNTuple "Tangle2", one field per column of
+// Tangle2EventRecord in its compact type, with the default RNTuple
+// compression.
+//
+// Needs cmake -DWITH_TANGLE2_RNTUPLE=ON and ROOT 6.34 or later
+// (defines TANGLE2_WITH_RNTUPLE); otherwise Open fails.
+
+#ifndef Tangle2RNTupleOutput_hh
+#define Tangle2RNTupleOutput_hh 1
+
+#include "Tangle2OutputBackend.hh"
+
+#include <memory>
+#include <vector>
+
+class Tangle2RNTupleOutput : public Tangle2OutputBackend
+{
+public:
+  Tangle2RNTupleOutput();
+  virtual ~Tangle2RNTupleOutput();
+
+  virtual const char* GetName() const { return "rntuple"; }
+
+  // Built with ROOT RNTuple
+  static bool IsAvailable();
+
+protected:
+  virtual std::string DoOpen(const std::string& fileName);
+  virtual void DoWrite(const Tangle2EventRecord&);
+  virtual void DoClose();
+
+private:
+  // ROOT types are kept out of this header
+  struct Writer;
+  std::unique_ptr<Writer> fpWriter;
+};
+
+#endif
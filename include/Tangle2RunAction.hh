@@ -18,10 +18,20 @@
 #define Tangle2RunAction_hh
 
 #include "G4UserRunAction.hh"
+#include "G4Timer.hh"
+#include "Tangle2Histogram.hh"
+#include "Tangle2Selection.hh"
+#include "Tangle2Checkpoint.hh"
+#include "Tangle2Shard.hh"
+#include "Tangle2Telemetry.hh"
+#include "Tangle2StepProfiler.hh"
 
+#include <chrono>
 #include <vector>
 
 class G4Run;
+class Tangle2VSteppingAction;
+class Tangle2OutputBackend;
 
 class Tangle2RunAction : public G4UserRunAction
 {
@@ -31,9 +41,106 @@ public:
 
   virtual void BeginOfRunAction(const G4Run*);
   virtual void   EndOfRunAction(const G4Run*);
+
+  // Worker threads only - the master has no stepping action
+  void SetSteppingAction(Tangle2VSteppingAction* steppingAction)
+  { fpTangle2VSteppingAction = steppingAction; }
+  
+  // Selected events go here; null on the master of a
+  // multi-threaded run unless the format is g4root
+  Tangle2OutputBackend* GetOutput() const { return fpOutput; }
+  
+  // Tangle2::config.outputFormat, or g4root if that format
+  // is not in this build
+  static G4int GetOutputFormat();
+  
+  // Configured with /tangle2/select/, this thread's copy
+  Tangle2Selection& GetSelection() { return fSelection; }
+  
+  // Histograms booked with /tangle2/hist/, this thread's copy
+  void FillHistograms(const Tangle2EventRecord& record)
+  {
+    for (std::size_t h = 0; h < fHistograms.size(); h++)
+      fHistograms[h].Fill(record);
+  }
+  
+  // Steps and tracks of this thread, see Tangle2StepProfiler
+  Tangle2StepProfiler& GetProfiler() { return fProfiler; }
+  
+  // Master, after the end of run, for Tangle2ForkRunManager: the
+  // merged histograms and the output files closed during the run
+  const std::vector<Tangle2Histogram>& GetHistograms() const
+  { return fHistograms; }
+  const std::vector<G4String>& GetOutputFiles() const
+  { return fShard.GetFiles(); }
+  
+  // At the start of each event, this thread's totals so far
+  void UpdateTelemetry(G4long nEvents, G4long nSelected)
+  { fpMasterRunAction->fTelemetry.Update(fThreadID, nEvents, nSelected); }
+  
+  // At the start of each event, see Tangle2Checkpoint
+  void CheckpointIfDue()
+  {
+    if (!fpMasterRunAction->fCheckpoint.IsEnabled()) return;
+    const G4int checkpoint = fpMasterRunAction->fCheckpoint.Count();
+    if (checkpoint != fCheckpointNumber)
+      Checkpoint(checkpoint);
+  }
+  
   
 private:
+  // Master only, Tangle2::fastSimMode validate
+  void PrintFastSimComparison() const;
+  
+  void CloseOutput();
+  void AddOutputStatistics() const;
+  void PrintOutputStatistics() const;
+  void PrintAsyncOutputStatistics() const;
+  void MergeAndWriteHistograms();
+  G4String WriteCheckpointHistograms(G4int checkpoint) const;
+  void ReadCheckpointHistograms(const std::vector<G4String>& files);
+  void PrintSelectionReport() const;
+  void PrintThreadBalance() const;
+  G4String OutputFileName(G4int checkpoint) const;
+  void Checkpoint(G4int checkpoint);
+  Tangle2CheckpointState::Counts GetCheckpointCounts() const;
+  
   static Tangle2RunAction* fpMasterRunAction;
+  Tangle2VSteppingAction* fpTangle2VSteppingAction;
+  Tangle2OutputBackend* fpOutput;
+  G4bool fAnalysisFileOpen;  // histograms only, non-g4root formats
+  G4Timer fRunTimer;         // master only
+  
+  // Master only: when the run started and, per worker, events and
+  // seconds from then to its end of run, for PrintThreadBalance
+  struct ThreadSummary {
+    G4int    threadID;
+    G4long   nEvents;
+    G4double finishSeconds;
+  };
+  std::chrono::steady_clock::time_point fRunStart;
+  std::vector<ThreadSummary> fThreadSummaries;
+  
+  Tangle2Telemetry  fTelemetry;   // master only
+  G4int             fThreadID;
+  Tangle2Checkpoint fCheckpoint;  // master only
+  Tangle2Shard      fShard;       // master only
+  G4int    fCheckpointNumber;     // this thread's last
+  // output files already closed at checkpoints this run
+  G4long   fClosedRows;
+  G4long   fClosedBytes;
+  G4double fClosedSeconds;
+  
+  // this thread's; the master's also holds the merged table
+  Tangle2StepProfiler fProfiler;
+  
+  Tangle2Selection fSelection;
+  std::vector<Tangle2Histogram> fHistograms;
+  // Master only: those of the runs before a resume
+  std::vector<Tangle2Histogram> fBaseHistograms;
+  // Master only: each worker's histograms, by thread ID
+  static const G4int kMaxThreads = 1024;
+  std::vector<const std::vector<Tangle2Histogram>*> fWorkerHistograms;
 };
 
 #endif
@@ -0,0 +1,123 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Event selection for output and histograms, in place of the fixed cut
+// in Tangle2EventAction (crystals 4 and 13 above 5 keV, both first
+// scatters with theta != 0), which remains the default.  Cuts:
+//
+//   Hits      - at least n of a set of crystals above their threshold
+//   Compton   - at least nA Compton scatters in array A and nB in B
+//               (A1B1, A2B1, ...), from the nb_Compt counts
+//   Energy    - summed deposit above threshold in a set of crystals
+//               within [min, max]
+//   Scattered - thetaA and thetaB both non-zero
+//   Theta     - thetaA and thetaB both in (min, max) degrees
+//
+// Compile() turns the list into a flat array evaluated in two phases:
+// cuts on deposits and counts (kBeforeAngles), then, only for events
+// that pass, the angle calculation and the cuts on angles
+// (kAfterAngles).  Within a phase the cheapest cuts come first.  Each
+// cut counts the events it tested and passed.
+//
+// Energies in MeV, angles in degrees.  Configured with /tangle2/select/
+// (Tangle2SelectionMessenger) into Tangle2::selection on the master;
+// each thread compiles its own copy.
+
+#ifndef Tangle2Selection_hh
+#define Tangle2Selection_hh 1
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct Tangle2SelectionEvent
+{
+  const double* eDep;     // [18]
+  const int*    nbCompt;  // [18]
+  double thetaA, thetaB;  // kAfterAngles only
+};
+
+class Tangle2Selection
+{
+public:
+  enum { kNCrystals = 18 };
+  enum Phase { kBeforeAngles = 0, kAfterAngles };
+
+  // The default: Hits(2, {4, 13}), Scattered, 5 keV thresholds
+  Tangle2Selection();
+
+  void Clear();  // no cuts
+  void Reset();  // the default
+
+  // Crystal set: numbers, A (0-8) and B (9-17), e.g. "4 13" or "A".
+  // Returns 0 if a token is not a crystal.
+  static uint32_t ParseCrystals(const std::string&, bool& ok);
+
+  void SetThreshold(int crystal, double eThres);
+  void SetThreshold(double eThres);  // all crystals
+  double GetThreshold(int crystal) const { return fThreshold[crystal]; }
+
+  void AddHits(uint32_t crystals, int minHits);
+  void AddCompton(int minA, int minB);
+  void AddEnergy(uint32_t crystals, double min, double max);
+  void AddScattered();
+  void AddTheta(double min, double max);
+
+  // Orders the cuts and zeroes the counts; call at begin of run
+  void Compile();
+
+  // True if the event passes all the cuts of the phase
+  bool Select(Phase, const Tangle2SelectionEvent&);
+
+  // True if an event without a recorded Compton scatter (thetaA and
+  // thetaB 0, nb_Compt all 0) fails a cut, which
+  // /tangle2/config/fastReject relies on
+  bool NeedsScatter() const;
+
+  // Counts, for the master to sum over threads (same cuts assumed)
+  void AddCounts(const Tangle2Selection&);
+  void ResetCounts();
+
+  // One line per cut, in evaluation order
+  std::string Report() const;
+  std::string List() const;
+
+private:
+  enum Type { kHits, kCompton, kEnergy, kScattered, kTheta };
+
+  struct Cut
+  {
+    Type     type;
+    uint32_t crystals;
+    int      n1, n2;
+    double   min, max;
+    long long nTested, nPassed;
+  };
+
+  static Phase PhaseOf(Type);
+  static int   CostOf(Type);
+  std::string  Describe(const Cut&) const;
+  bool Pass(const Cut&, const Tangle2SelectionEvent&);
+
+  double fThreshold[kNCrystals];
+  std::vector<Cut> fCuts;
+  std::size_t fFirstAngleCut;  // cuts before it are kBeforeAngles
+
+  // crystals above threshold, worked out once per event
+  uint32_t fHitMask;
+  bool     fHitMaskValid;
+};
+
+#endif
@@ -0,0 +1,63 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Event selection (see Tangle2Selection), from a macro:
+//
+//   /tangle2/select/threshold <keV> [crystals]   default 5 keV, all
+//   /tangle2/select/hits <min> <crystals>        e.g. hits 2 4 13
+//   /tangle2/select/compton <AnBm>               e.g. compton A2B1
+//   /tangle2/select/energy <minKeV> <maxKeV> <crystals>
+//   /tangle2/select/scattered                    thetaA, thetaB != 0
+//   /tangle2/select/theta <minDeg> <maxDeg>
+//   /tangle2/select/clear | reset | list
+//
+// Crystals are numbers and A (0-8), B (9-17).  The default, as reset,
+// is "hits 2 4 13" and "scattered".  Cuts are added to the list; start
+// with clear to replace the default.  /tangle2/config/fastReject only
+// applies when a cut needs both gammas to scatter (scattered, theta
+// excluding 0, or compton), since the events it aborts could not pass.
+
+#ifndef Tangle2SelectionMessenger_hh
+#define Tangle2SelectionMessenger_hh 1
+
+#include "G4UImessenger.hh"
+
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithoutParameter;
+
+class Tangle2SelectionMessenger : public G4UImessenger
+{
+public:
+  Tangle2SelectionMessenger();
+  virtual ~Tangle2SelectionMessenger();
+
+  virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+  G4UIdirectory*           fpDirectory;
+  G4UIcommand*             fpThresholdCmd;
+  G4UIcommand*             fpHitsCmd;
+  G4UIcmdWithAString*      fpComptonCmd;
+  G4UIcommand*             fpEnergyCmd;
+  G4UIcmdWithoutParameter* fpScatteredCmd;
+  G4UIcommand*             fpThetaCmd;
+  G4UIcmdWithoutParameter* fpClearCmd;
+  G4UIcmdWithoutParameter* fpResetCmd;
+  G4UIcmdWithoutParameter* fpListCmd;
+};
+
+#endif
@@ -0,0 +1,90 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// One shard of a campaign spread over several nodes, without MPI:
+//
+//   tangle2 --shard i/N -s <campaign seed> ...
+//
+// on each node, i = 0..N-1.  Sharded runs use CLHEP::MixMaxRng for the
+// master engine, and shard i draws the MIXMAX stream of the IDs
+// (campaign seed, i, resumes) (SeedStream): streams of different IDs
+// are guaranteed not to overlap, so no two shards, nor a shard and its
+// resumes, share random numbers, and a shard rerun on its own gives
+// the same events.  The output base name
+// becomes <name>_s<i>, and event IDs are offset by i times the events
+// of the /run/beamOn, so the rows of all shards can be merged back
+// into one event order.
+//
+// At the end of each run the master writes <name>_s<i>_shard.txt: the
+// campaign seed, i and N, the stream IDs, the events asked for and done,
+// and the output and histogram files of the shard.  tangle2_shards
+// (standalone/tangle2_shards.cc) checks that every shard of a campaign
+// is there exactly once and complete, and merges their files.
+//
+// A shard resumed from a checkpoint lists the files of the interrupted
+// run too, and its histograms cover both (see Tangle2Checkpoint).  Event IDs
+// are 64 bit, so they stay unique over the campaign however large.
+
+#ifndef Tangle2Shard_hh
+#define Tangle2Shard_hh 1
+
+#include "globals.hh"
+
+#include <vector>
+
+struct Tangle2CheckpointState;
+
+class Tangle2Shard
+{
+public:
+  Tangle2Shard();
+  
+  // "i/N", 0 <= i < N; false if not
+  static G4bool Parse(const G4String&, G4int& index, G4int& nShards);
+  // Seeds the master MixMaxRng with the stream of Tangle2::campaignSeed
+  // and Tangle2::shardIndex after the given number of resumes
+  static void SeedStream(G4int resumes);
+  static void StreamIDs(G4int resumes, G4long ids[4]);
+  
+  // Master, start of run, from Tangle2::shardIndex etc.; sets
+  // Tangle2::eventIDOffset.  resume is null unless resuming.
+  void BeginOfRun(G4long nEventsToBeProcessed,
+		  const Tangle2CheckpointState* resume);
+  G4bool IsEnabled() const { return fEnabled; }
+  
+  // Master, with the run action lock held on workers: an output file
+  // closed (at a checkpoint or the end of the run) or a histogram file.
+  // Kept sharded or not, for Tangle2ForkRunManager.
+  void AddFile(const G4String& fileName);
+  void AddHistogram(const G4String& fileName);
+  const std::vector<G4String>& GetFiles() const { return fFiles; }
+  
+  // Master, end of run, the counters merged
+  void EndOfRun(G4long nEvents, G4long nRows);
+  
+  static G4String ManifestFileName();
+  
+private:
+  G4bool fEnabled;
+  G4long fRunEvents;    // of the original /run/beamOn
+  G4long fBaseEvents;   // done before a resume
+  G4long fBaseRows;
+  G4int  fResumes;
+  G4long fEventIDBase;  // of the shard's first event
+  std::vector<G4String> fFiles;
+  std::vector<G4String> fHistograms;
+};
+
+#endif
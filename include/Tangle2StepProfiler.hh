@@ -0,0 +1,116 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Step accounting by particle, process (the one that limited the step)
+// and logical volume: number of steps and wall time, per thread, merged
+// by the master at the end of the run into a table ranked by time,
+// with totals by particle (and tracks), by process and by volume.
+//
+// Built only with cmake -DWITH_TANGLE2_PROFILE=ON (defines
+// TANGLE2_WITH_PROFILE) and switched on with /tangle2/profile/enable.
+// Without it the calls are empty inline functions; built with it but
+// switched off they cost one predictable branch per step.
+//
+// The time of a step is the time since the previous step of the same
+// track, or since PreUserTrackingAction for the first, so it includes
+// the user stepping action itself but not stacking or the event.
+
+#ifndef Tangle2StepProfiler_hh
+#define Tangle2StepProfiler_hh 1
+
+#include "globals.hh"
+
+#ifdef TANGLE2_WITH_PROFILE
+#include <chrono>
+#include <map>
+#include <string>
+#include <unordered_map>
+#endif
+
+class G4Step;
+class G4Track;
+
+class Tangle2StepProfiler
+{
+public:
+  static G4bool IsAvailable();
+
+#ifdef TANGLE2_WITH_PROFILE
+  Tangle2StepProfiler();
+  
+  // Each thread, from Tangle2::profileSteps
+  void BeginOfRun();
+  
+  void StartTrack(const G4Track* track)
+  { if (fEnabled) DoStartTrack(track); }
+  void Step(const G4Step* step)
+  { if (fEnabled) DoStep(step); }
+  
+  // Master: add a thread's totals, with the run action lock held
+  void Add(const Tangle2StepProfiler&);
+  // Master, all threads added
+  void Print() const;
+  
+private:
+  typedef std::chrono::steady_clock Clock;
+  
+  void DoStartTrack(const G4Track*);
+  void DoStep(const G4Step*);
+  
+  struct Key {
+    const void* particle;
+    const void* process;
+    const void* volume;
+    bool operator==(const Key& other) const
+    {
+      return particle == other.particle && process == other.process &&
+	volume == other.volume;
+    }
+  };
+  struct KeyHash {
+    std::size_t operator()(const Key& key) const
+    {
+      std::size_t h = std::size_t(key.particle);
+      h = h*31 + std::size_t(key.process);
+      h = h*31 + std::size_t(key.volume);
+      return h ^ (h >> 17);
+    }
+  };
+  struct Entry {
+    Entry() : nSteps(0), nanoseconds(0) {}
+    G4long nSteps;
+    G4long nanoseconds;
+    std::string particle, process, volume;  // names, for merging
+  };
+  G4bool fEnabled;
+  Clock::time_point fLast;
+  // this thread, by pointers
+  std::unordered_map<Key, Entry, KeyHash> fEntries;
+  Entry* fpLastEntry;
+  Key    fLastKey;
+  std::unordered_map<const void*, G4long> fTracks;  // by particle
+  // merged, by names
+  std::map<std::string, Entry> fMerged;
+  std::map<std::string, G4long> fMergedTracks;
+#else
+  void BeginOfRun() {}
+  void StartTrack(const G4Track*) {}
+  void Step(const G4Step*) {}
+  void Add(const Tangle2StepProfiler&) {}
+  void Print() const {}
+#endif
+};
+
+#endif
@@ -20,18 +20,57 @@
 #include "Tangle2VSteppingAction.hh"
 
 #include "Tangle2RunAction.hh"
+#include "Tangle2AngleKernel.hh"
 #include "G4ThreeVector.hh"
+#include "G4Timer.hh"
+
+class G4ParticleDefinition;
+class G4VProcess;
 
 class Tangle2SteppingAction: public Tangle2VSteppingAction
 {
 public:
   Tangle2SteppingAction(Tangle2RunAction*);
+  virtual void BeginOfRunAction();
+  virtual void EndOfRunAction();
   virtual void BeginOfEventAction();
   virtual void UserSteppingAction(const G4Step*);
   virtual void EndOfEventAction();
+  virtual void ComputeAngles();
+  virtual G4bool IsRejected() const { return fRejected; }
+
+  // Bookkeeping of photoelectric and Compton interactions of gammas,
+  // by volume copy number and global position.  Called from
+  // UserSteppingAction and also by Tangle2CrystalFastModel, which
+  // handles gammas in the crystals without Geant4 steps.
+  void RecordPhoto(G4int trackID,
+		   G4int copyNo,
+		   const G4ThreeVector& postPos);
+  void RecordCompton(G4int trackID,
+		     G4int copyNo,
+		     const G4ThreeVector& postPos,
+		     const G4ThreeVector& preDir,
+		     const G4ThreeVector& postDir,
+		     const G4ThreeVector& prePol,
+		     const G4ThreeVector& postPol);
 
 private:
-  //Tangle2RunAction* fpRunAction;
+  Tangle2RunAction* fpRunAction;
+  Tangle2StepProfiler* fpProfiler;  // the run action's
+  // Tangle2Config::fastReject, if the selection of the run needs
+  // the scatters it gives up on (Tangle2Selection::NeedsScatter)
+  G4bool fFastReject;
+
+  // Resolved once per run in BeginOfRunAction so that the
+  // per-step selection is pointer compares, not string compares.
+  // Processes are thread-local, hence not resolved in the constructor.
+  const G4ParticleDefinition* fpGamma;
+  const G4VProcess*           fpComptProcess;
+  const G4VProcess*           fpPhotProcess;
+
+  // Step throughput for this thread
+  G4long  fNSteps;
+  G4Timer fRunTimer;
 
   G4int nComptonA, nComptonB;
   G4int nPhotoA,   nPhotoB;
@@ -41,6 +80,7 @@ private:
   G4int eventID         = 0;
   
   G4bool doubleComptEvent = true;
+  G4bool fRejected        = false;
 
   // gamma track IDs are different for
   // back to back and positron sources 
@@ -57,13 +97,23 @@ private:
   // G4ThreeVector LOR_A2B1;  
   // G4ThreeVector LOR_A2B2;  
   
+  // Raw vectors at the first and second Compton
+  // scatter in each array, for ComputeAngles
   G4ThreeVector beam_A;  
   G4ThreeVector vScat_A1;
+  G4ThreeVector vPre_A2;
   G4ThreeVector vScat_A2;
+  G4ThreeVector vPolPre_A;
+  G4ThreeVector vPolPost_A;
   
   G4ThreeVector beam_B;
   G4ThreeVector vScat_B1;
+  G4ThreeVector vPre_B2;
   G4ThreeVector vScat_B2;  
+  G4ThreeVector vPolPre_B;
+  G4ThreeVector vPolPost_B;
+
+  Tangle2AngleBatch fAngleBatch;
 
   G4bool comments = false;
 
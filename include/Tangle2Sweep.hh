@@ -0,0 +1,73 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// A list of configurations run back to back in one session, so the
+// geometry and physics tables are built once:
+//
+//   /run/initialize
+//   /tangle2/sweep/add random   positrons=false
+//   /tangle2/sweep/add perp     positrons=false perpPol=true
+//   /tangle2/sweep/add polYZ    positrons=false fixedAxis=true polYZ=true
+//   /tangle2/sweep/add positron positrons=true
+//   /tangle2/sweep/run 1000000
+//
+// Each point starts from the configuration the sweep started with
+// (see Tangle2Config::Set for the names) and writes its output to
+// Tangle2_<tag>...  fullPET rebuilds the geometry for that point;
+// polarisedCompton can not change once the physics is built.  At the
+// end the initialisation and event loop times of each point are
+// printed separately.
+
+#ifndef Tangle2Sweep_hh
+#define Tangle2Sweep_hh 1
+
+#include "globals.hh"
+#include "Tangle2Config.hh"
+
+#include <vector>
+
+class Tangle2Sweep
+{
+public:
+  // "key=value ..."; false, and nothing added, if any is not known
+  G4bool Add(const G4String& tag, const G4String& settings);
+  void Clear() { fPoints.clear(); }
+  void List() const;
+  std::size_t Size() const { return fPoints.size(); }
+
+  // Master only, in Idle state
+  void Run(G4int nEvents);
+
+private:
+  struct Point {
+    G4String tag;
+    std::vector<G4String> names;
+    std::vector<G4String> values;
+  };
+  struct Result {
+    G4String tag;
+    G4long   nEvents;
+    G4double initSeconds;
+    G4double eventSeconds;
+  };
+  
+  // Apply the configuration; false if it can not be done in this session
+  static G4bool Apply(const Tangle2Config&);
+  void PrintResults(const std::vector<Result>&) const;
+  
+  std::vector<Point> fPoints;
+};
+
+#endif
@@ -0,0 +1,51 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// /tangle2/sweep/add <tag> [name=value ...]
+// /tangle2/sweep/run <nEvents>
+// /tangle2/sweep/clear | list
+//
+// See Tangle2Sweep.
+
+#ifndef Tangle2SweepMessenger_hh
+#define Tangle2SweepMessenger_hh 1
+
+#include "G4UImessenger.hh"
+#include "Tangle2Sweep.hh"
+
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithoutParameter;
+
+class Tangle2SweepMessenger : public G4UImessenger
+{
+public:
+  Tangle2SweepMessenger();
+  virtual ~Tangle2SweepMessenger();
+
+  virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+  Tangle2Sweep fSweep;
+  
+  G4UIdirectory*           fpDirectory;
+  G4UIcommand*             fpAddCmd;
+  G4UIcmdWithAnInteger*    fpRunCmd;
+  G4UIcmdWithoutParameter* fpClearCmd;
+  G4UIcmdWithoutParameter* fpListCmd;
+};
+
+#endif
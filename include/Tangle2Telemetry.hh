@@ -0,0 +1,109 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Live progress of a run, every /tangle2/telemetry/interval seconds
+// (default 30, 0 off): events/s per worker and in total, selected
+// events/s, ETA and output bytes so far, to the console and to
+// <name>_metrics.prom in the Prometheus text format (replaced as a
+// whole each time, for a node_exporter textfile collector or similar).
+//
+// Each thread stores its counters in its own cache line with relaxed
+// atomic stores, once per event; a separate thread, started and
+// stopped by the master run action, reads them and prints with G4cout
+// like the rest of tangle2 (not being a Geant4 thread, it has no output
+// destination of its own, so the lines go to standard output).
+
+#ifndef Tangle2Telemetry_hh
+#define Tangle2Telemetry_hh 1
+
+#include "globals.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Tangle2Telemetry
+{
+public:
+  Tangle2Telemetry();
+  ~Tangle2Telemetry();
+  
+  // Master, start and end of run
+  void BeginOfRun(G4long nEventsToBeProcessed);
+  void EndOfRun();
+  G4bool IsEnabled() const { return fEnabled; }
+  
+  // Any thread (master -1), its totals so far this run
+  void Update(G4int threadID, G4long nEvents, G4long nSelected)
+  {
+    if (!fEnabled) return;
+    Slot& slot = fSlots[Index(threadID)];
+    slot.nEvents.store(nEvents, std::memory_order_relaxed);
+    slot.nSelected.store(nSelected, std::memory_order_relaxed);
+  }
+  
+  // Any thread, on opening an output file: the bytes of the files it
+  // has already closed this run and the name of the open one
+  void SetOutput(G4int threadID, G4long closedBytes,
+		 const std::string& openFile);
+  
+  static const G4int kMaxSlots = 1025;  // the master and 1024 workers
+  
+private:
+  // One cache line each, so that workers do not share lines
+  struct alignas(64) Slot {
+    Slot() : nEvents(0), nSelected(0) {}
+    std::atomic<G4long> nEvents;
+    std::atomic<G4long> nSelected;
+  };
+  struct Sample {
+    Sample() : nEvents(0), nSelected(0) {}
+    G4long nEvents;
+    G4long nSelected;
+  };
+  
+  static G4int Index(G4int threadID)
+  { return threadID + 1 < kMaxSlots ? threadID + 1 : kMaxSlots - 1; }
+  
+  void Loop();
+  void Report(G4bool final);
+  G4long OutputBytes();
+  
+  G4bool   fEnabled;
+  G4double fInterval;
+  G4bool   fConsole;
+  G4long   fNEventsToBeProcessed;
+  std::string fMetricsFile;
+  
+  char* fSlotStorage;  // fSlots, 64-byte aligned, are in here
+  Slot* fSlots;
+  std::vector<Sample> fLast;
+  double fStartSeconds;
+  double fLastSeconds;
+  
+  std::mutex fOutputMutex;
+  std::vector<G4long> fClosedBytes;
+  std::vector<std::string> fOpenFiles;
+  
+  std::thread fThread;
+  std::mutex fMutex;
+  std::condition_variable fWake;
+  G4bool fStop;
+};
+
+#endif
@@ -0,0 +1,45 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// /tangle2/telemetry/interval <s>          0 off, default 30
+// /tangle2/telemetry/console true|false    default true
+//
+// See Tangle2Telemetry.  The metrics file is written either way.
+
+#ifndef Tangle2TelemetryMessenger_hh
+#define Tangle2TelemetryMessenger_hh 1
+
+#include "G4UImessenger.hh"
+
+class G4UIdirectory;
+class G4UIcmdWithADouble;
+class G4UIcmdWithABool;
+
+class Tangle2TelemetryMessenger : public G4UImessenger
+{
+public:
+  Tangle2TelemetryMessenger();
+  virtual ~Tangle2TelemetryMessenger();
+
+  virtual void SetNewValue(G4UIcommand*, G4String);
+  virtual G4String GetCurrentValue(G4UIcommand*);
+
+private:
+  G4UIdirectory*      fpDirectory;
+  G4UIcmdWithADouble* fpIntervalCmd;
+  G4UIcmdWithABool*   fpConsoleCmd;
+};
+
+#endif
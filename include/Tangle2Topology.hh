@@ -0,0 +1,86 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// The CPUs this process may use and how they are laid out, for the
+// default number of threads and the placement of worker threads
+// (tangle2 -t, -p; Tangle2WorkerInitialization).  Linux only; elsewhere
+// it knows std::thread::hardware_concurrency and nothing else.
+//
+// Available CPUs are those of the affinity mask (taskset, numactl,
+// batch systems), further limited by a CFS quota of the cgroup
+// (cpu.max, or cpu.cfs_quota_us of cgroup v1, as set by docker --cpus
+// and Kubernetes limits): a quota of 2.5 CPUs gives 2 threads, so the
+// default neither oversubscribes nor leaves a whole CPU idle.
+//
+// Placement policies, for worker thread i:
+//   compact  one thread per physical core first, NUMA node after NUMA
+//            node, then the other hardware threads in the same order
+//   scatter  round robin over the NUMA nodes, physical cores of each
+//            node first
+// More threads than CPUs wrap around.
+//
+// Memory follows the first touch on Linux, so pinning a worker before
+// it builds its actions puts its thread-local state and output buffers
+// on its own NUMA node.
+
+#ifndef Tangle2Topology_hh
+#define Tangle2Topology_hh 1
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class Tangle2Topology
+{
+public:
+  enum Policy { kNone, kCompact, kScatter };
+
+  // false for an unknown name; "none", "compact" or "scatter"
+  static bool ParsePolicy(const std::string& name, Policy& policy);
+  static const char* PolicyName(Policy);
+
+  // Reads the affinity mask, cgroup and /sys
+  Tangle2Topology();
+
+  int GetNAllowedCPUs() const { return int(fCPUs.size()); }
+  int GetNNodes() const { return fNNodes; }
+  // CPUs of the CFS quota, 0 if there is none
+  double GetQuotaCPUs() const { return fQuotaCPUs; }
+
+  // Threads that use the available CPUs without oversubscribing them
+  int GetDefaultNThreads() const;
+
+  // CPU of worker thread threadID, -1 for kNone or if unknown
+  int CPUForThread(int threadID, Policy) const;
+  int NodeOfCPU(int cpu) const;
+
+  // The calling thread to one CPU; false if not possible
+  static bool PinCurrentThread(int cpu);
+
+  void Print(std::ostream&) const;
+
+private:
+  struct CPU
+  {
+    int id, package, core, node;
+    int sibling;  // 0 for the first hardware thread of its core
+  };
+  std::vector<CPU> fCPUs;  // allowed, in compact order
+  std::vector<int> fScatter;
+  int    fNNodes;
+  double fQuotaCPUs;
+};
+
+#endif
@@ -3,11 +3,18 @@
 
 #include "G4UserTrackingAction.hh"
 
+class Tangle2RunAction;
+class Tangle2StepProfiler;
+
 class Tangle2TrackingAction : public G4UserTrackingAction
 {
 public:
+  Tangle2TrackingAction(Tangle2RunAction*);
   virtual void PreUserTrackingAction(const G4Track*);
   virtual void PostUserTrackingAction(const G4Track*);
+
+private:
+  Tangle2StepProfiler* fpProfiler;  // the run action's
 };
 
 #endif
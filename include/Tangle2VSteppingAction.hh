@@ -19,6 +19,9 @@
 // stepping action in this project should inherit.
 //
 // BeginOfEventAction and EndOfEventAction are called from Tangle2EventAction.
+// BeginOfRunAction and EndOfRunAction are called from Tangle2RunAction, so
+// that anything the stepping action needs per step can be looked up once
+// per run rather than on every step.
 
 #ifndef Tangle2VSteppingAction_hh
 #define Tangle2VSteppingAction_hh
@@ -29,8 +32,16 @@
 class Tangle2VSteppingAction : public G4UserSteppingAction
 {
 public:
+  virtual void BeginOfRunAction() {};
+  virtual void EndOfRunAction() {};
   virtual void BeginOfEventAction() {};
   virtual void EndOfEventAction() {};
+  // Deferred calculation of event quantities that are only
+  // needed for selected events - called from Tangle2EventAction
+  virtual void ComputeAngles() {};
+  // True if the event can no longer be selected and was given up
+  // on (Tangle2Config::fastReject) - called from Tangle2EventAction
+  virtual G4bool IsRejected() const { return false; };
 };
 
 #endif
@@ -0,0 +1,39 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Pins each worker thread to a CPU, by Tangle2Topology placement
+// policy (tangle2 -p compact|scatter), as the first thing the worker
+// does, before it builds its user actions and allocates its buffers.
+
+#ifndef Tangle2WorkerInitialization_hh
+#define Tangle2WorkerInitialization_hh 1
+
+#include "G4UserWorkerInitialization.hh"
+#include "Tangle2Topology.hh"
+
+class Tangle2WorkerInitialization : public G4UserWorkerInitialization
+{
+public:
+  Tangle2WorkerInitialization(const Tangle2Topology&,
+			      Tangle2Topology::Policy);
+
+  virtual void WorkerInitialize() const;
+
+private:
+  Tangle2Topology         fTopology;  // copied, workers start at /run/beamOn
+  Tangle2Topology::Policy fPolicy;
+};
+
+#endif
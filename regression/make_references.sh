@@ -0,0 +1,64 @@
+#!/bin/sh
+# Makes the physics references of tangle2_regression from the baseline,
+# as described in README.txt, and leaves them in regression/<configuration>
+# to be committed.  Needs Geant4 (Geant4Config.cmake found by cmake) and
+# tangle2_regression built from this tree:
+#
+#   regression/make_references.sh build-standalone/tangle2_regression
+#
+# The baseline is checked out in a temporary worktree, switched to csv
+# output, 2 threads and 200000 events, and built and run once per
+# configuration.  Its seeds come from the time, so the histograms differ
+# from run to run within their statistical errors.
+
+set -e
+
+if [ $# -lt 1 ] || [ ! -x "$1" ]; then
+  echo "usage: $0 path/to/tangle2_regression [baseline commit]" >&2
+  exit 2
+fi
+regression=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+baseline=${2:-7070dc6}
+references=$(cd "$(dirname "$0")" && pwd)
+work=$(mktemp -d "${TMPDIR:-/tmp}/tangle2-baseline.XXXXXX")
+
+git -C "$references/.." worktree add --detach "$work/src" "$baseline"
+trap 'git -C "$references/.." worktree remove --force "$work/src"; rm -rf "$work"' EXIT
+
+cd "$work/src"
+sed -i 's/"g4root.hh"/"g4csv.hh"/' include/Tangle2Data.hh
+sed -i -e 's|^#/run/numberOfThreads 8|/run/numberOfThreads 2|' \
+       -e 's|^/run/beamOn 50$|/run/beamOn 200000|' visNoGraph.mac
+
+# flag value: the assignment at the top of main()
+set_flag()
+{
+  sed -i "s/^\(  Tangle2::$1 *= *\)[a-z]*;/\1$2;/" tangle2.cc
+}
+
+for configuration in positrons fixedAxis perpPol polYZ fullPET; do
+  git checkout -q -- tangle2.cc
+  set_flag fixedAxis false
+  set_flag positrons true
+  set_flag perpPol false
+  set_flag polYZ false
+  set_flag fullPET false
+  case $configuration in
+    fixedAxis) set_flag positrons false; set_flag fixedAxis true ;;
+    perpPol)   set_flag positrons false; set_flag fixedAxis true
+               set_flag perpPol true ;;
+    polYZ)     set_flag positrons false; set_flag fixedAxis true
+               set_flag polYZ true ;;
+    fullPET)   set_flag fullPET true ;;
+  esac
+
+  build="$work/build-$configuration"
+  cmake -S . -B "$build" -DCMAKE_BUILD_TYPE=Release
+  cmake --build "$build" -j"$(nproc)"
+  (cd "$build" && ./tangle2 > tangle2.log 2>&1)
+  "$regression" histogram -d "$references/$configuration" \
+    "$build"/Tangle2_nt_Tangle2_t*.csv
+done
+
+echo "References in $references; commit them with the output of"
+echo "  git -C $references/.. log -1 --format=%H $baseline"
@@ -39,11 +39,12 @@ void Tangle2ActionInitialization::Build() const
   
   Tangle2SteppingAction* steppingAction
     = new Tangle2SteppingAction(runAction);
+  runAction->SetSteppingAction(steppingAction);
 
   Tangle2EventAction* eventAction
-    = new Tangle2EventAction(steppingAction);
+    = new Tangle2EventAction(steppingAction, runAction);
 
-  G4UserTrackingAction* trackingAction = new Tangle2TrackingAction;
+  G4UserTrackingAction* trackingAction = new Tangle2TrackingAction(runAction);
 
   SetUserAction(new Tangle2PrimaryGeneratorAction);
   SetUserAction(runAction);
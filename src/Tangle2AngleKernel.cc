@@ -0,0 +1,265 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2AngleKernel.hh"
+
+#include <cmath>
+
+// One build per instruction set, selected when the library is loaded.
+// Elsewhere the compiler's own target is used.
+#if defined(__x86_64__) && defined(__linux__) && \
+    (defined(__GNUC__) || defined(__clang__)) && \
+    !defined(TANGLE2_NO_TARGET_CLONES)
+#define TANGLE2_KERNEL \
+  __attribute__((target_clones("avx512f","avx2","default")))
+#define TANGLE2_KERNEL_DISPATCH 1
+#else
+#define TANGLE2_KERNEL
+#endif
+
+// Inputs and outputs never overlap
+#if defined(__GNUC__) || defined(__clang__)
+#define TANGLE2_RESTRICT __restrict__
+#else
+#define TANGLE2_RESTRICT
+#endif
+
+namespace {
+
+  const double kPi     = 3.14159265358979323846;
+  const double kPiBy2  = 1.57079632679489661923;
+  const double kPiBy4  = 0.78539816339744830962;
+  const double kMoreBits = 6.123233995736765886130E-17;
+  const double kToDeg  = 180./3.14159265358979323846;
+
+  // atan(t) for t in [0,1], Cephes rational approximation
+  inline double AtanUnit(double t)
+  {
+    // reduce t > 0.66 about pi/4
+    const bool   big = t > 0.66;
+    const double xr  = (t - 1.)/(t + 1.);
+    const double x   = big ? xr : t;
+    const double y0  = big ? kPiBy4 : 0.;
+    const double z   = x*x;
+    const double p = 
+      (((-8.750608600031904122785E-1*z
+	 -1.615753718733365076637E1)*z
+	-7.500855792314704667340E1)*z
+       -1.228866684490136173410E2)*z
+      -6.485021904942025371773E1;
+    const double q =
+      ((((z + 2.485846490142306297962E1)*z
+	 + 1.650270098316988542046E2)*z
+	+ 4.328810604912902668951E2)*z
+       + 4.853903996359136964868E2)*z
+      + 1.945506571482613964425E2;
+    const double r = x + x*(z*p/q);
+    return y0 + (big ? r + 0.5*kMoreBits : r);
+  }
+
+  // Branch-free atan2, radians
+  inline double Atan2(double y, double x)
+  {
+    const double ax = std::fabs(x), ay = std::fabs(y);
+    const double mx = ax > ay ? ax : ay;
+    const double mn = ax > ay ? ay : ax;
+    const double t  = mn/(mx > 0. ? mx : 1.);
+    double r = AtanUnit(t);
+    r = ay > ax ? kPiBy2 - r : r;
+    // signed zeros as std::atan2, i.e. atan2(+-0,-0) = +-pi
+    r = std::copysign(1., x) < 0. ? kPi - r : r;
+    return std::copysign(r, y);
+  }
+
+  // acos with cosine clamped to [-1,1], radians
+  inline double Acos(double c)
+  {
+    c = c >  1. ?  1. : c;
+    c = c < -1. ? -1. : c;
+    return Atan2(std::sqrt((1. - c)*(1. + c)), c);
+  }
+
+}
+
+void Tangle2AngleBatch::Clear()
+{
+  std::vector<double>* all[] = {
+    &beamX, &beamY, &beamZ, &preX, &preY, &preZ,
+    &scatX, &scatY, &scatZ,
+    &polPreX, &polPreY, &polPreZ, &polPostX, &polPostY, &polPostZ,
+    &theta, &phi, &thetaPol };
+  for (std::size_t i = 0; i < sizeof(all)/sizeof(all[0]); i++)
+    all[i]->clear();
+}
+
+void Tangle2AngleBatch::Reserve(std::size_t n)
+{
+  std::vector<double>* all[] = {
+    &beamX, &beamY, &beamZ, &preX, &preY, &preZ,
+    &scatX, &scatY, &scatZ,
+    &polPreX, &polPreY, &polPreZ, &polPostX, &polPostY, &polPostZ,
+    &theta, &phi, &thetaPol };
+  for (std::size_t i = 0; i < sizeof(all)/sizeof(all[0]); i++)
+    all[i]->reserve(n);
+}
+
+std::size_t Tangle2AngleBatch::Add(const double beam[3],
+				   const double pre[3],
+				   const double scat[3])
+{
+  beamX.push_back(beam[0]); beamY.push_back(beam[1]); beamZ.push_back(beam[2]);
+  preX.push_back(pre[0]);   preY.push_back(pre[1]);   preZ.push_back(pre[2]);
+  scatX.push_back(scat[0]); scatY.push_back(scat[1]); scatZ.push_back(scat[2]);
+  return scatX.size() - 1;
+}
+
+std::size_t Tangle2AngleBatch::Add(const double beam[3],
+				   const double pre[3],
+				   const double scat[3],
+				   const double polPre[3],
+				   const double polPost[3])
+{
+  // keep the polarisation arrays aligned with the others
+  polPreX.resize(scatX.size());  polPreY.resize(scatX.size());
+  polPreZ.resize(scatX.size());  polPostX.resize(scatX.size());
+  polPostY.resize(scatX.size()); polPostZ.resize(scatX.size());
+  
+  polPreX.push_back(polPre[0]);   polPreY.push_back(polPre[1]);
+  polPreZ.push_back(polPre[2]);
+  polPostX.push_back(polPost[0]); polPostY.push_back(polPost[1]);
+  polPostZ.push_back(polPost[2]);
+  
+  return Add(beam, pre, scat);
+}
+
+TANGLE2_KERNEL
+void Tangle2AngleKernel::ThetaPhi(std::size_t n,
+                                  const double* TANGLE2_RESTRICT bX,
+                                  const double* TANGLE2_RESTRICT bY,
+                                  const double* TANGLE2_RESTRICT bZ,
+                                  const double* TANGLE2_RESTRICT pX,
+                                  const double* TANGLE2_RESTRICT pY,
+                                  const double* TANGLE2_RESTRICT pZ,
+                                  const double* TANGLE2_RESTRICT sX,
+                                  const double* TANGLE2_RESTRICT sY,
+                                  const double* TANGLE2_RESTRICT sZ,
+                                  double* TANGLE2_RESTRICT theta,
+                                  double* TANGLE2_RESTRICT phi)
+{
+  for (std::size_t i = 0; i < n; i++) {
+    
+    theta[i] = Acos(sX[i]*pX[i] + sY[i]*pY[i] + sZ[i]*pZ[i]) * kToDeg;
+    
+    // phi is measured about the beam (xx) axis with the lab z axis
+    // as reference, or lab y in the unlikely case of a beam along z
+    const bool alongZ = (bX[i] == 0.) & (bY[i] == 0.) & (bZ[i] == 1.);
+    const double rX = 0.;
+    const double rY = alongZ ? 1. : 0.;
+    const double rZ = alongZ ? 0. : 1.;
+    
+    // yy = reference x beam
+    const double yyX = rY*bZ[i] - rZ*bY[i];
+    const double yyY = rZ*bX[i] - rX*bZ[i];
+    const double yyZ = rX*bY[i] - rY*bX[i];
+    // zz = beam x yy
+    const double zzX = bY[i]*yyZ - bZ[i]*yyY;
+    const double zzY = bZ[i]*yyX - bX[i]*yyZ;
+    const double zzZ = bX[i]*yyY - bY[i]*yyX;
+    // scattered direction projected perpendicular to the beam
+    const double vX = bY[i]*sZ[i] - bZ[i]*sY[i];
+    const double vY = bZ[i]*sX[i] - bX[i]*sZ[i];
+    const double vZ = bX[i]*sY[i] - bY[i]*sX[i];
+    
+    const double vScat_z = -(vX*yyX + vY*yyY + vZ*yyZ);
+    const double vScat_y =  (vX*zzX + vY*zzY + vZ*zzZ);
+    
+    phi[i] = Atan2(vScat_y, vScat_z) * kToDeg;
+  }
+}
+
+TANGLE2_KERNEL
+void Tangle2AngleKernel::Angle(std::size_t n,
+                               const double* TANGLE2_RESTRICT aX,
+                               const double* TANGLE2_RESTRICT aY,
+                               const double* TANGLE2_RESTRICT aZ,
+                               const double* TANGLE2_RESTRICT bX,
+                               const double* TANGLE2_RESTRICT bY,
+                               const double* TANGLE2_RESTRICT bZ,
+                               double* TANGLE2_RESTRICT angle)
+{
+  // as CLHEP::Hep3Vector::angle
+  for (std::size_t i = 0; i < n; i++) {
+    const double ab  = aX[i]*bX[i] + aY[i]*bY[i] + aZ[i]*bZ[i];
+    const double aa  = aX[i]*aX[i] + aY[i]*aY[i] + aZ[i]*aZ[i];
+    const double bb  = bX[i]*bX[i] + bY[i]*bY[i] + bZ[i]*bZ[i];
+    const double tot = aa*bb;
+    const double c   = tot > 0. ? ab/std::sqrt(tot > 0. ? tot : 1.) : 1.;
+    angle[i] = Acos(c) * kToDeg;
+  }
+}
+
+TANGLE2_KERNEL
+void Tangle2AngleKernel::DeltaPhi(std::size_t n,
+                                  const double* TANGLE2_RESTRICT phiA,
+                                  const double* TANGLE2_RESTRICT phiB,
+                                  double* TANGLE2_RESTRICT dphi)
+{
+  for (std::size_t i = 0; i < n; i++) {
+    const double d = phiA[i] + phiB[i];
+    dphi[i] = d < 0 ? d + 360 : d;
+  }
+}
+
+void Tangle2AngleKernel::Compute(Tangle2AngleBatch& b)
+{
+  const std::size_t n = b.Size();
+  
+  b.theta.resize(n);
+  b.phi.resize(n);
+  
+  if (n == 0)
+    return;
+  
+  ThetaPhi(n,
+	   &b.beamX[0], &b.beamY[0], &b.beamZ[0],
+	   &b.preX[0],  &b.preY[0],  &b.preZ[0],
+	   &b.scatX[0], &b.scatY[0], &b.scatZ[0],
+	   &b.theta[0], &b.phi[0]);
+  
+  if (b.polPreX.empty()) {
+    b.thetaPol.clear();
+    return;
+  }
+  
+  // entries added without polarisation give 0
+  const std::size_t nPol = b.polPreX.size();
+  b.thetaPol.assign(n, 0.);
+  Angle(nPol,
+	&b.polPreX[0],  &b.polPreY[0],  &b.polPreZ[0],
+	&b.polPostX[0], &b.polPostY[0], &b.polPostZ[0],
+	&b.thetaPol[0]);
+}
+
+const char* Tangle2AngleKernel::InstructionSet()
+{
+#ifdef TANGLE2_KERNEL_DISPATCH
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return "avx512f";
+  if (__builtin_cpu_supports("avx2"))    return "avx2";
+  return "x86-64";
+#else
+  return "scalar";
+#endif
+}
@@ -0,0 +1,235 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2AsyncOutput.hh"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// The one writer thread.  Started with the first Tangle2AsyncOutput
+// and idle, without polling, while none is open.
+class Tangle2AsyncWriter
+{
+public:
+  static Tangle2AsyncWriter& Instance()
+  {
+    static Tangle2AsyncWriter writer;
+    return writer;
+  }
+
+  void Register(Tangle2AsyncOutput* output)
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fOutputs.push_back(output);
+    if (!fThread.joinable())
+      fThread = std::thread(&Tangle2AsyncWriter::Loop, this);
+    fWake.notify_one();
+  }
+
+  // Called by a worker whose ring is full or closing
+  void Wake() { fWake.notify_one(); }
+
+  // Waits until the writer has drained and closed output
+  void Unregister(Tangle2AsyncOutput* output)
+  {
+    std::unique_lock<std::mutex> lock(fMutex);
+    fWake.notify_one();
+    fClosedCv.wait(lock, [output]
+		   { return output->fClosed.load(std::memory_order_acquire); });
+  }
+
+private:
+  Tangle2AsyncWriter() : fStop(false) {}
+
+  ~Tangle2AsyncWriter()
+  {
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fStop = true;
+    }
+    fWake.notify_one();
+    if (fThread.joinable()) fThread.join();
+  }
+
+  void Loop()
+  {
+    std::vector<Tangle2AsyncOutput*> outputs;
+    std::unique_lock<std::mutex> lock(fMutex);
+    
+    while (!fStop) {
+      if (fOutputs.empty()) {
+	fWake.wait(lock);
+	continue;
+      }
+      outputs = fOutputs;
+      lock.unlock();
+      
+      std::size_t nWritten = 0;
+      std::vector<Tangle2AsyncOutput*> closed;
+      for (std::size_t i = 0; i < outputs.size(); i++) {
+	Tangle2AsyncOutput* output = outputs[i];
+	// read closing before draining: once set, nothing more is pushed
+	const bool closing = output->fClosing.load(std::memory_order_acquire);
+	const std::size_t n = output->Drain();
+	nWritten += n;
+	if (closing && n == 0) {
+	  output->fpOutput->Close();
+	  closed.push_back(output);
+	}
+      }
+      
+      lock.lock();
+      if (!closed.empty()) {
+	for (std::size_t i = 0; i < closed.size(); i++) {
+	  fOutputs.erase(std::find(fOutputs.begin(), fOutputs.end(),
+				   closed[i]));
+	  closed[i]->fClosed.store(true, std::memory_order_release);
+	}
+	fClosedCv.notify_all();
+      }
+      // nothing to do: sleep until woken, or look again in a while
+      // since pushes below the wake-up mark do not notify
+      if (nWritten == 0 && closed.empty() && !fStop && !fOutputs.empty())
+	fWake.wait_for(lock, std::chrono::milliseconds(2));
+    }
+  }
+
+  std::mutex fMutex;
+  std::condition_variable fWake;
+  std::condition_variable fClosedCv;
+  std::vector<Tangle2AsyncOutput*> fOutputs;
+  std::thread fThread;
+  bool fStop;
+};
+
+namespace {
+
+  std::size_t RoundUpToPowerOf2(std::size_t n)
+  {
+    std::size_t p = 2;
+    while (p < n) p <<= 1;
+    return p;
+  }
+
+  double Seconds(const std::chrono::steady_clock::duration& d)
+  {
+    return std::chrono::duration<double>(d).count();
+  }
+
+}
+
+Tangle2AsyncOutput::Tangle2AsyncOutput(Tangle2OutputBackend* output,
+				       std::size_t capacity)
+: fpOutput(output),
+  fSlots(RoundUpToPowerOf2(capacity)),
+  fMask(fSlots.size() - 1),
+  fHead(0), fTail(0),
+  fClosing(false), fClosed(true),
+  fOccupancySum(0.), fNPushes(0),
+  fLagSum(0.), fNWritten(0)
+{
+  fStatistics = Statistics();
+  fStatistics.capacity = fSlots.size();
+}
+
+Tangle2AsyncOutput::~Tangle2AsyncOutput()
+{
+  Close();
+  delete fpOutput;
+}
+
+std::string Tangle2AsyncOutput::DoOpen(const std::string& fileName)
+{
+  // the wrapped backend is opened here, in the calling thread
+  if (!fpOutput->Open(fileName)) return "";
+  
+  fHead.store(0, std::memory_order_relaxed);
+  fTail.store(0, std::memory_order_relaxed);
+  fClosing.store(false, std::memory_order_relaxed);
+  fClosed.store(false, std::memory_order_relaxed);
+  fOccupancySum = 0.;
+  fNPushes = 0;
+  fLagSum = 0.;
+  fNWritten = 0;
+  fStatistics = Statistics();
+  fStatistics.capacity = fSlots.size();
+  
+  Tangle2AsyncWriter::Instance().Register(this);
+  return fpOutput->GetFileName();
+}
+
+void Tangle2AsyncOutput::DoWrite(const Tangle2EventRecord& record)
+{
+  const std::size_t head = fHead.load(std::memory_order_relaxed);
+  
+  // back-pressure: wait for the writer thread to make space
+  if (head - fTail.load(std::memory_order_acquire) == fSlots.size()) {
+    const Clock::time_point start = Clock::now();
+    ++fStatistics.nStalls;
+    Tangle2AsyncWriter::Instance().Wake();
+    while (head - fTail.load(std::memory_order_acquire) == fSlots.size())
+      std::this_thread::yield();
+    fStatistics.stallSeconds += Seconds(Clock::now() - start);
+  }
+  
+  Slot& slot = fSlots[head & fMask];
+  slot.record = record;
+  slot.pushed = Clock::now();
+  fHead.store(head + 1, std::memory_order_release);
+  
+  const std::size_t occupancy
+    = head + 1 - fTail.load(std::memory_order_relaxed);
+  fStatistics.maxOccupancy = std::max(fStatistics.maxOccupancy, occupancy);
+  fOccupancySum += occupancy;
+  ++fNPushes;
+  
+  // wake the writer well before the ring fills
+  if (occupancy == fSlots.size()/2)
+    Tangle2AsyncWriter::Instance().Wake();
+}
+
+std::size_t Tangle2AsyncOutput::Drain()
+{
+  const std::size_t tail = fTail.load(std::memory_order_relaxed);
+  const std::size_t head = fHead.load(std::memory_order_acquire);
+  const std::size_t n = std::min(head - tail, kBatchSize);
+  if (n == 0) return 0;
+  
+  const Clock::time_point now = Clock::now();
+  for (std::size_t i = 0; i < n; i++) {
+    const Slot& slot = fSlots[(tail + i) & fMask];
+    fpOutput->Write(slot.record);
+    const double lag = Seconds(now - slot.pushed);
+    fLagSum += lag;
+    fStatistics.maxLagSeconds = std::max(fStatistics.maxLagSeconds, lag);
+  }
+  fNWritten += n;
+  ++fStatistics.nBatches;
+  
+  fTail.store(tail + n, std::memory_order_release);
+  return n;
+}
+
+void Tangle2AsyncOutput::DoClose()
+{
+  fClosing.store(true, std::memory_order_release);
+  Tangle2AsyncWriter::Instance().Unregister(this);
+  
+  fStatistics.meanOccupancy = fNPushes ? fOccupancySum/fNPushes : 0.;
+  fStatistics.meanLagSeconds = fNWritten ? fLagSum/fNWritten : 0.;
+  fStatistics.writerSeconds = fpOutput->GetSeconds();
+}
@@ -0,0 +1,251 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2Checkpoint.hh"
+
+#include "Tangle2Data.hh"
+#include "Tangle2RunAction.hh"
+
+#include "Randomize.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+  G4long NowMillis()
+  {
+    return std::chrono::duration_cast<std::chrono::milliseconds>
+      (std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+}
+
+Tangle2CheckpointState::Counts::Counts()
+: nEvents(0), nEventsPh(0), nEventsRejected(0), nEventsRejectedPh(0),
+  nDirectionTrials(0), nRows(0)
+{}
+
+void Tangle2CheckpointState::Counts::Add(const Counts& other)
+{
+  nEvents          += other.nEvents;
+  nEventsPh        += other.nEventsPh;
+  nEventsRejected  += other.nEventsRejected;
+  nEventsRejectedPh += other.nEventsRejectedPh;
+  nDirectionTrials += other.nDirectionTrials;
+  nRows            += other.nRows;
+}
+
+Tangle2CheckpointState::Tangle2CheckpointState()
+: checkpoint(0), resumes(0), complete(false), runEvents(0)
+{}
+
+// Written to a temporary file first, so a crash while writing leaves
+// the previous checkpoint in place
+G4bool Tangle2CheckpointState::Write(const G4String& fileName) const
+{
+  const G4String tmpName = fileName + ".tmp";
+  {
+    std::ofstream file(tmpName.c_str());
+    if (!file) return false;
+    file << "# Tangle2 checkpoint" << std::endl
+	 << "checkpoint " << checkpoint << std::endl
+	 << "resumes " << resumes << std::endl
+	 << "complete " << complete << std::endl
+	 << "runEvents " << runEvents << std::endl
+	 << "events " << counts.nEvents << std::endl
+	 << "eventsPh " << counts.nEventsPh << std::endl
+	 << "eventsRejected " << counts.nEventsRejected << std::endl
+	 << "eventsRejectedPh " << counts.nEventsRejectedPh << std::endl
+	 << "directionTrials " << counts.nDirectionTrials << std::endl
+	 << "rows " << counts.nRows << std::endl;
+    for (std::size_t i = 0; i < files.size(); i++)
+      file << "file " << files[i] << std::endl;
+    for (std::size_t i = 0; i < histograms.size(); i++)
+      file << "histograms " << histograms[i] << std::endl;
+    if (!file) return false;
+  }
+  return std::rename(tmpName.c_str(), fileName.c_str()) == 0;
+}
+
+G4bool Tangle2CheckpointState::Read(const G4String& fileName)
+{
+  std::ifstream file(fileName.c_str());
+  if (!file) return false;
+  
+  *this = Tangle2CheckpointState();
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream is(line);
+    std::string key;
+    is >> key;
+    if      (key == "checkpoint")      is >> checkpoint;
+    else if (key == "resumes")         is >> resumes;
+    else if (key == "complete")        is >> complete;
+    else if (key == "runEvents")       is >> runEvents;
+    else if (key == "events")          is >> counts.nEvents;
+    else if (key == "eventsPh")        is >> counts.nEventsPh;
+    else if (key == "eventsRejected")  is >> counts.nEventsRejected;
+    else if (key == "eventsRejectedPh") is >> counts.nEventsRejectedPh;
+    else if (key == "directionTrials") is >> counts.nDirectionTrials;
+    else if (key == "rows")            is >> counts.nRows;
+    else if (key == "file") {
+      std::string name;
+      is >> name;
+      files.push_back(name);
+    }
+    else if (key == "histograms") {
+      std::string name;
+      is >> name;
+      histograms.push_back(name);
+    }
+  }
+  return runEvents > 0;
+}
+
+Tangle2Checkpoint::Tangle2Checkpoint()
+: fEnabled(false), fFirst(0), fEveryEvents(0), fEveryMinutes(0.),
+  fNEvents(0), fCheckpoint(0), fLastMillis(0)
+{}
+
+G4String Tangle2Checkpoint::StateFileName()
+{
+  return Tangle2::outputName + "_checkpoint.txt";
+}
+
+G4String Tangle2Checkpoint::MasterEngineFileName()
+{
+  return Tangle2::outputName + "_master.rndm";
+}
+
+G4bool Tangle2Checkpoint::IsPossible()
+{
+  return !Tangle2::ntupleOutput ||
+    Tangle2RunAction::GetOutputFormat() != Tangle2::kOutputG4Root;
+}
+
+void Tangle2Checkpoint::BeginOfRun(G4long nEventsToBeProcessed,
+				   const Tangle2CheckpointState* resume)
+{
+  fEveryEvents  = Tangle2::checkpointEvents;
+  fEveryMinutes = Tangle2::checkpointMinutes;
+  fEnabled = fEveryEvents > 0 || fEveryMinutes > 0. || resume;
+  if (fEnabled && !IsPossible()) {
+    G4cout << " Tangle2Checkpoint: g4root output is only written at the"
+	   << " end of the run, no checkpoints (use hdf5 or rntuple)"
+	   << G4endl;
+    fEnabled = false;
+  }
+  
+  fBase = resume ? *resume : Tangle2CheckpointState();
+  if (!resume)
+    fBase.runEvents = nEventsToBeProcessed;
+  fBase.complete = false;
+  // files from an interrupted checkpoint are not in the list and
+  // are overwritten
+  fFirst = resume ? resume->checkpoint + 1 : 0;
+  
+  fNEvents = 0;
+  fCheckpoint = fFirst;
+  fLastMillis = NowMillis();
+  
+  fState = fBase;
+  fState.checkpoint = fFirst;
+  fThreadCounts.clear();
+  fThreadHistograms.clear();
+  
+  if (!fEnabled) return;
+  
+  // before the master draws the seeds for the events of this run
+  G4Random::saveEngineStatus(MasterEngineFileName().c_str());
+  if (!fState.Write(StateFileName()))
+    G4cout << " Tangle2Checkpoint: can not write " << StateFileName()
+	   << G4endl;
+}
+
+G4int Tangle2Checkpoint::Count()
+{
+  const G4long n = fNEvents.fetch_add(1, std::memory_order_relaxed);
+  if (n > 0) {
+    G4bool due = fEveryEvents > 0 && n % fEveryEvents == 0;
+    // the clock only every so often
+    if (!due && fEveryMinutes > 0. && n % 64 == 0) {
+      const G4long now = NowMillis();
+      G4long last = fLastMillis.load();
+      due = now - last >= fEveryMinutes*60000. &&
+	fLastMillis.compare_exchange_strong(last, now);
+    }
+    if (due) {
+      fLastMillis = NowMillis();
+      fCheckpoint.fetch_add(1);
+    }
+  }
+  return fCheckpoint.load();
+}
+
+void Tangle2Checkpoint::Record(G4int threadID,
+			       const Tangle2CheckpointState::Counts& counts,
+			       const G4String& closedFile,
+			       const G4String& histogramFile)
+{
+  if (!fEnabled) return;
+  
+  // the master is thread ID -1
+  const std::size_t slot = threadID + 1;
+  if (fThreadCounts.size() <= slot) {
+    fThreadCounts.resize(slot + 1);
+    fThreadHistograms.resize(slot + 1);
+  }
+  fThreadCounts[slot] = counts;
+  if (!closedFile.empty())
+    fState.files.push_back(closedFile);
+  const G4String previousHistograms = fThreadHistograms[slot];
+  if (!histogramFile.empty())
+    fThreadHistograms[slot] = histogramFile;
+  
+  fState.counts = fBase.counts;
+  for (std::size_t i = 0; i < fThreadCounts.size(); i++)
+    fState.counts.Add(fThreadCounts[i]);
+  fState.histograms = fBase.histograms;
+  for (std::size_t i = 0; i < fThreadHistograms.size(); i++)
+    if (!fThreadHistograms[i].empty())
+      fState.histograms.push_back(fThreadHistograms[i]);
+  fState.checkpoint = fCheckpoint.load();
+  
+  if (!fState.Write(StateFileName())) {
+    G4cout << " Tangle2Checkpoint: can not write " << StateFileName()
+	   << G4endl;
+    return;
+  }
+  // no longer listed
+  if (!previousHistograms.empty() &&
+      previousHistograms != fThreadHistograms[slot])
+    std::remove(previousHistograms.c_str());
+}
+
+void Tangle2Checkpoint::EndOfRun()
+{
+  if (!fEnabled) return;
+  
+  fState.complete = true;
+  fState.Write(StateFileName());
+  G4cout << " Checkpoints " << fFirst << " to " << fState.checkpoint
+	 << ", " << fState.counts.nEvents << " of " << fState.runEvents
+	 << " events in " << fState.files.size() << " files, see "
+	 << StateFileName() << G4endl;
+}
@@ -0,0 +1,161 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2CheckpointMessenger.hh"
+
+#include "Tangle2Data.hh"
+#include "Tangle2Checkpoint.hh"
+#include "Tangle2Shard.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4RunManager.hh"
+#include "Randomize.hh"
+
+#include <fstream>
+#include <stdint.h>
+
+namespace {
+
+  // SplitMix64 finaliser
+  uint64_t Mix(uint64_t x)
+  {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30))*0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27))*0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+
+}
+
+Tangle2CheckpointMessenger::Tangle2CheckpointMessenger()
+{
+  fpDirectory = new G4UIdirectory("/tangle2/checkpoint/");
+  fpDirectory->SetGuidance("Checkpoints during long runs.");
+  
+  fpEventsCmd = new G4UIcmdWithAnInteger("/tangle2/checkpoint/events", this);
+  fpEventsCmd->SetGuidance("Checkpoint every N events, 0 for none.");
+  fpEventsCmd->SetParameterName("N", false);
+  fpEventsCmd->SetRange("N >= 0");
+  fpEventsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  
+  fpMinutesCmd = new G4UIcmdWithADouble("/tangle2/checkpoint/minutes", this);
+  fpMinutesCmd->SetGuidance("Checkpoint every T minutes, 0 for none.");
+  fpMinutesCmd->SetParameterName("T", false);
+  fpMinutesCmd->SetRange("T >= 0.");
+  fpMinutesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  
+  fpResumeCmd = new G4UIcmdWithoutParameter("/tangle2/checkpoint/resume",
+					    this);
+  fpResumeCmd->SetGuidance("Run the rest of the events of an interrupted");
+  fpResumeCmd->SetGuidance("run from its last checkpoint, with new seeds.");
+  fpResumeCmd->AvailableForStates(G4State_Idle);
+  
+  // Shared settings, on the master only
+  fpEventsCmd->SetToBeBroadcasted(false);
+  fpMinutesCmd->SetToBeBroadcasted(false);
+  fpResumeCmd->SetToBeBroadcasted(false);
+}
+
+Tangle2CheckpointMessenger::~Tangle2CheckpointMessenger()
+{
+  delete fpResumeCmd;
+  delete fpMinutesCmd;
+  delete fpEventsCmd;
+  delete fpDirectory;
+}
+
+void Tangle2CheckpointMessenger::SetNewValue(G4UIcommand* command,
+					     G4String newValue)
+{
+  if (command == fpEventsCmd)
+    Tangle2::checkpointEvents = fpEventsCmd->GetNewIntValue(newValue);
+  else if (command == fpMinutesCmd)
+    Tangle2::checkpointMinutes = fpMinutesCmd->GetNewDoubleValue(newValue);
+  else if (command == fpResumeCmd)
+    Resume();
+}
+
+G4String Tangle2CheckpointMessenger::GetCurrentValue(G4UIcommand* command)
+{
+  if (command == fpEventsCmd)
+    return fpEventsCmd->ConvertToString(G4int(Tangle2::checkpointEvents));
+  if (command == fpMinutesCmd)
+    return fpMinutesCmd->ConvertToString(Tangle2::checkpointMinutes);
+  return "";
+}
+
+void Tangle2CheckpointMessenger::Resume()
+{
+  if (!Tangle2Checkpoint::IsPossible()) {
+    G4cout << " Tangle2CheckpointMessenger: can not resume with g4root"
+	   << " output" << G4endl;
+    return;
+  }
+  const G4String stateFile = Tangle2Checkpoint::StateFileName();
+  Tangle2CheckpointState state;
+  if (!state.Read(stateFile)) {
+    G4cout << " Tangle2CheckpointMessenger: no checkpoint in "
+	   << stateFile << G4endl;
+    return;
+  }
+  if (state.complete) {
+    G4cout << " Tangle2CheckpointMessenger: the run in " << stateFile
+	   << " is complete" << G4endl;
+    return;
+  }
+  const G4long nRemaining = state.runEvents - state.counts.nEvents;
+  state.resumes += 1;
+  
+  // A shard takes the next stream of its campaign (see Tangle2Shard).
+  // Otherwise the previous run's master engine, as at its start, mixed
+  // with the number of resumes: neither its events nor those of an
+  // earlier resume are repeated
+  G4long seeds[2] = { 0, 0 };
+  if (Tangle2::nShards > 0)
+    Tangle2Shard::SeedStream(state.resumes);
+  else {
+    const G4String engineFile = Tangle2Checkpoint::MasterEngineFileName();
+    if (std::ifstream(engineFile.c_str()))
+      G4Random::restoreEngineStatus(engineFile.c_str());
+    else
+      G4cout << " Tangle2CheckpointMessenger: no " << engineFile
+	     << ", seeds from the current engine" << G4endl;
+    for (G4int i = 0; i < 2; i++) {
+      const uint64_t draw = uint64_t(G4UniformRand()*4294967296.);
+      // positive and non-zero, for RanecuEngine
+      seeds[i] = G4long(Mix(draw ^ (uint64_t(state.resumes) << 32)) >> 34)
+	+ 1;
+    }
+    G4Random::setTheSeeds(seeds);
+  }
+  
+  G4cout << " Resuming from checkpoint " << state.checkpoint << ": "
+	 << state.counts.nEvents << " of " << state.runEvents
+	 << " events done, " << state.files.size() << " files, "
+	 << state.histograms.size() << " histogram files;"
+	 << " resume " << state.resumes;
+  if (Tangle2::nShards > 0)
+    G4cout << ", MixMaxRng stream of shard " << Tangle2::shardIndex;
+  else
+    G4cout << ", seeds " << seeds[0] << " " << seeds[1];
+  G4cout << G4endl;
+  
+  Tangle2::checkpointResume = &state;
+  G4RunManager::GetRunManager()->BeamOn(G4int(nRemaining));
+  Tangle2::checkpointResume = 0;
+}
@@ -0,0 +1,102 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2ComptonSampler.hh"
+
+namespace {
+
+  double Dot(const double a[3], const double b[3])
+  {
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+  }
+
+  void Cross(const double a[3], const double b[3], double c[3])
+  {
+    c[0] = a[1]*b[2] - a[2]*b[1];
+    c[1] = a[2]*b[0] - a[0]*b[2];
+    c[2] = a[0]*b[1] - a[1]*b[0];
+  }
+
+  void Normalise(double a[3])
+  {
+    const double m = std::sqrt(Dot(a, a));
+    if (m > 0.)
+      for (int i = 0; i < 3; i++) a[i] *= 1./m;
+  }
+
+}
+
+bool Tangle2ComptonSampler::PerpendicularPolarisation
+(const double direction[3], const double polarisation[3], double pol0[3])
+{
+  const double d = Dot(polarisation, direction);
+  for (int i = 0; i < 3; i++) pol0[i] = polarisation[i] - d*direction[i];
+  if (Dot(pol0, pol0) < 1.e-12) return false;
+  Normalise(pol0);
+  return true;
+}
+
+void Tangle2ComptonSampler::RandomPolarisation(const double direction[3],
+					       double phi0, double pol0[3])
+{
+  // a perpendicular to direction as CLHEP Hep3Vector::orthogonal
+  const double x = direction[0], y = direction[1], z = direction[2];
+  const double ax = std::fabs(x), ay = std::fabs(y), az = std::fabs(z);
+  double a[3] = {y, -x, 0.};
+  if (ax < ay && ax < az) {
+    a[0] = 0.; a[1] = z; a[2] = -y;
+  } else if (ax >= ay && ay < az) {
+    a[0] = -z; a[1] = 0.; a[2] = x;
+  }
+  Normalise(a);
+  double b[3];
+  Cross(direction, a, b);
+  for (int i = 0; i < 3; i++)
+    pol0[i] = std::cos(phi0)*a[i] + std::sin(phi0)*b[i];
+  Normalise(pol0);
+}
+
+void Tangle2ComptonSampler::Scatter(double cosTheta, double sinTheta,
+				    double cosPhi, double sinPhi,
+				    double cosBeta, double sinBeta,
+				    const double pol0[3],
+				    double direction[3],
+				    double polarisation[3])
+{
+  const double sint2         = sinTheta*sinTheta;
+  const double normalisation = std::sqrt(1. - cosPhi*cosPhi*sint2);
+  
+  // New polarisation in the frame x = pol0, z = direction
+  const double polX = normalisation*cosBeta;
+  const double polY =
+    (-(sint2*cosPhi*sinPhi)*cosBeta + cosTheta*sinBeta)/normalisation;
+  const double polZ =
+    (-(cosTheta*sinTheta*cosPhi)*cosBeta - sinTheta*sinPhi*sinBeta)
+    /normalisation;
+  
+  double axisZ[3] = {direction[0], direction[1], direction[2]};
+  Normalise(axisZ);
+  double axisY[3];
+  Cross(axisZ, pol0, axisY);
+  Normalise(axisY);
+  
+  for (int i = 0; i < 3; i++) {
+    direction[i] = sinTheta*cosPhi*pol0[i] + sinTheta*sinPhi*axisY[i] +
+      cosTheta*axisZ[i];
+    polarisation[i] = polX*pol0[i] + polY*axisY[i] + polZ*axisZ[i];
+  }
+  Normalise(direction);
+  Normalise(polarisation);
+}
@@ -0,0 +1,166 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2Config.hh"
+
+#include "Tangle2Data.hh"
+
+#include "G4Exception.hh"
+
+namespace {
+  Tangle2Config theConfig;
+  G4bool frozen = false;
+}
+
+const Tangle2Config& Tangle2::config = theConfig;
+
+Tangle2Config::Tangle2Config()
+: positrons(true)
+, fixedAxis(false)
+, perpPol(false)
+, polYZ(false)
+, acceptanceSampling(false)
+, polarisedCompton(true)
+, fullPET(false)
+, fastReject(false)
+, outputFormat(Tangle2::kOutputG4Root)
+, asyncOutput(true)
+{}
+
+Tangle2Config& Tangle2Config::Modify()
+{
+  if (frozen)
+    G4Exception("Tangle2Config::Modify", "Tangle2Config0001",
+		FatalException,
+		"Configuration is frozen after /run/initialize.");
+  return theConfig;
+}
+
+void Tangle2Config::Freeze()
+{
+  if (frozen) return;
+  
+  // safety
+  if (theConfig.polYZ)
+    theConfig.perpPol = true;
+  
+  frozen = true;
+  theConfig.Print();
+}
+
+G4bool Tangle2Config::IsFrozen()
+{
+  return frozen;
+}
+
+G4bool Tangle2Config::Set(const G4String& name, const G4String& value)
+{
+  if (name == "output") {
+    if      (value == "g4root")  outputFormat = Tangle2::kOutputG4Root;
+    else if (value == "hdf5")    outputFormat = Tangle2::kOutputHdf5;
+    else if (value == "rntuple") outputFormat = Tangle2::kOutputRNTuple;
+    else return false;
+    return true;
+  }
+  
+  G4bool* flag = 0;
+  if      (name == "positrons")          flag = &positrons;
+  else if (name == "fixedAxis")          flag = &fixedAxis;
+  else if (name == "perpPol")            flag = &perpPol;
+  else if (name == "polYZ")              flag = &polYZ;
+  else if (name == "acceptanceSampling") flag = &acceptanceSampling;
+  else if (name == "polarisedCompton")   flag = &polarisedCompton;
+  else if (name == "fullPET")            flag = &fullPET;
+  else if (name == "fastReject")         flag = &fastReject;
+  else if (name == "asyncOutput")        flag = &asyncOutput;
+  else return false;
+  
+  if      (value == "true"  || value == "1") *flag = true;
+  else if (value == "false" || value == "0") *flag = false;
+  else return false;
+  return true;
+}
+
+G4bool Tangle2Config::Reconfigure(const Tangle2Config& next,
+				  G4bool& geometryChanged)
+{
+  geometryChanged = false;
+  if (next.polarisedCompton != theConfig.polarisedCompton) {
+    G4cout << " Tangle2Config: the physics (polarisedCompton) can only"
+	   << " be set before /run/initialize" << G4endl;
+    return false;
+  }
+  
+  geometryChanged = next.fullPET != theConfig.fullPET;
+  theConfig = next;
+  
+  // safety
+  if (theConfig.polYZ)
+    theConfig.perpPol = true;
+  
+  return true;
+}
+
+void Tangle2Config::Print() const
+{
+  G4cout << " ------------------------------------------ " << G4endl;
+  G4cout << " QETlab simulation " << G4endl;
+  G4cout <<  G4endl;
+
+  if(fullPET){
+    G4cout << " Human PET diameter " << G4endl;
+  }
+  else{
+    G4cout << " Lab experiment diameter " << G4endl;
+  }
+    
+  G4cout <<  G4endl;
+  G4cout << " Generated : " << G4endl;
+  
+  // Print beam choices to screen
+  if(positrons)
+    G4cout << " Positrons " << G4endl;
+  else{
+    G4cout << " Back to back gammas. " << G4endl;
+    if(fixedAxis)
+      G4cout << " On a fixed axis, " << G4endl;
+    else
+      G4cout << " Covering detector area, " << G4endl;
+    if(perpPol)
+      G4cout << " with perpendicular polarisation. " << G4endl;
+    else
+      G4cout << " with random relative polarisation. " << G4endl;
+  }
+  if(polarisedCompton)
+    G4cout << " Polarized Compton scattering " << G4endl;
+  else
+    G4cout << " UnPolarized Compton scattering " << G4endl;
+  if(fastReject)
+    G4cout << " Fast reject of non double Compton events " << G4endl;
+  if(acceptanceSampling && !positrons && !fixedAxis)
+    G4cout << " Beam axes restricted to the array acceptance " << G4endl;
+  if(Tangle2::fastSimMode == Tangle2::kFastSimOn)
+    G4cout << " Fast simulation of gammas in the crystals " << G4endl;
+  else if(Tangle2::fastSimMode == Tangle2::kFastSimValidate)
+    G4cout << " Fast simulation validation (even events fast) " << G4endl;
+  if(outputFormat == Tangle2::kOutputHdf5)
+    G4cout << " HDF5 output " << G4endl;
+  else if(outputFormat == Tangle2::kOutputRNTuple)
+    G4cout << " RNTuple output " << G4endl;
+  if(outputFormat != Tangle2::kOutputG4Root && asyncOutput)
+    G4cout << " written by a separate thread " << G4endl;
+     
+  G4cout << " ------------------------------------------ " << G4endl;
+}
@@ -0,0 +1,139 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2ConfigMessenger.hh"
+
+#include "Tangle2Data.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4VModularPhysicsList.hh"
+#include "G4EmLivermorePolarizedPhysics.hh"
+#include "G4EmLivermorePhysics.hh"
+
+Tangle2ConfigMessenger::Tangle2ConfigMessenger
+(G4VModularPhysicsList* physList)
+: fpPhysList(physList)
+{
+  fpDirectory = new G4UIdirectory("/tangle2/config/");
+  fpDirectory->SetGuidance("Run configuration, before /run/initialize.");
+  
+  AddBool("positrons", &Tangle2Config::positrons,
+	  "Positrons, else back to back gammas.");
+  AddBool("fixedAxis", &Tangle2Config::fixedAxis,
+	  "Back to back gammas on a fixed axis.");
+  AddBool("perpPol", &Tangle2Config::perpPol,
+	  "Perpendicular polarisation, else random relative.");
+  AddBool("polYZ", &Tangle2Config::polYZ,
+	  "Polarisation in y,z (implies perpPol).");
+  AddBool("acceptanceSampling", &Tangle2Config::acceptanceSampling,
+	  "Gamma axes restricted to the array acceptance, with weights.");
+  AddBool("polarisedCompton", &Tangle2Config::polarisedCompton,
+	  "Livermore polarised, else unpolarised, EM physics.");
+  fpPolarisedComptonCmd = fBoolCmds.back();
+  AddBool("fullPET", &Tangle2Config::fullPET,
+	  "Arrays 90 cm apart, else 6 cm apart.");
+  AddBool("fastReject", &Tangle2Config::fastReject,
+	  "Abort events when the first gamma out has no Compton.");
+  AddBool("asyncOutput", &Tangle2Config::asyncOutput,
+	  "Write hdf5 and rntuple from a separate thread.");
+  
+  fpOutputCmd = new G4UIcmdWithAString("/tangle2/config/output", this);
+  fpOutputCmd->SetGuidance("Format of the selected-event output.");
+  fpOutputCmd->SetParameterName("format", false);
+  fpOutputCmd->SetCandidates("g4root hdf5 rntuple");
+  fpOutputCmd->AvailableForStates(G4State_PreInit);
+  fpOutputCmd->SetToBeBroadcasted(false);
+  
+  fpPrintCmd = new G4UIcmdWithoutParameter("/tangle2/config/print", this);
+  fpPrintCmd->SetGuidance("Print the configuration.");
+  fpPrintCmd->SetToBeBroadcasted(false);
+}
+
+Tangle2ConfigMessenger::~Tangle2ConfigMessenger()
+{
+  delete fpPrintCmd;
+  delete fpOutputCmd;
+  for (std::size_t i = 0; i < fBoolCmds.size(); i++)
+    delete fBoolCmds[i];
+  delete fpDirectory;
+}
+
+void Tangle2ConfigMessenger::AddBool(const char* name,
+				     G4bool Tangle2Config::* flag,
+				     const char* guidance)
+{
+  G4UIcmdWithABool* command
+    = new G4UIcmdWithABool(G4String("/tangle2/config/") + name, this);
+  command->SetGuidance(guidance);
+  command->SetParameterName(name, false);
+  // Frozen at /run/initialize
+  command->AvailableForStates(G4State_PreInit);
+  // Tangle2::config is shared, so set it on the master only
+  command->SetToBeBroadcasted(false);
+  fBoolCmds.push_back(command);
+  fBoolFlags.push_back(flag);
+}
+
+void Tangle2ConfigMessenger::SetEmPhysics()
+{
+  if (Tangle2::config.polarisedCompton)
+    fpPhysList->ReplacePhysics(new G4EmLivermorePolarizedPhysics);
+  else
+    fpPhysList->ReplacePhysics(new G4EmLivermorePhysics);
+}
+
+void Tangle2ConfigMessenger::SetNewValue(G4UIcommand* command,
+					 G4String newValue)
+{
+  for (std::size_t i = 0; i < fBoolCmds.size(); i++) {
+    if (command == fBoolCmds[i]) {
+      Tangle2Config::Modify().*fBoolFlags[i]
+	= fBoolCmds[i]->GetNewBoolValue(newValue);
+      if (command == fpPolarisedComptonCmd)
+	SetEmPhysics();
+      return;
+    }
+  }
+  
+  if (command == fpOutputCmd) {
+    if (newValue == "hdf5")
+      Tangle2Config::Modify().outputFormat = Tangle2::kOutputHdf5;
+    else if (newValue == "rntuple")
+      Tangle2Config::Modify().outputFormat = Tangle2::kOutputRNTuple;
+    else
+      Tangle2Config::Modify().outputFormat = Tangle2::kOutputG4Root;
+  }
+  else if (command == fpPrintCmd)
+    Tangle2::config.Print();
+}
+
+G4String Tangle2ConfigMessenger::GetCurrentValue(G4UIcommand* command)
+{
+  for (std::size_t i = 0; i < fBoolCmds.size(); i++)
+    if (command == fBoolCmds[i])
+      return fBoolCmds[i]->ConvertToString(Tangle2::config.*fBoolFlags[i]);
+  
+  if (command == fpOutputCmd) {
+    switch (Tangle2::config.outputFormat) {
+    case Tangle2::kOutputHdf5:    return "hdf5";
+    case Tangle2::kOutputRNTuple: return "rntuple";
+    default:                      return "g4root";
+    }
+  }
+  return "";
+}
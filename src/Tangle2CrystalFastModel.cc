@@ -0,0 +1,214 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2CrystalFastModel.hh"
+
+#include "Tangle2Data.hh"
+#include "Tangle2ComptonSampler.hh"
+#include "Tangle2SteppingAction.hh"
+
+#include "G4FastTrack.hh"
+#include "G4FastStep.hh"
+#include "G4Gamma.hh"
+#include "G4Material.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4AffineTransform.hh"
+#include "G4EmCalculator.hh"
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <cfloat>
+
+namespace {
+  const G4int    kNTableBins = 400;
+  const G4double kTableEMin  = 1*keV;
+  const G4double kTableEMax  = 1*MeV;
+}
+
+Tangle2CrystalFastModel::Tangle2CrystalFastModel(const G4String& name,
+						 G4Region* envelope)
+: G4VFastSimulationModel(name, envelope),
+  fpTableMaterial(0),
+  fLogEMin(std::log(kTableEMin)),
+  fLogEMax(std::log(kTableEMax)),
+  fDLogE((fLogEMax - fLogEMin)/kNTableBins),
+  fEnergyCut(1*keV),
+  fpSteppingAction(0)
+{}
+
+Tangle2CrystalFastModel::~Tangle2CrystalFastModel()
+{}
+
+G4bool Tangle2CrystalFastModel::IsApplicable
+(const G4ParticleDefinition& particle)
+{
+  return &particle == G4Gamma::Definition();
+}
+
+G4bool Tangle2CrystalFastModel::ModelTrigger(const G4FastTrack&)
+{
+  // set per event by Tangle2EventAction from Tangle2::fastSimMode
+  return Tangle2::fastSimEvent;
+}
+
+void Tangle2CrystalFastModel::BuildTables(const G4Material* material)
+{
+  G4EmCalculator calculator;
+  const G4ParticleDefinition* gamma = G4Gamma::Definition();
+  
+  fMuCompt.resize(kNTableBins + 1);
+  fMuPhot.resize(kNTableBins + 1);
+  
+  for (G4int i = 0; i <= kNTableBins; i++) {
+    G4double energy = std::exp(fLogEMin + i*fDLogE);
+    fMuCompt[i] = calculator.ComputeCrossSectionPerVolume
+      (energy, gamma, "compt", material);
+    fMuPhot[i]  = calculator.ComputeCrossSectionPerVolume
+      (energy, gamma, "phot", material);
+  }
+  
+  fpTableMaterial = material;
+}
+
+void Tangle2CrystalFastModel::GetMu(G4double energy,
+				    G4double& muCompt,
+				    G4double& muPhot) const
+{
+  // linear interpolation in log(E)
+  G4double x = (std::log(energy) - fLogEMin)/fDLogE;
+  if (x < 0.) x = 0.;
+  if (x > kNTableBins) x = kNTableBins;
+  G4int    i = std::min(G4int(x), kNTableBins - 1);
+  G4double f = x - i;
+  
+  muCompt = (1. - f)*fMuCompt[i] + f*fMuCompt[i+1];
+  muPhot  = (1. - f)*fMuPhot[i]  + f*fMuPhot[i+1];
+}
+
+void Tangle2CrystalFastModel::DoIt(const G4FastTrack& fastTrack,
+				   G4FastStep& fastStep)
+{
+  const G4Track* track = fastTrack.GetPrimaryTrack();
+  
+  const G4Material* material
+    = fastTrack.GetEnvelopeLogicalVolume()->GetMaterial();
+  if (material != fpTableMaterial)
+    BuildTables(material);
+  
+  if (!fpSteppingAction)
+    fpSteppingAction = dynamic_cast<Tangle2SteppingAction*>
+      (const_cast<G4UserSteppingAction*>
+       (G4RunManager::GetRunManager()->GetUserSteppingAction()));
+  
+  const G4VSolid* solid = fastTrack.GetEnvelopeSolid();
+  // world -> crystal and crystal -> world
+  const G4AffineTransform* toLocal  = fastTrack.GetAffineTransformation();
+  const G4AffineTransform* toGlobal
+    = fastTrack.GetInverseAffineTransformation();
+  
+  G4int trackID = track->GetTrackID();
+  G4int copyNo  = track->GetVolume()->GetCopyNo();
+  
+  G4ThreeVector position     = fastTrack.GetPrimaryTrackLocalPosition();
+  G4ThreeVector direction    = fastTrack.GetPrimaryTrackLocalDirection();
+  G4ThreeVector polarisation = toLocal->TransformAxis(track->GetPolarization());
+  G4double      energy       = track->GetKineticEnergy();
+  
+  G4double eDep     = 0.;
+  G4double path     = 0.;
+  G4bool   absorbed = false;
+  
+  while (true) {
+    
+    G4double muCompt, muPhot;
+    GetMu(energy, muCompt, muPhot);
+    G4double muTotal = muCompt + muPhot;
+    
+    G4double distanceOut = solid->DistanceToOut(position, direction);
+    G4double distance    = DBL_MAX;
+    if (muTotal > 0.)
+      distance = -std::log(1. - G4UniformRand())/muTotal;
+    
+    // escape - hand back to Geant4 on the crystal surface
+    if (distance >= distanceOut) {
+      position += distanceOut*direction;
+      path     += distanceOut;
+      break;
+    }
+    
+    position += distance*direction;
+    path     += distance;
+    
+    G4ThreeVector globalPosition = toGlobal->TransformPoint(position);
+    
+    // photoabsorption
+    if (G4UniformRand()*muTotal < muPhot) {
+      eDep    += energy;
+      energy   = 0.;
+      absorbed = true;
+      if (fpSteppingAction)
+	fpSteppingAction->RecordPhoto(trackID, copyNo, globalPosition);
+      break;
+    }
+    
+    // Compton scattering
+    G4ThreeVector preDirection    = direction;
+    G4ThreeVector prePolarisation = polarisation;
+    G4double      preEnergy       = energy;
+    
+    // polarised Klein-Nishina, in MeV
+    G4double energyMeV = energy/MeV;
+    G4double dir[3] = {direction.x(), direction.y(), direction.z()};
+    G4double pol[3] = {polarisation.x(), polarisation.y(), polarisation.z()};
+    Tangle2ComptonSampler::Sample(energyMeV, dir, pol,
+				  [] { return G4UniformRand(); });
+    energy = energyMeV*MeV;
+    direction.set(dir[0], dir[1], dir[2]);
+    polarisation.set(pol[0], pol[1], pol[2]);
+    eDep += preEnergy - energy;
+    
+    if (fpSteppingAction)
+      fpSteppingAction->RecordCompton
+	(trackID, copyNo, globalPosition,
+	 toGlobal->TransformAxis(preDirection),
+	 toGlobal->TransformAxis(direction),
+	 toGlobal->TransformAxis(prePolarisation),
+	 toGlobal->TransformAxis(polarisation));
+    
+    if (energy < fEnergyCut) {
+      eDep    += energy;
+      energy   = 0.;
+      absorbed = true;
+      break;
+    }
+  }
+  
+  // the deposit is picked up by Tangle2CrystalSD
+  fastStep.ProposeTotalEnergyDeposited(eDep);
+  fastStep.ProposePrimaryTrackPathLength(path);
+  fastStep.ProposePrimaryTrackFinalTime(track->GetGlobalTime() + path/c_light);
+  
+  if (absorbed) {
+    fastStep.KillPrimaryTrack();
+    return;
+  }
+  
+  fastStep.ProposePrimaryTrackFinalPosition(position);
+  fastStep.ProposePrimaryTrackFinalMomentumDirection(direction);
+  fastStep.ProposePrimaryTrackFinalPolarization(polarisation);
+  fastStep.ProposePrimaryTrackFinalKineticEnergy(energy);
+}
@@ -0,0 +1,26 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2CrystalHit.hh"
+
+G4ThreadLocal G4Allocator<Tangle2CrystalHit>* Tangle2CrystalHitAllocator = 0;
+
+Tangle2CrystalHit::Tangle2CrystalHit()
+: G4VHit(),
+  fEdep(0.)
+{}
+
+Tangle2CrystalHit::~Tangle2CrystalHit()
+{}
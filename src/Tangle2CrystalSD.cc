@@ -0,0 +1,65 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2CrystalSD.hh"
+
+#include "G4HCofThisEvent.hh"
+#include "G4Step.hh"
+#include "G4SDManager.hh"
+
+Tangle2CrystalSD::Tangle2CrystalSD(const G4String& name,
+				   const G4String& hitsCollectionName,
+				   G4int nCrystals)
+: G4VSensitiveDetector(name),
+  fHitsCollection(0),
+  fNCrystals(nCrystals)
+{
+  collectionName.insert(hitsCollectionName);
+}
+
+Tangle2CrystalSD::~Tangle2CrystalSD()
+{}
+
+void Tangle2CrystalSD::Initialize(G4HCofThisEvent* hce)
+{
+  fHitsCollection 
+    = new Tangle2CrystalHitsCollection(SensitiveDetectorName,
+				       collectionName[0]);
+  
+  G4int hcID 
+    = G4SDManager::GetSDMpointer()->GetCollectionID(fHitsCollection);
+  hce->AddHitsCollection(hcID, fHitsCollection);
+  
+  // one hit per crystal, index = copy number
+  for (G4int i = 0; i < fNCrystals; i++)
+    fHitsCollection->insert(new Tangle2CrystalHit());
+}
+
+G4bool Tangle2CrystalSD::ProcessHits(G4Step* step, G4TouchableHistory*)
+{
+  G4double eDep = step->GetTotalEnergyDeposit();
+  
+  if (eDep == 0.)
+    return false;
+  
+  G4int copyNo = step->GetPreStepPoint()->GetTouchable()->GetCopyNumber();
+  
+  if (copyNo < 0 || copyNo >= fNCrystals)
+    return false;
+  
+  (*fHitsCollection)[copyNo]->AddEdep(eDep);
+  
+  return true;
+}
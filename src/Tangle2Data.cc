@@ -1,18 +1,45 @@
 #include "Tangle2Data.hh"
 
-G4bool Tangle2::positrons = false;
-G4bool Tangle2::fixedAxis = false;
-G4bool Tangle2::perpPol   = false;
-G4bool Tangle2::polYZ     = false;
-G4bool Tangle2::fullPET   = false;
+G4int  Tangle2::fastSimMode = Tangle2::kFastSimOff;
+G4bool Tangle2::ntupleOutput = true;
+G4String Tangle2::outputName = "Tangle2";
+G4long Tangle2::checkpointEvents = 0;
+G4double Tangle2::checkpointMinutes = 0.;
+const Tangle2CheckpointState* Tangle2::checkpointResume = 0;
+G4double Tangle2::telemetryInterval = 30.;
+G4bool Tangle2::telemetryConsole = true;
+G4bool Tangle2::profileSteps = false;
+G4int  Tangle2::shardIndex = 0;
+G4int  Tangle2::nShards = 0;
+G4long Tangle2::campaignSeed = 0;
+G4long Tangle2::eventIDOffset = 0;
+G4int  Tangle2::forkProcess = -1;
+G4long Tangle2::forkFirstEvent = 0;
+G4long Tangle2::forkRunEvents = 0;
+Tangle2Selection Tangle2::selection;
+std::vector<Tangle2Histogram> Tangle2::histograms;
 
 // For runs with multi-threading
-G4int Tangle2::nMasterEventsPh = 0;
-G4int Tangle2::nMasterEvents = 0;
+G4long Tangle2::nMasterEventsPh = 0;
+G4long Tangle2::nMasterEvents = 0;
+G4long Tangle2::nMasterEventsRejected = 0;
+G4long Tangle2::nMasterEventsRejectedPh = 0;
+G4long Tangle2::nMasterEventsSelected = 0;
+G4long Tangle2::nMasterDirectionTrials = 0;
+G4long Tangle2::nMasterOutputRows = 0;
+G4long Tangle2::nMasterOutputBytes = 0;
+G4double Tangle2::masterOutputSeconds = 0.;
+G4double Tangle2::masterEventSeconds = 0.;
 
 // Worker quantities
-G4ThreadLocal G4int Tangle2::nEvents = 0;
-G4ThreadLocal G4int Tangle2::nEventsPh = 0;
+G4ThreadLocal G4long Tangle2::nEvents = 0;
+G4ThreadLocal G4long Tangle2::nEventsPh = 0;
+G4ThreadLocal G4long Tangle2::nEventsRejected = 0;
+G4ThreadLocal G4long Tangle2::nEventsRejectedPh = 0;
+G4ThreadLocal G4long Tangle2::nEventsSelected = 0;
+G4ThreadLocal G4bool Tangle2::fastSimEvent = false;
+G4ThreadLocal G4long Tangle2::nDirectionTrials = 0;
+G4ThreadLocal G4double Tangle2::eventWeight = 1.;
 G4ThreadLocal G4double Tangle2::eDepEvent = 0.;
 G4ThreadLocal G4double Tangle2::eDepCryst[18] ={0.};
 G4ThreadLocal G4double Tangle2::eDepColl1 =0.;
@@ -45,8 +72,8 @@ G4ThreadLocal G4double Tangle2::dphiA2B2 = 0;
 G4ThreadLocal G4double Tangle2::thetaPolA = 0;
 G4ThreadLocal G4double Tangle2::thetaPolB = 0;
 
-G4ThreadLocal G4int Tangle2::nA1B1 = 0;
-G4ThreadLocal G4int Tangle2::nA2B1 = 0;
-G4ThreadLocal G4int Tangle2::nA1B2 = 0;
-G4ThreadLocal G4int Tangle2::nA2B2 = 0;
+G4ThreadLocal G4long Tangle2::nA1B1 = 0;
+G4ThreadLocal G4long Tangle2::nA2B1 = 0;
+G4ThreadLocal G4long Tangle2::nA1B2 = 0;
+G4ThreadLocal G4long Tangle2::nA2B2 = 0;
 
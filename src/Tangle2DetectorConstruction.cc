@@ -14,6 +14,9 @@
 
 #include "Tangle2DetectorConstruction.hh"
 #include "Tangle2Data.hh"
+#include "Tangle2Geometry.hh"
+#include "Tangle2CrystalSD.hh"
+#include "Tangle2CrystalFastModel.hh"
 
 #include "G4NistManager.hh"
 #include "G4Box.hh"
@@ -23,6 +26,8 @@
 #include "G4RotationMatrix.hh"
 #include "G4Transform3D.hh"
 #include "G4SDManager.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
 #include "G4MultiFunctionalDetector.hh"
 #include "G4VPrimitiveScorer.hh"
 #include "G4PSEnergyDeposit.hh"
@@ -112,25 +117,29 @@ void Tangle2DetectorConstruction::DefineMaterials()
 
 G4VPhysicalVolume* Tangle2DetectorConstruction::Construct()
 {  
+  // Called on the master at /run/initialize, before any worker
+  // starts - from here on the configuration is read only
+  Tangle2Config::Freeze();
+  
   G4NistManager* nist = G4NistManager::Instance();
   G4bool checkOverlaps = true;
   
-  // Crystal full dimensions
-  G4double cryst_dX = 22*mm, cryst_dY = 4*mm, cryst_dZ = 4*mm;
+  // Crystal full dimensions (shared with the standalone engine)
+  G4double cryst_dX = Tangle2Geometry::cryst_dX*mm;
+  G4double cryst_dY = Tangle2Geometry::cryst_dY*mm;
+  G4double cryst_dZ = Tangle2Geometry::cryst_dZ*mm;
 
   G4Material* cryst_mat   = nist->FindOrBuildMaterial("Lu2Y2SiO5");
   
-  G4double ringDiameter = 60.*mm;
-  
-  // set in tangle2.cc
-  if(Tangle2::fullPET)
-    ringDiameter = 900*mm;
+  // fullPET is set with /tangle2/config/fullPET
+  G4double ringDiameter
+    = Tangle2Geometry::RingDiameter(Tangle2::config.fullPET)*mm;
   
   // World
   
   // leave a 1 mm gap after crystals
-  G4double    world_sizeX  = (ringDiameter + 2*cryst_dX + 2.)*mm; 
-  G4double    world_sizeYZ = 2*cm;
+  G4double    world_sizeX  = ringDiameter + 2*cryst_dX + 2.*mm; 
+  G4double    world_sizeYZ = Tangle2Geometry::worldSizeYZ*mm;
   G4Material* world_mat = nist->FindOrBuildMaterial("G4_AIR");
     
   G4Box* solidWorld =    
@@ -164,35 +173,20 @@ G4VPhysicalVolume* Tangle2DetectorConstruction::Construct()
                         cryst_mat,
                         "CrystalLV");         
   
-  //array of positions for 18 crystals
-  G4int nb_cryst = 18;
+  // Envelope for the fast simulation of gammas (Tangle2CrystalFastModel)
+  G4Region* crystalRegion = new G4Region("CrystalArrays");
+  logicCryst->SetRegion(crystalRegion);
+  crystalRegion->AddRootLogicalVolume(logicCryst);
   
-  // Crystal centres
-  G4double pos_dX = 0.5*(world_sizeX - cryst_dX - 2.);
-
-  G4ThreeVector positions[18] = {
-    G4ThreeVector(pos_dX,-cryst_dY,cryst_dZ),
-    G4ThreeVector(pos_dX,0,cryst_dZ),
-    G4ThreeVector(pos_dX,cryst_dY,cryst_dZ),
-    G4ThreeVector(pos_dX,-cryst_dY,0),
-    G4ThreeVector(pos_dX,0,0),
-    G4ThreeVector(pos_dX,cryst_dY,0),
-    G4ThreeVector(pos_dX,-cryst_dY,-cryst_dZ),
-    G4ThreeVector(pos_dX,0,-cryst_dZ),
-    G4ThreeVector(pos_dX,cryst_dY,-cryst_dZ),
-    G4ThreeVector(-pos_dX,-cryst_dY,cryst_dZ),
-    G4ThreeVector(-pos_dX,0,cryst_dZ),
-    G4ThreeVector(-pos_dX,cryst_dY,cryst_dZ),
-    G4ThreeVector(-pos_dX,-cryst_dY,0),
-    G4ThreeVector(-pos_dX,0,0),
-    G4ThreeVector(-pos_dX,cryst_dY,0),
-    G4ThreeVector(-pos_dX,-cryst_dY,-cryst_dZ),
-    G4ThreeVector(-pos_dX,0,-cryst_dZ),
-    G4ThreeVector(-pos_dX,cryst_dY,-cryst_dZ)};
+  //array of positions for 18 crystals
+  G4int nb_cryst = Tangle2Geometry::nCrystals;
   
   for (G4int icrys = 0; icrys < nb_cryst; icrys++) {
+    // Crystal centres
+    G4double centre[3];
+    Tangle2Geometry::CrystalCentre(icrys, Tangle2::config.fullPET, centre);
     new G4PVPlacement(0,                      
-		      positions[icrys],       
+		      G4ThreeVector(centre[0], centre[1], centre[2])*mm,
 		      logicCryst,             
 		      "crystal",              
 		      logicWorld,             
@@ -281,3 +275,17 @@ G4VPhysicalVolume* Tangle2DetectorConstruction::Construct()
   
   return physWorld; 
 }
+
+void Tangle2DetectorConstruction::ConstructSDandField()
+{
+  // Energy deposited in the crystals (and only the crystals)
+  Tangle2CrystalSD* crystalSD
+    = new Tangle2CrystalSD("CrystalSD", "CrystalHitsCollection", 18);
+  G4SDManager::GetSDMpointer()->AddNewDetector(crystalSD);
+  SetSensitiveDetector("CrystalLV", crystalSD);
+  
+  // Only triggered when Tangle2::fastSimMode asks for it
+  G4Region* crystalRegion
+    = G4RegionStore::GetInstance()->GetRegion("CrystalArrays");
+  new Tangle2CrystalFastModel("CrystalFastModel", crystalRegion);
+}
@@ -0,0 +1,104 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2DirectionSampler.hh"
+#include "Tangle2Geometry.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+  const double kPi  = 3.14159265358979323846;
+  const int    kGrid = 1000;
+}
+
+Tangle2DirectionSampler::Tangle2DirectionSampler(bool fullPET)
+: fCosThetaMax(std::cos(Tangle2Geometry::BeamThetaMax(fullPET)*kPi/180.)),
+  fAcceptance(-1.)
+{
+  // Array bounding boxes from the crystal boxes
+  const double halfSize[3] = {0.5*Tangle2Geometry::cryst_dX,
+			      0.5*Tangle2Geometry::cryst_dY,
+			      0.5*Tangle2Geometry::cryst_dZ};
+  for (int j = 0; j < 3; j++) {
+    fLoA[j] = fLoB[j] =  1.e99;
+    fHiA[j] = fHiB[j] = -1.e99;
+  }
+  for (int i = 0; i < Tangle2Geometry::nCrystals; i++) {
+    double centre[3];
+    Tangle2Geometry::CrystalCentre(i, fullPET, centre);
+    double* lo = (i < 9) ? fLoA : fLoB;
+    double* hi = (i < 9) ? fHiA : fHiB;
+    for (int j = 0; j < 3; j++) {
+      lo[j] = std::min(lo[j], centre[j] - halfSize[j]);
+      hi[j] = std::max(hi[j], centre[j] + halfSize[j]);
+    }
+  }
+}
+
+void Tangle2DirectionSampler::SampleCone(double u1, double u2,
+					 double dir[3]) const
+{
+  // theta wrt x-axis (fixed beam in x)
+  const double cosTheta = 1. - u1*(1. - fCosThetaMax);
+  const double sinTheta = std::sqrt(std::max(0., 1. - cosTheta*cosTheta));
+  const double phi      = 2.*kPi*u2;
+  dir[0] = cosTheta;
+  dir[1] = sinTheta*std::cos(phi);
+  dir[2] = sinTheta*std::sin(phi);
+}
+
+bool Tangle2DirectionSampler::HitsBox(const double lo[3], const double hi[3],
+				      const double dir[3]) const
+{
+  // slab method for a ray from the origin
+  double tIn = 0., tOut = 1.e99;
+  for (int j = 0; j < 3; j++) {
+    if (dir[j] == 0.) {
+      if (lo[j] > 0. || hi[j] < 0.) return false;
+      continue;
+    }
+    double t1 = lo[j]/dir[j];
+    double t2 = hi[j]/dir[j];
+    if (t1 > t2) std::swap(t1, t2);
+    tIn  = std::max(tIn,  t1);
+    tOut = std::min(tOut, t2);
+  }
+  return tOut > tIn;
+}
+
+bool Tangle2DirectionSampler::HitsArrays(const double dir[3]) const
+{
+  const double back[3] = {-dir[0], -dir[1], -dir[2]};
+  return
+    (HitsBox(fLoA, fHiA, dir)  || HitsBox(fLoB, fHiB, dir)) &&
+    (HitsBox(fLoA, fHiA, back) || HitsBox(fLoB, fHiB, back));
+}
+
+double Tangle2DirectionSampler::Acceptance() const
+{
+  if (fAcceptance < 0.) {
+    long hits = 0;
+    double dir[3];
+    for (int i = 0; i < kGrid; i++) {
+      for (int j = 0; j < kGrid; j++) {
+	SampleCone((i + 0.5)/kGrid, (j + 0.5)/kGrid, dir);
+	if (HitsArrays(dir)) hits++;
+      }
+    }
+    fAcceptance = double(hits)/(double(kGrid)*kGrid);
+  }
+  return fAcceptance;
+}
@@ -18,15 +18,24 @@
 
 #include "Tangle2Data.hh"
 #include "Tangle2RunAction.hh"
+#include "Tangle2OutputBackend.hh"
 #include "Tangle2VSteppingAction.hh"
+#include "Tangle2CrystalHit.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4RunManager.hh"
+#include "G4SDManager.hh"
+#include "G4HCofThisEvent.hh"
 
 #include "G4Event.hh"
 
 Tangle2EventAction::Tangle2EventAction
-(Tangle2VSteppingAction* onePhotonSteppingAction)
-: fpTangle2VSteppingAction(onePhotonSteppingAction)
+(Tangle2VSteppingAction* onePhotonSteppingAction,
+ Tangle2RunAction* runAction)
+: fpTangle2VSteppingAction(onePhotonSteppingAction),
+  fpRunAction(runAction),
+  fCrystalHCID(-1),
+  fDphiFullH1ID(-1),
+  fDphiFastH1ID(-1)
 {}
 
 Tangle2EventAction::~Tangle2EventAction()
@@ -34,10 +43,20 @@ Tangle2EventAction::~Tangle2EventAction()
 delete G4AnalysisManager::Instance();
 }
 
-void Tangle2EventAction::BeginOfEventAction(const G4Event*)
+void Tangle2EventAction::BeginOfEventAction(const G4Event* event)
 {
   fpTangle2VSteppingAction->BeginOfEventAction();
   
+  // Read by Tangle2CrystalFastModel::ModelTrigger
+  Tangle2::fastSimEvent =
+    (Tangle2::fastSimMode == Tangle2::kFastSimOn) ||
+    (Tangle2::fastSimMode == Tangle2::kFastSimValidate &&
+     event->GetEventID()%2 == 0);
+  
+  // before this event is counted
+  fpRunAction->UpdateTelemetry(Tangle2::nEvents, Tangle2::nEventsSelected);
+  fpRunAction->CheckpointIfDue();
+  
   Tangle2::nEvents += 1;
 
   //  G4cout << G4endl;
@@ -84,112 +103,140 @@ void Tangle2EventAction::BeginOfEventAction(const G4Event*)
 
 }
 
-void Tangle2EventAction::EndOfEventAction(const G4Event*)
+void Tangle2EventAction::EndOfEventAction(const G4Event* event)
 {   
-  fpTangle2VSteppingAction->EndOfEventAction();
-  
-  G4int nb_HitsA = 0, nb_HitsB = 0;
-  G4double eDepEvent = 0., eThres = 5*keV;
-  
-  // record number of hits above threshold
-  // and total energy deposited 
-  for (G4int i = 0; i < 9 ; i++){
-    // Array A
-    if (Tangle2::eDepCryst[i] > eThres){
-      nb_HitsA += 1;
-      eDepEvent += Tangle2::eDepCryst[i];
-    }
-    // Array B
-    if (Tangle2::eDepCryst[i+9] > eThres){
-      nb_HitsB += 1;
-      eDepEvent += Tangle2::eDepCryst[i+9];
+  // Given up on by the stepping action (Tangle2Config::fastReject):
+  // the event can not pass the selection below, and was aborted
+  G4bool rejected = fpTangle2VSteppingAction->IsRejected();
+  
+  if (!rejected)
+    fpTangle2VSteppingAction->EndOfEventAction();
+
+  // Crystal energy deposits from the sensitive detector
+  if (fCrystalHCID < 0)
+    fCrystalHCID = G4SDManager::GetSDMpointer()
+      ->GetCollectionID("CrystalSD/CrystalHitsCollection");
+  
+  G4HCofThisEvent* hce = event->GetHCofThisEvent();
+  if (hce) {
+    Tangle2CrystalHitsCollection* crystalHC
+      = static_cast<Tangle2CrystalHitsCollection*>(hce->GetHC(fCrystalHCID));
+    if (crystalHC) {
+      for (G4int i = 0; i < 18 && i < (G4int)crystalHC->entries(); i++)
+	Tangle2::eDepCryst[i] = (*crystalHC)[i]->GetEdep();
     }
   }
   
-  // Output to the root file 
+  Tangle2Selection& selection = fpRunAction->GetSelection();
+  
   // 4 and 13 are the central crystals
-  if ((Tangle2::eDepCryst[4]  > eThres) && 
-      (Tangle2::eDepCryst[13] > eThres) &&  
-      (Tangle2::thetaA !=0)             &&
-      (Tangle2::thetaB !=0)){
+  G4bool centralHits =
+    ((Tangle2::eDepCryst[4]  > selection.GetThreshold(4)) && 
+     (Tangle2::eDepCryst[13] > selection.GetThreshold(13)));
+  
+  // deposits up to the abort, so the rejected QET events are
+  // counted apart from those tracked to the end
+  if (rejected) {
+    Tangle2::nEventsRejected += 1;
+    if (centralHits)
+      Tangle2::nEventsRejectedPh += 1;
+    return;
+  }
+  
+  // Selected for output (see Tangle2Selection).  Scattering angles
+  // are only needed from the angle cuts on, so only calculate them
+  // for events that pass the cuts on deposits and counts
+  Tangle2SelectionEvent selectionEvent =
+    {Tangle2::eDepCryst, Tangle2::nb_Compt, 0., 0.};
+  G4bool selected =
+    selection.Select(Tangle2Selection::kBeforeAngles, selectionEvent);
+  if (selected) {
+    fpTangle2VSteppingAction->ComputeAngles();
+    // already in degrees
+    selectionEvent.thetaA = Tangle2::thetaA;
+    selectionEvent.thetaB = Tangle2::thetaB;
+    selected =
+      selection.Select(Tangle2Selection::kAfterAngles, selectionEvent);
+  }
+  
+  // Compare fast and full simulation (see Tangle2RunAction)
+  if (Tangle2::fastSimMode == Tangle2::kFastSimValidate && selected) {
     
     G4AnalysisManager* man = G4AnalysisManager::Instance();
+    if (fDphiFullH1ID < 0) {
+      fDphiFullH1ID = man->GetH1Id("dphi_full");
+      fDphiFastH1ID = man->GetH1Id("dphi_fast");
+    }
+    // dphi is in degrees
+    man->FillH1(Tangle2::fastSimEvent ? fDphiFastH1ID : fDphiFullH1ID,
+		Tangle2::dphi);
+  }
+  
+  // Output to the file (see Tangle2OutputBackend)
+  if (selected) {
     
-    for (G4int i = 0 ; i < 18 ; i++)
-      man->FillNtupleDColumn(i, Tangle2::eDepCryst[i]/MeV);
-    
-    man->FillNtupleDColumn(18, Tangle2::eDepColl1/MeV);
-    man->FillNtupleDColumn(19, Tangle2::eDepColl2/MeV);
+    Tangle2EventRecord& r = fRecord;
     
     for (G4int i = 0 ; i < 18 ; i++)
-      man->FillNtupleIColumn(i+20, Tangle2::nb_Compt[i]);
-        
-    man->FillNtupleDColumn(38, Tangle2::posA_1[0]/mm);
-    man->FillNtupleDColumn(39, Tangle2::posA_1[1]/mm);
-    man->FillNtupleDColumn(40, Tangle2::posA_1[2]/mm);
-    
-    man->FillNtupleDColumn(41, Tangle2::posA_2[0]/mm);
-    man->FillNtupleDColumn(42, Tangle2::posA_2[1]/mm);
-    man->FillNtupleDColumn(43, Tangle2::posA_2[2]/mm);
-    
-    man->FillNtupleDColumn(44, Tangle2::posB_1[0]/mm);
-    man->FillNtupleDColumn(45, Tangle2::posB_1[1]/mm);
-    man->FillNtupleDColumn(46, Tangle2::posB_1[2]/mm);
-    
-    man->FillNtupleDColumn(47, Tangle2::posB_2[0]/mm);
-    man->FillNtupleDColumn(48, Tangle2::posB_2[1]/mm);
-    man->FillNtupleDColumn(49, Tangle2::posB_2[2]/mm);
-    
-    man->FillNtupleDColumn(50, Tangle2::thetaA/radian);
-    man->FillNtupleDColumn(51, Tangle2::phiA/radian);
+      r.edep[i] = Tangle2::eDepCryst[i]/MeV;
     
-    man->FillNtupleDColumn(52, Tangle2::thetaB/radian);
-    man->FillNtupleDColumn(53, Tangle2::phiB/radian);
+    r.edepColl[0] = Tangle2::eDepColl1/MeV;
+    r.edepColl[1] = Tangle2::eDepColl2/MeV;
     
-    man->FillNtupleDColumn(54, Tangle2::dphi/radian);
+    for (G4int i = 0 ; i < 18 ; i++) {
+      r.nb_Compt[i] = Tangle2::nb_Compt[i];
+      r.nb_Photo[i] = Tangle2::nb_Photo[i];
+    }
     
-    man->FillNtupleDColumn(55, Tangle2::thetaA2/radian);
-    man->FillNtupleDColumn(56, Tangle2::phiA2/radian);
+    for (G4int i = 0 ; i < 3 ; i++) {
+      r.posA_1[i] = Tangle2::posA_1[i]/mm;
+      r.posA_2[i] = Tangle2::posA_2[i]/mm;
+      r.posB_1[i] = Tangle2::posB_1[i]/mm;
+      r.posB_2[i] = Tangle2::posB_2[i]/mm;
+      
+      r.posA_P1[i] = Tangle2::posA_P1[i]/mm;
+      r.posA_P2[i] = Tangle2::posA_P2[i]/mm;
+      r.posB_P1[i] = Tangle2::posB_P1[i]/mm;
+      r.posB_P2[i] = Tangle2::posB_P2[i]/mm;
+    }
     
-    man->FillNtupleDColumn(57, Tangle2::thetaB2/radian);
-    man->FillNtupleDColumn(58, Tangle2::phiB2/radian);
+    // angles are already in degrees
+    r.thetaA = Tangle2::thetaA;
+    r.phiA   = Tangle2::phiA;
+    r.thetaB = Tangle2::thetaB;
+    r.phiB   = Tangle2::phiB;
+    r.dphi   = Tangle2::dphi;
     
-    man->FillNtupleDColumn(59, Tangle2::dphiA1B2/radian);
-    man->FillNtupleDColumn(60, Tangle2::dphiA2B1/radian);
-    man->FillNtupleDColumn(61, Tangle2::dphiA2B2/radian);
+    r.thetaA2 = Tangle2::thetaA2;
+    r.phiA2   = Tangle2::phiA2;
+    r.thetaB2 = Tangle2::thetaB2;
+    r.phiB2   = Tangle2::phiB2;
     
-    man->FillNtupleDColumn(62, Tangle2::thetaPolA);
-    man->FillNtupleDColumn(63, Tangle2::thetaPolB);
+    r.dphiA1B2 = Tangle2::dphiA1B2;
+    r.dphiA2B1 = Tangle2::dphiA2B1;
+    r.dphiA2B2 = Tangle2::dphiA2B2;
     
-    man->FillNtupleDColumn(64, Tangle2::nEvents);
-
-    for (G4int i = 0 ; i < 18 ; i++)
-      man->FillNtupleIColumn(i+65, Tangle2::nb_Photo[i]);
-
-    man->FillNtupleDColumn(83, Tangle2::posA_P1[0]/mm);
-    man->FillNtupleDColumn(84, Tangle2::posA_P1[1]/mm);
-    man->FillNtupleDColumn(85, Tangle2::posA_P1[2]/mm);
+    r.thetaPolA = Tangle2::thetaPolA;
+    r.thetaPolB = Tangle2::thetaPolB;
     
-    man->FillNtupleDColumn(86, Tangle2::posA_P2[0]/mm);
-    man->FillNtupleDColumn(87, Tangle2::posA_P2[1]/mm);
-    man->FillNtupleDColumn(88, Tangle2::posA_P2[2]/mm);
+    // per thread
+    r.nEvents = Tangle2::nEvents;
+    r.weight  = Tangle2::eventWeight;
+    // global over the shards of a campaign, see Tangle2Shard
+    r.eventID  = event->GetEventID() + Tangle2::eventIDOffset;
+    r.threadID = G4Threading::G4GetThreadId();
     
-    man->FillNtupleDColumn(89, Tangle2::posB_P1[0]/mm);
-    man->FillNtupleDColumn(90, Tangle2::posB_P1[1]/mm);
-    man->FillNtupleDColumn(91, Tangle2::posB_P1[2]/mm);
+    fpRunAction->FillHistograms(r);
     
-    man->FillNtupleDColumn(92, Tangle2::posB_P2[0]/mm);
-    man->FillNtupleDColumn(93, Tangle2::posB_P2[1]/mm);
-    man->FillNtupleDColumn(94, Tangle2::posB_P2[2]/mm);
+    Tangle2OutputBackend* output = fpRunAction->GetOutput();
+    if (output) output->Write(r);
     
-
-    man->AddNtupleRow();
+    Tangle2::nEventsSelected += 1;
   }
   
   // Count total number events with energy 
   // dep. in central crystals
-  if ((Tangle2::eDepCryst[4]  > eThres) && 
-      (Tangle2::eDepCryst[13] > eThres)){
+  if (centralHits){
     Tangle2::nEventsPh += 1;
   }
   
@@ -0,0 +1,126 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2EventRecord.hh"
+
+#include <cstring>
+#include <sstream>
+
+namespace {
+
+  typedef Tangle2EventRecord R;
+
+  void Add(std::vector<R::Column>& columns, const std::string& name,
+	   R::Type type, std::size_t offset)
+  {
+    R::Column column = {name, type, offset};
+    columns.push_back(column);
+  }
+
+  // name0, name1, ...
+  void AddArray(std::vector<R::Column>& columns, const std::string& name,
+		R::Type type, std::size_t offset, int n)
+  {
+    for (int i = 0; i < n; i++) {
+      std::ostringstream os;
+      os << name << i;
+      Add(columns, os.str(), type, offset + i*R::Size(type));
+    }
+  }
+
+  // Xname, Yname, Zname
+  void AddPosition(std::vector<R::Column>& columns, const std::string& name,
+		   std::size_t offset)
+  {
+    Add(columns, "X" + name, R::kFloat, offset);
+    Add(columns, "Y" + name, R::kFloat, offset +   sizeof(float));
+    Add(columns, "Z" + name, R::kFloat, offset + 2*sizeof(float));
+  }
+
+  std::vector<R::Column> BuildColumns()
+  {
+    // as booked by Tangle2RunAction before the backends
+    std::vector<R::Column> c;
+    AddArray(c, "edep", R::kFloat, offsetof(R, edep), 18);
+    Add(c, "edepColl1", R::kFloat, offsetof(R, edepColl));
+    Add(c, "edepColl2", R::kFloat, offsetof(R, edepColl) + sizeof(float));
+    AddArray(c, "nb_Compt", R::kInt16, offsetof(R, nb_Compt), 18);
+    AddPosition(c, "posA_1st", offsetof(R, posA_1));
+    AddPosition(c, "posA_2nd", offsetof(R, posA_2));
+    AddPosition(c, "posB_1st", offsetof(R, posB_1));
+    AddPosition(c, "posB_2nd", offsetof(R, posB_2));
+    Add(c, "ThetaA_1st", R::kFloat, offsetof(R, thetaA));
+    Add(c, "PhiA_1st",   R::kFloat, offsetof(R, phiA));
+    Add(c, "ThetaB_1st", R::kFloat, offsetof(R, thetaB));
+    Add(c, "PhiB_1st",   R::kFloat, offsetof(R, phiB));
+    Add(c, "dPhi_1st",   R::kFloat, offsetof(R, dphi));
+    Add(c, "ThetaA_2nd", R::kFloat, offsetof(R, thetaA2));
+    Add(c, "PhiA_2nd",   R::kFloat, offsetof(R, phiA2));
+    Add(c, "ThetaB_2nd", R::kFloat, offsetof(R, thetaB2));
+    Add(c, "PhiB_2nd",   R::kFloat, offsetof(R, phiB2));
+    Add(c, "dPhi_A1B2",  R::kFloat, offsetof(R, dphiA1B2));
+    Add(c, "dPhi_A2B1",  R::kFloat, offsetof(R, dphiA2B1));
+    Add(c, "dPhi_A2B2",  R::kFloat, offsetof(R, dphiA2B2));
+    Add(c, "thetaPolA",  R::kFloat, offsetof(R, thetaPolA));
+    Add(c, "thetaPolB",  R::kFloat, offsetof(R, thetaPolB));
+    Add(c, "nEvents",    R::kInt64, offsetof(R, nEvents));
+    AddArray(c, "nb_Photo", R::kInt16, offsetof(R, nb_Photo), 18);
+    AddPosition(c, "posA_P1st", offsetof(R, posA_P1));
+    AddPosition(c, "posA_P2nd", offsetof(R, posA_P2));
+    AddPosition(c, "posB_P1st", offsetof(R, posB_P1));
+    AddPosition(c, "posB_P2nd", offsetof(R, posB_P2));
+    Add(c, "weight",     R::kFloat, offsetof(R, weight));
+    // for merging the per-thread files in event order, see tangle2_merge
+    Add(c, "eventID",    R::kInt64, offsetof(R, eventID));
+    Add(c, "threadID",   R::kInt16, offsetof(R, threadID));
+    return c;
+  }
+
+}
+
+const std::vector<Tangle2EventRecord::Column>& Tangle2EventRecord::Columns()
+{
+  static const std::vector<Column> columns = BuildColumns();
+  return columns;
+}
+
+std::size_t Tangle2EventRecord::Size(Type type)
+{
+  switch (type) {
+  case kInt16: return sizeof(int16_t);
+  case kInt64: return sizeof(int64_t);
+  default:     return sizeof(float);
+  }
+}
+
+double Tangle2EventRecord::Get(const Column& column) const
+{
+  const char* p = reinterpret_cast<const char*>(this) + column.offset;
+  switch (column.type) {
+  case kInt16: { int16_t v; std::memcpy(&v, p, sizeof v); return v; }
+  case kInt64: { int64_t v; std::memcpy(&v, p, sizeof v); return double(v); }
+  default:     { float   v; std::memcpy(&v, p, sizeof v); return v; }
+  }
+}
+
+void Tangle2EventRecord::Set(const Column& column, double value)
+{
+  char* p = reinterpret_cast<char*>(this) + column.offset;
+  switch (column.type) {
+  case kInt16: { int16_t v = int16_t(value); std::memcpy(p, &v, sizeof v); break; }
+  case kInt64: { int64_t v = int64_t(value); std::memcpy(p, &v, sizeof v); break; }
+  default:     { float   v = float(value);   std::memcpy(p, &v, sizeof v); break; }
+  }
+}
@@ -0,0 +1,71 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2FastSimMessenger.hh"
+
+#include "Tangle2Data.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+
+Tangle2FastSimMessenger::Tangle2FastSimMessenger()
+{
+  fpDirectory = new G4UIdirectory("/tangle2/fastSim/");
+  fpDirectory->SetGuidance("Fast simulation of gammas in the crystals.");
+  
+  fpModeCmd = new G4UIcmdWithAString("/tangle2/fastSim/mode", this);
+  fpModeCmd->SetGuidance("Select full or parameterised tracking of gammas");
+  fpModeCmd->SetGuidance("in the crystals.");
+  fpModeCmd->SetGuidance("  off      - full Geant4 tracking");
+  fpModeCmd->SetGuidance("  on       - Tangle2CrystalFastModel");
+  fpModeCmd->SetGuidance("  validate - fast for even, full for odd events,");
+  fpModeCmd->SetGuidance("             dPhi compared at end of run");
+  fpModeCmd->SetParameterName("mode", false);
+  fpModeCmd->SetCandidates("off on validate");
+  fpModeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  // Tangle2::fastSimMode is shared, so set it on the master only
+  fpModeCmd->SetToBeBroadcasted(false);
+}
+
+Tangle2FastSimMessenger::~Tangle2FastSimMessenger()
+{
+  delete fpModeCmd;
+  delete fpDirectory;
+}
+
+void Tangle2FastSimMessenger::SetNewValue(G4UIcommand* command,
+					  G4String newValue)
+{
+  if (command == fpModeCmd) {
+    if (newValue == "on")
+      Tangle2::fastSimMode = Tangle2::kFastSimOn;
+    else if (newValue == "validate")
+      Tangle2::fastSimMode = Tangle2::kFastSimValidate;
+    else
+      Tangle2::fastSimMode = Tangle2::kFastSimOff;
+  }
+}
+
+G4String Tangle2FastSimMessenger::GetCurrentValue(G4UIcommand* command)
+{
+  if (command == fpModeCmd) {
+    switch (Tangle2::fastSimMode) {
+    case Tangle2::kFastSimOn:       return "on";
+    case Tangle2::kFastSimValidate: return "validate";
+    default:                        return "off";
+    }
+  }
+  return "";
+}
@@ -0,0 +1,432 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2ForkRunManager.hh"
+
+#include "Tangle2Data.hh"
+#include "Tangle2RunAction.hh"
+#include "Tangle2Shard.hh"
+
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+Tangle2ForkRunManager::Result::Result()
+: nEvents(0), nEventsPh(0), nEventsRejected(0), nEventsRejectedPh(0),
+  nEventsSelected(0), nDirectionTrials(0), nRows(0), nBytes(0),
+  outputSeconds(0.)
+{}
+
+Tangle2ForkRunManager::Tangle2ForkRunManager(G4int nProcesses)
+: fNProcesses(nProcesses > 0 ? nProcesses : 1),
+  fMaxRestarts(2),
+  fRunEvents(0),
+  fPolicy(Tangle2Topology::kNone)
+{}
+
+Tangle2ForkRunManager::~Tangle2ForkRunManager()
+{}
+
+G4String Tangle2ForkRunManager::ProcessName(G4int index)
+{
+  std::ostringstream name;
+  name << Tangle2::outputName << "_p" << index;
+  return name.str();
+}
+
+void Tangle2ForkRunManager::BeamOn(G4int n_event, const char* macroFile,
+				   G4int n_select)
+{
+  // in a forked process, or nothing to share out
+  if (Tangle2::forkProcess >= 0 || n_event <= 0) {
+    G4RunManager::BeamOn(n_event, macroFile, n_select);
+    return;
+  }
+  if (!ConfirmBeamOnCondition()) return;
+  
+  // geometry closed and physics tables built, to be shared
+  G4RunManager::BeamOn(0);
+  const Memory parent = ReadMemory();
+  
+  const G4int nProcesses = G4int(std::min<G4long>(fNProcesses, n_event));
+  fRunEvents = n_event;
+  std::vector<Process> processes(nProcesses);
+  G4long firstEvent = 0;
+  for (G4int k = 0; k < nProcesses; k++) {
+    Process& p = processes[k];
+    p.index = k;
+    p.nEvents = n_event/nProcesses + (k < n_event%nProcesses ? 1 : 0);
+    p.firstEvent = firstEvent;
+    firstEvent += p.nEvents;
+    // as G4MTRunManager draws the seeds of each event
+    for (G4int i = 0; i < 2; i++)
+      p.seeds[i] = G4long(100000000L*G4UniformRand());
+    p.pid = -1;
+    p.restarts = 0;
+    p.done = false;
+    p.seconds = 0.;
+    p.maxRSS = 0.;
+  }
+  
+  G4cout << "Tangle2ForkRunManager: " << n_event << " events in "
+	 << nProcesses << " processes, " << parent.rss
+	 << " MB initialised" << G4endl;
+  const std::chrono::steady_clock::time_point start
+    = std::chrono::steady_clock::now();
+  
+  G4int nRunning = 0;
+  for (G4int k = 0; k < nProcesses; k++)
+    if (Start(processes[k], macroFile, n_select)) nRunning++;
+  
+  std::vector<Result> results(nProcesses);
+  while (nRunning > 0) {
+    int status = 0;
+    struct rusage usage;
+    const pid_t pid = wait4(-1, &status, 0, &usage);
+    if (pid < 0) {
+      if (errno == EINTR) continue;
+      std::perror("Tangle2ForkRunManager: wait4");
+      break;
+    }
+    Process* p = 0;
+    for (G4int k = 0; k < nProcesses; k++)
+      if (processes[k].pid == pid) p = &processes[k];
+    if (!p) continue;
+    nRunning--;
+    
+    p->pid = -1;
+    p->seconds = std::chrono::duration<G4double>
+      (std::chrono::steady_clock::now() - p->start).count();
+    p->maxRSS = usage.ru_maxrss/1024.;  // kB on Linux
+    
+    Result& result = results[p->index];
+    result = Result();
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+	ReadResult(ProcessName(p->index) + "_process.txt", result) &&
+	result.nEvents == p->nEvents) {
+      p->done = true;
+      continue;
+    }
+    
+    G4cout << "Tangle2ForkRunManager: process " << p->index << " ";
+    if (WIFSIGNALED(status))
+      G4cout << "killed by signal " << WTERMSIG(status);
+    else if (WIFEXITED(status) && WEXITSTATUS(status) != 0)
+      G4cout << "exited with status " << WEXITSTATUS(status);
+    else
+      G4cout << "did " << result.nEvents << " of " << p->nEvents
+	     << " events";
+    G4cout << ", see " << ProcessName(p->index) << ".log";
+    if (p->restarts < fMaxRestarts) {
+      p->restarts++;
+      G4cout << "; restart " << p->restarts << G4endl;
+      if (Start(*p, macroFile, n_select)) nRunning++;
+    }
+    else
+      G4cout << "; given up, its events are missing" << G4endl;
+  }
+  
+  const G4double seconds = std::chrono::duration<G4double>
+    (std::chrono::steady_clock::now() - start).count();
+  Report(processes, results, parent, seconds);
+}
+
+G4bool Tangle2ForkRunManager::Start(Process& p, const char* macroFile,
+				    G4int n_select)
+{
+  // nothing buffered is written twice
+  G4cout << std::flush;
+  std::cout.flush();
+  std::cerr.flush();
+  
+  p.start = std::chrono::steady_clock::now();
+  const pid_t pid = fork();
+  if (pid < 0) {
+    std::perror("Tangle2ForkRunManager: fork");
+    return false;
+  }
+  if (pid == 0)
+    RunProcess(p, macroFile, n_select);
+  p.pid = pid;
+  return true;
+}
+
+void Tangle2ForkRunManager::RunProcess(const Process& p,
+				       const char* macroFile, G4int n_select)
+{
+  const G4String name = ProcessName(p.index);
+  const int log = open((name + ".log").c_str(),
+		       O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (log >= 0) {
+    dup2(log, STDOUT_FILENO);
+    dup2(log, STDERR_FILENO);
+    close(log);
+  }
+  
+  const G4int cpu = fTopology.CPUForThread(p.index, fPolicy);
+  if (cpu >= 0) {
+    if (Tangle2Topology::PinCurrentThread(cpu))
+      G4cout << "Tangle2ForkRunManager: process " << p.index << " on CPU "
+	     << cpu << " (NUMA node " << fTopology.NodeOfCPU(cpu) << ")"
+	     << G4endl;
+    else
+      G4cout << "Tangle2ForkRunManager: process " << p.index
+	     << " could not be pinned to CPU " << cpu << G4endl;
+  }
+  
+  Tangle2::outputName = name;
+  Tangle2::forkProcess = p.index;
+  Tangle2::forkFirstEvent = p.firstEvent;
+  Tangle2::forkRunEvents = fRunEvents;
+  G4Random::setTheSeeds(p.seeds);
+  G4cout << "Tangle2ForkRunManager: process " << p.index << ", events "
+	 << p.firstEvent << " to " << p.firstEvent + p.nEvents - 1
+	 << ", seeds " << p.seeds[0] << " " << p.seeds[1]
+	 << ", restart " << p.restarts << G4endl;
+  
+  G4RunManager::BeamOn(G4int(p.nEvents), macroFile, n_select);
+  const G4bool written = WriteResult(name + "_process.txt");
+  
+  G4cout << std::flush;
+  std::cout.flush();
+  std::cerr.flush();
+  // not the parent's destructors and exit handlers
+  _exit(written ? 0 : 1);
+}
+
+G4bool Tangle2ForkRunManager::WriteResult(const G4String& fileName) const
+{
+  const Tangle2RunAction* runAction
+    = dynamic_cast<const Tangle2RunAction*>(GetUserRunAction());
+  if (!runAction) return false;
+  
+  std::FILE* file = std::fopen(fileName.c_str(), "w");
+  if (!file) return false;
+  
+  const Memory memory = ReadMemory();
+  std::fprintf(file, "# Tangle2 process\n"
+	       "events %ld\neventsPh %ld\neventsRejected %ld\n"
+	       "eventsRejectedPh %ld\n"
+	       "selected %ld\ndirectionTrials %ld\nrows %ld\nbytes %ld\n"
+	       "outputSeconds %a\nmemory %a %a %a %a\n",
+	       Tangle2::nMasterEvents, Tangle2::nMasterEventsPh,
+	       Tangle2::nMasterEventsRejected, Tangle2::nMasterEventsRejectedPh,
+	       Tangle2::nMasterEventsSelected,
+	       Tangle2::nMasterDirectionTrials, Tangle2::nMasterOutputRows,
+	       Tangle2::nMasterOutputBytes, Tangle2::masterOutputSeconds,
+	       memory.rss, memory.pss, memory.shared, memory.priv);
+  const std::vector<G4String>& files = runAction->GetOutputFiles();
+  for (std::size_t i = 0; i < files.size(); i++)
+    std::fprintf(file, "file %s\n", files[i].c_str());
+  const std::vector<Tangle2Histogram>& histograms
+    = runAction->GetHistograms();
+  for (std::size_t i = 0; i < histograms.size(); i++) {
+    std::fprintf(file, "histogram ");
+    histograms[i].WriteContents(file);
+  }
+  return std::fclose(file) == 0;
+}
+
+G4bool Tangle2ForkRunManager::ReadResult(const G4String& fileName,
+					 Result& result) const
+{
+  std::FILE* file = std::fopen(fileName.c_str(), "r");
+  if (!file) return false;
+  
+  G4bool ok = true;
+  char key[64];
+  while (ok && std::fscanf(file, " %63s", key) == 1) {
+    const std::string k = key;
+    if (k == "#" || k == "file") {
+      char line[4096];
+      if (!std::fgets(line, sizeof line, file)) break;
+      line[std::strcspn(line, "\n")] = 0;
+      if (k == "file")
+	result.files.push_back(G4String(line + std::strspn(line, " ")));
+    }
+    else if (k == "events")
+      ok = std::fscanf(file, "%ld", &result.nEvents) == 1;
+    else if (k == "eventsPh")
+      ok = std::fscanf(file, "%ld", &result.nEventsPh) == 1;
+    else if (k == "eventsRejected")
+      ok = std::fscanf(file, "%ld", &result.nEventsRejected) == 1;
+    else if (k == "eventsRejectedPh")
+      ok = std::fscanf(file, "%ld", &result.nEventsRejectedPh) == 1;
+    else if (k == "selected")
+      ok = std::fscanf(file, "%ld", &result.nEventsSelected) == 1;
+    else if (k == "directionTrials")
+      ok = std::fscanf(file, "%ld", &result.nDirectionTrials) == 1;
+    else if (k == "rows")
+      ok = std::fscanf(file, "%ld", &result.nRows) == 1;
+    else if (k == "bytes")
+      ok = std::fscanf(file, "%ld", &result.nBytes) == 1;
+    else if (k == "outputSeconds")
+      ok = std::fscanf(file, "%la", &result.outputSeconds) == 1;
+    else if (k == "memory")
+      ok = std::fscanf(file, "%la %la %la %la",
+		       &result.memory.rss, &result.memory.pss,
+		       &result.memory.shared, &result.memory.priv) == 4;
+    else if (k == "histogram") {
+      // in the order booked
+      const std::size_t h = result.histograms.size();
+      ok = h < Tangle2::histograms.size();
+      if (ok) {
+	result.histograms.push_back(Tangle2::histograms[h]);
+	ok = result.histograms.back().ReadContents(file);
+      }
+    }
+    else
+      ok = false;
+  }
+  std::fclose(file);
+  return ok && result.histograms.size() == Tangle2::histograms.size();
+}
+
+Tangle2ForkRunManager::Memory Tangle2ForkRunManager::ReadMemory()
+{
+  Memory memory;
+  // kernel 4.14 or later; otherwise the resident size only
+  std::ifstream rollup("/proc/self/smaps_rollup");
+  std::ifstream status;
+  if (!rollup) status.open("/proc/self/status");
+  std::istream& in = rollup ? static_cast<std::istream&>(rollup) : status;
+  std::string line;
+  while (std::getline(in, line)) {
+    char key[64];
+    G4double kB;
+    if (std::sscanf(line.c_str(), "%63[^:]: %lf", key, &kB) != 2) continue;
+    const std::string k = key;
+    const G4double mb = kB/1024.;
+    if      (k == "Rss" || k == "VmRSS") memory.rss = mb;
+    else if (k == "Pss") memory.pss = mb;
+    else if (k == "Shared_Clean" || k == "Shared_Dirty") memory.shared += mb;
+    else if (k == "Private_Clean" || k == "Private_Dirty") memory.priv += mb;
+  }
+  return memory;
+}
+
+void Tangle2ForkRunManager::Report(const std::vector<Process>& processes,
+				   const std::vector<Result>& results,
+				   const Memory& parent, G4double seconds)
+{
+  // As the master run action's counters, in process order
+  Tangle2::nMasterEvents = 0;
+  Tangle2::nMasterEventsPh = 0;
+  Tangle2::nMasterEventsRejected = 0;
+  Tangle2::nMasterEventsRejectedPh = 0;
+  Tangle2::nMasterEventsSelected = 0;
+  Tangle2::nMasterDirectionTrials = 0;
+  Tangle2::nMasterOutputRows = 0;
+  Tangle2::nMasterOutputBytes = 0;
+  Tangle2::masterOutputSeconds = 0.;
+  Tangle2::masterEventSeconds = seconds;
+  
+  std::vector<Tangle2Histogram> histograms = Tangle2::histograms;
+  for (std::size_t h = 0; h < histograms.size(); h++)
+    histograms[h].Reset();
+  Tangle2Shard shard;
+  shard.BeginOfRun(fRunEvents, 0);
+  
+  G4int nDone = 0;
+  for (std::size_t k = 0; k < processes.size(); k++) {
+    if (!processes[k].done) continue;
+    nDone++;
+    const Result& r = results[k];
+    Tangle2::nMasterEvents          += r.nEvents;
+    Tangle2::nMasterEventsPh        += r.nEventsPh;
+    Tangle2::nMasterEventsRejected  += r.nEventsRejected;
+    Tangle2::nMasterEventsRejectedPh += r.nEventsRejectedPh;
+    Tangle2::nMasterEventsSelected  += r.nEventsSelected;
+    Tangle2::nMasterDirectionTrials += r.nDirectionTrials;
+    Tangle2::nMasterOutputRows      += r.nRows;
+    Tangle2::nMasterOutputBytes     += r.nBytes;
+    // processes write in parallel, so keep the slowest
+    Tangle2::masterOutputSeconds
+      = std::max(Tangle2::masterOutputSeconds, r.outputSeconds);
+    for (std::size_t h = 0; h < histograms.size(); h++)
+      histograms[h].Add(r.histograms[h]);
+    for (std::size_t f = 0; f < r.files.size(); f++)
+      shard.AddFile(r.files[f]);
+  }
+  
+  G4cout << G4endl
+	 << "Tangle2ForkRunManager: " << nDone << " of " << processes.size()
+	 << " processes done" << G4endl
+	 << Tangle2::nMasterEvents << " events, "
+	 << Tangle2::nMasterEventsPh << " QET events, "
+	 << Tangle2::nMasterEventsSelected << " selected" << G4endl
+	 // read by tangle2_scaling
+	 << "Event loop " << Tangle2::masterEventSeconds << " s" << G4endl;
+  if (Tangle2::config.fastReject)
+    G4cout << Tangle2::nMasterEventsRejected << " events rejected early, "
+	   << Tangle2::nMasterEventsRejectedPh << " of them QET by then"
+	   << G4endl;
+  if (Tangle2::nMasterOutputRows > 0)
+    G4cout << Tangle2::nMasterOutputRows << " events written, "
+	   << Tangle2::nMasterOutputBytes << " bytes in "
+	   << shard.GetFiles().size() << " files" << G4endl;
+  
+  for (std::size_t h = 0; h < histograms.size(); h++) {
+    const Tangle2Histogram& histogram = histograms[h];
+    const G4String fileName
+      = Tangle2::outputName + "_hist_" + histogram.GetName() + ".txt";
+    if (!histogram.Write(fileName)) {
+      G4cout << " Can not write " << fileName << G4endl;
+      continue;
+    }
+    shard.AddHistogram(fileName);
+    G4cout << " Histogram " << histogram.GetName() << ": "
+	   << histogram.GetEntries() << " entries, "
+	   << histogram.GetSum() << " in range, written to "
+	   << fileName << G4endl;
+  }
+  shard.EndOfRun(Tangle2::nMasterEvents, Tangle2::nMasterOutputRows);
+  
+  // Pss counts a page shared by n processes as 1/n in each, so the
+  // parent's and the processes' Pss (each at the end of its run) add
+  // up to about what the node held; Rss counts shared pages in full
+  G4double sumRss = parent.rss, sumPss = parent.pss;
+  G4cout << "Memory, MB        rss      pss   shared  private  max rss"
+	 << G4endl;
+  char line[128];
+  std::snprintf(line, sizeof line, "  parent   %8.1f %8.1f %8.1f %8.1f",
+		parent.rss, parent.pss, parent.shared, parent.priv);
+  G4cout << line << G4endl;
+  for (std::size_t k = 0; k < processes.size(); k++) {
+    const Process& p = processes[k];
+    const Memory& m = results[k].memory;
+    std::snprintf(line, sizeof line,
+		  "  p%-7zu %8.1f %8.1f %8.1f %8.1f %8.1f  %.1f s%s",
+		  k, m.rss, m.pss, m.shared, m.priv, p.maxRSS, p.seconds,
+		  p.restarts > 0 ? ", restarted" : "");
+    G4cout << line << G4endl;
+    sumRss += m.rss;
+    sumPss += m.pss;
+  }
+  G4cout << "In use " << sumPss << " MB (sum of pss), " << sumRss - sumPss
+	 << " MB of the sum of rss shared copy-on-write" << G4endl;
+}
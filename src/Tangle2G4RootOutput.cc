@@ -0,0 +1,139 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2G4RootOutput.hh"
+
+#include "Tangle2Data.hh"
+
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cassert>
+#include <sstream>
+
+Tangle2G4RootOutput::Tangle2G4RootOutput()
+{}
+
+Tangle2G4RootOutput::~Tangle2G4RootOutput()
+{
+  Close();
+}
+
+namespace {
+  // The analysis manager is per thread and keeps its ntuples from
+  // run to run, so the ntuple is booked once per thread (a backend
+  // may be made anew for each run) and only the file is per run
+  G4ThreadLocal G4bool ntupleBooked = false;
+}
+
+std::string Tangle2G4RootOutput::DoOpen(const std::string& fileName)
+{
+  G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+  
+  if (!ntupleBooked) {
+    const std::vector<Tangle2EventRecord::Column>& columns
+      = Tangle2EventRecord::Columns();
+    
+    analysisManager->SetFirstNtupleId(1);
+    analysisManager->CreateNtuple("Tangle2", "Tangle2");
+    for (std::size_t i = 0; i < columns.size(); i++) {
+      if (columns[i].type == Tangle2EventRecord::kInt16)
+	analysisManager->CreateNtupleIColumn(columns[i].name);
+      else
+	analysisManager->CreateNtupleDColumn(columns[i].name);
+    }
+    analysisManager->FinishNtuple();
+    ntupleBooked = true;
+  }
+  
+  if (!analysisManager->OpenFile(fileName))
+    return "";
+  
+  // g4root writes one file per worker thread
+  std::ostringstream name;
+  name << fileName;
+  if (G4Threading::IsWorkerThread())
+    name << "_t" << G4Threading::G4GetThreadId();
+  name << ".root";
+  return name.str();
+}
+
+namespace {
+  
+  void FillPosition(G4AnalysisManager* man, G4int& i, const G4ThreeVector& v)
+  {
+    for (G4int k = 0; k < 3; k++)
+      man->FillNtupleDColumn(i++, v[k]/mm);
+  }
+  
+}
+
+// The double columns from the Tangle2:: quantities themselves, as
+// before the backends, not from the (float) record, so the ntuple is
+// the same to the last bit.  Only the columns added since (eventID,
+// threadID) come from the record.  g4root is written by the worker
+// in its EndOfEventAction, never asynchronously, so they are current.
+void Tangle2G4RootOutput::DoWrite(const Tangle2EventRecord& record)
+{
+  G4AnalysisManager* man = G4AnalysisManager::Instance();
+  
+  // in the order of Tangle2EventRecord::Columns
+  G4int i = 0;
+  for (G4int k = 0; k < 18; k++)
+    man->FillNtupleDColumn(i++, Tangle2::eDepCryst[k]/MeV);
+  man->FillNtupleDColumn(i++, Tangle2::eDepColl1/MeV);
+  man->FillNtupleDColumn(i++, Tangle2::eDepColl2/MeV);
+  for (G4int k = 0; k < 18; k++)
+    man->FillNtupleIColumn(i++, Tangle2::nb_Compt[k]);
+  FillPosition(man, i, Tangle2::posA_1);
+  FillPosition(man, i, Tangle2::posA_2);
+  FillPosition(man, i, Tangle2::posB_1);
+  FillPosition(man, i, Tangle2::posB_2);
+  // angles are already in degrees
+  man->FillNtupleDColumn(i++, Tangle2::thetaA);
+  man->FillNtupleDColumn(i++, Tangle2::phiA);
+  man->FillNtupleDColumn(i++, Tangle2::thetaB);
+  man->FillNtupleDColumn(i++, Tangle2::phiB);
+  man->FillNtupleDColumn(i++, Tangle2::dphi);
+  man->FillNtupleDColumn(i++, Tangle2::thetaA2);
+  man->FillNtupleDColumn(i++, Tangle2::phiA2);
+  man->FillNtupleDColumn(i++, Tangle2::thetaB2);
+  man->FillNtupleDColumn(i++, Tangle2::phiB2);
+  man->FillNtupleDColumn(i++, Tangle2::dphiA1B2);
+  man->FillNtupleDColumn(i++, Tangle2::dphiA2B1);
+  man->FillNtupleDColumn(i++, Tangle2::dphiA2B2);
+  man->FillNtupleDColumn(i++, Tangle2::thetaPolA);
+  man->FillNtupleDColumn(i++, Tangle2::thetaPolB);
+  man->FillNtupleDColumn(i++, Tangle2::nEvents);
+  for (G4int k = 0; k < 18; k++)
+    man->FillNtupleIColumn(i++, Tangle2::nb_Photo[k]);
+  FillPosition(man, i, Tangle2::posA_P1);
+  FillPosition(man, i, Tangle2::posA_P2);
+  FillPosition(man, i, Tangle2::posB_P1);
+  FillPosition(man, i, Tangle2::posB_P2);
+  man->FillNtupleDColumn(i++, Tangle2::eventWeight);
+  man->FillNtupleDColumn(i++, double(record.eventID));
+  man->FillNtupleIColumn(i++, record.threadID);
+  assert(std::size_t(i) == Tangle2EventRecord::Columns().size());
+  man->AddNtupleRow();
+}
+
+void Tangle2G4RootOutput::DoClose()
+{
+  // histograms too, if any
+  G4AnalysisManager* man = G4AnalysisManager::Instance();
+  man->Write();
+  man->CloseFile();
+}
@@ -0,0 +1,197 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2Hdf5Output.hh"
+
+#ifdef TANGLE2_WITH_HDF5
+
+#include <hdf5.h>
+
+#include <cstring>
+
+namespace {
+
+  hid_t FileType(Tangle2EventRecord::Type type)
+  {
+    switch (type) {
+    case Tangle2EventRecord::kInt16: return H5T_STD_I16LE;
+    case Tangle2EventRecord::kInt64: return H5T_STD_I64LE;
+    default:                         return H5T_IEEE_F32LE;
+    }
+  }
+
+  hid_t MemoryType(Tangle2EventRecord::Type type)
+  {
+    switch (type) {
+    case Tangle2EventRecord::kInt16: return H5T_NATIVE_INT16;
+    case Tangle2EventRecord::kInt64: return H5T_NATIVE_INT64;
+    default:                         return H5T_NATIVE_FLOAT;
+    }
+  }
+
+}
+
+#endif
+
+std::mutex& Tangle2Hdf5Output::Mutex()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+Tangle2Hdf5Output::Tangle2Hdf5Output()
+: fFile(-1), fGroup(-1), fBufferedRows(0), fWrittenRows(0)
+{}
+
+Tangle2Hdf5Output::~Tangle2Hdf5Output()
+{
+  Close();
+}
+
+#ifdef TANGLE2_WITH_HDF5
+
+bool Tangle2Hdf5Output::IsAvailable()
+{
+  return true;
+}
+
+std::string Tangle2Hdf5Output::DoOpen(const std::string& fileName)
+{
+  const std::string name = fileName + ".h5";
+  const std::vector<Tangle2EventRecord::Column>& columns
+    = Tangle2EventRecord::Columns();
+  
+  std::lock_guard<std::mutex> lock(Mutex());
+  
+  fFile = H5Fcreate(name.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+  if (fFile < 0) return "";
+  fGroup = H5Gcreate2(fFile, "Tangle2",
+		      H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  
+  hsize_t dims[1]    = {0};
+  hsize_t maxDims[1] = {H5S_UNLIMITED};
+  hsize_t chunk[1]   = {kChunkRows};
+  
+  hid_t space = H5Screate_simple(1, dims, maxDims);
+  hid_t dcpl  = H5Pcreate(H5P_DATASET_CREATE);
+  H5Pset_chunk(dcpl, 1, chunk);
+  H5Pset_shuffle(dcpl);
+  if (H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0)
+    H5Pset_deflate(dcpl, 4);
+  // Whole chunks are written at a time, so no chunk cache: each is
+  // compressed when written, not all at H5Dclose
+  hid_t dapl  = H5Pcreate(H5P_DATASET_ACCESS);
+  H5Pset_chunk_cache(dapl, 0, 0, H5D_CHUNK_CACHE_W0_DEFAULT);
+  
+  fDatasets.clear();
+  fBuffers.clear();
+  for (std::size_t i = 0; i < columns.size(); i++) {
+    fDatasets.push_back(H5Dcreate2(fGroup, columns[i].name.c_str(),
+				   FileType(columns[i].type), space,
+				   H5P_DEFAULT, dcpl, dapl));
+    fBuffers.push_back(std::vector<char>
+		       (kChunkRows*Tangle2EventRecord::Size(columns[i].type)));
+  }
+  
+  H5Pclose(dapl);
+  H5Pclose(dcpl);
+  H5Sclose(space);
+  
+  fBufferedRows = 0;
+  fWrittenRows  = 0;
+  return name;
+}
+
+void Tangle2Hdf5Output::DoWrite(const Tangle2EventRecord& record)
+{
+  const std::vector<Tangle2EventRecord::Column>& columns
+    = Tangle2EventRecord::Columns();
+  const char* base = reinterpret_cast<const char*>(&record);
+  
+  for (std::size_t i = 0; i < columns.size(); i++) {
+    const std::size_t size = Tangle2EventRecord::Size(columns[i].type);
+    std::memcpy(&fBuffers[i][fBufferedRows*size],
+		base + columns[i].offset, size);
+  }
+  
+  if (++fBufferedRows == kChunkRows)
+    Flush();
+}
+
+void Tangle2Hdf5Output::Flush()
+{
+  if (fBufferedRows == 0) return;
+  
+  const std::vector<Tangle2EventRecord::Column>& columns
+    = Tangle2EventRecord::Columns();
+  
+  std::lock_guard<std::mutex> lock(Mutex());
+  
+  hsize_t newSize[1] = {fWrittenRows + fBufferedRows};
+  hsize_t start[1]   = {fWrittenRows};
+  hsize_t count[1]   = {fBufferedRows};
+  hid_t memSpace = H5Screate_simple(1, count, 0);
+  
+  for (std::size_t i = 0; i < columns.size(); i++) {
+    H5Dset_extent(fDatasets[i], newSize);
+    hid_t fileSpace = H5Dget_space(fDatasets[i]);
+    H5Sselect_hyperslab(fileSpace, H5S_SELECT_SET, start, 0, count, 0);
+    H5Dwrite(fDatasets[i], MemoryType(columns[i].type),
+	     memSpace, fileSpace, H5P_DEFAULT, &fBuffers[i][0]);
+    H5Sclose(fileSpace);
+  }
+  
+  H5Sclose(memSpace);
+  
+  fWrittenRows += fBufferedRows;
+  fBufferedRows = 0;
+}
+
+void Tangle2Hdf5Output::DoClose()
+{
+  Flush();
+  
+  std::lock_guard<std::mutex> lock(Mutex());
+  for (std::size_t i = 0; i < fDatasets.size(); i++)
+    H5Dclose(fDatasets[i]);
+  fDatasets.clear();
+  fBuffers.clear();
+  if (fGroup >= 0) H5Gclose(fGroup);
+  if (fFile  >= 0) H5Fclose(fFile);
+  fGroup = fFile = -1;
+}
+
+#else // no HDF5
+
+bool Tangle2Hdf5Output::IsAvailable()
+{
+  return false;
+}
+
+std::string Tangle2Hdf5Output::DoOpen(const std::string&)
+{
+  return "";
+}
+
+void Tangle2Hdf5Output::DoWrite(const Tangle2EventRecord&)
+{}
+
+void Tangle2Hdf5Output::Flush()
+{}
+
+void Tangle2Hdf5Output::DoClose()
+{}
+
+#endif
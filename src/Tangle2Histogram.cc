@@ -0,0 +1,184 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2Histogram.hh"
+
+#include <cmath>
+#include <cstdio>
+
+Tangle2Histogram::Tangle2Histogram(const std::string& name,
+				   const std::string& xColumn,
+				   int nx, double xMin, double xMax,
+				   const std::string& yColumn,
+				   int ny, double yMin, double yMax)
+: fName(name),
+  fpX(FindColumn(xColumn)),
+  fpY(yColumn.empty() ? 0 : FindColumn(yColumn)),
+  fNx(nx), fNy(yColumn.empty() ? 0 : ny),
+  fXMin(xMin), fXMax(xMax), fYMin(yMin), fYMax(yMax),
+  fThetaWindow(false), fThetaMin(0.), fThetaMax(0.),
+  fpThetaA(FindColumn("ThetaA_1st")),
+  fpThetaB(FindColumn("ThetaB_1st")),
+  fEntries(0)
+{
+  // an unknown y column leaves fpY null, caught by IsValid
+  if (!yColumn.empty() && !fpY) fNy = -1;
+  
+  const std::size_t nBins = (fNx > 0 ? fNx + 2 : 0)*(fNy > 0 ? fNy + 2 : 1);
+  fSumW.assign(nBins, 0.);
+  fSumW2.assign(nBins, 0.);
+}
+
+const Tangle2EventRecord::Column*
+Tangle2Histogram::FindColumn(const std::string& name)
+{
+  const std::vector<Tangle2EventRecord::Column>& columns
+    = Tangle2EventRecord::Columns();
+  for (std::size_t i = 0; i < columns.size(); i++)
+    if (columns[i].name == name) return &columns[i];
+  return 0;
+}
+
+void Tangle2Histogram::SetThetaWindow(double min, double max)
+{
+  fThetaWindow = true;
+  fThetaMin = min;
+  fThetaMax = max;
+}
+
+bool Tangle2Histogram::IsValid() const
+{
+  return fpX && fNx > 0 && fXMax > fXMin &&
+    (fNy == 0 || (fpY && fNy > 0 && fYMax > fYMin));
+}
+
+int Tangle2Histogram::Bin(double value, int n, double min, double max)
+{
+  if (!(value >= min)) return 0;  // NaN to underflow
+  if (value >= max) return n + 1;
+  const int bin = 1 + int((value - min)/(max - min)*n);
+  return bin > n ? n : bin;
+}
+
+void Tangle2Histogram::Fill(const Tangle2EventRecord& record)
+{
+  if (fThetaWindow) {
+    const double thetaA = record.Get(*fpThetaA);
+    const double thetaB = record.Get(*fpThetaB);
+    if (!(thetaA > fThetaMin && thetaA < fThetaMax &&
+	  thetaB > fThetaMin && thetaB < fThetaMax))
+      return;
+  }
+  
+  std::size_t i = Bin(record.Get(*fpX), fNx, fXMin, fXMax);
+  if (fpY)
+    i += std::size_t(fNx + 2)*Bin(record.Get(*fpY), fNy, fYMin, fYMax);
+  
+  const double w = record.weight;
+  fSumW[i]  += w;
+  fSumW2[i] += w*w;
+  ++fEntries;
+}
+
+void Tangle2Histogram::Add(const Tangle2Histogram& other)
+{
+  for (std::size_t i = 0; i < fSumW.size() && i < other.fSumW.size(); i++) {
+    fSumW[i]  += other.fSumW[i];
+    fSumW2[i] += other.fSumW2[i];
+  }
+  fEntries += other.fEntries;
+}
+
+void Tangle2Histogram::Reset()
+{
+  fSumW.assign(fSumW.size(), 0.);
+  fSumW2.assign(fSumW2.size(), 0.);
+  fEntries = 0;
+}
+
+double Tangle2Histogram::GetSum() const
+{
+  double sum = 0.;
+  if (!fpY)
+    for (int ix = 1; ix <= fNx; ix++)
+      sum += fSumW[ix];
+  else
+    for (int iy = 1; iy <= fNy; iy++)
+      for (int ix = 1; ix <= fNx; ix++)
+	sum += fSumW[ix + std::size_t(fNx + 2)*iy];
+  return sum;
+}
+
+bool Tangle2Histogram::Write(const std::string& fileName) const
+{
+  std::FILE* file = std::fopen(fileName.c_str(), "w");
+  if (!file) return false;
+  
+  const double dx = (fXMax - fXMin)/fNx;
+  
+  std::fprintf(file, "# %s: %s", fName.c_str(), fpX->name.c_str());
+  if (fpY) std::fprintf(file, " vs %s", fpY->name.c_str());
+  if (fThetaWindow)
+    std::fprintf(file, ", %g < ThetaA_1st, ThetaB_1st < %g",
+		 fThetaMin, fThetaMax);
+  // contents in full, so files of several runs can be added up
+  std::fprintf(file, "\n# entries %ld, in range %.15g\n", fEntries, GetSum());
+  
+  if (!fpY) {
+    std::fprintf(file, "# underflow %.15g overflow %.15g\n",
+		 fSumW[0], fSumW[fNx + 1]);
+    for (int ix = 1; ix <= fNx; ix++)
+      std::fprintf(file, "%g %g %.15g %.15g\n",
+		   fXMin + (ix - 1)*dx, fXMin + ix*dx,
+		   fSumW[ix], std::sqrt(fSumW2[ix]));
+  }
+  else {
+    const double dy = (fYMax - fYMin)/fNy;
+    for (int ix = 1; ix <= fNx; ix++) {
+      for (int iy = 1; iy <= fNy; iy++)
+	std::fprintf(file, "%g %g %.15g\n",
+		     fXMin + (ix - 0.5)*dx, fYMin + (iy - 0.5)*dy,
+		     fSumW[ix + std::size_t(fNx + 2)*iy]);
+      std::fprintf(file, "\n");
+    }
+  }
+  
+  return std::fclose(file) == 0;
+}
+
+void Tangle2Histogram::WriteContents(std::FILE* file) const
+{
+  std::fprintf(file, "%s %zu %ld\n",
+	       fName.c_str(), fSumW.size(), fEntries);
+  for (std::size_t i = 0; i < fSumW.size(); i++)
+    std::fprintf(file, "%a %a\n", fSumW[i], fSumW2[i]);
+}
+
+bool Tangle2Histogram::ReadContents(std::FILE* file)
+{
+  char name[256];
+  std::size_t nBins;
+  long entries;
+  if (std::fscanf(file, " %255s %zu %ld",
+		  name, &nBins, &entries) != 3 ||
+      fName != name || nBins != fSumW.size())
+    return false;
+  
+  for (std::size_t i = 0; i < nBins; i++)
+    if (std::fscanf(file, " %la %la", &fSumW[i], &fSumW2[i]) != 2)
+      return false;
+  fEntries = entries;
+  return true;
+}
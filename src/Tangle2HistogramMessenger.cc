@@ -0,0 +1,171 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2HistogramMessenger.hh"
+
+#include "Tangle2Data.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include <sstream>
+
+namespace {
+
+  void AddParameter(G4UIcommand* command, const char* name, char type)
+  {
+    command->SetParameter(new G4UIparameter(name, type, false));
+  }
+
+  Tangle2Histogram* Find(const G4String& name)
+  {
+    for (std::size_t i = 0; i < Tangle2::histograms.size(); i++)
+      if (Tangle2::histograms[i].GetName() == name)
+	return &Tangle2::histograms[i];
+    return 0;
+  }
+
+  void Book(const Tangle2Histogram& histogram)
+  {
+    if (!histogram.IsValid()) {
+      G4cout << "Tangle2HistogramMessenger: " << histogram.GetName()
+	     << ": unknown column or empty range, not booked" << G4endl;
+      return;
+    }
+    Tangle2Histogram* existing = Find(histogram.GetName());
+    if (existing) *existing = histogram;
+    else Tangle2::histograms.push_back(histogram);
+  }
+
+}
+
+Tangle2HistogramMessenger::Tangle2HistogramMessenger()
+{
+  fpDirectory = new G4UIdirectory("/tangle2/hist/");
+  fpDirectory->SetGuidance("Histograms filled in the event loop.");
+  
+  fpH1Cmd = new G4UIcommand("/tangle2/hist/h1", this);
+  fpH1Cmd->SetGuidance("Book a 1D histogram of an ntuple column.");
+  fpH1Cmd->SetGuidance("e.g. /tangle2/hist/h1 dphi dPhi_1st 360 0 360");
+  AddParameter(fpH1Cmd, "name", 's');
+  AddParameter(fpH1Cmd, "column", 's');
+  AddParameter(fpH1Cmd, "nBins", 'i');
+  AddParameter(fpH1Cmd, "min", 'd');
+  AddParameter(fpH1Cmd, "max", 'd');
+  
+  fpH2Cmd = new G4UIcommand("/tangle2/hist/h2", this);
+  fpH2Cmd->SetGuidance("Book a 2D histogram of two ntuple columns.");
+  fpH2Cmd->SetGuidance
+    ("e.g. /tangle2/hist/h2 phiAB PhiA_1st 40 -200 200 PhiB_1st 40 -200 200");
+  AddParameter(fpH2Cmd, "name", 's');
+  AddParameter(fpH2Cmd, "xColumn", 's');
+  AddParameter(fpH2Cmd, "nx", 'i');
+  AddParameter(fpH2Cmd, "xMin", 'd');
+  AddParameter(fpH2Cmd, "xMax", 'd');
+  AddParameter(fpH2Cmd, "yColumn", 's');
+  AddParameter(fpH2Cmd, "ny", 'i');
+  AddParameter(fpH2Cmd, "yMin", 'd');
+  AddParameter(fpH2Cmd, "yMax", 'd');
+  
+  fpThetaWindowCmd = new G4UIcommand("/tangle2/hist/thetaWindow", this);
+  fpThetaWindowCmd->SetGuidance
+    ("Fill only events with ThetaA_1st and ThetaB_1st in (min, max) deg.");
+  AddParameter(fpThetaWindowCmd, "name", 's');
+  AddParameter(fpThetaWindowCmd, "min", 'd');
+  AddParameter(fpThetaWindowCmd, "max", 'd');
+  
+  fpNtupleOutputCmd
+    = new G4UIcmdWithABool("/tangle2/hist/ntupleOutput", this);
+  fpNtupleOutputCmd->SetGuidance("False: histograms only, no ntuple rows.");
+  fpNtupleOutputCmd->SetParameterName("ntupleOutput", false);
+  
+  fpClearCmd = new G4UIcmdWithoutParameter("/tangle2/hist/clear", this);
+  fpClearCmd->SetGuidance("Remove all histograms.");
+  
+  fpListCmd = new G4UIcmdWithoutParameter("/tangle2/hist/list", this);
+  fpListCmd->SetGuidance("List the histograms.");
+  
+  G4UIcommand* commands[] = {fpH1Cmd, fpH2Cmd, fpThetaWindowCmd,
+			     fpNtupleOutputCmd, fpClearCmd, fpListCmd};
+  for (std::size_t i = 0; i < sizeof(commands)/sizeof(commands[0]); i++) {
+    commands[i]->AvailableForStates(G4State_PreInit, G4State_Idle);
+    // Tangle2::histograms is shared, so book on the master only
+    commands[i]->SetToBeBroadcasted(false);
+  }
+}
+
+Tangle2HistogramMessenger::~Tangle2HistogramMessenger()
+{
+  delete fpListCmd;
+  delete fpClearCmd;
+  delete fpNtupleOutputCmd;
+  delete fpThetaWindowCmd;
+  delete fpH2Cmd;
+  delete fpH1Cmd;
+  delete fpDirectory;
+}
+
+void Tangle2HistogramMessenger::SetNewValue(G4UIcommand* command,
+					    G4String newValue)
+{
+  std::istringstream is(newValue);
+  
+  if (command == fpH1Cmd) {
+    G4String name, column;
+    G4int nBins;
+    G4double min, max;
+    is >> name >> column >> nBins >> min >> max;
+    Book(Tangle2Histogram(name, column, nBins, min, max));
+  }
+  else if (command == fpH2Cmd) {
+    G4String name, xColumn, yColumn;
+    G4int nx, ny;
+    G4double xMin, xMax, yMin, yMax;
+    is >> name >> xColumn >> nx >> xMin >> xMax
+       >> yColumn >> ny >> yMin >> yMax;
+    Book(Tangle2Histogram(name, xColumn, nx, xMin, xMax,
+			  yColumn, ny, yMin, yMax));
+  }
+  else if (command == fpThetaWindowCmd) {
+    G4String name;
+    G4double min, max;
+    is >> name >> min >> max;
+    Tangle2Histogram* histogram = Find(name);
+    if (histogram)
+      histogram->SetThetaWindow(min, max);
+    else
+      G4cout << "Tangle2HistogramMessenger: no histogram " << name << G4endl;
+  }
+  else if (command == fpNtupleOutputCmd) {
+    Tangle2::ntupleOutput = fpNtupleOutputCmd->GetNewBoolValue(newValue);
+  }
+  else if (command == fpClearCmd) {
+    Tangle2::histograms.clear();
+  }
+  else if (command == fpListCmd) {
+    for (std::size_t i = 0; i < Tangle2::histograms.size(); i++)
+      G4cout << " " << Tangle2::histograms[i].GetName() << G4endl;
+  }
+}
+
+G4String Tangle2HistogramMessenger::GetCurrentValue(G4UIcommand* command)
+{
+  if (command == fpNtupleOutputCmd)
+    return fpNtupleOutputCmd->ConvertToString(Tangle2::ntupleOutput);
+  return "";
+}
@@ -0,0 +1,109 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2MTRunManager.hh"
+
+#ifdef G4MULTITHREADED
+
+#include "G4AutoLock.hh"
+#include "G4Event.hh"
+#include "G4RNGHelper.hh"
+
+#include <algorithm>
+
+namespace {
+  // as setUpEventMutex of G4MTRunManager, which is not accessible
+  G4Mutex chunkMutex = G4MUTEX_INITIALIZER;
+}
+
+Tangle2MTRunManager::Tangle2MTRunManager()
+: fChunkSeconds(0.05), fNChunks(0), fMinChunk(0), fMaxChunk(0)
+{}
+
+Tangle2MTRunManager::~Tangle2MTRunManager()
+{}
+
+void Tangle2MTRunManager::InitializeEventLoop(G4int n_event,
+					      const char* macroFile,
+					      G4int n_select)
+{
+  G4MTRunManager::InitializeEventLoop(n_event, macroFile, n_select);
+  fStart = Clock::now();
+  fNChunks = 0;
+  fMinChunk = fMaxChunk = 0;
+}
+
+G4int Tangle2MTRunManager::ChunkSize() const
+{
+  const G4int remaining = numberOfEventToBeProcessed - numberOfEventProcessed;
+  const G4int nThreads = std::max(GetNumberOfThreads(), 1);
+  
+  G4int chunk = 1;
+  const G4double elapsed
+    = std::chrono::duration<G4double>(Clock::now() - fStart).count();
+  if (elapsed >= fChunkSeconds && numberOfEventProcessed > 0) {
+    // seconds per event on one thread
+    const G4double cost = elapsed*nThreads/numberOfEventProcessed;
+    chunk = G4int(std::min(fChunkSeconds/cost, 1.e9));
+  }
+  // guided: never more than a share of what is left
+  chunk = std::min(chunk, remaining/(2*nThreads));
+  return std::max(chunk, 1);
+}
+
+// As G4MTRunManager::SetUpNEvents, with ChunkSize for eventModulo
+size_t Tangle2MTRunManager::SetUpNEvents(G4Event* evt,
+					 G4SeedsQueue* seedsQueue,
+					 G4bool reseedRequired)
+{
+  G4AutoLock lock(&chunkMutex);
+  if (numberOfEventProcessed >= numberOfEventToBeProcessed || runAborted)
+    return 0;
+  
+  G4int nev = std::min(ChunkSize(),
+		       numberOfEventToBeProcessed - numberOfEventProcessed);
+  evt->SetEventID(numberOfEventProcessed);
+  
+  if (reseedRequired) {
+    G4RNGHelper* helper = G4RNGHelper::GetInstance();
+    const G4int nevRnd = SeedOncePerCommunication() > 0 ? 1 : nev;
+    for (G4int i = 0; i < nevRnd; i++) {
+      seedsQueue->push(helper->GetSeed(nSeedsFilled));
+      seedsQueue->push(helper->GetSeed(nSeedsFilled + 1));
+      if (nSeedsPerEvent == 3)
+	seedsQueue->push(helper->GetSeed(nSeedsFilled + 2));
+      nSeedsFilled += nSeedsPerEvent;
+      if (nSeedsFilled >= nSeedsMax) RefillSeeds();
+    }
+  }
+  
+  numberOfEventProcessed += nev;
+  
+  if (fNChunks == 0 || nev < fMinChunk) fMinChunk = nev;
+  if (nev > fMaxChunk) fMaxChunk = nev;
+  ++fNChunks;
+  return nev;
+}
+
+void Tangle2MTRunManager::RunTermination()
+{
+  G4MTRunManager::RunTermination();
+  if (fNChunks > 0)
+    G4cout << "Tangle2MTRunManager: " << numberOfEventProcessed
+	   << " events in " << fNChunks << " chunks of " << fMinChunk
+	   << " to " << fMaxChunk << " events" << G4endl;
+}
+
+#endif
@@ -0,0 +1,77 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2OutputBackend.hh"
+
+#include <chrono>
+#include <fstream>
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  double SecondsSince(const Clock::time_point& start)
+  {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+}
+
+Tangle2OutputBackend::Tangle2OutputBackend()
+: fOpen(false), fNRows(0), fNBytes(0), fSeconds(0.)
+{}
+
+Tangle2OutputBackend::~Tangle2OutputBackend()
+{}
+
+bool Tangle2OutputBackend::Open(const std::string& fileName)
+{
+  fNRows   = 0;
+  fNBytes  = 0;
+  fSeconds = 0.;
+  
+  Clock::time_point start = Clock::now();
+  fFileName = DoOpen(fileName);
+  fSeconds += SecondsSince(start);
+  
+  fOpen = !fFileName.empty();
+  return fOpen;
+}
+
+void Tangle2OutputBackend::Write(const Tangle2EventRecord& record)
+{
+  if (!fOpen) return;
+  
+  Clock::time_point start = Clock::now();
+  DoWrite(record);
+  fSeconds += SecondsSince(start);
+  
+  ++fNRows;
+}
+
+void Tangle2OutputBackend::Close()
+{
+  if (!fOpen) return;
+  
+  Clock::time_point start = Clock::now();
+  DoClose();
+  fSeconds += SecondsSince(start);
+  
+  fOpen = false;
+  
+  std::ifstream file(fFileName.c_str(), std::ios::binary | std::ios::ate);
+  if (file)
+    fNBytes = long(file.tellg());
+}
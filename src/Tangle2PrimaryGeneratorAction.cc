@@ -30,13 +30,18 @@
 #include "Randomize.hh"
 #include "G4RandomDirection.hh"
 #include "G4PhysicalConstants.hh"
+#include "G4Exception.hh"
 
 #include "G4GeneralParticleSource.hh"
 
 
 Tangle2PrimaryGeneratorAction::Tangle2PrimaryGeneratorAction()
 : G4VUserPrimaryGeneratorAction(),
-  fParticleGun(0)
+  fParticleGun(0),
+  fDirectionSampler(Tangle2::config.fullPET),
+  fDirectionSamplerSet(false),
+  fDirectionSamplerFullPET(false),
+  fNTrialLimitReached(0)
 {
   G4int n_particle = 1;
   fParticleGun  = new G4ParticleGun(n_particle);
@@ -52,17 +57,26 @@ void Tangle2PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
   G4ParticleTable* particleTable = G4ParticleTable::GetParticleTable();
   G4String particleName;
 
+  // In sequential mode this action is built before the macro
+  // has set the configuration
+  if (!fDirectionSamplerSet ||
+      fDirectionSamplerFullPET != Tangle2::config.fullPET) {
+    fDirectionSampler = Tangle2DirectionSampler(Tangle2::config.fullPET);
+    fDirectionSamplerSet = true;
+    fDirectionSamplerFullPET = Tangle2::config.fullPET;
+  }
+
   // Use positrons or
   // back to back photons
   G4bool generatePositrons = false;
-  if(Tangle2::positrons)
+  if(Tangle2::config.positrons)
     generatePositrons = true;
   
   // For back to back photons
   // a fixed axis beam can be chosen
   G4bool generateFixedAxis = false; 
   
-  if (Tangle2::fixedAxis){
+  if (Tangle2::config.fixedAxis){
     if(!generatePositrons)
       generateFixedAxis = true;
     else
@@ -74,7 +88,7 @@ void Tangle2PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
   // For back to back photons
   // the relative polarisation
   // can be orthogonal or random
-  if(Tangle2::perpPol){
+  if(Tangle2::config.perpPol){
     if(!generatePositrons) 
       generatePerpPol = true;
     else 
@@ -86,9 +100,12 @@ void Tangle2PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
   // fixed beam in x direction
   G4bool generatePolYandZ = false;
   
-  if(Tangle2::polYZ)
+  if(Tangle2::config.polYZ)
     generatePolYandZ = true;
   
+  // weight 1 unless acceptance sampling is used
+  Tangle2::eventWeight = 1.;
+  
   // vertex
   G4double x0  = 0*cm, y0  = 0*cm, z0  = 0*cm;
   
@@ -101,33 +118,38 @@ void Tangle2PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
     }
     else{ // isotropic over theta = [0,12] degrees
       
-      G4double theta    = 999999.9;
-      G4double cosTheta = 99999.9;
-      G4double sinTheta = 9999.9;
-      G4double phi      = 999.9;
-      G4double thetaMax = 12.; // atan(6 mm / radius in mm)
-
-      if(Tangle2::fullPET)
-	thetaMax = 0.8;
-	
-      // thetaMax degrees is just outside of 
-      // outer crystal outer edge
-      while(theta > thetaMax ){
-	// code from G4RandomDirection
-	cosTheta  = 2.*G4UniformRand()-1.;
-	G4double sinTheta2 = 1. - cosTheta*cosTheta;
-	if( sinTheta2 < 0.)  sinTheta2 = 0.;
-	sinTheta  = std::sqrt(sinTheta2); 
-	phi       = twopi*G4UniformRand();
-	theta = std::acos(cosTheta)* 180/(pi);
-      }
+      // sampled on the cone directly, see Tangle2DirectionSampler
+      const G4long maxTrials = 1000000;
+      G4double axis[3];
+      G4long   nTrials = 0;
+      G4bool   accepted;
+      do {
+	fDirectionSampler.SampleCone(G4UniformRand(), G4UniformRand(), axis);
+	nTrials++;
+	accepted = !Tangle2::config.acceptanceSampling ||
+	  fDirectionSampler.HitsArrays(axis);
+      } while(!accepted && nTrials < maxTrials);
+      
+      Tangle2::nDirectionTrials += nTrials;
       
-      // G4cout << " theta = " << theta << G4endl;
+      // No direction hitting the arrays: abort with no primaries
+      // rather than fire along a rejected one
+      if(!accepted){
+	fNTrialLimitReached++;
+	G4ExceptionDescription ed;
+	ed << "no direction hitting the arrays in " << maxTrials
+	   << " trials, event " << anEvent->GetEventID() << " aborted ("
+	   << fNTrialLimitReached << " on this thread so far)";
+	G4Exception("Tangle2PrimaryGeneratorAction::GeneratePrimaries",
+		    "Tangle2PrimaryGeneratorAction0001",JustWarning,ed);
+	anEvent->SetEventAborted();
+	return;
+      }
+      if(Tangle2::config.acceptanceSampling)
+	Tangle2::eventWeight = fDirectionSampler.Acceptance();
       
       // theta wrt x-axis (fixed beam in x)
-      beam_axis.set(cosTheta,
-		    sinTheta*std::cos(phi),
-		    sinTheta*std::sin(phi));
+      beam_axis.set(axis[0], axis[1], axis[2]);
       
       beam_axis = beam_axis.unit(); 
       
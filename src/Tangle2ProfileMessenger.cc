@@ -0,0 +1,65 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2ProfileMessenger.hh"
+
+#include "Tangle2Data.hh"
+#include "Tangle2StepProfiler.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+
+Tangle2ProfileMessenger::Tangle2ProfileMessenger()
+{
+  fpDirectory = new G4UIdirectory("/tangle2/profile/");
+  fpDirectory->SetGuidance("Step accounting by particle, process and volume.");
+  
+  fpEnableCmd = new G4UIcmdWithABool("/tangle2/profile/enable", this);
+  fpEnableCmd->SetGuidance("Count steps and their time in the next runs;");
+  fpEnableCmd->SetGuidance("the table is printed at the end of each run.");
+  fpEnableCmd->SetGuidance("Needs a build with -DWITH_TANGLE2_PROFILE=ON.");
+  fpEnableCmd->SetParameterName("enable", true);
+  fpEnableCmd->SetDefaultValue(true);
+  fpEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  // Tangle2::profileSteps is shared, so set it on the master only
+  fpEnableCmd->SetToBeBroadcasted(false);
+}
+
+Tangle2ProfileMessenger::~Tangle2ProfileMessenger()
+{
+  delete fpEnableCmd;
+  delete fpDirectory;
+}
+
+void Tangle2ProfileMessenger::SetNewValue(G4UIcommand* command,
+					  G4String newValue)
+{
+  if (command == fpEnableCmd) {
+    const G4bool enable = fpEnableCmd->GetNewBoolValue(newValue);
+    if (enable && !Tangle2StepProfiler::IsAvailable()) {
+      G4cout << "/tangle2/profile/enable: this build has no step profiler;"
+	" rebuild with -DWITH_TANGLE2_PROFILE=ON." << G4endl;
+      return;
+    }
+    Tangle2::profileSteps = enable;
+  }
+}
+
+G4String Tangle2ProfileMessenger::GetCurrentValue(G4UIcommand* command)
+{
+  if (command == fpEnableCmd)
+    return fpEnableCmd->ConvertToString(Tangle2::profileSteps);
+  return "";
+}
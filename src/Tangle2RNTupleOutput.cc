@@ -0,0 +1,144 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2RNTupleOutput.hh"
+
+#ifdef TANGLE2_WITH_RNTUPLE
+
+#include <ROOT/RNTupleModel.hxx>
+#include <ROOT/RNTupleWriter.hxx>
+#include <TROOT.h>
+
+#include <mutex>
+
+namespace {
+  std::once_flag threadSafetyFlag;
+}
+
+struct Tangle2RNTupleOutput::Writer
+{
+  std::unique_ptr<ROOT::RNTupleWriter> writer;
+  
+  // Field values, bound to the model, by column
+  std::vector<std::shared_ptr<float> >   floats;
+  std::vector<std::shared_ptr<int16_t> > int16s;
+  std::vector<std::shared_ptr<int64_t> > int64s;
+  std::vector<std::size_t> slot;
+};
+
+Tangle2RNTupleOutput::Tangle2RNTupleOutput()
+{}
+
+Tangle2RNTupleOutput::~Tangle2RNTupleOutput()
+{
+  Close();
+}
+
+bool Tangle2RNTupleOutput::IsAvailable()
+{
+  return true;
+}
+
+std::string Tangle2RNTupleOutput::DoOpen(const std::string& fileName)
+{
+  // Every worker thread writes its own file
+  std::call_once(threadSafetyFlag, [] { ROOT::EnableThreadSafety(); });
+  
+  const std::string name = fileName + ".root";
+  const std::vector<Tangle2EventRecord::Column>& columns
+    = Tangle2EventRecord::Columns();
+  
+  fpWriter.reset(new Writer);
+  std::unique_ptr<ROOT::RNTupleModel> model = ROOT::RNTupleModel::Create();
+  
+  for (std::size_t i = 0; i < columns.size(); i++) {
+    switch (columns[i].type) {
+    case Tangle2EventRecord::kInt16:
+      fpWriter->slot.push_back(fpWriter->int16s.size());
+      fpWriter->int16s.push_back(model->MakeField<int16_t>(columns[i].name));
+      break;
+    case Tangle2EventRecord::kInt64:
+      fpWriter->slot.push_back(fpWriter->int64s.size());
+      fpWriter->int64s.push_back(model->MakeField<int64_t>(columns[i].name));
+      break;
+    default:
+      fpWriter->slot.push_back(fpWriter->floats.size());
+      fpWriter->floats.push_back(model->MakeField<float>(columns[i].name));
+      break;
+    }
+  }
+  
+  try {
+    fpWriter->writer
+      = ROOT::RNTupleWriter::Recreate(std::move(model), "Tangle2", name);
+  } catch (const std::exception&) {
+    fpWriter.reset();
+    return "";
+  }
+  return name;
+}
+
+void Tangle2RNTupleOutput::DoWrite(const Tangle2EventRecord& record)
+{
+  const std::vector<Tangle2EventRecord::Column>& columns
+    = Tangle2EventRecord::Columns();
+  
+  for (std::size_t i = 0; i < columns.size(); i++) {
+    const std::size_t j = fpWriter->slot[i];
+    const double value = record.Get(columns[i]);
+    switch (columns[i].type) {
+    case Tangle2EventRecord::kInt16: *fpWriter->int16s[j] = int16_t(value); break;
+    case Tangle2EventRecord::kInt64: *fpWriter->int64s[j] = int64_t(value); break;
+    default:                         *fpWriter->floats[j] = float(value);   break;
+    }
+  }
+  fpWriter->writer->Fill();
+}
+
+void Tangle2RNTupleOutput::DoClose()
+{
+  // the writer commits the dataset when it is destroyed
+  fpWriter.reset();
+}
+
+#else // no RNTuple
+
+struct Tangle2RNTupleOutput::Writer {};
+
+Tangle2RNTupleOutput::Tangle2RNTupleOutput()
+{}
+
+Tangle2RNTupleOutput::~Tangle2RNTupleOutput()
+{
+  Close();
+}
+
+bool Tangle2RNTupleOutput::IsAvailable()
+{
+  return false;
+}
+
+std::string Tangle2RNTupleOutput::DoOpen(const std::string&)
+{
+  return "";
+}
+
+void Tangle2RNTupleOutput::DoWrite(const Tangle2EventRecord&)
+{}
+
+void Tangle2RNTupleOutput::DoClose()
+{}
+
+#endif
@@ -16,13 +16,24 @@
 
 #include "Tangle2RunAction.hh"
 #include "Tangle2Data.hh"
+#include "Tangle2VSteppingAction.hh"
+#include "Tangle2G4RootOutput.hh"
+#include "Tangle2Hdf5Output.hh"
+#include "Tangle2RNTupleOutput.hh"
+#include "Tangle2AsyncOutput.hh"
 
 #include "G4Run.hh"
 #include "G4RunManager.hh"
 #include "G4Threading.hh"
 #include "G4AutoLock.hh"
+#include "G4Exception.hh"
+#include "Randomize.hh"
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdio>
 #include <fstream>
+#include <sstream>
 
 Tangle2RunAction* Tangle2RunAction::fpMasterRunAction = 0;
 
@@ -31,6 +42,14 @@ namespace {
 }
 
 Tangle2RunAction::Tangle2RunAction()
+: fpTangle2VSteppingAction(0),
+  fpOutput(0),
+  fAnalysisFileOpen(false),
+  fThreadID(G4Threading::G4GetThreadId()),
+  fCheckpointNumber(0),
+  fClosedRows(0),
+  fClosedBytes(0),
+  fClosedSeconds(0.)
 {
   if (G4Threading::IsMasterThread()) {
     fpMasterRunAction = this;
@@ -40,10 +59,11 @@ Tangle2RunAction::Tangle2RunAction()
 
 Tangle2RunAction::~Tangle2RunAction()
 {
+  delete fpOutput;
   delete G4AnalysisManager::Instance();
 }
 
-void Tangle2RunAction::BeginOfRunAction(const G4Run*)
+void Tangle2RunAction::BeginOfRunAction(const G4Run* run)
 {
   G4cout
     << "Tangle2RunAction::BeginOfRunAction: Thread: "
@@ -54,148 +74,126 @@ void Tangle2RunAction::BeginOfRunAction(const G4Run*)
 
     Tangle2::nEvents   = 0;
     Tangle2::nEventsPh = 0;
+    Tangle2::nEventsRejected = 0;
+    Tangle2::nEventsRejectedPh = 0;
+    Tangle2::nEventsSelected = 0;
+    Tangle2::nDirectionTrials = 0;
    
   } else {  // Master thread
 
     Tangle2::nMasterEvents = 0;
     Tangle2::nMasterEventsPh = 0;
+    Tangle2::nMasterEventsRejected = 0;
+    Tangle2::nMasterEventsRejectedPh = 0;
+    Tangle2::nMasterEventsSelected = 0;
+    Tangle2::nMasterDirectionTrials = 0;
+    Tangle2::nMasterOutputRows = 0;
+    Tangle2::nMasterOutputBytes = 0;
+    Tangle2::masterOutputSeconds = 0.;
+    Tangle2::masterEventSeconds = 0.;
+    fRunTimer.Start();
+    fRunStart = std::chrono::steady_clock::now();
+    fThreadSummaries.clear();
+    
+    // before the workers start
+    fCheckpoint.BeginOfRun(run->GetNumberOfEventToBeProcessed(),
+			   Tangle2::checkpointResume);
+    fTelemetry.BeginOfRun(run->GetNumberOfEventToBeProcessed());
+    fShard.BeginOfRun(run->GetNumberOfEventToBeProcessed(),
+		      Tangle2::checkpointResume);
   }
+  
+  fThreadID = G4Threading::G4GetThreadId();
+  fCheckpointNumber = fpMasterRunAction->fCheckpoint.GetFirst();
+  fClosedRows = 0;
+  fClosedBytes = 0;
+  fClosedSeconds = 0.;
+  fProfiler.BeginOfRun();
 
   G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
-  analysisManager->SetFirstNtupleId(1);
-  
-  analysisManager->CreateNtuple("Tangle2", "Tangle2");
-  
-  //energy deposited in crystals in A
-  analysisManager->CreateNtupleDColumn("edep0");
-  analysisManager->CreateNtupleDColumn("edep1");
-  analysisManager->CreateNtupleDColumn("edep2");
-  analysisManager->CreateNtupleDColumn("edep3");
-  analysisManager->CreateNtupleDColumn("edep4");
-  analysisManager->CreateNtupleDColumn("edep5");
-  analysisManager->CreateNtupleDColumn("edep6");
-  analysisManager->CreateNtupleDColumn("edep7");
-  analysisManager->CreateNtupleDColumn("edep8");
-  //energy deposited in crystals in B
-  analysisManager->CreateNtupleDColumn("edep9");
-  analysisManager->CreateNtupleDColumn("edep10");
-  analysisManager->CreateNtupleDColumn("edep11");
-  analysisManager->CreateNtupleDColumn("edep12");
-  analysisManager->CreateNtupleDColumn("edep13");
-  analysisManager->CreateNtupleDColumn("edep14");
-  analysisManager->CreateNtupleDColumn("edep15");
-  analysisManager->CreateNtupleDColumn("edep16");
-  analysisManager->CreateNtupleDColumn("edep17"); 
-
-  //energy deposited in collimator 
-  analysisManager->CreateNtupleDColumn("edepColl1");
-  analysisManager->CreateNtupleDColumn("edepColl2"); // 20
-
-  //number of Compton scattering processes in each crystal
-  analysisManager->CreateNtupleIColumn("nb_Compt0");
-  analysisManager->CreateNtupleIColumn("nb_Compt1");
-  analysisManager->CreateNtupleIColumn("nb_Compt2");
-  analysisManager->CreateNtupleIColumn("nb_Compt3");
-  analysisManager->CreateNtupleIColumn("nb_Compt4");
-  analysisManager->CreateNtupleIColumn("nb_Compt5");
-  analysisManager->CreateNtupleIColumn("nb_Compt6");
-  analysisManager->CreateNtupleIColumn("nb_Compt7");
-  analysisManager->CreateNtupleIColumn("nb_Compt8");
-    
-  analysisManager->CreateNtupleIColumn("nb_Compt9");
-  analysisManager->CreateNtupleIColumn("nb_Compt10");
-  analysisManager->CreateNtupleIColumn("nb_Compt11");
-  analysisManager->CreateNtupleIColumn("nb_Compt12");
-  analysisManager->CreateNtupleIColumn("nb_Compt13");
-  analysisManager->CreateNtupleIColumn("nb_Compt14");
-  analysisManager->CreateNtupleIColumn("nb_Compt15");
-  analysisManager->CreateNtupleIColumn("nb_Compt16");
-  analysisManager->CreateNtupleIColumn("nb_Compt17"); // 38
-
-  //position of first Compton in A
-  analysisManager->CreateNtupleDColumn("XposA_1st");
-  analysisManager->CreateNtupleDColumn("YposA_1st");
-  analysisManager->CreateNtupleDColumn("ZposA_1st");
-  //position of second Compton in A
-  analysisManager->CreateNtupleDColumn("XposA_2nd");
-  analysisManager->CreateNtupleDColumn("YposA_2nd");
-  analysisManager->CreateNtupleDColumn("ZposA_2nd");
-  //position of first Compton in B
-  analysisManager->CreateNtupleDColumn("XposB_1st");
-  analysisManager->CreateNtupleDColumn("YposB_1st");
-  analysisManager->CreateNtupleDColumn("ZposB_1st");
-  //position of second Compton in B
-  analysisManager->CreateNtupleDColumn("XposB_2nd");
-  analysisManager->CreateNtupleDColumn("YposB_2nd");
-  analysisManager->CreateNtupleDColumn("ZposB_2nd");
-  
-  //angles --> theta and phi 
-  //first Compton scatter
-  analysisManager->CreateNtupleDColumn("ThetaA_1st");
-  analysisManager->CreateNtupleDColumn("PhiA_1st");
-  analysisManager->CreateNtupleDColumn("ThetaB_1st");
-  analysisManager->CreateNtupleDColumn("PhiB_1st");
-  analysisManager->CreateNtupleDColumn("dPhi_1st");
-  //second Compton scatter
-  analysisManager->CreateNtupleDColumn("ThetaA_2nd");
-  analysisManager->CreateNtupleDColumn("PhiA_2nd");
-  analysisManager->CreateNtupleDColumn("ThetaB_2nd");
-  analysisManager->CreateNtupleDColumn("PhiB_2nd");
-  
-  analysisManager->CreateNtupleDColumn("dPhi_A1B2");
-  analysisManager->CreateNtupleDColumn("dPhi_A2B1");
-  analysisManager->CreateNtupleDColumn("dPhi_A2B2");
-  
-  analysisManager->CreateNtupleDColumn("thetaPolA");
-  analysisManager->CreateNtupleDColumn("thetaPolB");
-
-  analysisManager->CreateNtupleDColumn("nEvents");
-
-  //number of photoelectric processes in each crystal
-  analysisManager->CreateNtupleIColumn("nb_Photo0");
-  analysisManager->CreateNtupleIColumn("nb_Photo1");
-  analysisManager->CreateNtupleIColumn("nb_Photo2");
-  analysisManager->CreateNtupleIColumn("nb_Photo3");
-  analysisManager->CreateNtupleIColumn("nb_Photo4");
-  analysisManager->CreateNtupleIColumn("nb_Photo5");
-  analysisManager->CreateNtupleIColumn("nb_Photo6");
-  analysisManager->CreateNtupleIColumn("nb_Photo7");
-  analysisManager->CreateNtupleIColumn("nb_Photo8");
-    
-  analysisManager->CreateNtupleIColumn("nb_Photo9");
-  analysisManager->CreateNtupleIColumn("nb_Photo10");
-  analysisManager->CreateNtupleIColumn("nb_Photo11");
-  analysisManager->CreateNtupleIColumn("nb_Photo12");
-  analysisManager->CreateNtupleIColumn("nb_Photo13");
-  analysisManager->CreateNtupleIColumn("nb_Photo14");
-  analysisManager->CreateNtupleIColumn("nb_Photo15");
-  analysisManager->CreateNtupleIColumn("nb_Photo16");
-  analysisManager->CreateNtupleIColumn("nb_Photo17"); // 
-  
-  
-  //position of first Photoelectric in A
-  analysisManager->CreateNtupleDColumn("XposA_P1st");
-  analysisManager->CreateNtupleDColumn("YposA_P1st");
-  analysisManager->CreateNtupleDColumn("ZposA_P1st");
-  //position of second Photoelectric in A
-  analysisManager->CreateNtupleDColumn("XposA_P2nd");
-  analysisManager->CreateNtupleDColumn("YposA_P2nd");
-  analysisManager->CreateNtupleDColumn("ZposA_P2nd");
-  //position of first Photoelectric in B
-  analysisManager->CreateNtupleDColumn("XposB_P1st");
-  analysisManager->CreateNtupleDColumn("YposB_P1st");
-  analysisManager->CreateNtupleDColumn("ZposB_P1st");
-  //position of second Photoelectric in B
-  analysisManager->CreateNtupleDColumn("XposB_P2nd");
-  analysisManager->CreateNtupleDColumn("YposB_P2nd");
-  analysisManager->CreateNtupleDColumn("ZposB_P2nd");
-
- 
-  analysisManager->FinishNtuple();
-  
-  analysisManager->OpenFile("Tangle2");
+  
+  // dphi for fast and full simulation events, compared at the end
+  // of the run (filled in Tangle2EventAction)
+  if (Tangle2::fastSimMode == Tangle2::kFastSimValidate &&
+      analysisManager->GetH1Id("dphi_full", false) < 0) {
+    analysisManager->CreateH1("dphi_full", "dPhi_1st, full simulation",
+			      36, 0., 360.);
+    analysisManager->CreateH1("dphi_fast", "dPhi_1st, fast simulation",
+			      36, 0., 360.);
+  }
+  
+  // Selected events, see Tangle2OutputBackend
+  const G4int format = GetOutputFormat();
+  if (format != Tangle2::config.outputFormat &&
+      G4Threading::IsMasterThread())
+    G4cout << " Output format not available in this build,"
+	   << " using g4root" << G4endl;
+  
+  delete fpOutput;
+  fpOutput = 0;
+  fAnalysisFileOpen = false;
+  
+  if (!Tangle2::ntupleOutput) {
+    // histograms only, see below
+  } else if (format == Tangle2::kOutputG4Root) {
+    // on the master too, for the merged histograms
+    fpOutput = new Tangle2G4RootOutput;
+    fpOutput->Open(Tangle2::outputName);
+  } else {
+    // the master has no events to write in multi-threaded mode
+    if (G4Threading::IsWorkerThread() ||
+	!G4Threading::IsMultithreadedApplication()) {
+      if (format == Tangle2::kOutputHdf5)
+	fpOutput = new Tangle2Hdf5Output;
+      else
+	fpOutput = new Tangle2RNTupleOutput;
+      // serialise and compress on the writer thread
+      if (Tangle2::config.asyncOutput)
+	fpOutput = new Tangle2AsyncOutput(fpOutput);
+      
+      const G4String fileName = OutputFileName(fCheckpointNumber);
+      if (!fpOutput->Open(fileName))
+	G4cout << " Tangle2RunAction: can not open "
+	       << fpOutput->GetName() << " output " << fileName
+	       << G4endl;
+    }
+  }
+  if (fpOutput)
+    fpMasterRunAction->fTelemetry.SetOutput(fThreadID, 0,
+					    fpOutput->GetFileName());
+  // fast simulation histograms still go through G4AnalysisManager,
+  // into the g4root output file if there is one
+  if (Tangle2::fastSimMode == Tangle2::kFastSimValidate &&
+      !(Tangle2::ntupleOutput && format == Tangle2::kOutputG4Root)) {
+    analysisManager->OpenFile(Tangle2::outputName);
+    fAnalysisFileOpen = true;
+  }
+  
+  // Selection configured with /tangle2/select/, compiled per thread
+  fSelection = Tangle2::selection;
+  fSelection.Compile();
+  if (Tangle2::config.fastReject && !fSelection.NeedsScatter() &&
+      G4Threading::IsMasterThread())
+    G4Exception("Tangle2RunAction::BeginOfRunAction", "Tangle2RunAction0001",
+		JustWarning, "fastReject ignored for this run: the selection"
+		" does not need both gammas to scatter");
+  
+  // Histograms booked with /tangle2/hist/: a copy of the booking for
+  // each thread to fill, see EndOfRunAction
+  fHistograms = Tangle2::histograms;
+  if (G4Threading::IsMasterThread()) {
+    fWorkerHistograms.assign(kMaxThreads, 0);
+    fBaseHistograms.clear();
+    if (Tangle2::checkpointResume && fCheckpoint.IsEnabled())
+      ReadCheckpointHistograms(Tangle2::checkpointResume->histograms);
+  }
   
   G4RunManager::GetRunManager()->SetRandomNumberStore(false);
+
+  // Physics and geometry are in place by now, so the stepping
+  // action can resolve the pointers it compares against per step
+  if (fpTangle2VSteppingAction)
+    fpTangle2VSteppingAction->BeginOfRunAction();
   
 }
 
@@ -203,6 +201,49 @@ namespace {
   G4Mutex mutex = G4MUTEX_INITIALIZER;
 }
 
+void Tangle2RunAction::PrintFastSimComparison() const
+{
+  G4AnalysisManager* man = G4AnalysisManager::Instance();
+  G4int idFull = man->GetH1Id("dphi_full", false);
+  G4int idFast = man->GetH1Id("dphi_fast", false);
+  if (idFull < 0 || idFast < 0) return;
+  
+  tools::histo::h1d* full = man->GetH1(idFull);
+  tools::histo::h1d* fast = man->GetH1(idFast);
+  
+  G4int nBins = full->axis().bins();
+  G4double nFull = 0., nFast = 0.;
+  for (G4int i = 0; i < nBins; i++) {
+    nFull += full->bin_height(i);
+    nFast += fast->bin_height(i);
+  }
+  
+  G4cout << G4endl
+	 << "Fast simulation validation, dPhi_1st: "
+	 << nFull << " full, " << nFast << " fast events" << G4endl;
+  if (nFull <= 0. || nFast <= 0.) return;
+  
+  // Two sample chi2 for unweighted histograms
+  G4double chi2 = 0.;
+  G4int ndf = -1;
+  for (G4int i = 0; i < nBins; i++) {
+    G4double a = full->bin_height(i);
+    G4double b = fast->bin_height(i);
+    if (a + b <= 0.) continue;
+    G4double d = std::sqrt(nFast/nFull)*a - std::sqrt(nFull/nFast)*b;
+    chi2 += d*d/(a + b);
+    ndf++;
+  }
+  
+  G4cout << " chi2/ndf = " << chi2 << "/" << ndf;
+  if (ndf > 0)
+    G4cout << " = " << chi2/ndf;
+  G4cout << G4endl;
+  
+  G4cout << " mean dPhi: full " << full->mean()
+	 << " fast " << fast->mean() << " deg" << G4endl;
+}
+
 void Tangle2RunAction::EndOfRunAction(const G4Run* run)
 {
   
@@ -217,24 +258,120 @@ void Tangle2RunAction::EndOfRunAction(const G4Run* run)
     G4cout << Tangle2::nEvents << " events, "
 	   << ", " << Tangle2::nEventsPh << " QET events"
 	   << G4endl;
+    if (Tangle2::config.fastReject)
+      G4cout << Tangle2::nEventsRejected << " events rejected early, "
+	     << Tangle2::nEventsRejectedPh << " of them QET by then"
+	     << G4endl;
+    
+    UpdateTelemetry(Tangle2::nEvents, Tangle2::nEventsSelected);
+    CloseOutput();
+    PrintAsyncOutputStatistics();
+    
+    // Each worker has its own slot, so no lock is needed; the master
+    // reads them after all workers have finished the run
+    const G4int threadID = G4Threading::G4GetThreadId();
+    if (!fHistograms.empty() && fpMasterRunAction) {
+      if (threadID < kMaxThreads)
+	fpMasterRunAction->fWorkerHistograms[threadID] = &fHistograms;
+      else
+	G4cout << "Tangle2RunAction: thread " << threadID
+	       << " histograms not merged" << G4endl;
+    }
     
     // Always use a lock when writing to a 
     // location that is shared by threads
     G4AutoLock lock(&mutex);
     Tangle2::nMasterEvents += Tangle2::nEvents;
     Tangle2::nMasterEventsPh += Tangle2::nEventsPh;
+    Tangle2::nMasterEventsRejected += Tangle2::nEventsRejected;
+    Tangle2::nMasterEventsRejectedPh += Tangle2::nEventsRejectedPh;
+    Tangle2::nMasterEventsSelected += Tangle2::nEventsSelected;
+    Tangle2::nMasterDirectionTrials += Tangle2::nDirectionTrials;
+    AddOutputStatistics();
+    if (fpMasterRunAction)
+      fpMasterRunAction->fSelection.AddCounts(fSelection);
+    fpMasterRunAction->fProfiler.Add(fProfiler);
+    ThreadSummary summary = {threadID, Tangle2::nEvents,
+			     std::chrono::duration<G4double>
+			     (std::chrono::steady_clock::now() -
+			      fpMasterRunAction->fRunStart).count()};
+    fpMasterRunAction->fThreadSummaries.push_back(summary);
+    fpMasterRunAction->fCheckpoint.Record
+      (threadID, GetCheckpointCounts(),
+       fpOutput ? G4String(fpOutput->GetFileName()) : G4String(),
+       fpMasterRunAction->fCheckpoint.IsEnabled() ?
+       WriteCheckpointHistograms(fCheckpointNumber) : G4String());
+    if (fpOutput)
+      fpMasterRunAction->fShard.AddFile(fpOutput->GetFileName());
     
   } else {  // Master thread
+    fRunTimer.Stop();
+    Tangle2::masterEventSeconds = fRunTimer.GetRealElapsed();
+    // the events in sequential mode; the workers are done
+    UpdateTelemetry(Tangle2::nEvents, Tangle2::nEventsSelected);
+    fTelemetry.EndOfRun();
+    
+    // Worker histograms have been merged into the master's by now,
+    // compare them before the master writes (and resets) them
+    if (Tangle2::fastSimMode == Tangle2::kFastSimValidate)
+      PrintFastSimComparison();
+    CloseOutput();
+    AddOutputStatistics();
+    // the events in sequential mode, only the file otherwise
+    fCheckpoint.Record
+      (-1, GetCheckpointCounts(),
+       fpOutput ? G4String(fpOutput->GetFileName()) : G4String(),
+       fCheckpoint.IsEnabled() ?
+       WriteCheckpointHistograms(fCheckpointNumber) : G4String());
+    fCheckpoint.EndOfRun();
+    if (fpOutput)
+      fShard.AddFile(fpOutput->GetFileName());
+    
     Tangle2::nMasterEvents += Tangle2::nEvents;
     Tangle2::nMasterEventsPh += Tangle2::nEventsPh;
+    Tangle2::nMasterEventsRejected += Tangle2::nEventsRejected;
+    Tangle2::nMasterEventsRejectedPh += Tangle2::nEventsRejectedPh;
+    Tangle2::nMasterEventsSelected += Tangle2::nEventsSelected;
+    Tangle2::nMasterDirectionTrials += Tangle2::nDirectionTrials;
     G4cout
       << "Tangle2RunAction::EndOfRunAction: Master thread: "
       << G4endl;
     
     G4cout << Tangle2::nMasterEvents   << " events, "
-	   << Tangle2::nMasterEventsPh << " QET events"
+	   << Tangle2::nMasterEventsPh << " QET events, "
+	   << Tangle2::nMasterEventsSelected << " selected"
 	   << G4endl;
+    // read by tangle2_scaling
+    G4cout << "Event loop " << Tangle2::masterEventSeconds << " s" << G4endl;
+    // Rejected events are counted in nEvents but not in the QET
+    // events, which are of the events tracked to the end; those QET
+    // already when given up on are a lower bound for the rest (see
+    // Tangle2Config::fastReject)
+    if (Tangle2::config.fastReject)
+      G4cout << Tangle2::nMasterEventsRejected
+	     << " events rejected early, "
+	     << Tangle2::nMasterEventsRejectedPh << " of them QET by then"
+	     << G4endl;
+    // Each event stands for (trials/events) cone events
+    if (Tangle2::config.acceptanceSampling &&
+	!Tangle2::config.positrons && !Tangle2::config.fixedAxis)
+      G4cout << Tangle2::nMasterDirectionTrials
+	     << " beam axes drawn for the events on the fixed cone,"
+	     << " weight = acceptance of the arrays"
+	     << G4endl;
+    PrintOutputStatistics();
+    PrintThreadBalance();
+    PrintSelectionReport();
+    MergeAndWriteHistograms();
+    fShard.EndOfRun(Tangle2::nMasterEvents, Tangle2::nMasterOutputRows);
+    // the master's own steps in sequential mode
+    if (!G4Threading::IsMultithreadedApplication())
+      fProfiler.Add(fProfiler);
+    fProfiler.Print();
   }
+
+  if (fpTangle2VSteppingAction)
+    fpTangle2VSteppingAction->EndOfRunAction();
   
   //   G4cout << G4endl;
   //   G4cout << " nA1B1 = " << Tangle2::nA1B1 << G4endl;
@@ -243,8 +380,268 @@ void Tangle2RunAction::EndOfRunAction(const G4Run* run)
   //   G4cout << " nA2B2 = " << Tangle2::nA2B2 << G4endl;
   //   G4cout << G4endl;
   
-  G4AnalysisManager* man = G4AnalysisManager::Instance();
-  man->Write();
-  man->CloseFile();
+}
+
+// Master only, worker counts added in by now
+void Tangle2RunAction::PrintSelectionReport() const
+{
+  G4cout << "Selection, cuts in the order applied:" << G4endl
+	 << fSelection.Report();
+}
+
+// Master only.  Adding the workers in thread order, rather than as
+// they finish, makes the sums the same from run to run.
+void Tangle2RunAction::MergeAndWriteHistograms()
+{
+  if (fHistograms.empty()) return;
+  
+  // sequential mode: the master has filled its own
+  if (G4Threading::IsMultithreadedApplication()) {
+    for (std::size_t h = 0; h < fHistograms.size(); h++)
+      fHistograms[h].Reset();
+    for (G4int i = 0; i < kMaxThreads; i++) {
+      const std::vector<Tangle2Histogram>* worker = fWorkerHistograms[i];
+      if (!worker) continue;
+      for (std::size_t h = 0; h < fHistograms.size(); h++)
+	fHistograms[h].Add((*worker)[h]);
+    }
+  }
+  // and the runs before a resume
+  for (std::size_t h = 0; h < fBaseHistograms.size(); h++)
+    fHistograms[h].Add(fBaseHistograms[h]);
+  
+  for (std::size_t h = 0; h < fHistograms.size(); h++) {
+    const Tangle2Histogram& histogram = fHistograms[h];
+    const G4String fileName
+      = Tangle2::outputName + "_hist_" + histogram.GetName() + ".txt";
+    if (!histogram.Write(fileName))
+      G4cout << " Can not write " << fileName << G4endl;
+    else
+      fShard.AddHistogram(fileName);
+    G4cout << " Histogram " << histogram.GetName() << ": "
+	   << histogram.GetEntries() << " entries, "
+	   << histogram.GetSum() << " in range, written to "
+	   << fileName << G4endl;
+  }
+}
+
+// This thread's histograms so far, for a resume to add back (see
+// Tangle2Checkpoint); "" if there are none.  Through a temporary file,
+// as the name is reused at the end of the run.
+G4String Tangle2RunAction::WriteCheckpointHistograms(G4int checkpoint) const
+{
+  // the master fills none in multi-threaded mode
+  if (fHistograms.empty() ||
+      (G4Threading::IsMasterThread() &&
+       G4Threading::IsMultithreadedApplication()))
+    return "";
+  
+  const G4String fileName = OutputFileName(checkpoint) + ".hist";
+  const G4String tmpName = fileName + ".tmp";
+  std::FILE* file = std::fopen(tmpName.c_str(), "w");
+  G4bool ok = file != 0;
+  if (file) {
+    for (std::size_t h = 0; h < fHistograms.size(); h++)
+      fHistograms[h].WriteContents(file);
+    ok = std::fclose(file) == 0 &&
+      std::rename(tmpName.c_str(), fileName.c_str()) == 0;
+  }
+  if (!ok) {
+    G4cout << " Tangle2RunAction: can not write " << fileName << G4endl;
+    return "";
+  }
+  return fileName;
+}
+
+// Master, start of a resumed run
+void Tangle2RunAction::ReadCheckpointHistograms
+(const std::vector<G4String>& files)
+{
+  fBaseHistograms = fHistograms;
+  for (std::size_t h = 0; h < fBaseHistograms.size(); h++)
+    fBaseHistograms[h].Reset();
+  
+  for (std::size_t i = 0; i < files.size(); i++) {
+    std::FILE* file = std::fopen(files[i].c_str(), "r");
+    G4bool ok = file != 0;
+    std::vector<Tangle2Histogram> contents = fHistograms;
+    for (std::size_t h = 0; ok && h < contents.size(); h++)
+      ok = contents[h].ReadContents(file);
+    if (file) std::fclose(file);
+    if (!ok) {
+      G4cout << " Tangle2RunAction: " << files[i] << " missing or not"
+	     << " of the same /tangle2/hist/ booking, not added" << G4endl;
+      continue;
+    }
+    for (std::size_t h = 0; h < contents.size(); h++)
+      fBaseHistograms[h].Add(contents[h]);
+  }
+}
+
+void Tangle2RunAction::CloseOutput()
+{
+  if (fpOutput) fpOutput->Close();
+  
+  if (fAnalysisFileOpen) {
+    G4AnalysisManager* man = G4AnalysisManager::Instance();
+    man->Write();
+    man->CloseFile();
+    fAnalysisFileOpen = false;
+  }
+}
+
+// Call with the lock held on workers
+void Tangle2RunAction::AddOutputStatistics() const
+{
+  if (!fpOutput) return;
+  
+  Tangle2::nMasterOutputRows  += fClosedRows + fpOutput->GetNRows();
+  Tangle2::nMasterOutputBytes += fClosedBytes + fpOutput->GetNBytes();
+  // threads write in parallel, so keep the slowest
+  const G4double seconds = fClosedSeconds + fpOutput->GetSeconds();
+  if (seconds > Tangle2::masterOutputSeconds)
+    Tangle2::masterOutputSeconds = seconds;
+}
+
+G4int Tangle2RunAction::GetOutputFormat()
+{
+  const G4int format = Tangle2::config.outputFormat;
+  if ((format == Tangle2::kOutputHdf5 &&
+       !Tangle2Hdf5Output::IsAvailable()) ||
+      (format == Tangle2::kOutputRNTuple &&
+       !Tangle2RNTupleOutput::IsAvailable()))
+    return Tangle2::kOutputG4Root;
+  return format;
+}
+
+G4String Tangle2RunAction::OutputFileName(G4int checkpoint) const
+{
+  std::ostringstream fileName;
+  fileName << Tangle2::outputName;
+  if (G4Threading::IsWorkerThread())
+    fileName << "_t" << G4Threading::G4GetThreadId();
+  if (checkpoint > 0)
+    fileName << "_c" << checkpoint;
+  return fileName.str();
+}
+
+// This thread's totals, its output closed
+Tangle2CheckpointState::Counts Tangle2RunAction::GetCheckpointCounts() const
+{
+  Tangle2CheckpointState::Counts counts;
+  counts.nEvents          = Tangle2::nEvents;
+  counts.nEventsPh        = Tangle2::nEventsPh;
+  counts.nEventsRejected  = Tangle2::nEventsRejected;
+  counts.nEventsRejectedPh = Tangle2::nEventsRejectedPh;
+  counts.nDirectionTrials = Tangle2::nDirectionTrials;
+  counts.nRows            = fClosedRows;
+  if (fpOutput) counts.nRows += fpOutput->GetNRows();
+  return counts;
+}
+
+// Any thread, between events
+void Tangle2RunAction::Checkpoint(G4int checkpoint)
+{
+  fCheckpointNumber = checkpoint;
+  
+  // never g4root, see Tangle2Checkpoint::IsPossible
+  G4String closedFile;
+  if (fpOutput) {
+    fpOutput->Close();
+    closedFile = fpOutput->GetFileName();
+    fClosedRows    += fpOutput->GetNRows();
+    fClosedBytes   += fpOutput->GetNBytes();
+    fClosedSeconds += fpOutput->GetSeconds();
+    const G4String fileName = OutputFileName(checkpoint);
+    if (!fpOutput->Open(fileName))
+      G4cout << " Tangle2RunAction: can not open "
+	     << fpOutput->GetName() << " output " << fileName << G4endl;
+    fpMasterRunAction->fTelemetry.SetOutput(fThreadID, fClosedBytes,
+					    fpOutput->GetFileName());
+  }
+  
+  std::ostringstream engineFile;
+  engineFile << Tangle2::outputName;
+  if (G4Threading::IsWorkerThread())
+    engineFile << "_t" << G4Threading::G4GetThreadId();
+  engineFile << ".rndm";
+  G4Random::saveEngineStatus(engineFile.str().c_str());
+  
+  // this thread's histograms so far
+  const G4String histogramFile = WriteCheckpointHistograms(checkpoint);
+  
+  G4AutoLock lock(&mutex);
+  fpMasterRunAction->fCheckpoint.Record(G4Threading::G4GetThreadId(),
+					 GetCheckpointCounts(), closedFile,
+					 histogramFile);
+  fpMasterRunAction->fShard.AddFile(closedFile);
+}
+
+// Ring occupancy and writer lag, for tuning the ring capacity
+void Tangle2RunAction::PrintAsyncOutputStatistics() const
+{
+  const Tangle2AsyncOutput* output
+    = dynamic_cast<const Tangle2AsyncOutput*>(fpOutput);
+  if (!output || output->GetNRows() == 0) return;
+  
+  const Tangle2AsyncOutput::Statistics& s = output->GetStatistics();
+  G4cout << "Async output: ring occupancy mean " << s.meanOccupancy
+	 << ", max " << s.maxOccupancy << " of " << s.capacity
+	 << "; " << s.nStalls << " stalls (" << s.stallSeconds << " s)"
+	 << "; writer lag mean " << s.meanLagSeconds*1.e3
+	 << " ms, max " << s.maxLagSeconds*1.e3 << " ms"
+	 << "; " << s.nBatches << " batches, " << s.writerSeconds
+	 << " s writing"
+	 << G4endl;
+}
+
+void Tangle2RunAction::PrintThreadBalance() const
+{
+  const std::size_t nThreads = fThreadSummaries.size();
+  if (nThreads < 2) return;
+  
+  const ThreadSummary* fewest = &fThreadSummaries[0];
+  const ThreadSummary* most   = &fThreadSummaries[0];
+  G4double first = fThreadSummaries[0].finishSeconds, last = first;
+  G4long nEvents = 0;
+  for (std::size_t i = 0; i < nThreads; i++) {
+    const ThreadSummary& s = fThreadSummaries[i];
+    if (s.nEvents < fewest->nEvents) fewest = &s;
+    if (s.nEvents > most->nEvents)   most = &s;
+    first = std::min(first, s.finishSeconds);
+    last  = std::max(last,  s.finishSeconds);
+    nEvents += s.nEvents;
+  }
+  // thread time spent waiting for the last thread to finish
+  G4double idle = 0.;
+  for (std::size_t i = 0; i < nThreads; i++)
+    idle += last - fThreadSummaries[i].finishSeconds;
+  const G4double mean = G4double(nEvents)/nThreads;
+  
+  G4cout << "Events per thread: min " << fewest->nEvents
+	 << " (thread " << fewest->threadID << "), mean " << mean
+	 << ", max " << most->nEvents << " (thread " << most->threadID
+	 << "), max/mean " << (mean > 0. ? most->nEvents/mean : 0.)
+	 << G4endl
+	 << "Threads finished " << first << " to " << last
+	 << " s into the run, "
+	 << (last > 0. ? 100.*idle/(nThreads*last) : 0.)
+	 << "% of thread time waiting for the last" << G4endl;
+}
+
+void Tangle2RunAction::PrintOutputStatistics() const
+{
+  if (Tangle2::nMasterOutputRows == 0) return;
+  
+  G4double bytesPerEvent =
+    G4double(Tangle2::nMasterOutputBytes)/Tangle2::nMasterOutputRows;
+  G4double mbPerSecond = Tangle2::masterOutputSeconds > 0. ?
+    Tangle2::nMasterOutputBytes/1.e6/Tangle2::masterOutputSeconds : 0.;
   
+  G4cout << Tangle2::nMasterOutputRows << " events written, "
+	 << Tangle2::nMasterOutputBytes << " bytes ("
+	 << bytesPerEvent << " bytes/event) in "
+	 << Tangle2::masterOutputSeconds << " s, "
+	 << mbPerSecond << " MB/s"
+	 << G4endl;
 }
@@ -0,0 +1,315 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2Selection.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+
+  const uint32_t kArrayA = (1u << 9) - 1;
+  const uint32_t kArrayB = kArrayA << 9;
+
+  int PopCount(uint32_t mask)
+  {
+    int n = 0;
+    for (; mask; mask &= mask - 1) ++n;
+    return n;
+  }
+
+  std::string CrystalList(uint32_t mask)
+  {
+    if (mask == kArrayA) return "A";
+    if (mask == kArrayB) return "B";
+    if (mask == (kArrayA | kArrayB)) return "A B";
+    std::ostringstream os;
+    for (int i = 0; i < Tangle2Selection::kNCrystals; i++)
+      if (mask & (1u << i)) os << (os.tellp() > 0 ? " " : "") << i;
+    return os.str();
+  }
+
+}
+
+Tangle2Selection::Tangle2Selection()
+{
+  Reset();
+}
+
+void Tangle2Selection::Clear()
+{
+  fCuts.clear();
+  fFirstAngleCut = 0;
+  fHitMaskValid = false;
+}
+
+void Tangle2Selection::Reset()
+{
+  Clear();
+  SetThreshold(0.005);
+  // 4 and 13 are the central crystals
+  AddHits((1u << 4) | (1u << 13), 2);
+  AddScattered();
+  Compile();
+}
+
+uint32_t Tangle2Selection::ParseCrystals(const std::string& list, bool& ok)
+{
+  std::istringstream is(list);
+  std::string token;
+  uint32_t mask = 0;
+  ok = true;
+  while (is >> token) {
+    if (token == "A") mask |= kArrayA;
+    else if (token == "B") mask |= kArrayB;
+    else {
+      char* end;
+      const long i = std::strtol(token.c_str(), &end, 10);
+      if (*end || i < 0 || i >= kNCrystals) {
+	ok = false;
+	return 0;
+      }
+      mask |= 1u << i;
+    }
+  }
+  ok = mask != 0;
+  return mask;
+}
+
+void Tangle2Selection::SetThreshold(int crystal, double eThres)
+{
+  if (crystal >= 0 && crystal < kNCrystals)
+    fThreshold[crystal] = eThres;
+}
+
+void Tangle2Selection::SetThreshold(double eThres)
+{
+  for (int i = 0; i < kNCrystals; i++)
+    fThreshold[i] = eThres;
+}
+
+void Tangle2Selection::AddHits(uint32_t crystals, int minHits)
+{
+  Cut cut = {kHits, crystals, minHits, 0, 0., 0., 0, 0};
+  fCuts.push_back(cut);
+}
+
+void Tangle2Selection::AddCompton(int minA, int minB)
+{
+  Cut cut = {kCompton, 0, minA, minB, 0., 0., 0, 0};
+  fCuts.push_back(cut);
+}
+
+void Tangle2Selection::AddEnergy(uint32_t crystals, double min, double max)
+{
+  Cut cut = {kEnergy, crystals, 0, 0, min, max, 0, 0};
+  fCuts.push_back(cut);
+}
+
+void Tangle2Selection::AddScattered()
+{
+  Cut cut = {kScattered, 0, 0, 0, 0., 0., 0, 0};
+  fCuts.push_back(cut);
+}
+
+void Tangle2Selection::AddTheta(double min, double max)
+{
+  Cut cut = {kTheta, 0, 0, 0, min, max, 0, 0};
+  fCuts.push_back(cut);
+}
+
+bool Tangle2Selection::NeedsScatter() const
+{
+  for (std::size_t i = 0; i < fCuts.size(); i++) {
+    const Cut& cut = fCuts[i];
+    if (cut.type == kScattered) return true;
+    if (cut.type == kCompton && (cut.n1 > 0 || cut.n2 > 0)) return true;
+    if (cut.type == kTheta && !(cut.min < 0. && cut.max > 0.)) return true;
+  }
+  return false;
+}
+
+Tangle2Selection::Phase Tangle2Selection::PhaseOf(Type type)
+{
+  return (type == kScattered || type == kTheta) ? kAfterAngles : kBeforeAngles;
+}
+
+// Relative cost of a test, angles not included
+int Tangle2Selection::CostOf(Type type)
+{
+  switch (type) {
+  case kScattered: return 0;  // two compares
+  case kTheta:     return 1;
+  case kHits:      return 2;  // 18 compares, once per event
+  case kCompton:   return 3;  // 18 additions
+  default:         return 4;  // kEnergy, 18 compares and additions
+  }
+}
+
+namespace {
+
+  struct CutOrder
+  {
+    template <class C> bool operator()(const C& a, const C& b) const
+    { return a.first < b.first; }
+  };
+
+}
+
+void Tangle2Selection::Compile()
+{
+  // phase, then cost; stable, so equal cuts stay in the order given
+  std::vector<std::pair<int, Cut> > keyed;
+  for (std::size_t i = 0; i < fCuts.size(); i++)
+    keyed.push_back(std::make_pair
+		    (10*PhaseOf(fCuts[i].type) + CostOf(fCuts[i].type),
+		     fCuts[i]));
+  std::stable_sort(keyed.begin(), keyed.end(), CutOrder());
+  
+  fFirstAngleCut = fCuts.size();
+  for (std::size_t i = 0; i < keyed.size(); i++) {
+    fCuts[i] = keyed[i].second;
+    if (PhaseOf(fCuts[i].type) == kAfterAngles && fFirstAngleCut > i)
+      fFirstAngleCut = i;
+  }
+  ResetCounts();
+}
+
+bool Tangle2Selection::Pass(const Cut& cut, const Tangle2SelectionEvent& event)
+{
+  switch (cut.type) {
+    
+  case kHits:
+    if (!fHitMaskValid) {
+      fHitMask = 0;
+      for (int i = 0; i < kNCrystals; i++)
+	if (event.eDep[i] > fThreshold[i]) fHitMask |= 1u << i;
+      fHitMaskValid = true;
+    }
+    return PopCount(fHitMask & cut.crystals) >= cut.n1;
+    
+  case kCompton: {
+    int nA = 0, nB = 0;
+    for (int i = 0; i < 9; i++) {
+      nA += event.nbCompt[i];
+      nB += event.nbCompt[i+9];
+    }
+    return nA >= cut.n1 && nB >= cut.n2;
+  }
+    
+  case kEnergy: {
+    double sum = 0.;
+    for (int i = 0; i < kNCrystals; i++)
+      if ((cut.crystals & (1u << i)) && event.eDep[i] > fThreshold[i])
+	sum += event.eDep[i];
+    return sum >= cut.min && sum <= cut.max;
+  }
+    
+  case kScattered:
+    return event.thetaA != 0 && event.thetaB != 0;
+    
+  case kTheta:
+    return event.thetaA > cut.min && event.thetaA < cut.max &&
+      event.thetaB > cut.min && event.thetaB < cut.max;
+  }
+  return false;
+}
+
+bool Tangle2Selection::Select(Phase phase, const Tangle2SelectionEvent& event)
+{
+  std::size_t first = 0, last = fFirstAngleCut;
+  if (phase == kAfterAngles) {
+    first = fFirstAngleCut;
+    last  = fCuts.size();
+  }
+  else
+    fHitMaskValid = false;  // a new event
+  
+  for (std::size_t i = first; i < last; i++) {
+    Cut& cut = fCuts[i];
+    ++cut.nTested;
+    if (!Pass(cut, event)) return false;
+    ++cut.nPassed;
+  }
+  return true;
+}
+
+void Tangle2Selection::AddCounts(const Tangle2Selection& other)
+{
+  for (std::size_t i = 0; i < fCuts.size() && i < other.fCuts.size(); i++) {
+    fCuts[i].nTested += other.fCuts[i].nTested;
+    fCuts[i].nPassed += other.fCuts[i].nPassed;
+  }
+}
+
+void Tangle2Selection::ResetCounts()
+{
+  for (std::size_t i = 0; i < fCuts.size(); i++)
+    fCuts[i].nTested = fCuts[i].nPassed = 0;
+}
+
+std::string Tangle2Selection::Describe(const Cut& cut) const
+{
+  std::ostringstream os;
+  switch (cut.type) {
+  case kHits:
+    os << "hits >= " << cut.n1 << " of " << CrystalList(cut.crystals);
+    break;
+  case kCompton:
+    os << "compton A" << cut.n1 << "B" << cut.n2;
+    break;
+  case kEnergy:
+    os << "energy of " << CrystalList(cut.crystals) << " in ["
+       << cut.min*1000. << ", " << cut.max*1000. << "] keV";
+    break;
+  case kScattered:
+    os << "thetaA, thetaB != 0";
+    break;
+  case kTheta:
+    os << cut.min << " < thetaA, thetaB < " << cut.max;
+    break;
+  }
+  return os.str();
+}
+
+std::string Tangle2Selection::List() const
+{
+  std::ostringstream os;
+  for (std::size_t i = 0; i < fCuts.size(); i++) {
+    if (i == fFirstAngleCut) os << "  (angles calculated)\n";
+    os << "  " << Describe(fCuts[i]) << "\n";
+  }
+  os << "  thresholds (keV):";
+  for (int i = 0; i < kNCrystals; i++) os << " " << fThreshold[i]*1000.;
+  os << "\n";
+  return os.str();
+}
+
+std::string Tangle2Selection::Report() const
+{
+  std::ostringstream os;
+  for (std::size_t i = 0; i < fCuts.size(); i++) {
+    const Cut& cut = fCuts[i];
+    if (i == fFirstAngleCut)
+      os << "  " << cut.nTested << " angle calculations\n";
+    os << "  " << Describe(cut) << ": " << cut.nPassed << " of "
+       << cut.nTested << " passed";
+    if (cut.nTested > 0)
+      os << " (" << 100.*cut.nPassed/cut.nTested << "%)";
+    os << "\n";
+  }
+  return os.str();
+}
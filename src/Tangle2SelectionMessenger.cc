@@ -0,0 +1,180 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2SelectionMessenger.hh"
+
+#include "Tangle2Data.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cstdio>
+#include <sstream>
+
+namespace {
+
+  void AddParameter(G4UIcommand* command, const char* name, char type,
+		    G4bool omittable = false)
+  {
+    command->SetParameter(new G4UIparameter(name, type, omittable));
+  }
+
+  // The rest of the line after the leading numbers
+  G4String Rest(std::istringstream& is)
+  {
+    std::string rest;
+    std::getline(is, rest);
+    return rest;
+  }
+
+  uint32_t Crystals(const G4String& list)
+  {
+    G4bool ok;
+    const uint32_t crystals = Tangle2Selection::ParseCrystals(list, ok);
+    if (!ok)
+      G4cout << "Tangle2SelectionMessenger: bad crystal list \""
+	     << list << "\"" << G4endl;
+    return crystals;
+  }
+
+}
+
+Tangle2SelectionMessenger::Tangle2SelectionMessenger()
+{
+  fpDirectory = new G4UIdirectory("/tangle2/select/");
+  fpDirectory->SetGuidance("Selection of events for output and histograms.");
+  fpDirectory->SetGuidance("Crystals: numbers, A (0-8) and B (9-17).");
+  
+  fpThresholdCmd = new G4UIcommand("/tangle2/select/threshold", this);
+  fpThresholdCmd->SetGuidance("Energy threshold (keV) of the crystals given,");
+  fpThresholdCmd->SetGuidance("or of all crystals.  Default 5 keV.");
+  AddParameter(fpThresholdCmd, "keV", 'd');
+  AddParameter(fpThresholdCmd, "crystals", 's', true);
+  fpThresholdCmd->GetParameter(1)->SetDefaultValue("A B");
+  
+  fpHitsCmd = new G4UIcommand("/tangle2/select/hits", this);
+  fpHitsCmd->SetGuidance("At least min of the crystals above threshold.");
+  fpHitsCmd->SetGuidance("e.g. hits 2 4 13 (the default), hits 1 A");
+  AddParameter(fpHitsCmd, "min", 'i');
+  AddParameter(fpHitsCmd, "crystals", 's');
+  
+  fpComptonCmd = new G4UIcmdWithAString("/tangle2/select/compton", this);
+  fpComptonCmd->SetGuidance("At least n Compton scatters in array A and m");
+  fpComptonCmd->SetGuidance("in array B, written AnBm, e.g. A2B1.");
+  fpComptonCmd->SetParameterName("AnBm", false);
+  
+  fpEnergyCmd = new G4UIcommand("/tangle2/select/energy", this);
+  fpEnergyCmd->SetGuidance("Summed deposit (keV) above threshold in the");
+  fpEnergyCmd->SetGuidance("crystals within [min, max], e.g. 400 600 A");
+  AddParameter(fpEnergyCmd, "minKeV", 'd');
+  AddParameter(fpEnergyCmd, "maxKeV", 'd');
+  AddParameter(fpEnergyCmd, "crystals", 's');
+  
+  fpScatteredCmd
+    = new G4UIcmdWithoutParameter("/tangle2/select/scattered", this);
+  fpScatteredCmd->SetGuidance("First scatters in A and B (theta != 0).");
+  
+  fpThetaCmd = new G4UIcommand("/tangle2/select/theta", this);
+  fpThetaCmd->SetGuidance("thetaA and thetaB in (min, max) degrees.");
+  AddParameter(fpThetaCmd, "minDeg", 'd');
+  AddParameter(fpThetaCmd, "maxDeg", 'd');
+  
+  fpClearCmd = new G4UIcmdWithoutParameter("/tangle2/select/clear", this);
+  fpClearCmd->SetGuidance("Remove all cuts (thresholds are kept).");
+  
+  fpResetCmd = new G4UIcmdWithoutParameter("/tangle2/select/reset", this);
+  fpResetCmd->SetGuidance("Back to the default selection.");
+  
+  fpListCmd = new G4UIcmdWithoutParameter("/tangle2/select/list", this);
+  fpListCmd->SetGuidance("List the cuts in the order they are applied.");
+  
+  G4UIcommand* commands[] = {fpThresholdCmd, fpHitsCmd, fpComptonCmd,
+			     fpEnergyCmd, fpScatteredCmd, fpThetaCmd,
+			     fpClearCmd, fpResetCmd, fpListCmd};
+  for (std::size_t i = 0; i < sizeof(commands)/sizeof(commands[0]); i++) {
+    commands[i]->AvailableForStates(G4State_PreInit, G4State_Idle);
+    // Tangle2::selection is shared, so set it on the master only
+    commands[i]->SetToBeBroadcasted(false);
+  }
+}
+
+Tangle2SelectionMessenger::~Tangle2SelectionMessenger()
+{
+  delete fpListCmd;
+  delete fpResetCmd;
+  delete fpClearCmd;
+  delete fpThetaCmd;
+  delete fpScatteredCmd;
+  delete fpEnergyCmd;
+  delete fpComptonCmd;
+  delete fpHitsCmd;
+  delete fpThresholdCmd;
+  delete fpDirectory;
+}
+
+void Tangle2SelectionMessenger::SetNewValue(G4UIcommand* command,
+					    G4String newValue)
+{
+  Tangle2Selection& selection = Tangle2::selection;
+  std::istringstream is(newValue);
+  
+  if (command == fpThresholdCmd) {
+    G4double eThres;
+    is >> eThres;
+    const uint32_t crystals = Crystals(Rest(is));
+    for (G4int i = 0; i < Tangle2Selection::kNCrystals; i++)
+      if (crystals & (1u << i))
+	selection.SetThreshold(i, eThres*keV);
+  }
+  else if (command == fpHitsCmd) {
+    G4int min;
+    is >> min;
+    const uint32_t crystals = Crystals(Rest(is));
+    if (crystals) selection.AddHits(crystals, min);
+  }
+  else if (command == fpComptonCmd) {
+    G4int nA, nB;
+    if (std::sscanf(newValue.c_str(), " A%dB%d", &nA, &nB) == 2)
+      selection.AddCompton(nA, nB);
+    else
+      G4cout << "Tangle2SelectionMessenger: expected AnBm, e.g. A2B1, not "
+	     << newValue << G4endl;
+  }
+  else if (command == fpEnergyCmd) {
+    G4double min, max;
+    is >> min >> max;
+    const uint32_t crystals = Crystals(Rest(is));
+    if (crystals) selection.AddEnergy(crystals, min*keV, max*keV);
+  }
+  else if (command == fpScatteredCmd)
+    selection.AddScattered();
+  else if (command == fpThetaCmd) {
+    G4double min, max;
+    is >> min >> max;
+    selection.AddTheta(min, max);
+  }
+  else if (command == fpClearCmd)
+    selection.Clear();
+  else if (command == fpResetCmd)
+    selection.Reset();
+  
+  // show the order the cuts will be applied in
+  selection.Compile();
+  G4cout << "Tangle2 selection:" << G4endl << selection.List();
+}
@@ -0,0 +1,151 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2Shard.hh"
+
+#include "Tangle2Data.hh"
+#include "Tangle2Checkpoint.hh"
+
+#include "Randomize.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <stdint.h>
+
+Tangle2Shard::Tangle2Shard()
+: fEnabled(false), fRunEvents(0), fBaseEvents(0), fBaseRows(0),
+  fResumes(0), fEventIDBase(0)
+{}
+
+G4bool Tangle2Shard::Parse(const G4String& value,
+			   G4int& index, G4int& nShards)
+{
+  char rest;
+  return std::sscanf(value.c_str(), "%d/%d%c",
+		     &index, &nShards, &rest) == 2 &&
+    nShards > 0 && index >= 0 && index < nShards;
+}
+
+// MixMaxRng::setSeeds(ids, 4) is seed_uniquestream(ids[3], ids[2],
+// ids[1], ids[0]): a skip ahead of the MIXMAX sequence that gives
+// every set of four 32 bit IDs its own stream, which no other set
+// overlaps.  The cluster ID is never 0, so the shard streams are also
+// apart from those of the two seed setSeeds (worker events, forked
+// processes), which leave it 0.
+void Tangle2Shard::StreamIDs(G4int resumes, G4long ids[4])
+{
+  const uint64_t campaign = uint64_t(Tangle2::campaignSeed);
+  ids[0] = Tangle2::shardIndex;
+  ids[1] = G4long(campaign & 0xFFFFFFFFull);
+  ids[2] = G4long(campaign >> 32);
+  ids[3] = 1 + resumes;
+}
+
+void Tangle2Shard::SeedStream(G4int resumes)
+{
+  G4long ids[4];
+  StreamIDs(resumes, ids);
+  G4Random::setTheSeeds(ids, 4);
+}
+
+G4String Tangle2Shard::ManifestFileName()
+{
+  return Tangle2::outputName + "_shard.txt";
+}
+
+void Tangle2Shard::BeginOfRun(G4long nEventsToBeProcessed,
+			      const Tangle2CheckpointState* resume)
+{
+  // a process forked by Tangle2ForkRunManager runs a share of the
+  // run: the shard's size is that of the whole run, and the events
+  // before its share are added to the event IDs
+  const G4bool forked = Tangle2::forkProcess >= 0;
+  fEnabled = Tangle2::nShards > 0;
+  fRunEvents  = resume ? resume->runEvents :
+    forked ? Tangle2::forkRunEvents : nEventsToBeProcessed;
+  fBaseEvents = resume ? resume->counts.nEvents : 0;
+  fBaseRows   = resume ? resume->counts.nRows : 0;
+  fResumes    = resume ? resume->resumes : 0;
+  fFiles.clear();
+  if (resume)
+    fFiles = resume->files;
+  fHistograms.clear();
+  
+  // a resumed run numbers its events on from those already done,
+  // sharded or not, so no event ID repeats across the resumes
+  fEventIDBase = 0;
+  Tangle2::eventIDOffset = (forked ? Tangle2::forkFirstEvent : 0) + fBaseEvents;
+  if (!fEnabled) return;
+  
+  // within the range of the shard (64 bit, see Tangle2EventRecord)
+  fEventIDBase = Tangle2::shardIndex*fRunEvents;
+  Tangle2::eventIDOffset += fEventIDBase;
+}
+
+void Tangle2Shard::AddFile(const G4String& fileName)
+{
+  if (!fileName.empty())
+    fFiles.push_back(fileName);
+}
+
+void Tangle2Shard::AddHistogram(const G4String& fileName)
+{
+  fHistograms.push_back(fileName);
+}
+
+// Written to a temporary file first, so a manifest is either complete
+// or absent
+void Tangle2Shard::EndOfRun(G4long nEvents, G4long nRows)
+{
+  // the parent of forked processes writes it for all of them
+  if (!fEnabled || Tangle2::forkProcess >= 0) return;
+  
+  G4long ids[4];
+  StreamIDs(fResumes, ids);
+  const G4long nDone = fBaseEvents + nEvents;
+  
+  const G4String fileName = ManifestFileName();
+  const G4String tmpName = fileName + ".tmp";
+  G4bool written = false;
+  {
+    std::ofstream file(tmpName.c_str());
+    if (file) {
+      file << "# Tangle2 shard" << std::endl
+	   << "campaignSeed " << Tangle2::campaignSeed << std::endl
+	   << "shard " << Tangle2::shardIndex << std::endl
+	   << "shards " << Tangle2::nShards << std::endl
+	   << "engine MixMaxRng" << std::endl
+	   << "stream " << ids[3] << " " << ids[2] << " " << ids[1]
+	   << " " << ids[0] << std::endl
+	   << "runEvents " << fRunEvents << std::endl
+	   << "eventIDOffset " << fEventIDBase << std::endl
+	   << "events " << nDone << std::endl
+	   << "rows " << fBaseRows + nRows << std::endl
+	   << "resumes " << fResumes << std::endl
+	   << "complete " << (nDone == fRunEvents) << std::endl;
+      for (std::size_t i = 0; i < fFiles.size(); i++)
+	file << "file " << fFiles[i] << std::endl;
+      for (std::size_t i = 0; i < fHistograms.size(); i++)
+	file << "histogram " << fHistograms[i] << std::endl;
+      written = bool(file);
+    }
+  }
+  if (written && std::rename(tmpName.c_str(), fileName.c_str()) == 0)
+    G4cout << " Shard " << Tangle2::shardIndex << "/" << Tangle2::nShards
+	   << ": " << nDone << " of " << fRunEvents << " events, "
+	   << fFiles.size() << " files, see " << fileName << G4endl;
+  else
+    G4cout << " Tangle2Shard: can not write " << fileName << G4endl;
+}
@@ -0,0 +1,226 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2StepProfiler.hh"
+
+#ifdef TANGLE2_WITH_PROFILE
+
+#include "Tangle2Data.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4ParticleDefinition.hh"
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+G4bool Tangle2StepProfiler::IsAvailable()
+{
+  return true;
+}
+
+Tangle2StepProfiler::Tangle2StepProfiler()
+: fEnabled(false), fpLastEntry(0)
+{}
+
+void Tangle2StepProfiler::BeginOfRun()
+{
+  fEnabled = Tangle2::profileSteps;
+  fEntries.clear();
+  fTracks.clear();
+  fMerged.clear();
+  fMergedTracks.clear();
+  fpLastEntry = 0;
+  fLast = Clock::now();
+}
+
+void Tangle2StepProfiler::DoStartTrack(const G4Track* track)
+{
+  ++fTracks[track->GetDefinition()];
+  fLast = Clock::now();
+}
+
+void Tangle2StepProfiler::DoStep(const G4Step* step)
+{
+  const Clock::time_point now = Clock::now();
+  const G4long ns
+    = std::chrono::duration_cast<std::chrono::nanoseconds>(now - fLast)
+    .count();
+  fLast = now;
+  
+  const G4ParticleDefinition* particle = step->GetTrack()->GetDefinition();
+  const G4VProcess* process
+    = step->GetPostStepPoint()->GetProcessDefinedStep();
+  const G4VPhysicalVolume* physical
+    = step->GetPreStepPoint()->GetPhysicalVolume();
+  const G4LogicalVolume* volume
+    = physical ? physical->GetLogicalVolume() : 0;
+  const Key key = {particle, process, volume};
+  
+  // steps of a track mostly repeat the previous key
+  if (!fpLastEntry || !(key == fLastKey)) {
+    std::unordered_map<Key, Entry, KeyHash>::iterator i = fEntries.find(key);
+    if (i == fEntries.end()) {
+      Entry entry;
+      entry.particle = particle->GetParticleName();
+      entry.process  = process ? process->GetProcessName() : "none";
+      entry.volume   = volume ? volume->GetName() : "none";
+      i = fEntries.insert(std::make_pair(key, entry)).first;
+    }
+    fpLastEntry = &i->second;
+    fLastKey = key;
+  }
+  ++fpLastEntry->nSteps;
+  fpLastEntry->nanoseconds += ns;
+}
+
+void Tangle2StepProfiler::Add(const Tangle2StepProfiler& other)
+{
+  for (std::unordered_map<Key, Entry, KeyHash>::const_iterator i
+	 = other.fEntries.begin(); i != other.fEntries.end(); ++i) {
+    const Entry& entry = i->second;
+    Entry& merged = fMerged[entry.particle + '\n' + entry.process + '\n' +
+			    entry.volume];
+    merged.particle = entry.particle;
+    merged.process  = entry.process;
+    merged.volume   = entry.volume;
+    merged.nSteps      += entry.nSteps;
+    merged.nanoseconds += entry.nanoseconds;
+  }
+  for (std::unordered_map<const void*, G4long>::const_iterator i
+	 = other.fTracks.begin(); i != other.fTracks.end(); ++i)
+    fMergedTracks[static_cast<const G4ParticleDefinition*>(i->first)
+		  ->GetParticleName()] += i->second;
+}
+
+namespace {
+
+  struct Total {
+    Total() : nSteps(0), nanoseconds(0) {}
+    G4long nSteps;
+    G4long nanoseconds;
+  };
+  
+  G4bool ByTime(const std::pair<std::string, Total>& a,
+		const std::pair<std::string, Total>& b)
+  {
+    return a.second.nanoseconds > b.second.nanoseconds;
+  }
+  
+  void PrintTotals(const char* title, const std::map<std::string, Total>& totals,
+		   G4long nSteps, G4long nanoseconds,
+		   const std::map<std::string, G4long>* tracks = 0)
+  {
+    std::vector<std::pair<std::string, Total> >
+      sorted(totals.begin(), totals.end());
+    std::sort(sorted.begin(), sorted.end(), ByTime);
+    
+    G4cout << " By " << title << ":" << G4endl;
+    for (std::size_t i = 0; i < sorted.size(); i++) {
+      const Total& total = sorted[i].second;
+      G4cout << "  " << std::setw(30) << std::left << sorted[i].first
+	     << std::right << std::setw(14) << total.nSteps
+	     << std::setw(7) << std::setprecision(3)
+	     << 100.*total.nSteps/nSteps << "%"
+	     << std::setw(12) << std::setprecision(4) << total.nanoseconds*1.e-9
+	     << " s" << std::setw(7) << std::setprecision(3)
+	     << 100.*total.nanoseconds/nanoseconds << "%";
+      if (tracks) {
+	std::map<std::string, G4long>::const_iterator t
+	  = tracks->find(sorted[i].first);
+	G4cout << std::setw(14) << (t == tracks->end() ? 0 : t->second)
+	       << " tracks";
+      }
+      G4cout << G4endl;
+    }
+  }
+
+}
+
+void Tangle2StepProfiler::Print() const
+{
+  if (fMerged.empty()) return;
+  
+  std::vector<const Entry*> entries;
+  std::map<std::string, Total> byParticle, byProcess, byVolume;
+  G4long nSteps = 0, nanoseconds = 0;
+  for (std::map<std::string, Entry>::const_iterator i = fMerged.begin();
+       i != fMerged.end(); ++i) {
+    const Entry& entry = i->second;
+    entries.push_back(&entry);
+    nSteps += entry.nSteps;
+    nanoseconds += entry.nanoseconds;
+    Total* totals[] = {&byParticle[entry.particle],
+		       &byProcess[entry.process], &byVolume[entry.volume]};
+    for (G4int j = 0; j < 3; j++) {
+      totals[j]->nSteps += entry.nSteps;
+      totals[j]->nanoseconds += entry.nanoseconds;
+    }
+  }
+  if (nSteps == 0) return;
+  
+  struct ByTime {
+    bool operator()(const Entry* a, const Entry* b) const
+    { return a->nanoseconds > b->nanoseconds; }
+  };
+  std::sort(entries.begin(), entries.end(), ByTime());
+  
+  const std::ios::fmtflags flags = G4cout.flags();
+  const std::streamsize precision = G4cout.precision();
+  
+  G4cout << G4endl << "Step profile: " << nSteps << " steps, "
+	 << nanoseconds*1.e-9 << " s (summed over threads)" << G4endl
+	 << " " << std::setw(4) << "rank" << std::setw(12) << "particle"
+	 << std::setw(22) << "process" << std::setw(16) << "volume"
+	 << std::setw(14) << "steps" << std::setw(12) << "time [s]"
+	 << std::setw(8) << "time" << std::setw(10) << "ns/step" << G4endl;
+  
+  const std::size_t nRows = std::min<std::size_t>(entries.size(), 30);
+  for (std::size_t i = 0; i < nRows; i++) {
+    const Entry& entry = *entries[i];
+    G4cout << " " << std::setw(4) << i + 1
+	   << std::setw(12) << entry.particle
+	   << std::setw(22) << entry.process
+	   << std::setw(16) << entry.volume
+	   << std::setw(14) << entry.nSteps
+	   << std::setw(12) << std::setprecision(4) << entry.nanoseconds*1.e-9
+	   << std::setw(7) << std::setprecision(3)
+	   << 100.*entry.nanoseconds/nanoseconds << "%"
+	   << std::setw(10) << std::setprecision(4)
+	   << G4double(entry.nanoseconds)/entry.nSteps << G4endl;
+  }
+  if (entries.size() > nRows)
+    G4cout << " ... " << entries.size() - nRows << " more" << G4endl;
+  
+  PrintTotals("particle", byParticle, nSteps, nanoseconds, &fMergedTracks);
+  PrintTotals("process", byProcess, nSteps, nanoseconds);
+  PrintTotals("volume", byVolume, nSteps, nanoseconds);
+  
+  G4cout.flags(flags);
+  G4cout.precision(precision);
+}
+
+#else
+
+G4bool Tangle2StepProfiler::IsAvailable()
+{
+  return false;
+}
+
+#endif
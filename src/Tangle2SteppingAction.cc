@@ -18,8 +18,10 @@
 
 #include "Tangle2RunAction.hh"
 #include "Tangle2Data.hh"
+#include "Tangle2AngleKernel.hh"
 
 #include "G4Step.hh"
+#include "G4Event.hh"
 #include "G4VProcess.hh"
 #include "G4MTRunManager.hh"
 #include "G4EventManager.hh"
@@ -28,11 +30,54 @@
 #include "G4SystemOfUnits.hh"
 #include "G4PhysicalConstants.hh"
 #include "G4Gamma.hh"
+#include "G4ProcessTable.hh"
 #include "G4Threading.hh"
 #include <vector>
 
 Tangle2SteppingAction::Tangle2SteppingAction
-(Tangle2RunAction* runAction){}
+(Tangle2RunAction* runAction)
+: fpRunAction(runAction)
+, fpProfiler(&runAction->GetProfiler())
+, fFastReject(false)
+, fpGamma(0)
+, fpComptProcess(0)
+, fpPhotProcess(0)
+, fNSteps(0)
+{
+  fAngleBatch.Reserve(4);
+}
+
+void Tangle2SteppingAction::BeginOfRunAction()
+{
+  fpGamma = G4Gamma::Definition();
+  
+  G4ProcessTable* processTable = G4ProcessTable::GetProcessTable();
+  fpComptProcess = processTable->FindProcess("compt", fpGamma);
+  fpPhotProcess  = processTable->FindProcess("phot",  fpGamma);
+  
+  if(!fpComptProcess || !fpPhotProcess)
+    G4cout << " Tangle2SteppingAction::BeginOfRunAction: "
+	   << " gamma process \"compt\" or \"phot\" not found "
+	   << G4endl;
+  
+  fFastReject = Tangle2::config.fastReject &&
+    fpRunAction->GetSelection().NeedsScatter();
+  
+  fNSteps = 0;
+  fRunTimer.Start();
+}
+
+void Tangle2SteppingAction::EndOfRunAction()
+{
+  fRunTimer.Stop();
+  
+  G4double realTime = fRunTimer.GetRealElapsed();
+  
+  G4cout << fNSteps << " steps in " << realTime << " s";
+  if(realTime > 0)
+    G4cout << ", " << fNSteps/realTime << " steps/s";
+  G4cout << G4endl;
+}
 
 
 void Tangle2SteppingAction::BeginOfEventAction()
@@ -42,7 +87,7 @@ void Tangle2SteppingAction::BeginOfEventAction()
 
   //G4cout << " eventID = " << eventID << G4endl;
 
-  if(Tangle2::positrons){
+  if(Tangle2::config.positrons){
     sndGammaTrackID = 2; // first track is 3
   }
   
@@ -70,6 +115,7 @@ void Tangle2SteppingAction::BeginOfEventAction()
     // this boolean is used to skip angle calculations
     // for events without Compt for both gammas
     doubleComptEvent = true;
+    fRejected        = false;
     
   }
   
@@ -78,21 +124,12 @@ void Tangle2SteppingAction::BeginOfEventAction()
 
 void Tangle2SteppingAction::EndOfEventAction()
 {
+  // Multiplicity counts only - the angles themselves are
+  // left to ComputeAngles for events that pass the selection
+  
   if( nComptonA >= 1  && 
       nComptonB >= 1 ){
     
-    if(comments){
-      G4cout << G4endl;
-      G4cout << " beam_A = (" << beam_A.getX() 
-	     <<           "," << beam_A.getY() 
-	     <<           "," << beam_A.getZ()
-	     <<          " )" << G4endl;
-      G4cout << " beam_B = (" << beam_B.getX() 
-	     <<           "," << beam_B.getY() 
-	     <<           "," << beam_B.getZ()
-	     <<          " )" << G4endl;
-    }
-    
     if(comments){
       G4cout << G4endl;
       G4cout << " --------------------------- " << G4endl;
@@ -102,185 +139,153 @@ void Tangle2SteppingAction::EndOfEventAction()
       G4cout << G4endl;
     }
     
-    Tangle2::dphi = Tangle2::phiB + Tangle2::phiA;
-    
-    if (Tangle2::dphi < 0)
-      Tangle2::dphi = Tangle2::dphi + 360;
-    
     Tangle2::nA1B1++;
-  
   }
   
   if(nComptonA >= 2 && 
-     nComptonB >= 1){
-    
-    Tangle2::dphiA2B1 = Tangle2::phiB + Tangle2::phiA2;
-    
-    if (Tangle2::dphiA2B1 < 0)
-      Tangle2::dphiA2B1 = Tangle2::dphiA2B1 + 360;
-    
+     nComptonB >= 1)
     Tangle2::nA2B1++;
-    
-  }
   
   if(nComptonA >= 1 && 
-     nComptonB >= 2){
-  
-    Tangle2::dphiA1B2 = Tangle2::phiB2 + Tangle2::phiA;
-    
-    if (Tangle2::dphiA1B2 < 0)
-      Tangle2::dphiA1B2 = Tangle2::dphiA1B2 + 360;
-    
+     nComptonB >= 2)
     Tangle2::nA1B2++;
-  }
   
   if(nComptonA >= 2 && 
-     nComptonB >= 2){
-
-    Tangle2::dphiA2B2 = Tangle2::phiB2 + Tangle2::phiA2;
-    
-    if (Tangle2::dphiA2B2 < 0)
-      Tangle2::dphiA2B2 = Tangle2::dphiA2B2 + 360;
-    
+     nComptonB >= 2)
     Tangle2::nA2B2++;
-  }
 
 }
 
-void CalculateThetaPhi(const G4ThreeVector& vBeam,
-		       const G4ThreeVector& vPre,
-		       const G4ThreeVector& vScat,
-		       // Output quantities
-		       G4double& theta,
-		       G4double& phi)
-{
-  
-  // for testing phi convention
-  //G4ThreeVector tempVScat(0,1,1);
+namespace {
   
-  G4double cosTheta = vScat*vPre;
-  theta = std::acos(cosTheta) * 180/(pi); //convert to degrees
-  
-  G4bool comments = false;
+  void ToArray(const G4ThreeVector& v, G4double a[3])
+  {
+    a[0] = v.x();
+    a[1] = v.y();
+    a[2] = v.z();
+  }
   
-  if(comments){
-    G4cout << G4endl;
-    G4cout << " ----------- "  << G4endl;
-    G4cout << " theta = " << theta << G4endl;
+  // Queue one scatter for Tangle2AngleKernel, see 
+  // Tangle2AngleKernel.hh for the theta and phi conventions
+  std::size_t AddScatter(Tangle2AngleBatch& batch,
+			 const G4ThreeVector& vBeam,
+			 const G4ThreeVector& vPre,
+			 const G4ThreeVector& vScat)
+  {
+    G4double beam[3], pre[3], scat[3];
+    ToArray(vBeam, beam);
+    ToArray(vPre,  pre);
+    ToArray(vScat, scat);
+    return batch.Add(beam, pre, scat);
   }
   
-  // Define x,y,z in the frame of the beam
+  std::size_t AddScatter(Tangle2AngleBatch& batch,
+			 const G4ThreeVector& vBeam,
+			 const G4ThreeVector& vPre,
+			 const G4ThreeVector& vScat,
+			 const G4ThreeVector& vPolPre,
+			 const G4ThreeVector& vPolPost)
+  {
+    G4double beam[3], pre[3], scat[3], polPre[3], polPost[3];
+    ToArray(vBeam,    beam);
+    ToArray(vPre,     pre);
+    ToArray(vScat,    scat);
+    ToArray(vPolPre,  polPre);
+    ToArray(vPolPost, polPost);
+    return batch.Add(beam, pre, scat, polPre, polPost);
+  }
   
-  // fixed axis beam is in lab x direction
-  // so we'll call the beam axis xx_axis
-  const G4ThreeVector xx_axis = vBeam;
+}
+
+void Tangle2SteppingAction::ComputeAngles()
+{
+  // Angles from the raw vectors recorded in UserSteppingAction.
+  // Only called for events that pass the energy selection.
+  // All (up to four) scatters go to the angle kernel as one batch.
   
   if(comments){
     G4cout << G4endl;
-    G4cout << " vBeam = ("  << vBeam.getX() 
-	   <<           "," << vBeam.getY() 
-	   <<           "," << vBeam.getZ()
-	   <<          " )" << G4endl;
-    
-    G4cout << G4endl;
-    G4cout << " vPre  = ("  << vPre.getX() 
-	   <<           "," << vPre.getY() 
-	   <<           "," << vPre.getZ()
+    G4cout << " beam_A = (" << beam_A.getX() 
+	   <<           "," << beam_A.getY() 
+	   <<           "," << beam_A.getZ()
 	   <<          " )" << G4endl;
-    
-    G4cout << G4endl;
-    G4cout << " vScat = ("  << vScat.getX() 
-	   <<           "," << vScat.getY() 
-	   <<           "," << vScat.getZ()
+    G4cout << " beam_B = (" << beam_B.getX() 
+	   <<           "," << beam_B.getY() 
+	   <<           "," << beam_B.getZ()
 	   <<          " )" << G4endl;
   }
-    
-  // we need a global reference to define phi wrt
-  // lets make this 'arbitrary' reference in lab z (ie lab 'up') so that
-  // when there is a fixed beam, phi = 0 is always in z direction
-  // NB for an isotropic beam as the phi plane depends on the beam
-  // direction the plane may not be consistent with the detector
-  // surface
-
-  G4ThreeVector scanner_axis = G4ThreeVector(0,0,1);
-
-  // safety - very unlikely 
-  if( vBeam == scanner_axis )
-    scanner_axis = G4ThreeVector(0,1,0);
   
-  // for a beam in x direction this will be the 
-  // lab y_axis so we'll call it yy_axis
-  const G4ThreeVector yy_axis = (scanner_axis.cross(xx_axis));
-
-  if(comments){
-    G4cout << G4endl;
-    G4cout << " yy_axis = ("  << yy_axis.getX() 
-	   <<             "," << yy_axis.getY() 
-	   <<             "," << yy_axis.getZ()
-	   <<            " )" << G4endl;
+  fAngleBatch.Clear();
+  
+  std::size_t iA1 = 0, iA2 = 0, iB1 = 0, iB2 = 0;
+  
+  // first scatters use the beam as the pre-scatter direction
+  if(nComptonA >= 1)
+    iA1 = AddScatter(fAngleBatch, beam_A, beam_A, vScat_A1,
+		     vPolPre_A, vPolPost_A);
+  if(nComptonB >= 1)
+    iB1 = AddScatter(fAngleBatch, beam_B, beam_B, vScat_B1,
+		     vPolPre_B, vPolPost_B);
+  if(nComptonA >= 2)
+    iA2 = AddScatter(fAngleBatch, beam_A, vPre_A2, vScat_A2);
+  if(nComptonB >= 2)
+    iB2 = AddScatter(fAngleBatch, beam_B, vPre_B2, vScat_B2);
+  
+  Tangle2AngleKernel::Compute(fAngleBatch);
+  
+  // array A
+  if(nComptonA >= 1){
+    Tangle2::thetaA    = fAngleBatch.theta[iA1];
+    Tangle2::phiA      = fAngleBatch.phi[iA1];
+    Tangle2::thetaPolA = fAngleBatch.thetaPol[iA1];
   }
-  
-  // perpendicular to beam and yy_axis
-  const G4ThreeVector zz_axis = xx_axis.cross(yy_axis);
-  
-  if(comments){
-    G4cout << G4endl;
-    G4cout << " zz_axis = ("  << zz_axis.getX() 
-	   <<             "," << zz_axis.getY() 
-	   <<             "," << zz_axis.getZ()
-	   <<            " )" << G4endl;
+  if(nComptonA >= 2){
+    Tangle2::thetaA2   = fAngleBatch.theta[iA2];
+    Tangle2::phiA2     = fAngleBatch.phi[iA2];
   }
   
-  //-------
-  // Calculate phi
-  // with phi =   0,      90,       180,     -90 
-  //    at     (0,0,1), (0,1,0), (0,0,-1), (0,-1,0)
-  // for (1,0,0) beam
-  
-  // vScat_yz perpendicular to beam and 
-  // scattered photon projections
-  // for fixed beam this is in yz plane
-  //  which is the system used for the lab:
-  // (1,0,0)x(Sx,Sy,Sz) = (0,-Sz,Sy)
+  // array B
+  if(nComptonB >= 1){
+    Tangle2::thetaB    = fAngleBatch.theta[iB1];
+    Tangle2::phiB      = fAngleBatch.phi[iB1];
+    Tangle2::thetaPolB = fAngleBatch.thetaPol[iB1];
+  }
+  if(nComptonB >= 2){
+    Tangle2::thetaB2   = fAngleBatch.theta[iB2];
+    Tangle2::phiB2     = fAngleBatch.phi[iB2];
+  }
   
-  const G4ThreeVector vScat_yz = xx_axis.cross(vScat);
+  // relative azimuthal angles
+  if(nComptonA >= 1 && 
+     nComptonB >= 1)
+    Tangle2::dphi = Tangle2AngleKernel::DeltaPhi(Tangle2::phiA,
+						 Tangle2::phiB);
   
-  if(comments){
-    G4cout << G4endl;
-    G4cout << " vScat_yz = ("  << vScat_yz.getX() 
-	   <<              "," << vScat_yz.getY() 
-	   <<              "," << vScat_yz.getZ()
-	   <<             " )" << G4endl;
-  }
+  if(nComptonA >= 2 && 
+     nComptonB >= 1)
+    Tangle2::dphiA2B1 = Tangle2AngleKernel::DeltaPhi(Tangle2::phiA2,
+						     Tangle2::phiB);
   
-  // for fixed beam z component is (negative) 
-  // y component of vScat_yz - [see above]
-  const G4double vScat_z = -vScat_yz*yy_axis;
-  const G4double vScat_y =  vScat_yz*zz_axis;
-    
-  phi = std::atan2(vScat_y,vScat_z) * 180/(pi);
+  if(nComptonA >= 1 && 
+     nComptonB >= 2)
+    Tangle2::dphiA1B2 = Tangle2AngleKernel::DeltaPhi(Tangle2::phiA,
+						     Tangle2::phiB2);
   
-  if(comments){
-    G4cout << G4endl;
-    G4cout << " vScat_y  = " << vScat_y << G4endl;
-    G4cout << G4endl;
-    G4cout << " vScat_z  = " << vScat_z << G4endl;
-    
-    G4cout << G4endl;
-    G4cout << " phi = "  << phi << G4endl;
-    G4cout << " ----------- "  << G4endl;
-  }
+  if(nComptonA >= 2 && 
+     nComptonB >= 2)
+    Tangle2::dphiA2B2 = Tangle2AngleKernel::DeltaPhi(Tangle2::phiA2,
+						     Tangle2::phiB2);
   
 }
 
 void Tangle2SteppingAction::UserSteppingAction(const G4Step* step)
 {
+  fpProfiler->Step(step);
+  ++fNSteps;
   
   G4StepPoint* preStepPoint  = step->GetPreStepPoint();
   G4StepPoint* postStepPoint = step->GetPostStepPoint();
   
-  G4double     eDep = step->GetTotalEnergyDeposit();
-  
   //G4VPhysicalVolume* prePV = preStepPoint->GetPhysicalVolume();
   G4VPhysicalVolume* postPV = postStepPoint->GetPhysicalVolume();
 
@@ -297,39 +302,14 @@ void Tangle2SteppingAction::UserSteppingAction(const G4Step* step)
   
   G4int    stepNumber   = track->GetCurrentStepNumber();
   G4int    trackID      = track->GetTrackID();
-  G4String particleName = track->GetDefinition()->GetParticleName();
 
+  const G4ParticleDefinition* particleDefinition = track->GetDefinition();
+  
   const G4VProcess* processDefinedStep;
   processDefinedStep    = postStepPoint->GetProcessDefinedStep();
-  G4String processName  = processDefinedStep->GetProcessName();
-  
   
-  //G4ParticleDefinition* particleDefinition = track->GetDefinition();
   //const G4VProcess* creatorProcess = track->GetCreatorProcess();
   
-  // Record energy deposited in crystal
-  // for any processes
-  if ( (postPV)   && 
-       (eDep > 0) && 
-       (postPV->GetName() != "disc")       &&
-       (postPV->GetName() != "Coll_right") &&
-       (postPV->GetName() != "Coll_left" ) )
-    {
-      Tangle2::eDepCryst[postPV->GetCopyNo()] += eDep;
-      
-//       G4cout << " processName  = " << processName         << G4endl;
-//       G4cout << " particleName = " << particleName        << G4endl;
-//       G4cout << " eDep         = " << eDep/keV            << G4endl;
-//       G4cout << " PV CopyNo    = " << postPV->GetCopyNo() << G4endl;
-    }
-  
-  //Fill Collimator energy depositions
-  /* if((postPV->GetCopyNo()==18) && (eDep>0)){
-    Tangle2::eDepColl1 +=eDep;}
-  if((postPV->GetCopyNo()==19) && (eDep>0)){
-    Tangle2::eDepColl2 +=eDep;}
-  */
-  
   // If there was no Compton scattering for the 
   // second track (first out) then delta phi cant be calculated
   if(!doubleComptEvent)
@@ -345,83 +325,120 @@ void Tangle2SteppingAction::UserSteppingAction(const G4Step* step)
     }
     
     doubleComptEvent     = false;
+
+    // Nothing more can be recorded for this event, so optionally
+    // stop tracking it (and its secondaries) here
+    if(fFastReject){
+      fRejected = true;
+      G4EventManager::GetEventManager()->AbortCurrentEvent();
+    }
+    
     return;
   }
     
-  // G4cout << G4endl;
-  // G4cout << " particleName = " << particleName << G4endl;
-  // G4cout << " processName  = " << processName  << G4endl;
-  
   //---------------------------
   // only photons shall pass
-  if(particleName != "gamma")
+  if(particleDefinition != fpGamma)
     return;
   
   //------------------------
   // record photoelectric
 
-  if( processName  == "phot"){
-    
-    Tangle2::nb_Photo[postPV->GetCopyNo()]++;
-    
-    // array A 
-    if     ( postPos[0] > 0) {
-      
-      
-      // first Photoelectric in A after initial
-      // Compton in A by same track
-      if     (nPhotoA == 0 &&
-	      trackID == trackID_A1){ 
-	//G4cout << " array A   " << G4endl;
-	nPhotoA  = 1;
-	Tangle2::posA_P1 = postPos; 
-      }
-      // second Photoelectric in A ..
-      // expect this to be at least rare
-      if     (nPhotoA == 1 &&
-	      trackID == trackID_A1){ 
-	nPhotoA  = 2;
-	Tangle2::posA_P2 = postPos; 
-      }
-      
-      
-    }// array B
-    else if( postPos[0] < 0){
-      
-      
-      // first Photoelectric in B after initial
-      // Compton in B by same track
-      if     (nPhotoB == 0 &&
-	      trackID == trackID_B1){ 
-	//G4cout << " array B   " << G4endl;
-	nPhotoB  = 1;
-	Tangle2::posB_P1 = postPos; 
-      }
-      // second Photo in B ..
-      // expect this to be at least rare
-      if     (nPhotoB == 1 &&
-	      trackID == trackID_B1){ 
-	nPhotoB  = 2;
-	Tangle2::posA_P2 = postPos; 
-      }
-      
-    }
-    
+  if( processDefinedStep == fpPhotProcess){
+    RecordPhoto(trackID, postPV->GetCopyNo(), postPos);
+    return;
   }
-
-  //-------------------------
   
   //-------------------------
   // From here on only gammas 
   // Compton scattering may pass. 
   
-  if( processName  != "compt")  
+  if( processDefinedStep != fpComptProcess)  
+    return;
+  
+  if(comments){
+    G4cout << G4endl;
+    G4cout << " particleName = " << particleDefinition->GetParticleName()
+	   << G4endl;
+    G4cout << " processName  = " << processDefinedStep->GetProcessName()
+	   << G4endl;
+    G4cout << " stepNumber   = " << stepNumber   << G4endl;
+  }
+  
+  RecordCompton(trackID, postPV->GetCopyNo(), postPos,
+		preMomentumDir, postMomentumDir,
+		preStepPol, postStepPol);
+  
+  return;
+}
+
+void Tangle2SteppingAction::RecordPhoto(G4int trackID,
+					G4int copyNo,
+					const G4ThreeVector& postPos)
+{
+  if(!doubleComptEvent)
     return;
   
-  //G4double cosThetaPol = preStepPol.unit().dot(postStepPol.unit());
-  //G4double thetaPol    = std::acos(cosThetaPol) * 180/(pi); 
+  Tangle2::nb_Photo[copyNo]++;
+  
+  // array A 
+  if     ( postPos[0] > 0) {
+    
+    
+    // first Photoelectric in A after initial
+    // Compton in A by same track
+    if     (nPhotoA == 0 &&
+	    trackID == trackID_A1){ 
+      //G4cout << " array A   " << G4endl;
+      nPhotoA  = 1;
+      Tangle2::posA_P1 = postPos; 
+    }
+    // second Photoelectric in A ..
+    // expect this to be at least rare
+    if     (nPhotoA == 1 &&
+	    trackID == trackID_A1){ 
+      nPhotoA  = 2;
+      Tangle2::posA_P2 = postPos; 
+    }
+    
+    
+  }// array B
+  else if( postPos[0] < 0){
+    
+    
+    // first Photoelectric in B after initial
+    // Compton in B by same track
+    if     (nPhotoB == 0 &&
+	    trackID == trackID_B1){ 
+      //G4cout << " array B   " << G4endl;
+      nPhotoB  = 1;
+      Tangle2::posB_P1 = postPos; 
+    }
+    // second Photo in B ..
+    // expect this to be at least rare
+    if     (nPhotoB == 1 &&
+	    trackID == trackID_B1){ 
+      nPhotoB  = 2;
+      Tangle2::posA_P2 = postPos; 
+    }
+    
+  }
+}
 
-  G4double thetaPol = preStepPol.angle(postStepPol) * 180/pi; 
+void Tangle2SteppingAction::RecordCompton(G4int trackID,
+					  G4int copyNo,
+					  const G4ThreeVector& postPos,
+					  const G4ThreeVector& preDir,
+					  const G4ThreeVector& postDir,
+					  const G4ThreeVector& prePol,
+					  const G4ThreeVector& postPol)
+{
+  if(!doubleComptEvent)
+    return;
+  
+  // Only the raw vectors are recorded here. Theta, phi and
+  // thetaPol are calculated in ComputeAngles, which is only
+  // called for events that pass the selection.
   
   // array A is in positive x direction
   if     ( postPos[0] > 0) {
@@ -433,33 +450,11 @@ void Tangle2SteppingAction::UserSteppingAction(const G4Step* step)
       nComptonA  = 1;
       Tangle2::posA_1 = postPos; 
       
-      beam_A   = preMomentumDir;
-      vScat_A1 = postMomentumDir;
+      beam_A   = preDir;
+      vScat_A1 = postDir;
       
-      Tangle2::thetaPolA = thetaPol;
-  
-      //      if(thetaPol==90){
-// 	G4cout << " thetaPolA = " << Tangle2::thetaPolA << G4endl;
-// 	G4cout << " preStepPol.x()  = " << preStepPol.x()  << G4endl; 
-// 	G4cout << " preStepPol.y()  = " << preStepPol.y()  << G4endl; 
-// 	G4cout << " preStepPol.z()  = " << preStepPol.z()  << G4endl; 
-// 	G4cout << " postStepPol.x() = " << postStepPol.x() << G4endl; 
-// 	G4cout << " postStepPol.y() = " << postStepPol.y() << G4endl; 
-// 	G4cout << " postStepPol.z() = " << postStepPol.z() << G4endl; 
-	//      }
-      
-      CalculateThetaPhi(beam_A,
-			beam_A,
-			vScat_A1,
-			Tangle2::thetaA,
-			Tangle2::phiA);
-
-      // G4cout << G4endl;
-      // G4cout << " beam_A.phi()    = " << beam_A.phi()*180/pi   << G4endl;
-      // G4cout << " vScat_A1.phi()  = " << vScat_A1.phi()*180/pi << G4endl;
-      // G4cout << " Tangle2::phiA   = " << Tangle2::phiA         << G4endl;
-      // G4cout << " Tangle2::thetaA = " << Tangle2::thetaA       << G4endl;
-      // G4cout << " thetaPol        = " << thetaPol              << G4endl;
+      vPolPre_A  = prePol;
+      vPolPost_A = postPol;
       
     }
     // second Compton in A
@@ -469,13 +464,8 @@ void Tangle2SteppingAction::UserSteppingAction(const G4Step* step)
       nComptonA       = 2;
       Tangle2::posA_2 = postPos;
       
-      vScat_A2 = postMomentumDir;  
-      
-      CalculateThetaPhi(beam_A,
-			preMomentumDir,
-			vScat_A2,
-			Tangle2::thetaA2,
-			Tangle2::phiA2);
+      vPre_A2  = preDir;
+      vScat_A2 = postDir;  
       
     }
     else if(nComptonA == 2 &&
@@ -493,25 +483,12 @@ void Tangle2SteppingAction::UserSteppingAction(const G4Step* step)
       nComptonB = 1;
       Tangle2::posB_1 = postPos;
       
-      beam_B   = preMomentumDir;
-      vScat_B1 = postMomentumDir;
+      beam_B   = preDir;
+      vScat_B1 = postDir;
+      
+      vPolPre_B  = prePol;
+      vPolPost_B = postPol;
       
-      Tangle2::thetaPolB = thetaPol;
-
-//       G4cout << " thetaPolB = " << Tangle2::thetaPolB << G4endl;
-//       G4cout << " preStepPol.x()  = " << preStepPol.x()  << G4endl; 
-//       G4cout << " preStepPol.y()  = " << preStepPol.y()  << G4endl; 
-//       G4cout << " preStepPol.z()  = " << preStepPol.z()  << G4endl; 
-//       G4cout << " postStepPol.x() = " << postStepPol.x() << G4endl; 
-//       G4cout << " postStepPol.y() = " << postStepPol.y() << G4endl; 
-//       G4cout << " postStepPol.z() = " << postStepPol.z() << G4endl; 
-  
-      CalculateThetaPhi(beam_B,
-			beam_B,
-			vScat_B1,
-			Tangle2::thetaB,
-			Tangle2::phiB);
-
     }
     // second Compton in B
     else if(nComptonB == 1 &&
@@ -520,14 +497,9 @@ void Tangle2SteppingAction::UserSteppingAction(const G4Step* step)
       nComptonB = 2;
       Tangle2::posB_2 = postPos;
       
-      vScat_B2 = postMomentumDir;  
+      vPre_B2  = preDir;
+      vScat_B2 = postDir;  
       
-      CalculateThetaPhi(beam_B,
-			preMomentumDir,
-			vScat_B2,
-			Tangle2::thetaB2,
-			Tangle2::phiB2);
-
     }
     else if(nComptonB == 2 &&
 	    trackID == trackID_B1){
@@ -537,21 +509,15 @@ void Tangle2SteppingAction::UserSteppingAction(const G4Step* step)
   
   if(comments){
     G4cout << G4endl;
-    G4cout << " particleName = " << particleName << G4endl;
-    G4cout << " processName  = " << processName  << G4endl;
     G4cout << " trackID      = " << trackID      << G4endl;
-    G4cout << " stepNumber   = " << stepNumber   << G4endl;
     G4cout << G4endl;    
     G4cout << " nComptonA    = " << nComptonA   << G4endl;
     G4cout << " nComptonB    = " << nComptonB   << G4endl;
     G4cout << " trackID_A1   = " << trackID_A1  << G4endl;
     G4cout << " trackID_B1   = " << trackID_B1  << G4endl;
   }
-
   
   // Iterate the number of Compton scatters
   // occuring in each crystal
-  Tangle2::nb_Compt[postPV->GetCopyNo()]++;
-  
-  return;
+  Tangle2::nb_Compt[copyNo]++;
 }
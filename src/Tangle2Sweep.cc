@@ -0,0 +1,164 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2Sweep.hh"
+
+#include "Tangle2Data.hh"
+
+#include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "G4Timer.hh"
+
+#include <iomanip>
+#include <sstream>
+
+G4bool Tangle2Sweep::Add(const G4String& tag, const G4String& settings)
+{
+  for (std::size_t i = 0; i < fPoints.size(); i++) {
+    if (fPoints[i].tag == tag) {
+      G4cout << " Tangle2Sweep: " << tag << " already added" << G4endl;
+      return false;
+    }
+  }
+  
+  Point point;
+  point.tag = tag;
+  Tangle2Config scratch;
+  std::istringstream is(settings);
+  std::string setting;
+  while (is >> setting) {
+    const std::size_t eq = setting.find('=');
+    const G4String name  = setting.substr(0, eq);
+    const G4String value
+      = eq == std::string::npos ? "" : setting.substr(eq + 1);
+    if (!scratch.Set(name, value)) {
+      G4cout << " Tangle2Sweep: " << tag << ": bad setting \""
+	     << setting << "\"" << G4endl;
+      return false;
+    }
+    point.names.push_back(name);
+    point.values.push_back(value);
+  }
+  fPoints.push_back(point);
+  return true;
+}
+
+void Tangle2Sweep::List() const
+{
+  for (std::size_t i = 0; i < fPoints.size(); i++) {
+    const Point& point = fPoints[i];
+    G4cout << " " << point.tag << ":";
+    for (std::size_t j = 0; j < point.names.size(); j++)
+      G4cout << " " << point.names[j] << "=" << point.values[j];
+    G4cout << G4endl;
+  }
+}
+
+G4bool Tangle2Sweep::Apply(const Tangle2Config& config)
+{
+  G4bool geometryChanged;
+  if (!Tangle2Config::Reconfigure(config, geometryChanged))
+    return false;
+  // Rebuilt at the next BeamOn; the materials are the same, so the
+  // physics tables are kept
+  if (geometryChanged)
+    G4UImanager::GetUIpointer()->ApplyCommand("/run/reinitializeGeometry");
+  return true;
+}
+
+void Tangle2Sweep::Run(G4int nEvents)
+{
+  if (fPoints.empty()) {
+    G4cout << " Tangle2Sweep: nothing to run, see /tangle2/sweep/add"
+	   << G4endl;
+    return;
+  }
+  
+  const Tangle2Config base = Tangle2::config;
+  const G4String baseName = Tangle2::outputName;
+  
+  // The physics is built, check first rather than stop half way
+  for (std::size_t i = 0; i < fPoints.size(); i++) {
+    Tangle2Config config = base;
+    for (std::size_t j = 0; j < fPoints[i].names.size(); j++)
+      config.Set(fPoints[i].names[j], fPoints[i].values[j]);
+    if (config.polarisedCompton != base.polarisedCompton) {
+      G4cout << " Tangle2Sweep: " << fPoints[i].tag
+	     << " changes polarisedCompton, which needs its own job"
+	     << G4endl;
+      return;
+    }
+  }
+  
+  G4RunManager* runManager = G4RunManager::GetRunManager();
+  std::vector<Result> results;
+  
+  for (std::size_t i = 0; i < fPoints.size(); i++) {
+    const Point& point = fPoints[i];
+    Tangle2Config config = base;
+    for (std::size_t j = 0; j < point.names.size(); j++)
+      config.Set(point.names[j], point.values[j]);
+    if (!Apply(config)) continue;
+    Tangle2::outputName = baseName + "_" + point.tag;
+    
+    G4cout << G4endl << " Sweep point " << i + 1 << "/" << fPoints.size()
+	   << ": " << point.tag << G4endl;
+    Tangle2::config.Print();
+    
+    G4Timer timer;
+    timer.Start();
+    runManager->BeamOn(nEvents);
+    timer.Stop();
+    
+    // Tangle2::masterEventSeconds is set by the master run action;
+    // the rest of BeamOn is (re)initialisation and thread start-up
+    Result result;
+    result.tag = point.tag;
+    result.nEvents = Tangle2::nMasterEvents;
+    result.eventSeconds = Tangle2::masterEventSeconds;
+    result.initSeconds = timer.GetRealElapsed() - result.eventSeconds;
+    results.push_back(result);
+  }
+  
+  Apply(base);
+  Tangle2::outputName = baseName;
+  
+  PrintResults(results);
+}
+
+void Tangle2Sweep::PrintResults(const std::vector<Result>& results) const
+{
+  G4cout << G4endl << " Sweep: " << results.size() << " points" << G4endl
+	 << std::setw(16) << "tag" << std::setw(12) << "events"
+	 << std::setw(12) << "init [s]" << std::setw(12) << "events [s]"
+	 << std::setw(14) << "events/s" << G4endl;
+  
+  G4double initSeconds = 0., eventSeconds = 0.;
+  for (std::size_t i = 0; i < results.size(); i++) {
+    const Result& result = results[i];
+    G4cout << std::setw(16) << result.tag
+	   << std::setw(12) << result.nEvents
+	   << std::setw(12) << std::setprecision(3) << result.initSeconds
+	   << std::setw(12) << std::setprecision(3) << result.eventSeconds
+	   << std::setw(14) << std::setprecision(4)
+	   << (result.eventSeconds > 0. ?
+	       result.nEvents/result.eventSeconds : 0.)
+	   << G4endl;
+    initSeconds += result.initSeconds;
+    eventSeconds += result.eventSeconds;
+  }
+  G4cout << " total: " << initSeconds << " s initialisation, "
+	 << eventSeconds << " s event loop" << G4endl;
+}
@@ -0,0 +1,85 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2SweepMessenger.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include <sstream>
+
+Tangle2SweepMessenger::Tangle2SweepMessenger()
+{
+  fpDirectory = new G4UIdirectory("/tangle2/sweep/");
+  fpDirectory->SetGuidance("Several configurations in one session.");
+  
+  fpAddCmd = new G4UIcommand("/tangle2/sweep/add", this);
+  fpAddCmd->SetGuidance("Add a configuration, named as in /tangle2/config/,");
+  fpAddCmd->SetGuidance("e.g. add perp positrons=false perpPol=true");
+  fpAddCmd->SetGuidance("Output goes to Tangle2_<tag>...");
+  fpAddCmd->SetParameter(new G4UIparameter("tag", 's', false));
+  fpAddCmd->SetParameter(new G4UIparameter("settings", 's', true));
+  
+  fpRunCmd = new G4UIcmdWithAnInteger("/tangle2/sweep/run", this);
+  fpRunCmd->SetGuidance("Run nEvents for each configuration in turn.");
+  fpRunCmd->SetParameterName("nEvents", false);
+  fpRunCmd->SetRange("nEvents >= 0");
+  // after /run/initialize
+  fpRunCmd->AvailableForStates(G4State_Idle);
+  
+  fpClearCmd = new G4UIcmdWithoutParameter("/tangle2/sweep/clear", this);
+  fpClearCmd->SetGuidance("Remove all configurations.");
+  
+  fpListCmd = new G4UIcmdWithoutParameter("/tangle2/sweep/list", this);
+  fpListCmd->SetGuidance("List the configurations.");
+  
+  G4UIcommand* commands[] = {fpAddCmd, fpRunCmd, fpClearCmd, fpListCmd};
+  for (std::size_t i = 0; i < sizeof(commands)/sizeof(commands[0]); i++) {
+    if (commands[i] != fpRunCmd)
+      commands[i]->AvailableForStates(G4State_PreInit, G4State_Idle);
+    // the sweep runs on the master only
+    commands[i]->SetToBeBroadcasted(false);
+  }
+}
+
+Tangle2SweepMessenger::~Tangle2SweepMessenger()
+{
+  delete fpListCmd;
+  delete fpClearCmd;
+  delete fpRunCmd;
+  delete fpAddCmd;
+  delete fpDirectory;
+}
+
+void Tangle2SweepMessenger::SetNewValue(G4UIcommand* command,
+					G4String newValue)
+{
+  if (command == fpAddCmd) {
+    std::istringstream is(newValue);
+    std::string tag, settings;
+    is >> tag;
+    std::getline(is, settings);
+    fSweep.Add(tag, settings);
+  }
+  else if (command == fpRunCmd)
+    fSweep.Run(fpRunCmd->GetNewIntValue(newValue));
+  else if (command == fpClearCmd)
+    fSweep.Clear();
+  else if (command == fpListCmd)
+    fSweep.List();
+}
@@ -0,0 +1,256 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2Telemetry.hh"
+
+#include "Tangle2Data.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <new>
+#include <sstream>
+
+namespace {
+
+  double NowSeconds()
+  {
+    return std::chrono::duration<double>
+      (std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  G4long FileSize(const std::string& fileName)
+  {
+    std::ifstream file(fileName.c_str(), std::ios::binary | std::ios::ate);
+    return file ? G4long(file.tellg()) : 0;
+  }
+
+  std::string Duration(double seconds)
+  {
+    const long s = long(seconds + 0.5);
+    std::ostringstream os;
+    if (s >= 86400) os << s/86400 << "d ";
+    if (s >= 3600)  os << (s/3600)%24 << "h ";
+    os << (s/60)%60 << "m " << s%60 << "s";
+    return os.str();
+  }
+
+  std::string ThreadLabel(G4int index)
+  {
+    std::ostringstream os;
+    os << "{thread=\"";
+    if (index == 0) os << "master";
+    else os << index - 1;
+    os << "\"}";
+    return os.str();
+  }
+
+}
+
+Tangle2Telemetry::Tangle2Telemetry()
+: fEnabled(false), fInterval(0.), fConsole(true), fNEventsToBeProcessed(0),
+  fSlotStorage(new char[kMaxSlots*sizeof(Slot) + alignof(Slot)]),
+  fSlots(0), fLast(kMaxSlots),
+  fStartSeconds(0.), fLastSeconds(0.),
+  fClosedBytes(kMaxSlots), fOpenFiles(kMaxSlots), fStop(false)
+{
+  // new Slot[] is only aligned for over-aligned types from C++17 on
+  void* p = fSlotStorage;
+  std::size_t space = kMaxSlots*sizeof(Slot) + alignof(Slot);
+  p = std::align(alignof(Slot), kMaxSlots*sizeof(Slot), p, space);
+  fSlots = static_cast<Slot*>(p);
+  for (G4int i = 0; i < kMaxSlots; i++)
+    new (fSlots + i) Slot;
+}
+
+Tangle2Telemetry::~Tangle2Telemetry()
+{
+  EndOfRun();
+  for (G4int i = 0; i < kMaxSlots; i++)
+    fSlots[i].~Slot();
+  delete [] fSlotStorage;
+}
+
+void Tangle2Telemetry::BeginOfRun(G4long nEventsToBeProcessed)
+{
+  fInterval = Tangle2::telemetryInterval;
+  fConsole  = Tangle2::telemetryConsole;
+  fEnabled  = fInterval > 0.;
+  if (!fEnabled) return;
+  
+  fNEventsToBeProcessed = nEventsToBeProcessed;
+  fMetricsFile = Tangle2::outputName + "_metrics.prom";
+  for (G4int i = 0; i < kMaxSlots; i++) {
+    fSlots[i].nEvents = 0;
+    fSlots[i].nSelected = 0;
+    fLast[i] = Sample();
+  }
+  {
+    std::lock_guard<std::mutex> lock(fOutputMutex);
+    fClosedBytes.assign(kMaxSlots, 0);
+    fOpenFiles.assign(kMaxSlots, "");
+  }
+  fStartSeconds = fLastSeconds = NowSeconds();
+  
+  fStop = false;
+  fThread = std::thread(&Tangle2Telemetry::Loop, this);
+}
+
+void Tangle2Telemetry::EndOfRun()
+{
+  if (!fThread.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fStop = true;
+  }
+  fWake.notify_one();
+  fThread.join();
+  
+  // the workers' last Update is in by now
+  Report(true);
+}
+
+void Tangle2Telemetry::SetOutput(G4int threadID, G4long closedBytes,
+				 const std::string& openFile)
+{
+  if (!fEnabled) return;
+  std::lock_guard<std::mutex> lock(fOutputMutex);
+  fClosedBytes[Index(threadID)] = closedBytes;
+  fOpenFiles[Index(threadID)] = openFile;
+}
+
+void Tangle2Telemetry::Loop()
+{
+  std::unique_lock<std::mutex> lock(fMutex);
+  while (!fStop) {
+    fWake.wait_for(lock, std::chrono::duration<double>(fInterval));
+    if (fStop) break;
+    lock.unlock();
+    Report(false);
+    lock.lock();
+  }
+}
+
+G4long Tangle2Telemetry::OutputBytes()
+{
+  std::lock_guard<std::mutex> lock(fOutputMutex);
+  G4long bytes = 0;
+  for (G4int i = 0; i < kMaxSlots; i++) {
+    bytes += fClosedBytes[i];
+    if (!fOpenFiles[i].empty())
+      bytes += FileSize(fOpenFiles[i]);
+  }
+  return bytes;
+}
+
+// Rates over the last interval, or over the whole run if final
+void Tangle2Telemetry::Report(G4bool final)
+{
+  const double now = NowSeconds();
+  const double dt = final ? now - fStartSeconds : now - fLastSeconds;
+  
+  std::vector<Sample> current(kMaxSlots);
+  std::vector<double> rates(kMaxSlots, 0.);
+  Sample total;
+  G4double rate = 0., selectedRate = 0.;
+  G4double minRate = 0., maxRate = 0.;
+  G4int nThreads = 0;
+  for (G4int i = 0; i < kMaxSlots; i++) {
+    current[i].nEvents   = fSlots[i].nEvents.load(std::memory_order_relaxed);
+    current[i].nSelected = fSlots[i].nSelected.load(std::memory_order_relaxed);
+    if (current[i].nEvents == 0) continue;
+    const Sample& from = final ? Sample() : fLast[i];
+    if (dt > 0.) {
+      rates[i] = (current[i].nEvents - from.nEvents)/dt;
+      selectedRate += (current[i].nSelected - from.nSelected)/dt;
+    }
+    rate += rates[i];
+    if (nThreads == 0 || rates[i] < minRate) minRate = rates[i];
+    if (nThreads == 0 || rates[i] > maxRate) maxRate = rates[i];
+    total.nEvents += current[i].nEvents;
+    total.nSelected += current[i].nSelected;
+    nThreads++;
+  }
+  fLast = current;
+  fLastSeconds = now;
+  
+  const G4long nRemaining = fNEventsToBeProcessed - total.nEvents;
+  const G4double eta = final ? 0. : (rate > 0. ? nRemaining/rate : -1.);
+  const G4long bytes = OutputBytes();
+  const double runSeconds = now - fStartSeconds;
+  
+  if (fConsole) {
+    std::ostringstream os;
+    os << "Telemetry " << Duration(runSeconds) << ": "
+       << total.nEvents << " of " << fNEventsToBeProcessed << " events";
+    if (fNEventsToBeProcessed > 0)
+      os << " (" << std::fixed << std::setprecision(1)
+	 << 100.*total.nEvents/fNEventsToBeProcessed << "%)";
+    os << std::fixed << std::setprecision(0)
+       << ", " << rate << " events/s";
+    if (nThreads > 1)
+      os << " (" << nThreads << " threads, " << minRate << "-" << maxRate
+	 << " each)";
+    os << std::setprecision(1) << ", " << selectedRate << " selected/s";
+    if (!final)
+      os << ", ETA " << (eta >= 0. ? Duration(eta) : std::string("?"));
+    os << ", output " << bytes/1.e6 << " MB";
+    G4cout << os.str() << G4endl;
+  }
+  
+  // Prometheus text format, replaced as a whole
+  const std::string tmpName = fMetricsFile + ".tmp";
+  {
+    std::ofstream file(tmpName.c_str());
+    if (!file) return;
+    file << "# HELP tangle2_events_total Events processed this run"
+	 << std::endl << "# TYPE tangle2_events_total counter" << std::endl;
+    for (G4int i = 0; i < kMaxSlots; i++)
+      if (current[i].nEvents > 0)
+	file << "tangle2_events_total" << ThreadLabel(i) << " "
+	     << current[i].nEvents << std::endl;
+    file << "# HELP tangle2_selected_events_total Events selected this run"
+	 << std::endl << "# TYPE tangle2_selected_events_total counter"
+	 << std::endl;
+    for (G4int i = 0; i < kMaxSlots; i++)
+      if (current[i].nEvents > 0)
+	file << "tangle2_selected_events_total" << ThreadLabel(i) << " "
+	     << current[i].nSelected << std::endl;
+    file << "# HELP tangle2_events_per_second Over the last interval"
+	 << std::endl << "# TYPE tangle2_events_per_second gauge"
+	 << std::endl;
+    for (G4int i = 0; i < kMaxSlots; i++)
+      if (current[i].nEvents > 0)
+	file << "tangle2_events_per_second" << ThreadLabel(i) << " "
+	     << rates[i] << std::endl;
+    file << "# TYPE tangle2_selected_events_per_second gauge" << std::endl
+	 << "tangle2_selected_events_per_second " << selectedRate
+	 << std::endl
+	 << "# TYPE tangle2_run_events gauge" << std::endl
+	 << "tangle2_run_events " << fNEventsToBeProcessed << std::endl
+	 << "# TYPE tangle2_run_seconds gauge" << std::endl
+	 << "tangle2_run_seconds " << runSeconds << std::endl
+	 << "# HELP tangle2_eta_seconds -1 if not known" << std::endl
+	 << "# TYPE tangle2_eta_seconds gauge" << std::endl
+	 << "tangle2_eta_seconds " << eta << std::endl
+	 << "# TYPE tangle2_output_bytes gauge" << std::endl
+	 << "tangle2_output_bytes " << bytes << std::endl
+	 << "# TYPE tangle2_run_complete gauge" << std::endl
+	 << "tangle2_run_complete " << (final ? 1 : 0) << std::endl;
+  }
+  std::rename(tmpName.c_str(), fMetricsFile.c_str());
+}
@@ -0,0 +1,69 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2TelemetryMessenger.hh"
+
+#include "Tangle2Data.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithABool.hh"
+
+Tangle2TelemetryMessenger::Tangle2TelemetryMessenger()
+{
+  fpDirectory = new G4UIdirectory("/tangle2/telemetry/");
+  fpDirectory->SetGuidance("Progress reports during the run.");
+  
+  fpIntervalCmd = new G4UIcmdWithADouble("/tangle2/telemetry/interval",
+					 this);
+  fpIntervalCmd->SetGuidance("Seconds between reports, 0 for none.");
+  fpIntervalCmd->SetGuidance("Also written to <name>_metrics.prom.");
+  fpIntervalCmd->SetParameterName("s", false);
+  fpIntervalCmd->SetRange("s >= 0.");
+  fpIntervalCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  // Tangle2::telemetryInterval is shared, so set it on the master only
+  fpIntervalCmd->SetToBeBroadcasted(false);
+  
+  fpConsoleCmd = new G4UIcmdWithABool("/tangle2/telemetry/console", this);
+  fpConsoleCmd->SetGuidance("Print the reports as well.");
+  fpConsoleCmd->SetParameterName("console", false);
+  fpConsoleCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fpConsoleCmd->SetToBeBroadcasted(false);
+}
+
+Tangle2TelemetryMessenger::~Tangle2TelemetryMessenger()
+{
+  delete fpConsoleCmd;
+  delete fpIntervalCmd;
+  delete fpDirectory;
+}
+
+void Tangle2TelemetryMessenger::SetNewValue(G4UIcommand* command,
+					    G4String newValue)
+{
+  if (command == fpIntervalCmd)
+    Tangle2::telemetryInterval = fpIntervalCmd->GetNewDoubleValue(newValue);
+  else if (command == fpConsoleCmd)
+    Tangle2::telemetryConsole = fpConsoleCmd->GetNewBoolValue(newValue);
+}
+
+G4String Tangle2TelemetryMessenger::GetCurrentValue(G4UIcommand* command)
+{
+  if (command == fpIntervalCmd)
+    return fpIntervalCmd->ConvertToString(Tangle2::telemetryInterval);
+  if (command == fpConsoleCmd)
+    return fpConsoleCmd->ConvertToString(Tangle2::telemetryConsole);
+  return "";
+}
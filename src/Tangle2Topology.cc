@@ -0,0 +1,229 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2Topology.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+  // First number in the file, or fallback
+  int ReadInt(const std::string& fileName, int fallback)
+  {
+    std::ifstream file(fileName.c_str());
+    int value;
+    return (file >> value) ? value : fallback;
+  }
+
+#ifdef __linux__
+  // NUMA node of a CPU, from its nodeN entry in sysfs; 0 if none
+  int ReadNode(int cpu)
+  {
+    std::ostringstream path;
+    path << "/sys/devices/system/cpu/cpu" << cpu;
+    DIR* dir = opendir(path.str().c_str());
+    if (!dir) return 0;
+    int node = 0;
+    while (dirent* entry = readdir(dir)) {
+      int n;
+      if (std::sscanf(entry->d_name, "node%d", &n) == 1) {
+	node = n;
+	break;
+      }
+    }
+    closedir(dir);
+    return node;
+  }
+
+  // CPUs of the CFS quota of this process's cgroup, 0 if none
+  double ReadQuota()
+  {
+    // cgroup v2: "0::/path" in /proc/self/cgroup, "<quota> <period>"
+    // or "max <period>" in cpu.max, in the cgroup or (in a container,
+    // where the cgroup namespace hides the path) at the root
+    std::ifstream cgroups("/proc/self/cgroup");
+    std::string line, path;
+    while (std::getline(cgroups, line))
+      if (line.compare(0, 3, "0::") == 0) path = line.substr(3);
+    
+    std::vector<std::string> files;
+    if (!path.empty() && path != "/")
+      files.push_back("/sys/fs/cgroup" + path + "/cpu.max");
+    files.push_back("/sys/fs/cgroup/cpu.max");
+    for (std::size_t i = 0; i < files.size(); i++) {
+      std::ifstream file(files[i].c_str());
+      std::string quota;
+      double period;
+      if (file >> quota >> period) {
+	if (quota == "max" || period <= 0.) return 0.;
+	return std::atof(quota.c_str())/period;
+      }
+    }
+    
+    // cgroup v1
+    const char* const dirs[] = {"/sys/fs/cgroup/cpu,cpuacct",
+				"/sys/fs/cgroup/cpu"};
+    for (int i = 0; i < 2; i++) {
+      const std::string dir = dirs[i];
+      const int quota  = ReadInt(dir + "/cpu.cfs_quota_us", -1);
+      const int period = ReadInt(dir + "/cpu.cfs_period_us", -1);
+      if (period > 0)
+	return quota > 0 ? double(quota)/period : 0.;
+    }
+    return 0.;
+  }
+#endif
+
+}
+
+bool Tangle2Topology::ParsePolicy(const std::string& name, Policy& policy)
+{
+  if      (name == "none")    policy = kNone;
+  else if (name == "compact") policy = kCompact;
+  else if (name == "scatter") policy = kScatter;
+  else return false;
+  return true;
+}
+
+const char* Tangle2Topology::PolicyName(Policy policy)
+{
+  switch (policy) {
+  case kCompact: return "compact";
+  case kScatter: return "scatter";
+  default:       return "none";
+  }
+}
+
+Tangle2Topology::Tangle2Topology()
+: fNNodes(1), fQuotaCPUs(0.)
+{
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int id = 0; id < CPU_SETSIZE; id++) {
+      if (!CPU_ISSET(id, &set)) continue;
+      std::ostringstream topology;
+      topology << "/sys/devices/system/cpu/cpu" << id << "/topology/";
+      CPU cpu;
+      cpu.id      = id;
+      cpu.package = ReadInt(topology.str() + "physical_package_id", 0);
+      cpu.core    = ReadInt(topology.str() + "core_id", id);
+      cpu.node    = ReadNode(id);
+      cpu.sibling = 0;
+      fCPUs.push_back(cpu);
+    }
+  }
+  fQuotaCPUs = ReadQuota();
+  
+  // number the hardware threads of each core
+  std::map<std::pair<int, int>, int> nThreadsOfCore;
+  for (std::size_t i = 0; i < fCPUs.size(); i++)
+    fCPUs[i].sibling
+      = nThreadsOfCore[std::make_pair(fCPUs[i].package, fCPUs[i].core)]++;
+  
+  // compact order: first hardware threads first, then by node and core
+  struct Compact {
+    bool operator()(const CPU& a, const CPU& b) const
+    {
+      if (a.sibling != b.sibling) return a.sibling < b.sibling;
+      if (a.node != b.node) return a.node < b.node;
+      if (a.package != b.package) return a.package < b.package;
+      if (a.core != b.core) return a.core < b.core;
+      return a.id < b.id;
+    }
+  };
+  std::sort(fCPUs.begin(), fCPUs.end(), Compact());
+  
+  // scatter: the i-th CPU of each node in turn
+  std::map<int, std::vector<int> > byNode;
+  for (std::size_t i = 0; i < fCPUs.size(); i++)
+    byNode[fCPUs[i].node].push_back(fCPUs[i].id);
+  fNNodes = std::max<int>(byNode.size(), 1);
+  for (std::size_t k = 0; fScatter.size() < fCPUs.size(); k++)
+    for (std::map<int, std::vector<int> >::const_iterator n = byNode.begin();
+	 n != byNode.end(); ++n)
+      if (k < n->second.size())
+	fScatter.push_back(n->second[k]);
+#endif
+  
+  if (fCPUs.empty()) {
+    // unknown layout: numbered CPUs, no placement
+    const int n = std::max<int>(std::thread::hardware_concurrency(), 1);
+    for (int id = 0; id < n; id++) {
+      CPU cpu = {id, 0, id, 0, 0};
+      fCPUs.push_back(cpu);
+    }
+  }
+}
+
+int Tangle2Topology::GetDefaultNThreads() const
+{
+  int n = GetNAllowedCPUs();
+  if (fQuotaCPUs > 0.)
+    n = std::min(n, int(std::floor(fQuotaCPUs)));
+  return std::max(n, 1);
+}
+
+int Tangle2Topology::CPUForThread(int threadID, Policy policy) const
+{
+  if (threadID < 0 || fCPUs.empty()) return -1;
+  const std::size_t i = std::size_t(threadID)%fCPUs.size();
+  if (policy == kCompact) return fCPUs[i].id;
+  if (policy == kScatter && i < fScatter.size()) return fScatter[i];
+  return -1;
+}
+
+int Tangle2Topology::NodeOfCPU(int cpu) const
+{
+  for (std::size_t i = 0; i < fCPUs.size(); i++)
+    if (fCPUs[i].id == cpu) return fCPUs[i].node;
+  return 0;
+}
+
+bool Tangle2Topology::PinCurrentThread(int cpu)
+{
+#ifdef __linux__
+  if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  (void)cpu;
+  return false;
+#endif
+}
+
+void Tangle2Topology::Print(std::ostream& os) const
+{
+  os << " " << GetNAllowedCPUs() << " CPUs available";
+  if (fNNodes > 1) os << " on " << fNNodes << " NUMA nodes";
+  if (fQuotaCPUs > 0.) os << ", cgroup quota " << fQuotaCPUs << " CPUs";
+  os << ": " << GetDefaultNThreads() << " threads by default" << std::endl;
+}
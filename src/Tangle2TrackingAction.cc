@@ -1,9 +1,15 @@
 #include "Tangle2TrackingAction.hh"
 
 #include "Tangle2Data.hh"
+#include "Tangle2RunAction.hh"
 
-void Tangle2TrackingAction::PreUserTrackingAction(const G4Track*)
+Tangle2TrackingAction::Tangle2TrackingAction(Tangle2RunAction* runAction)
+: fpProfiler(&runAction->GetProfiler())
+{}
+
+void Tangle2TrackingAction::PreUserTrackingAction(const G4Track* track)
 {
+  fpProfiler->StartTrack(track);
 //  G4cout << "Tangle2TrackingAction::PreUserTrackingAction" << G4endl;
 }
 
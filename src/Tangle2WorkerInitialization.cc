@@ -0,0 +1,38 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2WorkerInitialization.hh"
+
+#include "G4Threading.hh"
+
+Tangle2WorkerInitialization::Tangle2WorkerInitialization
+(const Tangle2Topology& topology, Tangle2Topology::Policy policy)
+: fTopology(topology), fPolicy(policy)
+{}
+
+void Tangle2WorkerInitialization::WorkerInitialize() const
+{
+  const G4int threadID = G4Threading::G4GetThreadId();
+  const G4int cpu = fTopology.CPUForThread(threadID, fPolicy);
+  if (cpu < 0) return;
+  
+  if (Tangle2Topology::PinCurrentThread(cpu))
+    G4cout << "Tangle2WorkerInitialization: thread " << threadID
+	   << " on CPU " << cpu << " (NUMA node "
+	   << fTopology.NodeOfCPU(cpu) << ")" << G4endl;
+  else
+    G4cout << "Tangle2WorkerInitialization: thread " << threadID
+	   << " could not be pinned to CPU " << cpu << G4endl;
+}
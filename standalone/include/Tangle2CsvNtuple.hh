@@ -0,0 +1,71 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Ntuples as comma separated text in the layout of the Geant4 csv
+// analysis manager (g4csv.hh, tools::wcsv::ntuple with header):
+//
+//   #class tools::wcsv::ntuple
+//   #title Tangle2
+//   #separator 44
+//   #vector_separator 59
+//   #column double edep0
+//   ...
+//   0.511,0,...
+//
+// so that tangle2 built with g4csv and the standalone engine write the
+// same files.  Tangle2CsvOutput writes them as a Tangle2OutputBackend,
+// to <fileName>_nt_Tangle2.csv as g4csv names them.  The reader also
+// accepts a single line of column names in place of the # header, as
+// exported by most other tools.
+
+#ifndef Tangle2CsvNtuple_hh
+#define Tangle2CsvNtuple_hh 1
+
+#include "Tangle2OutputBackend.hh"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class Tangle2CsvOutput : public Tangle2OutputBackend
+{
+public:
+  Tangle2CsvOutput();
+  virtual ~Tangle2CsvOutput();
+
+  virtual const char* GetName() const { return "csv"; }
+
+protected:
+  virtual std::string DoOpen(const std::string& fileName);
+  virtual void DoWrite(const Tangle2EventRecord&);
+  virtual void DoClose();
+
+private:
+  std::FILE* fpFile;
+};
+
+struct Tangle2CsvNtuple
+{
+  std::vector<std::string> names;
+  std::vector<std::vector<double> > rows;
+
+  // Index of the named column, or -1
+  int Column(const std::string& name) const;
+
+  // Returns false, with a message in error, if the file can not be read
+  bool Read(const std::string& fileName, std::string& error);
+};
+
+#endif
@@ -0,0 +1,59 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Event-ordered merge of Tangle2 ntuple files, see tangle2_merge.cc.
+//
+// Each input is in event order already (a worker processes its events
+// in increasing eventID), so a k-way merge on (eventID, threadID) puts
+// the rows of all threads back in event order, reading every input a
+// row (csv) or a chunk (hdf5) at a time.  Memory does not grow with the
+// number of rows.
+//
+// More inputs than fanIn are merged in groups of up to fanIn, nThreads
+// groups at a time, to temporary files next to the output, which are
+// then merged in turn.  This bounds the open files and the buffers per
+// merge, and uses the cores for hundreds of inputs.
+
+#ifndef Tangle2Merge_hh
+#define Tangle2Merge_hh 1
+
+#include <string>
+#include <vector>
+
+struct Tangle2MergeOptions
+{
+  std::string format;   // csv or hdf5, of the output
+  unsigned    nThreads;
+  std::size_t fanIn;
+  bool        verbose;
+
+  Tangle2MergeOptions()
+  : format("csv"), nThreads(1), fanIn(64), verbose(false) {}
+};
+
+struct Tangle2MergeResult
+{
+  long nRows;
+  long nOutOfOrder;  // rows of an input before the row preceding them
+  std::string outputFile;
+  std::string error;  // empty if the merge succeeded
+};
+
+// output is without extension, as Tangle2OutputBackend::Open
+Tangle2MergeResult Tangle2MergeFiles(const std::vector<std::string>& inputs,
+				     const std::string& output,
+				     const Tangle2MergeOptions& options);
+
+#endif
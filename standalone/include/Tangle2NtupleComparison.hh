@@ -0,0 +1,32 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Cross-check of two Tangle2 ntuples, typically tangle2 (full Geant4)
+// against the standalone engine.  For a fixed set of columns the two
+// distributions are compared shape only, with the two-sample chi2 test
+// for unweighted histograms, and the means are printed side by side.
+
+#ifndef Tangle2NtupleComparison_hh
+#define Tangle2NtupleComparison_hh 1
+
+#include <string>
+
+// Returns 0 if every column is compatible (p-value above pMin),
+// 1 if not, 2 if either file can not be read
+int Tangle2CompareNtuples(const std::string& referenceFile,
+			  const std::string& testFile,
+			  double pMin = 0.001);
+
+#endif
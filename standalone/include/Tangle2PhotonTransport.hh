@@ -0,0 +1,138 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Photon-only transport for the standalone engine: polarised
+// Klein-Nishina Compton scattering on free electrons and
+// photoabsorption in the LYSO crystals of Tangle2Geometry, treated as
+// axis-aligned boxes in vacuum.  Lengths in mm, energies in MeV.
+//
+// The Compton sampling is that of Tangle2CrystalFastModel,
+// Tangle2ComptonSampler.  Not
+// simulated: Rayleigh scattering, binding effects, fluorescence,
+// electron transport (the electron energy is deposited where it is
+// produced), the air and the entanglement correlations of the
+// modified Livermore model.
+
+#ifndef Tangle2PhotonTransport_hh
+#define Tangle2PhotonTransport_hh 1
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+class Tangle2StandaloneEvent;
+
+struct Tangle2Vector
+{
+  double x, y, z;
+
+  Tangle2Vector(): x(0.), y(0.), z(0.) {}
+  Tangle2Vector(double vx, double vy, double vz): x(vx), y(vy), z(vz) {}
+
+  Tangle2Vector operator+(const Tangle2Vector& v) const
+  { return Tangle2Vector(x + v.x, y + v.y, z + v.z); }
+  Tangle2Vector operator-(const Tangle2Vector& v) const
+  { return Tangle2Vector(x - v.x, y - v.y, z - v.z); }
+  Tangle2Vector operator*(double a) const
+  { return Tangle2Vector(a*x, a*y, a*z); }
+  Tangle2Vector operator-() const
+  { return Tangle2Vector(-x, -y, -z); }
+
+  double Dot(const Tangle2Vector& v) const
+  { return x*v.x + y*v.y + z*v.z; }
+  Tangle2Vector Cross(const Tangle2Vector& v) const
+  { return Tangle2Vector(y*v.z - z*v.y, z*v.x - x*v.z, x*v.y - y*v.x); }
+  double Mag2() const { return x*x + y*y + z*z; }
+  Tangle2Vector Unit() const
+  { double m = std::sqrt(Mag2()); return m > 0. ? *this*(1./m) : *this; }
+  // A vector perpendicular to this one (as CLHEP Hep3Vector::orthogonal)
+  Tangle2Vector Orthogonal() const;
+
+  void ToArray(double a[3]) const { a[0] = x; a[1] = y; a[2] = z; }
+};
+
+inline Tangle2Vector operator*(double a, const Tangle2Vector& v)
+{ return v*a; }
+
+struct Tangle2Photon
+{
+  int           trackID;
+  double        energy;
+  Tangle2Vector position;
+  Tangle2Vector direction;
+  Tangle2Vector polarisation;
+};
+
+// Linear attenuation coefficients, 1/mm, tabulated in log(E)
+class Tangle2PhotonCrossSections
+{
+public:
+  // Analytic LYSO estimate, see SetDefault
+  Tangle2PhotonCrossSections();
+
+  // Klein-Nishina on the electron density of LYSO at 7.4 g/cm3 and a
+  // power law for photoabsorption fitted to XCOM between 0.1 and 1 MeV.
+  // Good to a few percent for Compton, ~20% for photoabsorption.
+  void SetDefault();
+
+  // Text file, one line per energy, ascending:
+  //   E [MeV]  muCompt [1/mm]  muPhot [1/mm]
+  // Lines starting with # are ignored.  Returns false if unreadable.
+  bool Load(const std::string& fileName);
+
+  void GetMu(double energy, double& muCompt, double& muPhot) const;
+
+private:
+  std::vector<double> fLogE, fMuCompt, fMuPhot;
+};
+
+class Tangle2PhotonTransport
+{
+public:
+  Tangle2PhotonTransport(const Tangle2PhotonCrossSections&,
+			 bool fullPET,
+			 std::mt19937_64& engine);
+
+  // Tracks the photon until it leaves the crystals or is absorbed,
+  // reporting interactions and deposits to the event
+  void Transport(Tangle2Photon&, Tangle2StandaloneEvent&);
+
+  double Uniform() { return fFlat(fEngine); }
+
+  // Unit vector, uniform over 4pi
+  Tangle2Vector RandomDirection();
+
+private:
+  struct Box { double lo[3], hi[3]; };
+
+  // Nearest crystal ahead along the ray, or -1.  tIn is 0 if
+  // the point is already inside.
+  int  NextCrystal(const Tangle2Vector& pos, const Tangle2Vector& dir,
+		   double& tIn, double& tOut) const;
+  bool Intersect(const Box&, const Tangle2Vector& pos,
+		 const Tangle2Vector& dir,
+		 double& tIn, double& tOut) const;
+
+  const Tangle2PhotonCrossSections& fCrossSections;
+  std::vector<Box> fCrystals;
+  std::mt19937_64& fEngine;
+  std::uniform_real_distribution<double> fFlat;
+
+  // Photons below this are absorbed where they are
+  double fEnergyCut;
+};
+
+#endif
@@ -0,0 +1,65 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Running tangle2 from the tools that drive it, tangle2_scaling and
+// tangle2_regression: a child process in a directory of its own with
+// its output in a log, and the numbers the master's end of run report
+// leaves in that log (Tangle2RunAction).  POSIX (fork, execvp, wait4).
+
+#ifndef Tangle2Process_hh
+#define Tangle2Process_hh 1
+
+#include <string>
+#include <vector>
+
+struct Tangle2ProcessResult
+{
+  bool   ok;            // exited with 0
+  int    status;        // as from wait4
+  double wallSeconds;   // from fork to exit
+  long   peakRSSBytes;
+};
+
+// Values not found in the log are -1
+struct Tangle2RunLog
+{
+  long   nEvents;
+  long   nSelected;
+  double loopSeconds;   // the event loop
+};
+
+namespace Tangle2Process
+{
+  // args[0] is looked up in PATH if it has no '/'; a relative path to
+  // it must be made absolute by the caller (the child changes directory).
+  // stdout and stderr of the child go to directory/logName.
+  Tangle2ProcessResult Run(const std::vector<std::string>& args,
+			   const std::string& directory,
+			   const std::string& logName);
+
+  Tangle2RunLog ReadLog(const std::string& fileName);
+
+  // Relative to the working directory
+  std::string AbsolutePath(const std::string& path);
+
+  // True if it exists afterwards
+  bool MakeDirectory(const std::string& path);
+
+  // Bytes of the regular files in directory, but the one named except
+  long DirectoryBytes(const std::string& directory,
+		      const std::string& except = "");
+}
+
+#endif
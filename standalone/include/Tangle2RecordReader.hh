@@ -0,0 +1,64 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Streaming readers of Tangle2 ntuple files, one Tangle2EventRecord at
+// a time, for tangle2_merge.  Open chooses by extension:
+//
+//   .csv  - as written by g4csv or Tangle2CsvOutput (# header or a line
+//           of names), read a line at a time
+//   .h5   - as written by Tangle2Hdf5Output, read a chunk of rows at a
+//           time (needs WITH_TANGLE2_HDF5)
+//   .root  - g4root (the Tangle2 TTree) or Tangle2RNTupleOutput (the
+//           Tangle2 RNTuple), told apart by the class of the Tangle2
+//           key; needs ROOT, found when building, and RNTuple ROOT 6.34
+//           or later (WITH_TANGLE2_RNTUPLE)
+//
+// Columns are matched to Tangle2EventRecord by name; record columns
+// missing from the file read as 0, so eventID and threadID must be
+// present for an event-ordered merge (HasColumn) - g4root files of
+// tangle2 before these columns were added can not be merged.
+
+#ifndef Tangle2RecordReader_hh
+#define Tangle2RecordReader_hh 1
+
+#include "Tangle2EventRecord.hh"
+
+#include <string>
+
+class Tangle2RecordReader
+{
+public:
+  virtual ~Tangle2RecordReader();
+
+  // Null, with a message in error, if the file can not be read
+  static Tangle2RecordReader* Open(const std::string& fileName,
+				   std::string& error);
+
+  // False at the end of the file or on error (GetError non-empty)
+  virtual bool Next(Tangle2EventRecord&) = 0;
+
+  virtual bool HasColumn(const std::string& name) const = 0;
+
+  const std::string& GetFileName() const { return fFileName; }
+  const std::string& GetError() const { return fError; }
+
+protected:
+  explicit Tangle2RecordReader(const std::string& fileName);
+
+  std::string fFileName;
+  std::string fError;
+};
+
+#endif
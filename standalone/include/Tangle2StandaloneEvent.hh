@@ -0,0 +1,96 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// One event of the standalone engine.  It does, on plain types, what
+// Tangle2SteppingAction (RecordCompton, RecordPhoto, ComputeAngles) and
+// Tangle2EventAction (selection and ntuple row) do in tangle2, step for
+// step, so that every column means the same thing in both outputs.
+// Keep the two in step when either changes.
+
+#ifndef Tangle2StandaloneEvent_hh
+#define Tangle2StandaloneEvent_hh 1
+
+#include "Tangle2PhotonTransport.hh"
+#include "Tangle2AngleKernel.hh"
+#include "Tangle2EventRecord.hh"
+#include "Tangle2Selection.hh"
+
+class Tangle2StandaloneEvent
+{
+public:
+  Tangle2StandaloneEvent();
+
+  // nEvents as Tangle2::nEvents; sndGammaTrackID is the photon
+  // transported second (1 for back to back photons, 2 for positrons);
+  // weight as Tangle2::eventWeight
+  void Begin(long nEvents, int sndGammaTrackID, double weight);
+
+  // Before each photon is transported
+  void StartTrack(int trackID);
+
+  void AddEdep(int copyNo, double eDep);
+  void RecordPhoto(int trackID, int copyNo, const Tangle2Vector& pos);
+  void RecordCompton(int trackID, int copyNo, const Tangle2Vector& pos,
+		     const Tangle2Vector& preDir,
+		     const Tangle2Vector& postDir,
+		     const Tangle2Vector& prePol,
+		     const Tangle2Vector& postPol);
+
+  // Selection and angles.  Returns true, with Record() filled, if the
+  // event would be written to the Tangle2 ntuple.
+  bool End();
+
+  // The default, as tangle2 without /tangle2/select/ commands.
+  // Thresholds also decide CentralHits.
+  Tangle2Selection& GetSelection() { return fSelection; }
+
+  // Energy above threshold in both central crystals (a QET event)
+  bool CentralHits() const { return fCentralHits; }
+
+  const Tangle2EventRecord& Record() const { return fRecord; }
+
+private:
+  void ComputeAngles();
+
+  // Tangle2Data
+  double fEDepCryst[18];
+  int    fNbCompt[18], fNbPhoto[18];
+  Tangle2Vector fPosA1, fPosA2, fPosB1, fPosB2;
+  Tangle2Vector fPosAP1, fPosAP2, fPosBP1, fPosBP2;
+  double fThetaA, fThetaB, fPhiA, fPhiB, fDphi;
+  double fThetaA2, fThetaB2, fPhiA2, fPhiB2;
+  double fDphiA1B2, fDphiA2B1, fDphiA2B2;
+  double fThetaPolA, fThetaPolB;
+  long   fNEvents;
+  double fWeight;
+
+  // Tangle2SteppingAction
+  int  fNComptonA, fNComptonB;
+  int  fNPhotoA,   fNPhotoB;
+  int  fTrackIDA1, fTrackIDB1;
+  int  fSndGammaTrackID;
+  bool fDoubleComptEvent;
+
+  Tangle2Vector fBeamA, fScatA1, fPreA2, fScatA2, fPolPreA, fPolPostA;
+  Tangle2Vector fBeamB, fScatB1, fPreB2, fScatB2, fPolPreB, fPolPostB;
+
+  Tangle2AngleBatch fAngleBatch;
+
+  Tangle2Selection fSelection;
+  bool fCentralHits;
+  Tangle2EventRecord fRecord;
+};
+
+#endif
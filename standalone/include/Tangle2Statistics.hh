@@ -0,0 +1,50 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Shape comparisons of two binned distributions, for
+// Tangle2NtupleComparison and tangle2_regression:
+//
+//   ChiSquare   two sample chi2 for unweighted histograms (shape only),
+//               ndf = non-empty bins - 1
+//   Kolmogorov  largest difference of the normalised cumulative sums;
+//               on binned data the p-value is conservative
+//
+// Bins are the in-range contents, under- and overflow left out.
+
+#ifndef Tangle2Statistics_hh
+#define Tangle2Statistics_hh 1
+
+#include <vector>
+
+namespace Tangle2Statistics
+{
+  // Regularised upper incomplete gamma function Q(a,x)
+  double GammaQ(double a, double x);
+
+  // ndf is -1 if either histogram is empty
+  double ChiSquare(const std::vector<double>& a,
+		   const std::vector<double>& b,
+		   int& ndf);
+  // 1 for ndf <= 0
+  double ChiSquareProbability(double chi2, int ndf);
+
+  // 0 if either histogram is empty
+  double KolmogorovDistance(const std::vector<double>& a,
+			    const std::vector<double>& b);
+  // For entries nA and nB
+  double KolmogorovProbability(double distance, double nA, double nB);
+}
+
+#endif
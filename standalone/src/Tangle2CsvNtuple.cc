@@ -0,0 +1,143 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2CsvNtuple.hh"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+Tangle2CsvOutput::Tangle2CsvOutput()
+: fpFile(0)
+{}
+
+Tangle2CsvOutput::~Tangle2CsvOutput()
+{
+  Close();
+}
+
+std::string Tangle2CsvOutput::DoOpen(const std::string& fileName)
+{
+  const std::string name = fileName + "_nt_Tangle2.csv";
+  fpFile = std::fopen(name.c_str(), "w");
+  if (!fpFile) return "";
+  
+  const std::vector<Tangle2EventRecord::Column>& columns
+    = Tangle2EventRecord::Columns();
+  
+  std::fprintf(fpFile, "#class tools::wcsv::ntuple\n");
+  std::fprintf(fpFile, "#title Tangle2\n");
+  std::fprintf(fpFile, "#separator 44\n");
+  std::fprintf(fpFile, "#vector_separator 59\n");
+  // column types as booked by g4root, see Tangle2G4RootOutput
+  for (std::size_t i = 0; i < columns.size(); i++)
+    std::fprintf(fpFile, "#column %s %s\n",
+		 columns[i].type == Tangle2EventRecord::kInt16 ?
+		 "int" : "double", columns[i].name.c_str());
+  return name;
+}
+
+void Tangle2CsvOutput::DoWrite(const Tangle2EventRecord& record)
+{
+  const std::vector<Tangle2EventRecord::Column>& columns
+    = Tangle2EventRecord::Columns();
+  
+  for (std::size_t i = 0; i < columns.size(); i++) {
+    if (i) std::fputc(',', fpFile);
+    const double value = record.Get(columns[i]);
+    if (columns[i].type == Tangle2EventRecord::kFloat)
+      std::fprintf(fpFile, "%.9g", value);  // round trips a float
+    else
+      std::fprintf(fpFile, "%lld", (long long)(value));
+  }
+  std::fputc('\n', fpFile);
+}
+
+void Tangle2CsvOutput::DoClose()
+{
+  if (fpFile) std::fclose(fpFile);
+  fpFile = 0;
+}
+
+int Tangle2CsvNtuple::Column(const std::string& name) const
+{
+  for (std::size_t i = 0; i < names.size(); i++)
+    if (names[i] == name) return i;
+  return -1;
+}
+
+bool Tangle2CsvNtuple::Read(const std::string& fileName, std::string& error)
+{
+  names.clear();
+  rows.clear();
+  
+  std::ifstream in(fileName.c_str());
+  if (!in) {
+    error = "can not open " + fileName;
+    return false;
+  }
+  
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line[line.size()-1] == '\r')
+      line.erase(line.size()-1);
+    if (line.empty()) continue;
+    
+    if (line[0] == '#') {
+      // "#column <type> <name>"
+      std::istringstream is(line);
+      std::string key, type, name;
+      is >> key >> type >> name;
+      if (key == "#column" && !name.empty())
+	names.push_back(name);
+      continue;
+    }
+    
+    std::vector<std::string> fields;
+    std::istringstream is(line);
+    std::string field;
+    while (std::getline(is, field, ','))
+      fields.push_back(field);
+    
+    // a line of names instead of a # header
+    if (names.empty() && rows.empty()) {
+      char* end = 0;
+      std::strtod(fields[0].c_str(), &end);
+      if (end == fields[0].c_str()) {
+	names = fields;
+	continue;
+      }
+    }
+    
+    if (fields.size() != names.size()) {
+      std::ostringstream os;
+      os << fileName << ": row " << rows.size() + 1 << " has "
+	 << fields.size() << " fields for " << names.size() << " columns";
+      error = os.str();
+      return false;
+    }
+    
+    std::vector<double> row(fields.size());
+    for (std::size_t i = 0; i < fields.size(); i++)
+      row[i] = std::strtod(fields[i].c_str(), 0);
+    rows.push_back(row);
+  }
+  
+  if (names.empty()) {
+    error = fileName + ": no column names";
+    return false;
+  }
+  return true;
+}
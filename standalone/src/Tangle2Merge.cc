@@ -0,0 +1,196 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2Merge.hh"
+#include "Tangle2RecordReader.hh"
+#include "Tangle2CsvNtuple.hh"
+#include "Tangle2Hdf5Output.hh"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <queue>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+namespace {
+
+  typedef std::pair<long long, int> Key;
+
+  Key KeyOf(const Tangle2EventRecord& record)
+  {
+    return Key(record.eventID, record.threadID);
+  }
+
+  struct Input
+  {
+    std::unique_ptr<Tangle2RecordReader> reader;
+    Tangle2EventRecord record;
+    std::size_t index;
+  };
+
+  // Smallest key on top; equal keys in input order
+  struct Later
+  {
+    bool operator()(const Input* a, const Input* b) const
+    {
+      const Key ka = KeyOf(a->record), kb = KeyOf(b->record);
+      return kb < ka || (ka == kb && b->index < a->index);
+    }
+  };
+
+  Tangle2OutputBackend* CreateOutput(const std::string& format)
+  {
+    if (format == "csv") return new Tangle2CsvOutput;
+    if (format == "hdf5" && Tangle2Hdf5Output::IsAvailable())
+      return new Tangle2Hdf5Output;
+    return 0;
+  }
+
+  Tangle2MergeResult MergeDirect(const std::vector<std::string>& inputs,
+				 const std::string& output,
+				 const Tangle2MergeOptions& options)
+  {
+    Tangle2MergeResult result;
+    result.nRows = 0;
+    result.nOutOfOrder = 0;
+    
+    std::vector<Input> in(inputs.size());
+    for (std::size_t i = 0; i < inputs.size(); i++) {
+      in[i].reader.reset(Tangle2RecordReader::Open(inputs[i], result.error));
+      if (!in[i].reader) return result;
+      if (!in[i].reader->HasColumn("eventID") ||
+	  !in[i].reader->HasColumn("threadID")) {
+	result.error = inputs[i] + ": no eventID/threadID columns";
+	return result;
+      }
+      in[i].index = i;
+    }
+    
+    std::unique_ptr<Tangle2OutputBackend> out(CreateOutput(options.format));
+    if (!out) {
+      result.error = "output format " + options.format + " not available";
+      return result;
+    }
+    if (!out->Open(output)) {
+      result.error = "can not open " + output;
+      return result;
+    }
+    
+    std::priority_queue<Input*, std::vector<Input*>, Later> queue;
+    for (std::size_t i = 0; i < in.size(); i++) {
+      if (in[i].reader->Next(in[i].record)) queue.push(&in[i]);
+      else if (!in[i].reader->GetError().empty()) {
+	result.error = in[i].reader->GetError();
+	return result;
+      }
+    }
+    
+    while (!queue.empty()) {
+      Input* input = queue.top();
+      queue.pop();
+      out->Write(input->record);
+      ++result.nRows;
+      
+      const Key previous = KeyOf(input->record);
+      if (input->reader->Next(input->record)) {
+	if (KeyOf(input->record) < previous) ++result.nOutOfOrder;
+	queue.push(input);
+      }
+      else if (!input->reader->GetError().empty()) {
+	result.error = input->reader->GetError();
+	return result;
+      }
+    }
+    
+    out->Close();
+    result.outputFile = out->GetFileName();
+    
+    if (options.verbose)
+      std::printf(" merged %zu files, %ld rows, to %s\n",
+		  inputs.size(), result.nRows, result.outputFile.c_str());
+    return result;
+  }
+
+  Tangle2MergeResult Merge(const std::vector<std::string>& inputs,
+			   const std::string& output,
+			   const Tangle2MergeOptions& options,
+			   int level)
+  {
+    const std::size_t fanIn = options.fanIn < 2 ? 2 : options.fanIn;
+    if (inputs.size() <= fanIn)
+      return MergeDirect(inputs, output, options);
+    
+    // groups of up to fanIn consecutive inputs, to temporary files
+    const std::size_t nGroups = (inputs.size() + fanIn - 1)/fanIn;
+    std::vector<std::vector<std::string> > groups(nGroups);
+    std::vector<std::string> partNames(nGroups);
+    for (std::size_t i = 0; i < inputs.size(); i++)
+      groups[i*nGroups/inputs.size()].push_back(inputs[i]);
+    for (std::size_t g = 0; g < nGroups; g++) {
+      std::ostringstream os;
+      os << output << "_merge" << level << "_" << g;
+      partNames[g] = os.str();
+    }
+    
+    std::vector<Tangle2MergeResult> parts(nGroups);
+    std::atomic<std::size_t> next(0);
+    auto worker = [&]() {
+      for (std::size_t g = next++; g < nGroups; g = next++)
+	parts[g] = MergeDirect(groups[g], partNames[g], options);
+    };
+    
+    const unsigned nThreads = options.nThreads < 1 ? 1 : options.nThreads;
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < nThreads && t < nGroups; t++)
+      threads.push_back(std::thread(worker));
+    worker();
+    for (std::size_t t = 0; t < threads.size(); t++)
+      threads[t].join();
+    
+    Tangle2MergeResult result;
+    result.nRows = 0;
+    result.nOutOfOrder = 0;
+    std::vector<std::string> partFiles;
+    for (std::size_t g = 0; g < nGroups; g++) {
+      if (!parts[g].outputFile.empty())
+	partFiles.push_back(parts[g].outputFile);
+      if (result.error.empty()) result.error = parts[g].error;
+      result.nOutOfOrder += parts[g].nOutOfOrder;
+    }
+    
+    if (result.error.empty()) {
+      const Tangle2MergeResult final
+	= Merge(partFiles, output, options, level + 1);
+      result.nRows = final.nRows;
+      result.nOutOfOrder += final.nOutOfOrder;
+      result.outputFile = final.outputFile;
+      result.error = final.error;
+    }
+    
+    for (std::size_t i = 0; i < partFiles.size(); i++)
+      std::remove(partFiles[i].c_str());
+    return result;
+  }
+
+}
+
+Tangle2MergeResult Tangle2MergeFiles(const std::vector<std::string>& inputs,
+				     const std::string& output,
+				     const Tangle2MergeOptions& options)
+{
+  return Merge(inputs, output, options, 0);
+}
@@ -0,0 +1,120 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2NtupleComparison.hh"
+#include "Tangle2CsvNtuple.hh"
+#include "Tangle2Statistics.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+  struct Binning
+  {
+    const char* column;
+    int         nBins;
+    double      min, max;
+  };
+
+  // angles in degrees, energies in MeV
+  const Binning kColumns[] = {
+    {"dPhi_1st",   36,    0., 360.},
+    {"ThetaA_1st", 36,    0., 180.},
+    {"ThetaB_1st", 36,    0., 180.},
+    {"PhiA_1st",   36, -180., 180.},
+    {"PhiB_1st",   36, -180., 180.},
+    {"thetaPolA",  36,    0., 180.},
+    {"thetaPolB",  36,    0., 180.},
+    {"edep4",      55,    0., 0.55},
+    {"edep13",     55,    0., 0.55},
+    {"nb_Compt4",   5,    0.,   5.},
+    {"nb_Compt13",  5,    0.,   5.}
+  };
+
+  void Fill(const Tangle2CsvNtuple& ntuple, int column,
+	    const Binning& binning, std::vector<double>& histogram,
+	    double& mean)
+  {
+    histogram.assign(binning.nBins, 0.);
+    double sum = 0.;
+    for (std::size_t i = 0; i < ntuple.rows.size(); i++) {
+      const double value = ntuple.rows[i][column];
+      sum += value;
+      const int bin = int(std::floor((value - binning.min)/
+				     (binning.max - binning.min)*
+				     binning.nBins));
+      if (bin >= 0 && bin < binning.nBins)
+	histogram[bin] += 1.;
+    }
+    mean = ntuple.rows.empty() ? 0. : sum/ntuple.rows.size();
+  }
+
+}
+
+int Tangle2CompareNtuples(const std::string& referenceFile,
+			  const std::string& testFile,
+			  double pMin)
+{
+  Tangle2CsvNtuple reference, test;
+  std::string error;
+  if (!reference.Read(referenceFile, error) ||
+      !test.Read(testFile, error)) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 2;
+  }
+  
+  std::printf("Reference: %s, %zu rows\n",
+	      referenceFile.c_str(), reference.rows.size());
+  std::printf("Test:      %s, %zu rows\n",
+	      testFile.c_str(), test.rows.size());
+  std::printf("\n%-12s %12s %12s %10s %5s %10s\n",
+	      "column", "mean ref", "mean test", "chi2", "ndf", "p");
+  
+  int status = 0;
+  const int nColumns = sizeof(kColumns)/sizeof(kColumns[0]);
+  
+  for (int c = 0; c < nColumns; c++) {
+    const Binning& binning = kColumns[c];
+    const int iRef  = reference.Column(binning.column);
+    const int iTest = test.Column(binning.column);
+    if (iRef < 0 || iTest < 0) {
+      std::printf("%-12s missing\n", binning.column);
+      continue;
+    }
+    
+    std::vector<double> a, b;
+    double meanA, meanB;
+    Fill(reference, iRef,  binning, a, meanA);
+    Fill(test,      iTest, binning, b, meanB);
+    
+    // two sample chi2 for unweighted histograms
+    int ndf;
+    const double chi2 = Tangle2Statistics::ChiSquare(a, b, ndf);
+    const double p = Tangle2Statistics::ChiSquareProbability(chi2, ndf);
+    const bool   ok = p >= pMin;
+    if (!ok) status = 1;
+    
+    std::printf("%-12s %12.5g %12.5g %10.2f %5d %10.3g%s\n",
+		binning.column, meanA, meanB, chi2, ndf, p,
+		ok ? "" : "  <-- differs");
+  }
+  
+  std::printf("\n%s (p-value threshold %g)\n",
+	      status ? "Distributions differ" : "Distributions compatible",
+	      pMin);
+  return status;
+}
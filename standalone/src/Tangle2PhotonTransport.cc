@@ -0,0 +1,306 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2PhotonTransport.hh"
+#include "Tangle2StandaloneEvent.hh"
+#include "Tangle2Geometry.hh"
+#include "Tangle2ComptonSampler.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+  const double kPi             = 3.14159265358979323846;
+  const double kTwoPi          = 2.*kPi;
+  const double kElectronMass   = 0.51099895;        // MeV
+  const double kElectronRadius = 2.8179403262e-12;  // mm
+
+  // LYSO as Tangle2DetectorConstruction: 7.4 g/cm3, by mass Lu 71%,
+  // O 18%, Si 7%, Y 4%, i.e. 0.4304 mol electrons/g
+  const double kElectronDensity = 1.918e21;         // per mm3
+
+  // Photoabsorption above the Lu K edge, muPhot = mu511*(0.511/E)^n,
+  // reduced by the edge jump below it
+  const double kPhotMu511     = 0.025;              // 1/mm
+  const double kPhotIndex     = 2.6;
+  const double kLuKEdge       = 0.0633;             // MeV
+  const double kLuKEdgeJump   = 5.;
+
+  const int    kNTableBins = 400;
+  const double kTableEMin  = 1.e-3;
+  const double kTableEMax  = 1.;
+
+  // Total Klein-Nishina cross section per electron, mm2
+  double KleinNishina(double energy)
+  {
+    const double k  = energy/kElectronMass;
+    const double l  = std::log(1. + 2.*k);
+    const double a  = 1. + 2.*k;
+    return 2.*kPi*kElectronRadius*kElectronRadius*
+      ((1. + k)/(k*k)*(2.*(1. + k)/a - l/k) + l/(2.*k) - (1. + 3.*k)/(a*a));
+  }
+
+}
+
+Tangle2Vector Tangle2Vector::Orthogonal() const
+{
+  const double ax = std::fabs(x), ay = std::fabs(y), az = std::fabs(z);
+  if (ax < ay)
+    return ax < az ? Tangle2Vector(0., z, -y) : Tangle2Vector(y, -x, 0.);
+  else
+    return ay < az ? Tangle2Vector(-z, 0., x) : Tangle2Vector(y, -x, 0.);
+}
+
+//------------------------------------------------------------------
+// Cross sections
+
+Tangle2PhotonCrossSections::Tangle2PhotonCrossSections()
+{
+  SetDefault();
+}
+
+void Tangle2PhotonCrossSections::SetDefault()
+{
+  fLogE.resize(kNTableBins + 1);
+  fMuCompt.resize(kNTableBins + 1);
+  fMuPhot.resize(kNTableBins + 1);
+
+  const double logEMin = std::log(kTableEMin);
+  const double dLogE   = (std::log(kTableEMax) - logEMin)/kNTableBins;
+
+  for (int i = 0; i <= kNTableBins; i++) {
+    const double energy = std::exp(logEMin + i*dLogE);
+    fLogE[i]    = logEMin + i*dLogE;
+    fMuCompt[i] = kElectronDensity*KleinNishina(energy);
+    fMuPhot[i]  = kPhotMu511*std::pow(0.511/energy, kPhotIndex);
+    if (energy < kLuKEdge)
+      fMuPhot[i] /= kLuKEdgeJump;
+  }
+}
+
+bool Tangle2PhotonCrossSections::Load(const std::string& fileName)
+{
+  std::ifstream in(fileName.c_str());
+  if (!in) return false;
+
+  std::vector<double> logE, muCompt, muPhot;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream is(line);
+    double e, c, p;
+    if (!(is >> e >> c >> p) || e <= 0.) return false;
+    if (!logE.empty() && std::log(e) <= logE.back()) return false;
+    logE.push_back(std::log(e));
+    muCompt.push_back(c);
+    muPhot.push_back(p);
+  }
+  if (logE.size() < 2) return false;
+
+  fLogE.swap(logE);
+  fMuCompt.swap(muCompt);
+  fMuPhot.swap(muPhot);
+  return true;
+}
+
+void Tangle2PhotonCrossSections::GetMu(double energy,
+				       double& muCompt,
+				       double& muPhot) const
+{
+  // linear interpolation in log(E), constant beyond the ends;
+  // the grid need not be uniform, so bisect
+  const double logE = std::log(energy);
+  std::size_t n = fLogE.size();
+  if (logE <= fLogE[0]) {
+    muCompt = fMuCompt[0];
+    muPhot  = fMuPhot[0];
+    return;
+  }
+  if (logE >= fLogE[n-1]) {
+    muCompt = fMuCompt[n-1];
+    muPhot  = fMuPhot[n-1];
+    return;
+  }
+  std::size_t lo = 0, hi = n - 1;
+  while (hi - lo > 1) {
+    std::size_t mid = (lo + hi)/2;
+    if (fLogE[mid] <= logE) lo = mid; else hi = mid;
+  }
+  const double f = (logE - fLogE[lo])/(fLogE[hi] - fLogE[lo]);
+  muCompt = (1. - f)*fMuCompt[lo] + f*fMuCompt[hi];
+  muPhot  = (1. - f)*fMuPhot[lo]  + f*fMuPhot[hi];
+}
+
+//------------------------------------------------------------------
+// Transport
+
+Tangle2PhotonTransport::Tangle2PhotonTransport
+(const Tangle2PhotonCrossSections& crossSections,
+ bool fullPET,
+ std::mt19937_64& engine)
+: fCrossSections(crossSections),
+  fEngine(engine),
+  fFlat(0., 1.),
+  fEnergyCut(1.e-3)
+{
+  const double halfSize[3] = {0.5*Tangle2Geometry::cryst_dX,
+			      0.5*Tangle2Geometry::cryst_dY,
+			      0.5*Tangle2Geometry::cryst_dZ};
+  
+  fCrystals.resize(Tangle2Geometry::nCrystals);
+  for (int i = 0; i < Tangle2Geometry::nCrystals; i++) {
+    double centre[3];
+    Tangle2Geometry::CrystalCentre(i, fullPET, centre);
+    for (int j = 0; j < 3; j++) {
+      fCrystals[i].lo[j] = centre[j] - halfSize[j];
+      fCrystals[i].hi[j] = centre[j] + halfSize[j];
+    }
+  }
+}
+
+Tangle2Vector Tangle2PhotonTransport::RandomDirection()
+{
+  // as G4RandomDirection
+  const double cosTheta = 2.*Uniform() - 1.;
+  double sinTheta2 = 1. - cosTheta*cosTheta;
+  if (sinTheta2 < 0.) sinTheta2 = 0.;
+  const double sinTheta = std::sqrt(sinTheta2);
+  const double phi      = kTwoPi*Uniform();
+  return Tangle2Vector(sinTheta*std::cos(phi),
+		       sinTheta*std::sin(phi),
+		       cosTheta);
+}
+
+bool Tangle2PhotonTransport::Intersect(const Box& box,
+				       const Tangle2Vector& pos,
+				       const Tangle2Vector& dir,
+				       double& tIn, double& tOut) const
+{
+  // slab method
+  const double p[3] = {pos.x, pos.y, pos.z};
+  const double d[3] = {dir.x, dir.y, dir.z};
+  
+  tIn  = -DBL_MAX;
+  tOut =  DBL_MAX;
+  for (int j = 0; j < 3; j++) {
+    if (d[j] == 0.) {
+      if (p[j] < box.lo[j] || p[j] > box.hi[j]) return false;
+      continue;
+    }
+    double t1 = (box.lo[j] - p[j])/d[j];
+    double t2 = (box.hi[j] - p[j])/d[j];
+    if (t1 > t2) std::swap(t1, t2);
+    if (t1 > tIn)  tIn  = t1;
+    if (t2 < tOut) tOut = t2;
+  }
+  if (tIn < 0.) tIn = 0.;
+  
+  // a photon on the surface going out is not in the box
+  return tOut > tIn + 1.e-9;
+}
+
+int Tangle2PhotonTransport::NextCrystal(const Tangle2Vector& pos,
+					const Tangle2Vector& dir,
+					double& tIn, double& tOut) const
+{
+  int next = -1;
+  tIn  = DBL_MAX;
+  tOut = DBL_MAX;
+  for (std::size_t i = 0; i < fCrystals.size(); i++) {
+    double t1, t2;
+    if (Intersect(fCrystals[i], pos, dir, t1, t2) && t1 < tIn) {
+      next = i;
+      tIn  = t1;
+      tOut = t2;
+    }
+  }
+  return next;
+}
+
+void Tangle2PhotonTransport::Transport(Tangle2Photon& photon,
+				       Tangle2StandaloneEvent& event)
+{
+  double tIn, tOut;
+  int copyNo;
+  
+  // from crystal to crystal until the photon leaves them all
+  while ((copyNo = NextCrystal(photon.position, photon.direction,
+			       tIn, tOut)) >= 0) {
+    
+    photon.position = photon.position + photon.direction*tIn;
+    double distanceOut = tOut - tIn;
+    
+    while (true) {
+      
+      double muCompt, muPhot;
+      fCrossSections.GetMu(photon.energy, muCompt, muPhot);
+      const double muTotal = muCompt + muPhot;
+      
+      double distance = DBL_MAX;
+      if (muTotal > 0.)
+	distance = -std::log(1. - Uniform())/muTotal;
+      
+      // escape through the crystal surface
+      if (distance >= distanceOut) {
+	photon.position = photon.position + photon.direction*distanceOut;
+	break;
+      }
+      
+      photon.position = photon.position + photon.direction*distance;
+      
+      // photoabsorption
+      if (Uniform()*muTotal < muPhot) {
+	event.RecordPhoto(photon.trackID, copyNo, photon.position);
+	event.AddEdep(copyNo, photon.energy);
+	photon.energy = 0.;
+	return;
+      }
+      
+      // Compton scattering
+      const Tangle2Vector preDirection    = photon.direction;
+      const Tangle2Vector prePolarisation = photon.polarisation;
+      const double        preEnergy       = photon.energy;
+      
+      double direction[3], polarisation[3];
+      photon.direction.ToArray(direction);
+      photon.polarisation.ToArray(polarisation);
+      Tangle2ComptonSampler::Sample(photon.energy, direction, polarisation,
+				    [this]() { return Uniform(); });
+      photon.direction
+	= Tangle2Vector(direction[0], direction[1], direction[2]);
+      photon.polarisation
+	= Tangle2Vector(polarisation[0], polarisation[1], polarisation[2]);
+      event.AddEdep(copyNo, preEnergy - photon.energy);
+      
+      event.RecordCompton(photon.trackID, copyNo, photon.position,
+			  preDirection, photon.direction,
+			  prePolarisation, photon.polarisation);
+      
+      if (photon.energy < fEnergyCut) {
+	event.AddEdep(copyNo, photon.energy);
+	photon.energy = 0.;
+	return;
+      }
+      
+      double t1;
+      Intersect(fCrystals[copyNo], photon.position, photon.direction,
+		t1, distanceOut);
+      if (distanceOut < 0.) distanceOut = 0.;
+    }
+  }
+}
@@ -0,0 +1,137 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2Process.hh"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+Tangle2ProcessResult Tangle2Process::Run(const std::vector<std::string>& args,
+					 const std::string& directory,
+					 const std::string& logName)
+{
+  Tangle2ProcessResult result;
+  result.ok = false;
+  result.status = -1;
+  result.wallSeconds = 0.;
+  result.peakRSSBytes = 0;
+  if (args.empty()) return result;
+  
+  std::vector<char*> argv;
+  for (std::size_t i = 0; i < args.size(); i++)
+    argv.push_back(const_cast<char*>(args[i].c_str()));
+  argv.push_back(0);
+  
+  const std::chrono::steady_clock::time_point start
+    = std::chrono::steady_clock::now();
+  
+  const pid_t pid = fork();
+  if (pid < 0) {
+    std::perror("fork");
+    return result;
+  }
+  if (pid == 0) {
+    // the child: output and log in its own directory
+    if (chdir(directory.c_str()) != 0) _exit(126);
+    const int log = open(logName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (log < 0) _exit(126);
+    dup2(log, STDOUT_FILENO);
+    dup2(log, STDERR_FILENO);
+    close(log);
+    execvp(argv[0], &argv[0]);
+    _exit(127);
+  }
+  
+  int status = 0;
+  struct rusage usage;
+  if (wait4(pid, &status, 0, &usage) < 0) {
+    std::perror("wait4");
+    return result;
+  }
+  result.wallSeconds = std::chrono::duration<double>
+    (std::chrono::steady_clock::now() - start).count();
+#ifdef __APPLE__
+  result.peakRSSBytes = usage.ru_maxrss;       // bytes
+#else
+  result.peakRSSBytes = usage.ru_maxrss*1024L; // kilobytes
+#endif
+  result.status = status;
+  result.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  return result;
+}
+
+// The master's end of run report, see Tangle2RunAction
+Tangle2RunLog Tangle2Process::ReadLog(const std::string& fileName)
+{
+  Tangle2RunLog runLog;
+  runLog.nEvents = runLog.nSelected = -1;
+  runLog.loopSeconds = -1.;
+  
+  std::ifstream log(fileName.c_str());
+  std::string line;
+  while (std::getline(log, line)) {
+    long nEvents, nQET, nSelected;
+    double seconds;
+    if (std::sscanf(line.c_str(), "%ld events, %ld QET events, %ld selected",
+		    &nEvents, &nQET, &nSelected) == 3) {
+      runLog.nEvents = nEvents;
+      runLog.nSelected = nSelected;
+    }
+    else if (std::sscanf(line.c_str(), "Event loop %lf s", &seconds) == 1)
+      runLog.loopSeconds = seconds;
+  }
+  return runLog;
+}
+
+std::string Tangle2Process::AbsolutePath(const std::string& path)
+{
+  if (path.empty() || path[0] == '/') return path;
+  char cwd[4096];
+  if (!getcwd(cwd, sizeof(cwd))) return path;
+  return std::string(cwd) + "/" + path;
+}
+
+bool Tangle2Process::MakeDirectory(const std::string& path)
+{
+  return mkdir(path.c_str(), 0777) == 0 || errno == EEXIST;
+}
+
+long Tangle2Process::DirectoryBytes(const std::string& directory,
+				    const std::string& except)
+{
+  long bytes = 0;
+  DIR* dir = opendir(directory.c_str());
+  if (!dir) return 0;
+  while (dirent* entry = readdir(dir)) {
+    const std::string name = entry->d_name;
+    if (name == except) continue;
+    struct stat status;
+    if (stat((directory + "/" + name).c_str(), &status) == 0 &&
+	S_ISREG(status.st_mode))
+      bytes += status.st_size;
+  }
+  closedir(dir);
+  return bytes;
+}
@@ -0,0 +1,510 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2RecordReader.hh"
+#include "Tangle2Hdf5Output.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#ifdef TANGLE2_WITH_HDF5
+#include <hdf5.h>
+#endif
+
+#ifdef TANGLE2_WITH_ROOT
+#include <TFile.h>
+#include <TKey.h>
+#include <TLeaf.h>
+#include <TROOT.h>
+#include <TTree.h>
+#ifdef TANGLE2_WITH_RNTUPLE
+#include <ROOT/RNTupleReader.hxx>
+#endif
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#endif
+
+namespace {
+
+  typedef std::vector<Tangle2EventRecord::Column> Columns;
+
+  bool EndsWith(const std::string& s, const std::string& end)
+  {
+    return s.size() >= end.size() &&
+      s.compare(s.size() - end.size(), end.size(), end) == 0;
+  }
+
+  // Index in Tangle2EventRecord::Columns(), or -1
+  int RecordColumn(const std::string& name)
+  {
+    const Columns& columns = Tangle2EventRecord::Columns();
+    for (std::size_t i = 0; i < columns.size(); i++)
+      if (columns[i].name == name) return i;
+    return -1;
+  }
+
+  class CsvReader : public Tangle2RecordReader
+  {
+  public:
+    explicit CsvReader(const std::string& fileName)
+    : Tangle2RecordReader(fileName), fIn(fileName.c_str()), fNLines(0) {}
+
+    bool ReadHeader()
+    {
+      if (!fIn) {
+	fError = "can not open " + fFileName;
+	return false;
+      }
+      // "#column <type> <name>" lines, or a line of names
+      std::string line;
+      while (fIn.peek() == '#' && std::getline(fIn, line)) {
+	++fNLines;
+	std::istringstream is(line);
+	std::string key, type, name;
+	is >> key >> type >> name;
+	if (key == "#column" && !name.empty())
+	  fFileColumns.push_back(RecordColumn(name));
+      }
+      if (fFileColumns.empty() && fIn.peek() != EOF &&
+	  !std::isdigit(fIn.peek()) && fIn.peek() != '-') {
+	std::getline(fIn, line);
+	++fNLines;
+	std::istringstream is(line);
+	std::string name;
+	while (std::getline(is, name, ','))
+	  fFileColumns.push_back(RecordColumn(name));
+      }
+      if (fFileColumns.empty()) {
+	fError = fFileName + ": no column names";
+	return false;
+      }
+      return true;
+    }
+
+    virtual bool Next(Tangle2EventRecord& record)
+    {
+      const Columns& columns = Tangle2EventRecord::Columns();
+      
+      std::string line;
+      do {
+	if (!std::getline(fIn, line)) return false;
+	++fNLines;
+	if (!line.empty() && line[line.size()-1] == '\r')
+	  line.erase(line.size()-1);
+      } while (line.empty());
+      
+      record = Tangle2EventRecord();
+      const char* p = line.c_str();
+      std::size_t n = 0;
+      for (;; ++n) {
+	char* end;
+	const double value = std::strtod(p, &end);
+	if (n < fFileColumns.size() && fFileColumns[n] >= 0)
+	  record.Set(columns[fFileColumns[n]], value);
+	p = end;
+	if (*p != ',') break;
+	++p;
+      }
+      if (n + 1 != fFileColumns.size()) {
+	std::ostringstream os;
+	os << fFileName << ": line " << fNLines << " has " << n + 1
+	   << " fields for " << fFileColumns.size() << " columns";
+	fError = os.str();
+	return false;
+      }
+      return true;
+    }
+
+    virtual bool HasColumn(const std::string& name) const
+    {
+      const int column = RecordColumn(name);
+      for (std::size_t i = 0; i < fFileColumns.size(); i++)
+	if (fFileColumns[i] == column && column >= 0) return true;
+      return false;
+    }
+
+  private:
+    std::ifstream fIn;
+    long fNLines;
+    std::vector<int> fFileColumns;  // record column of each, or -1
+  };
+
+#ifdef TANGLE2_WITH_HDF5
+
+  hid_t MemoryType(Tangle2EventRecord::Type type)
+  {
+    switch (type) {
+    case Tangle2EventRecord::kInt16: return H5T_NATIVE_INT16;
+    case Tangle2EventRecord::kInt64: return H5T_NATIVE_INT64;
+    default:                         return H5T_NATIVE_FLOAT;
+    }
+  }
+
+  class Hdf5Reader : public Tangle2RecordReader
+  {
+  public:
+    explicit Hdf5Reader(const std::string& fileName)
+    : Tangle2RecordReader(fileName),
+      fFile(-1), fNRows(0), fNextRow(0), fBlockStart(0), fBlockRows(0) {}
+
+    ~Hdf5Reader()
+    {
+      std::lock_guard<std::mutex> lock(Tangle2Hdf5Output::Mutex());
+      for (std::size_t i = 0; i < fDatasets.size(); i++)
+	if (fDatasets[i] >= 0) H5Dclose(fDatasets[i]);
+      if (fFile >= 0) H5Fclose(fFile);
+    }
+
+    bool OpenFile()
+    {
+      const Columns& columns = Tangle2EventRecord::Columns();
+      std::lock_guard<std::mutex> lock(Tangle2Hdf5Output::Mutex());
+      
+      fFile = H5Fopen(fFileName.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+      if (fFile < 0) {
+	fError = "can not open " + fFileName;
+	return false;
+      }
+      
+      bool first = true;
+      for (std::size_t i = 0; i < columns.size(); i++) {
+	const std::string path = "/Tangle2/" + columns[i].name;
+	hid_t dataset = -1;
+	if (H5Lexists(fFile, "/Tangle2", H5P_DEFAULT) > 0 &&
+	    H5Lexists(fFile, path.c_str(), H5P_DEFAULT) > 0)
+	  dataset = H5Dopen2(fFile, path.c_str(), H5P_DEFAULT);
+	fDatasets.push_back(dataset);
+	fBuffers.push_back(std::vector<char>());
+	if (dataset < 0) continue;
+	
+	hid_t space = H5Dget_space(dataset);
+	hsize_t dims[1] = {0};
+	H5Sget_simple_extent_dims(space, dims, 0);
+	H5Sclose(space);
+	if (first) fNRows = dims[0];
+	if (!first && dims[0] != fNRows) {
+	  fError = fFileName + ": columns of different lengths";
+	  return false;
+	}
+	first = false;
+	fBuffers.back().resize
+	  (Tangle2Hdf5Output::kChunkRows*Tangle2EventRecord::Size(columns[i].type));
+      }
+      if (first) {
+	fError = fFileName + ": no Tangle2 columns";
+	return false;
+      }
+      return true;
+    }
+
+    virtual bool Next(Tangle2EventRecord& record)
+    {
+      if (fNextRow == fNRows) return false;
+      if (fNextRow == fBlockStart + fBlockRows && !ReadBlock()) return false;
+      
+      const Columns& columns = Tangle2EventRecord::Columns();
+      const std::size_t row = fNextRow - fBlockStart;
+      char* base = reinterpret_cast<char*>(&record);
+      
+      record = Tangle2EventRecord();
+      for (std::size_t i = 0; i < columns.size(); i++) {
+	if (fDatasets[i] < 0) continue;
+	const std::size_t size = Tangle2EventRecord::Size(columns[i].type);
+	std::memcpy(base + columns[i].offset, &fBuffers[i][row*size], size);
+      }
+      ++fNextRow;
+      return true;
+    }
+
+    virtual bool HasColumn(const std::string& name) const
+    {
+      const int column = RecordColumn(name);
+      return column >= 0 && fDatasets[column] >= 0;
+    }
+
+  private:
+    // The next chunk of rows (as written, so each is decompressed once)
+    bool ReadBlock()
+    {
+      const Columns& columns = Tangle2EventRecord::Columns();
+      
+      fBlockStart = fNextRow;
+      fBlockRows  = std::min<unsigned long long>
+	(Tangle2Hdf5Output::kChunkRows, fNRows - fNextRow);
+      
+      std::lock_guard<std::mutex> lock(Tangle2Hdf5Output::Mutex());
+      
+      hsize_t start[1] = {fBlockStart};
+      hsize_t count[1] = {fBlockRows};
+      hid_t memSpace = H5Screate_simple(1, count, 0);
+      herr_t status = 0;
+      for (std::size_t i = 0; i < columns.size() && status >= 0; i++) {
+	if (fDatasets[i] < 0) continue;
+	hid_t fileSpace = H5Dget_space(fDatasets[i]);
+	H5Sselect_hyperslab(fileSpace, H5S_SELECT_SET, start, 0, count, 0);
+	status = H5Dread(fDatasets[i], MemoryType(columns[i].type),
+			 memSpace, fileSpace, H5P_DEFAULT, &fBuffers[i][0]);
+	H5Sclose(fileSpace);
+      }
+      H5Sclose(memSpace);
+      
+      if (status < 0) {
+	fError = fFileName + ": read error";
+	return false;
+      }
+      return true;
+    }
+
+    hid_t fFile;
+    std::vector<hid_t> fDatasets;  // per record column, -1 if absent
+    std::vector<std::vector<char> > fBuffers;
+    unsigned long long fNRows, fNextRow, fBlockStart, fBlockRows;
+  };
+
+#endif
+
+#ifdef TANGLE2_WITH_ROOT
+
+  std::once_flag threadSafetyFlag;
+
+  // g4root: the Tangle2 TTree, a branch per column (double or int),
+  // read through the leaves of the branches of record columns only
+  class TreeReader : public Tangle2RecordReader
+  {
+  public:
+    TreeReader(const std::string& fileName, TFile* file, TTree* tree)
+    : Tangle2RecordReader(fileName), fFile(file), fTree(tree),
+      fNEntries(tree->GetEntries()), fNextEntry(0)
+    {
+      const Columns& columns = Tangle2EventRecord::Columns();
+      fTree->SetBranchStatus("*", 0);
+      for (std::size_t i = 0; i < columns.size(); i++) {
+	TLeaf* leaf = fTree->GetLeaf(columns[i].name.c_str());
+	if (leaf) fTree->SetBranchStatus(columns[i].name.c_str(), 1);
+	fLeaves.push_back(leaf);
+      }
+    }
+
+    ~TreeReader()
+    {
+      delete fFile;  // and the tree with it
+    }
+
+    bool HasColumns() const
+    {
+      for (std::size_t i = 0; i < fLeaves.size(); i++)
+	if (fLeaves[i]) return true;
+      return false;
+    }
+
+    virtual bool Next(Tangle2EventRecord& record)
+    {
+      if (fNextEntry == fNEntries) return false;
+      if (fTree->GetEntry(fNextEntry++) <= 0) {
+	fError = fFileName + ": read error";
+	return false;
+      }
+      
+      const Columns& columns = Tangle2EventRecord::Columns();
+      record = Tangle2EventRecord();
+      for (std::size_t i = 0; i < columns.size(); i++)
+	if (fLeaves[i]) record.Set(columns[i], fLeaves[i]->GetValue());
+      return true;
+    }
+
+    virtual bool HasColumn(const std::string& name) const
+    {
+      const int column = RecordColumn(name);
+      return column >= 0 && fLeaves[column] != 0;
+    }
+
+  private:
+    TFile* fFile;
+    TTree* fTree;
+    std::vector<TLeaf*> fLeaves;  // per record column, null if absent
+    Long64_t fNEntries, fNextEntry;
+  };
+
+#ifdef TANGLE2_WITH_RNTUPLE
+
+  typedef std::function<double(std::uint64_t)> FieldValue;
+
+  // Value of field name of an entry, or empty if there is no such field
+  template <class T>
+  FieldValue View(ROOT::RNTupleReader& reader, const std::string& name)
+  {
+    typedef decltype(reader.GetView<T>(name)) ViewType;
+    try {
+      std::shared_ptr<ViewType> view
+	= std::make_shared<ViewType>(reader.GetView<T>(name));
+      return [view](std::uint64_t entry) { return double((*view)(entry)); };
+    } catch (const std::exception&) {
+      return FieldValue();
+    }
+  }
+
+  // RNTuple: the Tangle2 ntuple of Tangle2RNTupleOutput, a field per
+  // column, read through views (which read a cluster at a time)
+  class NTupleReader : public Tangle2RecordReader
+  {
+  public:
+    NTupleReader(const std::string& fileName,
+		 std::unique_ptr<ROOT::RNTupleReader> reader)
+    : Tangle2RecordReader(fileName), fReader(std::move(reader)),
+      fNEntries(fReader->GetNEntries()), fNextEntry(0)
+    {
+      const Columns& columns = Tangle2EventRecord::Columns();
+      for (std::size_t i = 0; i < columns.size(); i++) {
+	switch (columns[i].type) {
+	case Tangle2EventRecord::kInt16:
+	  fFields.push_back(View<int16_t>(*fReader, columns[i].name)); break;
+	case Tangle2EventRecord::kInt64:
+	  fFields.push_back(View<int64_t>(*fReader, columns[i].name)); break;
+	default:
+	  fFields.push_back(View<float>(*fReader, columns[i].name));   break;
+	}
+      }
+    }
+
+    virtual bool Next(Tangle2EventRecord& record)
+    {
+      if (fNextEntry == fNEntries) return false;
+      
+      const Columns& columns = Tangle2EventRecord::Columns();
+      record = Tangle2EventRecord();
+      try {
+	for (std::size_t i = 0; i < columns.size(); i++)
+	  if (fFields[i]) record.Set(columns[i], fFields[i](fNextEntry));
+      } catch (const std::exception& e) {
+	fError = fFileName + ": " + e.what();
+	return false;
+      }
+      ++fNextEntry;
+      return true;
+    }
+
+    virtual bool HasColumn(const std::string& name) const
+    {
+      const int column = RecordColumn(name);
+      return column >= 0 && bool(fFields[column]);
+    }
+
+  private:
+    std::unique_ptr<ROOT::RNTupleReader> fReader;  // outlives the views
+    std::vector<FieldValue> fFields;  // per record column, empty if absent
+    std::uint64_t fNEntries, fNextEntry;
+  };
+
+#endif
+
+  // g4root or RNTuple, by the class of the Tangle2 key
+  Tangle2RecordReader* OpenRoot(const std::string& fileName,
+				std::string& error)
+  {
+    // tangle2_merge reads files in parallel
+    std::call_once(threadSafetyFlag, [] { ROOT::EnableThreadSafety(); });
+    
+    TFile* file = TFile::Open(fileName.c_str(), "READ");
+    if (!file || file->IsZombie()) {
+      delete file;
+      error = "can not open " + fileName;
+      return 0;
+    }
+    TKey* key = file->GetKey("Tangle2");
+    const std::string type = key ? key->GetClassName() : "";
+    
+    if (type == "TTree") {
+      TreeReader* reader
+	= new TreeReader(fileName, file, static_cast<TTree*>(key->ReadObj()));
+      if (reader->HasColumns()) return reader;
+      delete reader;
+      error = fileName + ": no Tangle2 columns";
+      return 0;
+    }
+    delete file;
+    
+    if (type.find("RNTuple") != std::string::npos) {
+#ifdef TANGLE2_WITH_RNTUPLE
+      try {
+	return new NTupleReader
+	  (fileName, ROOT::RNTupleReader::Open("Tangle2", fileName));
+      } catch (const std::exception& e) {
+	error = fileName + ": " + e.what();
+      }
+#else
+      error = fileName + ": RNTuple needs ROOT 6.34 or later"
+	" (WITH_TANGLE2_RNTUPLE)";
+#endif
+      return 0;
+    }
+    
+    error = fileName + ": no Tangle2 ntuple (TTree or RNTuple)";
+    return 0;
+  }
+
+#endif
+
+}
+
+Tangle2RecordReader::Tangle2RecordReader(const std::string& fileName)
+: fFileName(fileName)
+{}
+
+Tangle2RecordReader::~Tangle2RecordReader()
+{}
+
+Tangle2RecordReader* Tangle2RecordReader::Open(const std::string& fileName,
+					       std::string& error)
+{
+  if (EndsWith(fileName, ".csv")) {
+    CsvReader* reader = new CsvReader(fileName);
+    if (reader->ReadHeader()) return reader;
+    error = reader->GetError();
+    delete reader;
+    return 0;
+  }
+  
+  if (EndsWith(fileName, ".h5")) {
+#ifdef TANGLE2_WITH_HDF5
+    Hdf5Reader* reader = new Hdf5Reader(fileName);
+    if (reader->OpenFile()) return reader;
+    error = reader->GetError();
+    delete reader;
+#else
+    error = fileName + ": built without HDF5 (WITH_TANGLE2_HDF5)";
+#endif
+    return 0;
+  }
+  
+  if (EndsWith(fileName, ".root")) {
+#ifdef TANGLE2_WITH_ROOT
+    return OpenRoot(fileName, error);
+#else
+    error = fileName + ": g4root and RNTuple files need ROOT, which was not"
+      " found when tangle2_merge was built; write csv or hdf5 instead";
+    return 0;
+#endif
+  }
+  
+  error = fileName + ": unknown format, expected .csv, .h5 or .root";
+  return 0;
+}
@@ -0,0 +1,291 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2StandaloneEvent.hh"
+
+namespace {
+
+  void SetPosition(float pos[3], const Tangle2Vector& v)
+  {
+    pos[0] = v.x;
+    pos[1] = v.y;
+    pos[2] = v.z;
+  }
+
+}
+
+Tangle2StandaloneEvent::Tangle2StandaloneEvent()
+{
+  fAngleBatch.Reserve(4);
+  Begin(0, 1, 1.);
+}
+
+void Tangle2StandaloneEvent::Begin(long nEvents, int sndGammaTrackID,
+				   double weight)
+{
+  // as Tangle2EventAction::BeginOfEventAction
+  fNEvents = nEvents;
+  fWeight  = weight;
+  
+  for (int i = 0; i < 18; i++) {
+    fEDepCryst[i] = 0.;
+    fNbCompt[i]   = 0;
+    fNbPhoto[i]   = 0;
+  }
+  
+  const Tangle2Vector unset(-99., -99., -99.);
+  fPosA1  = fPosA2  = fPosB1  = fPosB2  = unset;
+  fPosAP1 = fPosAP2 = fPosBP1 = fPosBP2 = unset;
+  
+  fThetaA = fThetaB = fPhiA = fPhiB = 0.;
+  fDphi = -99.;
+  fThetaA2 = fThetaB2 = fPhiA2 = fPhiB2 = 500.;
+  fDphiA1B2 = fDphiA2B1 = fDphiA2B2 = -99.;
+  fThetaPolA = fThetaPolB = 0.;
+  
+  // as Tangle2SteppingAction::BeginOfEventAction
+  fNComptonA = fNComptonB = 0;
+  fNPhotoA   = fNPhotoB   = 0;
+  fTrackIDA1 = fTrackIDB1 = -1;
+  fSndGammaTrackID  = sndGammaTrackID;
+  fDoubleComptEvent = true;
+  
+  fCentralHits = false;
+}
+
+void Tangle2StandaloneEvent::StartTrack(int trackID)
+{
+  // If there was no Compton scattering for the first photon out
+  // then delta phi can't be calculated
+  if (fDoubleComptEvent        &&
+      trackID == fSndGammaTrackID &&
+      fNComptonA == 0          &&
+      fNComptonB == 0)
+    fDoubleComptEvent = false;
+}
+
+void Tangle2StandaloneEvent::AddEdep(int copyNo, double eDep)
+{
+  fEDepCryst[copyNo] += eDep;
+}
+
+void Tangle2StandaloneEvent::RecordPhoto(int trackID, int copyNo,
+					 const Tangle2Vector& pos)
+{
+  if (!fDoubleComptEvent)
+    return;
+  
+  fNbPhoto[copyNo]++;
+  
+  // Tangle2SteppingAction::RecordPhoto, including the fall
+  // through from the first to the second photoabsorption and
+  // the second in B going to posA_P2
+  if (pos.x > 0) {
+    if (fNPhotoA == 0 && trackID == fTrackIDA1) {
+      fNPhotoA = 1;
+      fPosAP1  = pos;
+    }
+    if (fNPhotoA == 1 && trackID == fTrackIDA1) {
+      fNPhotoA = 2;
+      fPosAP2  = pos;
+    }
+  }
+  else if (pos.x < 0) {
+    if (fNPhotoB == 0 && trackID == fTrackIDB1) {
+      fNPhotoB = 1;
+      fPosBP1  = pos;
+    }
+    if (fNPhotoB == 1 && trackID == fTrackIDB1) {
+      fNPhotoB = 2;
+      fPosAP2  = pos;
+    }
+  }
+}
+
+void Tangle2StandaloneEvent::RecordCompton(int trackID, int copyNo,
+					   const Tangle2Vector& pos,
+					   const Tangle2Vector& preDir,
+					   const Tangle2Vector& postDir,
+					   const Tangle2Vector& prePol,
+					   const Tangle2Vector& postPol)
+{
+  if (!fDoubleComptEvent)
+    return;
+  
+  // array A is in positive x direction
+  if (pos.x > 0) {
+    if (fNComptonA == 0) {
+      fTrackIDA1 = trackID;
+      fNComptonA = 1;
+      fPosA1     = pos;
+      fBeamA     = preDir;
+      fScatA1    = postDir;
+      fPolPreA   = prePol;
+      fPolPostA  = postPol;
+    }
+    else if (fNComptonA == 1 && trackID == fTrackIDA1) {
+      fNComptonA = 2;
+      fPosA2     = pos;
+      fPreA2     = preDir;
+      fScatA2    = postDir;
+    }
+    else if (fNComptonA == 2 && trackID == fTrackIDA1) {
+      fNComptonA = 3;
+    }
+  }
+  // array B is in negative x direction
+  else if (pos.x < 0) {
+    if (fNComptonB == 0) {
+      fTrackIDB1 = trackID;
+      fNComptonB = 1;
+      fPosB1     = pos;
+      fBeamB     = preDir;
+      fScatB1    = postDir;
+      fPolPreB   = prePol;
+      fPolPostB  = postPol;
+    }
+    else if (fNComptonB == 1 && trackID == fTrackIDB1) {
+      fNComptonB = 2;
+      fPosB2     = pos;
+      fPreB2     = preDir;
+      fScatB2    = postDir;
+    }
+    else if (fNComptonB == 2 && trackID == fTrackIDB1) {
+      fNComptonB = 3;
+    }
+  }
+  
+  fNbCompt[copyNo]++;
+}
+
+void Tangle2StandaloneEvent::ComputeAngles()
+{
+  // as Tangle2SteppingAction::ComputeAngles
+  double beam[3], pre[3], scat[3], polPre[3], polPost[3];
+  std::size_t iA1 = 0, iA2 = 0, iB1 = 0, iB2 = 0;
+  
+  fAngleBatch.Clear();
+  
+  if (fNComptonA >= 1) {
+    fBeamA.ToArray(beam); fScatA1.ToArray(scat);
+    fPolPreA.ToArray(polPre); fPolPostA.ToArray(polPost);
+    iA1 = fAngleBatch.Add(beam, beam, scat, polPre, polPost);
+  }
+  if (fNComptonB >= 1) {
+    fBeamB.ToArray(beam); fScatB1.ToArray(scat);
+    fPolPreB.ToArray(polPre); fPolPostB.ToArray(polPost);
+    iB1 = fAngleBatch.Add(beam, beam, scat, polPre, polPost);
+  }
+  if (fNComptonA >= 2) {
+    fBeamA.ToArray(beam); fPreA2.ToArray(pre); fScatA2.ToArray(scat);
+    iA2 = fAngleBatch.Add(beam, pre, scat);
+  }
+  if (fNComptonB >= 2) {
+    fBeamB.ToArray(beam); fPreB2.ToArray(pre); fScatB2.ToArray(scat);
+    iB2 = fAngleBatch.Add(beam, pre, scat);
+  }
+  
+  Tangle2AngleKernel::Compute(fAngleBatch);
+  
+  if (fNComptonA >= 1) {
+    fThetaA    = fAngleBatch.theta[iA1];
+    fPhiA      = fAngleBatch.phi[iA1];
+    fThetaPolA = fAngleBatch.thetaPol[iA1];
+  }
+  if (fNComptonA >= 2) {
+    fThetaA2   = fAngleBatch.theta[iA2];
+    fPhiA2     = fAngleBatch.phi[iA2];
+  }
+  if (fNComptonB >= 1) {
+    fThetaB    = fAngleBatch.theta[iB1];
+    fPhiB      = fAngleBatch.phi[iB1];
+    fThetaPolB = fAngleBatch.thetaPol[iB1];
+  }
+  if (fNComptonB >= 2) {
+    fThetaB2   = fAngleBatch.theta[iB2];
+    fPhiB2     = fAngleBatch.phi[iB2];
+  }
+  
+  if (fNComptonA >= 1 && fNComptonB >= 1)
+    fDphi = Tangle2AngleKernel::DeltaPhi(fPhiA, fPhiB);
+  if (fNComptonA >= 2 && fNComptonB >= 1)
+    fDphiA2B1 = Tangle2AngleKernel::DeltaPhi(fPhiA2, fPhiB);
+  if (fNComptonA >= 1 && fNComptonB >= 2)
+    fDphiA1B2 = Tangle2AngleKernel::DeltaPhi(fPhiA, fPhiB2);
+  if (fNComptonA >= 2 && fNComptonB >= 2)
+    fDphiA2B2 = Tangle2AngleKernel::DeltaPhi(fPhiA2, fPhiB2);
+}
+
+bool Tangle2StandaloneEvent::End()
+{
+  // as Tangle2EventAction::EndOfEventAction
+  
+  // 4 and 13 are the central crystals
+  fCentralHits = (fEDepCryst[4]  > fSelection.GetThreshold(4) &&
+		  fEDepCryst[13] > fSelection.GetThreshold(13));
+  
+  // angles only for events that pass the cuts on deposits and counts
+  Tangle2SelectionEvent selectionEvent = {fEDepCryst, fNbCompt, 0., 0.};
+  if (!fSelection.Select(Tangle2Selection::kBeforeAngles, selectionEvent))
+    return false;
+  ComputeAngles();
+  selectionEvent.thetaA = fThetaA;
+  selectionEvent.thetaB = fThetaB;
+  if (!fSelection.Select(Tangle2Selection::kAfterAngles, selectionEvent))
+    return false;
+  
+  // as Tangle2EventAction, no collimator
+  Tangle2EventRecord& r = fRecord;
+  
+  for (int i = 0; i < 18; i++) {
+    r.edep[i]     = fEDepCryst[i];
+    r.nb_Compt[i] = fNbCompt[i];
+    r.nb_Photo[i] = fNbPhoto[i];
+  }
+  r.edepColl[0] = r.edepColl[1] = 0.;
+  
+  SetPosition(r.posA_1, fPosA1);
+  SetPosition(r.posA_2, fPosA2);
+  SetPosition(r.posB_1, fPosB1);
+  SetPosition(r.posB_2, fPosB2);
+  
+  r.thetaA = fThetaA;
+  r.phiA   = fPhiA;
+  r.thetaB = fThetaB;
+  r.phiB   = fPhiB;
+  r.dphi   = fDphi;
+  r.thetaA2 = fThetaA2;
+  r.phiA2   = fPhiA2;
+  r.thetaB2 = fThetaB2;
+  r.phiB2   = fPhiB2;
+  r.dphiA1B2 = fDphiA1B2;
+  r.dphiA2B1 = fDphiA2B1;
+  r.dphiA2B2 = fDphiA2B2;
+  r.thetaPolA = fThetaPolA;
+  r.thetaPolB = fThetaPolB;
+  r.nEvents = fNEvents;
+  
+  SetPosition(r.posA_P1, fPosAP1);
+  SetPosition(r.posA_P2, fPosAP2);
+  SetPosition(r.posB_P1, fPosBP1);
+  SetPosition(r.posB_P2, fPosBP2);
+  
+  r.weight = fWeight;
+  // one thread, events numbered from 0 as G4Event
+  r.eventID  = fNEvents - 1;
+  r.threadID = -1;
+  
+  return true;
+}
@@ -0,0 +1,120 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+#include "Tangle2Statistics.hh"
+
+#include <algorithm>
+#include <cmath>
+
+// Numerical Recipes gammq
+double Tangle2Statistics::GammaQ(double a, double x)
+{
+  if (x <= 0.) return 1.;
+  const double gln = std::lgamma(a);
+  if (x < a + 1.) {
+    double ap = a, sum = 1./a, del = sum;
+    for (int n = 0; n < 1000; n++) {
+      ap  += 1.;
+      del *= x/ap;
+      sum += del;
+      if (std::fabs(del) < std::fabs(sum)*1.e-15) break;
+    }
+    return 1. - sum*std::exp(-x + a*std::log(x) - gln);
+  }
+  const double fpmin = 1.e-300;
+  double b = x + 1. - a, c = 1./fpmin, d = 1./b, h = d;
+  for (int i = 1; i < 1000; i++) {
+    const double an = -i*(i - a);
+    b += 2.;
+    d = an*d + b;
+    if (std::fabs(d) < fpmin) d = fpmin;
+    c = b + an/c;
+    if (std::fabs(c) < fpmin) c = fpmin;
+    d = 1./d;
+    const double del = d*c;
+    h *= del;
+    if (std::fabs(del - 1.) < 1.e-15) break;
+  }
+  return std::exp(-x + a*std::log(x) - gln)*h;
+}
+
+double Tangle2Statistics::ChiSquare(const std::vector<double>& a,
+				    const std::vector<double>& b,
+				    int& ndf)
+{
+  const std::size_t n = std::min(a.size(), b.size());
+  double nA = 0., nB = 0.;
+  for (std::size_t i = 0; i < n; i++) {
+    nA += a[i];
+    nB += b[i];
+  }
+  
+  double chi2 = 0.;
+  ndf = -1;
+  if (nA > 0. && nB > 0.) {
+    for (std::size_t i = 0; i < n; i++) {
+      if (a[i] + b[i] <= 0.) continue;
+      const double d = std::sqrt(nB/nA)*a[i] - std::sqrt(nA/nB)*b[i];
+      chi2 += d*d/(a[i] + b[i]);
+      ndf++;
+    }
+  }
+  return chi2;
+}
+
+double Tangle2Statistics::ChiSquareProbability(double chi2, int ndf)
+{
+  return ndf > 0 ? GammaQ(0.5*ndf, 0.5*chi2) : 1.;
+}
+
+double Tangle2Statistics::KolmogorovDistance(const std::vector<double>& a,
+					     const std::vector<double>& b)
+{
+  const std::size_t n = std::min(a.size(), b.size());
+  double nA = 0., nB = 0.;
+  for (std::size_t i = 0; i < n; i++) {
+    nA += a[i];
+    nB += b[i];
+  }
+  if (nA <= 0. || nB <= 0.) return 0.;
+  
+  double sumA = 0., sumB = 0., distance = 0.;
+  for (std::size_t i = 0; i < n; i++) {
+    sumA += a[i];
+    sumB += b[i];
+    distance = std::max(distance, std::fabs(sumA/nA - sumB/nB));
+  }
+  return distance;
+}
+
+// Numerical Recipes probks, with the effective number of entries
+double Tangle2Statistics::KolmogorovProbability(double distance,
+						double nA, double nB)
+{
+  if (nA <= 0. || nB <= 0. || distance <= 0.) return 1.;
+  const double ne = std::sqrt(nA*nB/(nA + nB));
+  const double lambda = (ne + 0.12 + 0.11/ne)*distance;
+  const double a2 = -2.*lambda*lambda;
+  double sign = 2., sum = 0., previous = 0.;
+  for (int j = 1; j <= 100; j++) {
+    const double term = sign*std::exp(a2*j*j);
+    sum += term;
+    if (std::fabs(term) <= 0.001*previous || std::fabs(term) <= 1.e-8*sum)
+      return std::min(1., std::max(0., sum));
+    sign = -sign;
+    previous = std::fabs(term);
+  }
+  return 1.;  // not converged, lambda near 0
+}
@@ -0,0 +1,693 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Micro-benchmarks of the per-event hot paths of tangle2, on synthetic
+// inputs and without Geant4, through the Geant4-free code they share
+// with the standalone engine:
+//
+//   angles/event        Tangle2AngleKernel::Compute on the four scatters
+//                       of an event (formerly CalculateThetaPhi)
+//   angles/scatter      the same over batches of 1024, per scatter
+//   direction/cone      Tangle2DirectionSampler::SampleCone, the beam
+//                       axis of Tangle2PrimaryGeneratorAction
+//   direction/accepted  the acceptanceSampling loop, per accepted axis
+//                       (lab and fullPET)
+//   endOfEvent/select   Tangle2EventAction::EndOfEventAction for a
+//                       selected event, past the hits collection: both
+//                       phases of Tangle2Selection, the angles of the
+//                       four scatters (ComputeAngles), the
+//                       Tangle2EventRecord filled field by field and a
+//                       dPhi_1st histogram
+//   endOfEvent/<f>      the same and the write to backend f
+//   output/<f>          Tangle2OutputBackend::Write of one record
+//
+// Backends f: null (the bookkeeping of the base class only), csv,
+// hdf5 and rntuple if built with them, and async/hdf5 and
+// async/rntuple through Tangle2AsyncOutput; the files go to the working
+// directory and are removed afterwards.  g4root needs Geant4 and is not
+// benchmarked here.
+//
+//   standalone/reset    the event reset of the standalone engine
+//                       (Tangle2StandaloneEvent::Begin)
+//   standalone/fill     its event: reset, two Compton scatters in each
+//                       array, then End (selection, angles and record
+//                       as above) and the histogram - the standalone
+//                       engine, not the tangle2 event actions
+//
+// Each benchmark is calibrated to samples of at least --sample seconds,
+// warmed up for --warmup seconds, then timed for --repetitions samples.
+// ns/op is reported as median, mean, standard deviation, min and max
+// over the samples.
+//
+//   tangle2_bench [options]
+//     --filter <s>       only benchmarks whose name contains s
+//     --repetitions <n>  samples per benchmark (default 20)
+//     --sample <s>       minimum seconds per sample (default 0.01)
+//     --warmup <s>       seconds of warm-up (default 0.1)
+//     --format <f>       text (default), csv or json
+//     --list             names only
+//
+// e.g. tangle2_bench --format json > before.json
+
+#include "Tangle2AngleKernel.hh"
+#include "Tangle2DirectionSampler.hh"
+#include "Tangle2StandaloneEvent.hh"
+#include "Tangle2Histogram.hh"
+#include "Tangle2CsvNtuple.hh"
+#include "Tangle2Hdf5Output.hh"
+#include "Tangle2RNTupleOutput.hh"
+#include "Tangle2AsyncOutput.hh"
+#include "Tangle2Selection.hh"
+#include "Tangle2Geometry.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  struct Options
+  {
+    std::string filter;
+    int         repetitions;
+    double      sampleSeconds;
+    double      warmupSeconds;
+    std::string format;
+    bool        list;
+
+    Options()
+    : repetitions(20), sampleSeconds(0.01), warmupSeconds(0.1),
+      format("text"), list(false) {}
+  };
+
+  struct Result
+  {
+    std::string name;
+    long   opsPerSample;
+    double median, mean, stddev, min, max;  // ns/op
+  };
+
+  // Runs n operations
+  typedef std::function<void(long n)> Operation;
+
+  struct Benchmark
+  {
+    std::string name;
+    Operation   operation;
+  };
+
+  // Results are added here so that the work is not optimised away
+  volatile double sink = 0.;
+
+  void Usage()
+  {
+    std::fprintf(stderr,
+      "Usage: tangle2_bench [--filter s] [--repetitions n] [--sample s]"
+      " [--warmup s]\n"
+      "                     [--format text|csv|json] [--list]\n");
+  }
+
+  bool EndsWith(const std::string& s, const std::string& end)
+  {
+    return s.size() >= end.size() &&
+      s.compare(s.size() - end.size(), end.size(), end) == 0;
+  }
+
+  double SecondsSince(const Clock::time_point& start)
+  {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+  Result Measure(const Benchmark& benchmark, const Options& options)
+  {
+    // once first, for what is set up on first use (datasets, tables)
+    benchmark.operation(1);
+    
+    // ops per sample, doubled until a sample is long enough
+    long n = 1;
+    for (;;) {
+      const Clock::time_point start = Clock::now();
+      benchmark.operation(n);
+      if (SecondsSince(start) >= options.sampleSeconds || n >= (1L << 40))
+	break;
+      n *= 2;
+    }
+    
+    const Clock::time_point warmup = Clock::now();
+    do benchmark.operation(n);
+    while (SecondsSince(warmup) < options.warmupSeconds);
+    
+    std::vector<double> nsPerOp;
+    for (int i = 0; i < options.repetitions; i++) {
+      const Clock::time_point start = Clock::now();
+      benchmark.operation(n);
+      nsPerOp.push_back(SecondsSince(start)*1.e9/n);
+    }
+    
+    Result result;
+    result.name = benchmark.name;
+    result.opsPerSample = n;
+    
+    double sum = 0., sum2 = 0.;
+    for (std::size_t i = 0; i < nsPerOp.size(); i++) {
+      sum  += nsPerOp[i];
+      sum2 += nsPerOp[i]*nsPerOp[i];
+    }
+    const double m = nsPerOp.size();
+    result.mean   = sum/m;
+    result.stddev = m > 1 ?
+      std::sqrt(std::max(0., (sum2 - sum*sum/m)/(m - 1))) : 0.;
+    
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+    const std::size_t mid = nsPerOp.size()/2;
+    result.median = nsPerOp.size()%2 ? nsPerOp[mid]
+      : 0.5*(nsPerOp[mid - 1] + nsPerOp[mid]);
+    result.min = nsPerOp.front();
+    result.max = nsPerOp.back();
+    return result;
+  }
+
+  // Synthetic inputs, the same on every run
+  
+  const std::size_t kNInputs = 4096;  // a power of 2
+
+  struct Inputs
+  {
+    std::vector<double> uniforms;
+    std::vector<Tangle2Vector> directions, polarisations;
+  };
+
+  Tangle2Vector RandomDirection(std::mt19937_64& engine)
+  {
+    std::uniform_real_distribution<double> flat(0., 1.);
+    const double cosTheta = 2.*flat(engine) - 1.;
+    const double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
+    const double phi = 2.*3.14159265358979323846*flat(engine);
+    return Tangle2Vector(sinTheta*std::cos(phi), sinTheta*std::sin(phi),
+			 cosTheta);
+  }
+
+  Inputs MakeInputs()
+  {
+    Inputs inputs;
+    std::mt19937_64 engine(12345);
+    std::uniform_real_distribution<double> flat(0., 1.);
+    for (std::size_t i = 0; i < kNInputs; i++) {
+      inputs.uniforms.push_back(flat(engine));
+      const Tangle2Vector direction = RandomDirection(engine);
+      inputs.directions.push_back(direction);
+      inputs.polarisations.push_back
+	(RandomDirection(engine).Cross(direction).Unit());
+    }
+    return inputs;
+  }
+
+  // Adds scatter i of the inputs to the batch, as ComputeAngles
+  void AddScatter(const Inputs& inputs, std::size_t i, bool polarisation,
+		  Tangle2AngleBatch& batch)
+  {
+    double beam[3], scat[3], polPre[3], polPost[3];
+    inputs.directions[i%kNInputs].ToArray(beam);
+    inputs.directions[(i + 1)%kNInputs].ToArray(scat);
+    if (polarisation) {
+      inputs.polarisations[i%kNInputs].ToArray(polPre);
+      inputs.polarisations[(i + 1)%kNInputs].ToArray(polPost);
+      batch.Add(beam, beam, scat, polPre, polPost);
+    }
+    else
+      batch.Add(beam, beam, scat);
+  }
+
+  // An event with two Compton scatters in each central crystal, as
+  // back to back photons (sndGammaTrackID 1, photon 2 first)
+  void FillEvent(const Inputs& inputs, long i,
+		 Tangle2StandaloneEvent& event)
+  {
+    const std::size_t j = (4*i)%kNInputs;
+    double centreA[3], centreB[3];
+    Tangle2Geometry::CrystalCentre(4, false, centreA);
+    Tangle2Geometry::CrystalCentre(13, false, centreB);
+    const Tangle2Vector posA(centreA[0], centreA[1], centreA[2]);
+    const Tangle2Vector posB(centreB[0], centreB[1], centreB[2]);
+    const std::vector<Tangle2Vector>& d = inputs.directions;
+    const std::vector<Tangle2Vector>& p = inputs.polarisations;
+    
+    event.Begin(i + 1, 1, 1.);
+    event.StartTrack(2);
+    event.RecordCompton(2, 4, posA, d[j], d[j + 1], p[j], p[j + 1]);
+    event.RecordCompton(2, 4, posA, d[j + 1], d[j + 2], p[j + 1], p[j + 2]);
+    event.AddEdep(4, 0.3);
+    event.StartTrack(1);
+    event.RecordCompton(1, 13, posB, -d[j], d[j + 2], p[j], p[j + 2]);
+    event.RecordCompton(1, 13, posB, d[j + 2], d[j + 3], p[j + 2], p[j + 3]);
+    event.AddEdep(13, 0.3);
+  }
+
+  // The Tangle2Data quantities of an event with two Compton scatters
+  // in each central crystal, already in the units of the record, and
+  // the vectors of Tangle2SteppingAction
+  struct EventData
+  {
+    double eDepCryst[18], eDepColl[2];
+    int    nb_Compt[18], nb_Photo[18];
+    double posA_1[3], posA_2[3], posB_1[3], posB_2[3];
+    double posA_P1[3], posA_P2[3], posB_P1[3], posB_P2[3];
+    double thetaA, phiA, thetaB, phiB, dphi;
+    double thetaA2, phiA2, thetaB2, phiB2;
+    double dphiA1B2, dphiA2B1, dphiA2B2;
+    double thetaPolA, thetaPolB;
+    long   nEvents;
+    double eventWeight;
+    Tangle2Vector beamA, beamB, scatA1, scatA2, scatB1, scatB2;
+    Tangle2Vector polPreA, polPostA, polPreB, polPostB;
+  };
+
+  void SetEventData(const Inputs& inputs, long i, EventData& d)
+  {
+    const std::size_t j = (4*i)%kNInputs;
+    const std::vector<Tangle2Vector>& v = inputs.directions;
+    const std::vector<Tangle2Vector>& p = inputs.polarisations;
+    
+    d = EventData();
+    d.eDepCryst[4] = d.eDepCryst[13] = 0.3;
+    d.nb_Compt[4]  = d.nb_Compt[13]  = 2;
+    double centreA[3], centreB[3];
+    Tangle2Geometry::CrystalCentre(4, false, centreA);
+    Tangle2Geometry::CrystalCentre(13, false, centreB);
+    for (int k = 0; k < 3; k++) {
+      d.posA_1[k] = d.posA_2[k] = centreA[k];
+      d.posB_1[k] = d.posB_2[k] = centreB[k];
+    }
+    d.nEvents = i + 1;
+    d.eventWeight = 1.;
+    d.beamA = v[j];      d.scatA1 = v[j + 1]; d.scatA2 = v[j + 2];
+    d.beamB = -v[j];     d.scatB1 = v[j + 2]; d.scatB2 = v[j + 3];
+    d.polPreA = p[j];    d.polPostA = p[j + 1];
+    d.polPreB = p[j];    d.polPostB = p[j + 2];
+  }
+
+  // Tangle2SteppingAction::ComputeAngles, two scatters in each array
+  void ComputeAngles(EventData& d, Tangle2AngleBatch& batch)
+  {
+    double beamA[3], beamB[3], a1[3], a2[3], b1[3], b2[3];
+    double polPreA[3], polPostA[3], polPreB[3], polPostB[3];
+    d.beamA.ToArray(beamA);   d.beamB.ToArray(beamB);
+    d.scatA1.ToArray(a1);     d.scatA2.ToArray(a2);
+    d.scatB1.ToArray(b1);     d.scatB2.ToArray(b2);
+    d.polPreA.ToArray(polPreA); d.polPostA.ToArray(polPostA);
+    d.polPreB.ToArray(polPreB); d.polPostB.ToArray(polPostB);
+    
+    batch.Clear();
+    const std::size_t iA1 = batch.Add(beamA, beamA, a1, polPreA, polPostA);
+    const std::size_t iB1 = batch.Add(beamB, beamB, b1, polPreB, polPostB);
+    const std::size_t iA2 = batch.Add(beamA, a1, a2);
+    const std::size_t iB2 = batch.Add(beamB, b1, b2);
+    Tangle2AngleKernel::Compute(batch);
+    
+    d.thetaA  = batch.theta[iA1];  d.phiA  = batch.phi[iA1];
+    d.thetaPolA = batch.thetaPol[iA1];
+    d.thetaA2 = batch.theta[iA2];  d.phiA2 = batch.phi[iA2];
+    d.thetaB  = batch.theta[iB1];  d.phiB  = batch.phi[iB1];
+    d.thetaPolB = batch.thetaPol[iB1];
+    d.thetaB2 = batch.theta[iB2];  d.phiB2 = batch.phi[iB2];
+    d.dphi     = Tangle2AngleKernel::DeltaPhi(d.phiA,  d.phiB);
+    d.dphiA2B1 = Tangle2AngleKernel::DeltaPhi(d.phiA2, d.phiB);
+    d.dphiA1B2 = Tangle2AngleKernel::DeltaPhi(d.phiA,  d.phiB2);
+    d.dphiA2B2 = Tangle2AngleKernel::DeltaPhi(d.phiA2, d.phiB2);
+  }
+
+  // Tangle2EventAction::EndOfEventAction from the selection on
+  void SetPosition(float r[3], const double pos[3])
+  {
+    for (int k = 0; k < 3; k++) r[k] = pos[k];
+  }
+
+  bool EndOfEvent(EventData& d, long eventID, Tangle2Selection& selection,
+		  Tangle2AngleBatch& batch, Tangle2EventRecord& r)
+  {
+    Tangle2SelectionEvent selectionEvent =
+      {d.eDepCryst, d.nb_Compt, 0., 0.};
+    if (!selection.Select(Tangle2Selection::kBeforeAngles, selectionEvent))
+      return false;
+    ComputeAngles(d, batch);
+    selectionEvent.thetaA = d.thetaA;
+    selectionEvent.thetaB = d.thetaB;
+    if (!selection.Select(Tangle2Selection::kAfterAngles, selectionEvent))
+      return false;
+    
+    for (int i = 0; i < 18; i++) {
+      r.edep[i]     = d.eDepCryst[i];
+      r.nb_Compt[i] = d.nb_Compt[i];
+      r.nb_Photo[i] = d.nb_Photo[i];
+    }
+    r.edepColl[0] = d.eDepColl[0];
+    r.edepColl[1] = d.eDepColl[1];
+    
+    SetPosition(r.posA_1, d.posA_1);
+    SetPosition(r.posA_2, d.posA_2);
+    SetPosition(r.posB_1, d.posB_1);
+    SetPosition(r.posB_2, d.posB_2);
+    SetPosition(r.posA_P1, d.posA_P1);
+    SetPosition(r.posA_P2, d.posA_P2);
+    SetPosition(r.posB_P1, d.posB_P1);
+    SetPosition(r.posB_P2, d.posB_P2);
+    
+    r.thetaA = d.thetaA;
+    r.phiA   = d.phiA;
+    r.thetaB = d.thetaB;
+    r.phiB   = d.phiB;
+    r.dphi   = d.dphi;
+    r.thetaA2 = d.thetaA2;
+    r.phiA2   = d.phiA2;
+    r.thetaB2 = d.thetaB2;
+    r.phiB2   = d.phiB2;
+    r.dphiA1B2 = d.dphiA1B2;
+    r.dphiA2B1 = d.dphiA2B1;
+    r.dphiA2B2 = d.dphiA2B2;
+    r.thetaPolA = d.thetaPolA;
+    r.thetaPolB = d.thetaPolB;
+    
+    r.nEvents  = d.nEvents;
+    r.weight   = d.eventWeight;
+    r.eventID  = eventID;
+    r.threadID = 0;
+    return true;
+  }
+
+  // Write without a file, for the bookkeeping of the base class
+  class Tangle2NullOutput : public Tangle2OutputBackend
+  {
+  public:
+    virtual const char* GetName() const { return "null"; }
+  protected:
+    virtual std::string DoOpen(const std::string& fileName)
+    { return fileName; }
+    virtual void DoWrite(const Tangle2EventRecord& record)
+    { sink = sink + record.thetaA; }
+    virtual void DoClose() {}
+  };
+
+  struct Output
+  {
+    std::string name;
+    std::shared_ptr<Tangle2OutputBackend> backend;
+  };
+
+  std::vector<Benchmark> MakeBenchmarks(const Inputs& inputs,
+					Tangle2StandaloneEvent& event,
+					Tangle2AngleBatch& batch,
+					const Tangle2DirectionSampler& lab,
+					const Tangle2DirectionSampler& fullPET,
+					const std::vector<Output>& outputs)
+  {
+    std::vector<Benchmark> benchmarks;
+    const Inputs* in = &inputs;
+    Tangle2StandaloneEvent* ev = &event;
+    Tangle2AngleBatch* b = &batch;
+    
+    Benchmark anglesEvent = {"angles/event", [=](long n) {
+	for (long i = 0; i < n; i++) {
+	  b->Clear();
+	  AddScatter(*in, 4*i,     true,  *b);
+	  AddScatter(*in, 4*i + 1, true,  *b);
+	  AddScatter(*in, 4*i + 2, false, *b);
+	  AddScatter(*in, 4*i + 3, false, *b);
+	  Tangle2AngleKernel::Compute(*b);
+	  sink = sink + b->phi[0];
+	}
+      }};
+    benchmarks.push_back(anglesEvent);
+    
+    // one batch of 1024 built once, so only the kernel is timed
+    std::shared_ptr<Tangle2AngleBatch> large(new Tangle2AngleBatch);
+    large->Reserve(1024);
+    for (std::size_t i = 0; i < 1024; i++)
+      AddScatter(inputs, i, true, *large);
+    Benchmark anglesScatter = {"angles/scatter", [=](long n) {
+	for (long i = 0; i < n; i += 1024) {
+	  Tangle2AngleKernel::Compute(*large);
+	  sink = sink + large->theta[i%1024];
+	}
+      }};
+    benchmarks.push_back(anglesScatter);
+    
+    const Tangle2DirectionSampler* l = &lab;
+    Benchmark cone = {"direction/cone", [=](long n) {
+	double axis[3];
+	for (long i = 0; i < n; i++) {
+	  const std::size_t j = (2*i)%kNInputs;
+	  l->SampleCone(in->uniforms[j], in->uniforms[j + 1], axis);
+	  sink = sink + axis[1];
+	}
+      }};
+    benchmarks.push_back(cone);
+    
+    const Tangle2DirectionSampler* samplers[2] = {&lab, &fullPET};
+    const char* names[2] = {"direction/accepted/lab",
+			    "direction/accepted/fullPET"};
+    for (int s = 0; s < 2; s++) {
+      const Tangle2DirectionSampler* sampler = samplers[s];
+      sampler->Acceptance();  // computed on first use
+      // the uniforms are cycled through, as a random number engine
+      std::shared_ptr<std::size_t> next(new std::size_t(0));
+      Benchmark accepted = {names[s], [=](long n) {
+	  double axis[3];
+	  std::size_t j = *next;
+	  for (long i = 0; i < n; i++) {
+	    do {
+	      sampler->SampleCone(in->uniforms[j], in->uniforms[j + 1], axis);
+	      j = (j + 2)%kNInputs;
+	    } while (!sampler->HitsArrays(axis));
+	    sink = sink + axis[2];
+	  }
+	  *next = j;
+	}};
+      benchmarks.push_back(accepted);
+    }
+    
+    // as booked by /tangle2/hist/h1 dphi dPhi_1st 360 0 360
+    std::shared_ptr<Tangle2Histogram>
+      dphi(new Tangle2Histogram("dphi", "dPhi_1st", 360, 0., 360.));
+    
+    // the events set up once, so only EndOfEventAction is timed
+    std::shared_ptr<std::vector<EventData> >
+      data(new std::vector<EventData>(kNInputs/4));
+    for (std::size_t i = 0; i < data->size(); i++)
+      SetEventData(inputs, i, (*data)[i]);
+    std::shared_ptr<Tangle2Selection> selection(new Tangle2Selection);
+    selection->Compile();
+    std::shared_ptr<Tangle2EventRecord> record(new Tangle2EventRecord);
+    
+    std::vector<Output> endOfEventOutputs(1);
+    endOfEventOutputs[0].name = "select";
+    endOfEventOutputs.insert(endOfEventOutputs.end(),
+			     outputs.begin(), outputs.end());
+    for (std::size_t o = 0; o < endOfEventOutputs.size(); o++) {
+      Tangle2OutputBackend* output = endOfEventOutputs[o].backend.get();
+      Benchmark endOfEvent = {"endOfEvent/" + endOfEventOutputs[o].name,
+			      [=](long n) {
+	  for (long i = 0; i < n; i++) {
+	    EventData& d = (*data)[i%data->size()];
+	    if (EndOfEvent(d, i, *selection, *b, *record)) {
+	      dphi->Fill(*record);
+	      if (output) output->Write(*record);
+	    }
+	  }
+	  sink = sink + dphi->GetSum();
+	}};
+      benchmarks.push_back(endOfEvent);
+    }
+    
+    EndOfEvent((*data)[0], 0, *selection, batch, *record);
+    for (std::size_t o = 0; o < outputs.size(); o++) {
+      Tangle2OutputBackend* output = outputs[o].backend.get();
+      Benchmark write = {"output/" + outputs[o].name, [=](long n) {
+	  for (long i = 0; i < n; i++)
+	    output->Write(*record);
+	}};
+      benchmarks.push_back(write);
+    }
+    
+    Benchmark reset = {"standalone/reset", [=](long n) {
+	for (long i = 0; i < n; i++)
+	  ev->Begin(i + 1, 1, 1.);
+	sink = sink + ev->Record().weight;
+      }};
+    benchmarks.push_back(reset);
+    
+    Benchmark fill = {"standalone/fill", [=](long n) {
+	for (long i = 0; i < n; i++) {
+	  FillEvent(*in, i, *ev);
+	  if (ev->End())
+	    dphi->Fill(ev->Record());
+	}
+	sink = sink + dphi->GetSum();
+      }};
+    benchmarks.push_back(fill);
+    
+    return benchmarks;
+  }
+
+  const char* BuildType()
+  {
+#ifdef NDEBUG
+    return "release";
+#else
+    return "debug";
+#endif
+  }
+
+  void Print(const std::vector<Result>& results, const Options& options)
+  {
+    if (options.format == "json") {
+      std::printf("{\n  \"context\": {\"instructionSet\": \"%s\","
+		  " \"build\": \"%s\", \"repetitions\": %d,"
+		  " \"sampleSeconds\": %g, \"warmupSeconds\": %g},\n"
+		  "  \"benchmarks\": [",
+		  Tangle2AngleKernel::InstructionSet(), BuildType(),
+		  options.repetitions, options.sampleSeconds,
+		  options.warmupSeconds);
+      for (std::size_t i = 0; i < results.size(); i++) {
+	const Result& r = results[i];
+	std::printf("%s\n    {\"name\": \"%s\", \"unit\": \"ns/op\","
+		    " \"median\": %.4g, \"mean\": %.4g, \"stddev\": %.4g,"
+		    " \"min\": %.4g, \"max\": %.4g, \"opsPerSample\": %ld}",
+		    i ? "," : "", r.name.c_str(), r.median, r.mean,
+		    r.stddev, r.min, r.max, r.opsPerSample);
+      }
+      std::printf("\n  ]\n}\n");
+    }
+    else if (options.format == "csv") {
+      std::printf("name,median_ns,mean_ns,stddev_ns,min_ns,max_ns,"
+		  "ops_per_sample\n");
+      for (std::size_t i = 0; i < results.size(); i++) {
+	const Result& r = results[i];
+	std::printf("%s,%.4g,%.4g,%.4g,%.4g,%.4g,%ld\n",
+		    r.name.c_str(), r.median, r.mean, r.stddev,
+		    r.min, r.max, r.opsPerSample);
+      }
+    }
+    else {
+      std::printf(" tangle2_bench: %s kernels, %s build, %d samples\n",
+		  Tangle2AngleKernel::InstructionSet(), BuildType(),
+		  options.repetitions);
+      std::printf(" %-28s %10s %10s %9s %10s %10s %12s\n", "ns/op",
+		  "median", "mean", "stddev", "min", "max", "ops/sample");
+      for (std::size_t i = 0; i < results.size(); i++) {
+	const Result& r = results[i];
+	std::printf(" %-28s %10.4g %10.4g %9.2g %10.4g %10.4g %12ld\n",
+		    r.name.c_str(), r.median, r.mean, r.stddev,
+		    r.min, r.max, r.opsPerSample);
+      }
+    }
+  }
+
+}
+
+int main(int argc, char** argv)
+{
+  Options options;
+  
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if      (arg == "--filter" && hasValue) options.filter = argv[++i];
+    else if (arg == "--repetitions" && hasValue)
+      options.repetitions = std::atoi(argv[++i]);
+    else if (arg == "--sample" && hasValue)
+      options.sampleSeconds = std::atof(argv[++i]);
+    else if (arg == "--warmup" && hasValue)
+      options.warmupSeconds = std::atof(argv[++i]);
+    else if (arg == "--format" && hasValue) options.format = argv[++i];
+    else if (arg == "--list") options.list = true;
+    else {
+      Usage();
+      return 2;
+    }
+  }
+  if (options.repetitions < 1 ||
+      (options.format != "text" && options.format != "csv" &&
+       options.format != "json")) {
+    Usage();
+    return 2;
+  }
+  
+  const Inputs inputs = MakeInputs();
+  Tangle2StandaloneEvent event;
+  Tangle2AngleBatch batch;
+  batch.Reserve(4);
+  const Tangle2DirectionSampler lab(false), fullPET(true);
+  
+  // each backend available, open for the whole run
+  const char* names[] = {"null", "csv", "hdf5", "rntuple",
+			 "async/hdf5", "async/rntuple"};
+  std::vector<Output> outputs;
+  for (std::size_t i = 0; i < sizeof(names)/sizeof(names[0]); i++) {
+    const std::string name = names[i];
+    Tangle2OutputBackend* backend = 0;
+    if (name == "null") backend = new Tangle2NullOutput;
+    else if (name == "csv") backend = new Tangle2CsvOutput;
+    else if (EndsWith(name, "hdf5") && Tangle2Hdf5Output::IsAvailable())
+      backend = new Tangle2Hdf5Output;
+    else if (EndsWith(name, "rntuple") && Tangle2RNTupleOutput::IsAvailable())
+      backend = new Tangle2RNTupleOutput;
+    if (!backend) continue;
+    if (name.compare(0, 6, "async/") == 0)
+      backend = new Tangle2AsyncOutput(backend);
+    
+    Output output = {name, std::shared_ptr<Tangle2OutputBackend>(backend)};
+    std::string fileName = "tangle2_bench_" + name;
+    std::replace(fileName.begin(), fileName.end(), '/', '_');
+    if (!backend->Open(fileName)) {
+      std::fprintf(stderr, "Can not open %s\n", fileName.c_str());
+      return 2;
+    }
+    outputs.push_back(output);
+  }
+  
+  const std::vector<Benchmark> benchmarks
+    = MakeBenchmarks(inputs, event, batch, lab, fullPET, outputs);
+  
+  std::vector<Result> results;
+  for (std::size_t i = 0; i < benchmarks.size(); i++) {
+    const Benchmark& benchmark = benchmarks[i];
+    if (benchmark.name.find(options.filter) == std::string::npos)
+      continue;
+    if (options.list)
+      std::printf("%s\n", benchmark.name.c_str());
+    else
+      results.push_back(Measure(benchmark, options));
+  }
+  
+  for (std::size_t i = 0; i < outputs.size(); i++) {
+    Tangle2OutputBackend& backend = *outputs[i].backend;
+    backend.Close();
+    if (outputs[i].name != "null")
+      std::remove(backend.GetFileName().c_str());
+  }
+  
+  if (!options.list)
+    Print(results, options);
+  return 0;
+}
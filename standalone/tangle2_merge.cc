@@ -0,0 +1,113 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Merges the per-thread Tangle2 ntuple files of a multi-threaded run
+// (or of several runs) into one file in event order, with the eventID
+// and threadID columns telling where each row came from.  See
+// Tangle2Merge.hh.
+//
+//   tangle2_merge [options] -o <output> <input> ...
+//     -o <output>        output, without extension
+//     --format <f>       csv or hdf5 (default: that of the first input,
+//                        csv for .root)
+//     -j <threads>       groups merged in parallel (default: all cores)
+//     --fanIn <n>        inputs per merge (default 64)
+//     -v                 report each merge
+//
+// Inputs are csv, hdf5 or, with ROOT, g4root and RNTuple (.root), see
+// Tangle2RecordReader.hh.
+//
+// e.g. tangle2_merge -o Tangle2_merged Tangle2_t*.h5
+
+#include "Tangle2Merge.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  void Usage()
+  {
+    std::fprintf(stderr,
+      "Usage: tangle2_merge [--format csv|hdf5] [-j threads] [--fanIn n]"
+      " [-v]\n"
+      "                     -o output input...\n");
+  }
+
+}
+
+int main(int argc, char** argv)
+{
+  Tangle2MergeOptions options;
+  options.nThreads = std::thread::hardware_concurrency();
+  if (options.nThreads == 0) options.nThreads = 1;
+  
+  std::string output, format;
+  std::vector<std::string> inputs;
+  
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if      (arg == "-o" && hasValue) output = argv[++i];
+    else if (arg == "--format" && hasValue) format = argv[++i];
+    else if (arg == "-j" && hasValue) options.nThreads = std::atoi(argv[++i]);
+    else if (arg == "--fanIn" && hasValue) options.fanIn = std::atol(argv[++i]);
+    else if (arg == "-v") options.verbose = true;
+    else if (!arg.empty() && arg[0] == '-') {
+      Usage();
+      return 2;
+    }
+    else inputs.push_back(arg);
+  }
+  
+  if (output.empty() || inputs.empty()) {
+    Usage();
+    return 2;
+  }
+  
+  const std::string& first = inputs[0];
+  if (!format.empty())
+    options.format = format;
+  else if (first.size() > 3 && first.compare(first.size() - 3, 3, ".h5") == 0)
+    options.format = "hdf5";
+  else
+    options.format = "csv";
+  
+  std::chrono::steady_clock::time_point start
+    = std::chrono::steady_clock::now();
+  
+  const Tangle2MergeResult result
+    = Tangle2MergeFiles(inputs, output, options);
+  
+  const double seconds = std::chrono::duration<double>
+    (std::chrono::steady_clock::now() - start).count();
+  
+  if (!result.error.empty()) {
+    std::fprintf(stderr, "tangle2_merge: %s\n", result.error.c_str());
+    return 1;
+  }
+  
+  std::printf(" %zu files, %ld rows merged to %s in %.3f s\n",
+	      inputs.size(), result.nRows, result.outputFile.c_str(), seconds);
+  if (result.nOutOfOrder > 0)
+    std::printf(" Warning: %ld rows were out of event order in their"
+		" input, the output is not fully ordered\n",
+		result.nOutOfOrder);
+  return 0;
+}
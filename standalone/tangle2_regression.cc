@@ -0,0 +1,487 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Statistical regression check of tangle2 against stored reference
+// histograms, to guard performance work against changes in the
+// physics.  A short run with a fixed seed of each configuration
+//
+//   positrons    the default, e+ at rest
+//   fixedAxis    back to back gammas along x, random polarisations
+//   perpPol      the same with perpendicular polarisations
+//   polYZ        the same with polarisations along y and z
+//   fullPET      e+ at rest, human PET diameter
+//
+// fills, with /tangle2/hist/, dPhi_1st, ThetaA_1st, ThetaB_1st and
+// edep0..edep17 of the selected events.  compare then checks the shape
+// of each histogram against the reference with the two sample chi2 and
+// Kolmogorov-Smirnov tests (see Tangle2Statistics), and the events/s
+// of each configuration against that of a speed reference.
+//
+//   tangle2_regression run [options] <tangle2> [tangle2 options]
+//     -d <dir>           (default tangle2_regression), a directory per
+//                        configuration with the histograms and the log
+//     -n <events>        per configuration (default 20000)
+//     -s <seed>          (default 12345)
+//     -t <threads>       (default 2)
+//
+//   tangle2_regression histogram -d <dir> <ntuple.csv>...
+//                        the same histograms from the csv ntuples of one
+//                        configuration (g4csv), for builds without
+//                        /tangle2/hist/ such as the baseline
+//
+//   tangle2_regression check <reference dir>
+//                        fails unless every reference histogram is there
+//
+//   tangle2_regression compare [options] <reference dir> <test dir>
+//     --speed <dir>      run directory of the speed reference (default
+//                        none, the speed is not compared)
+//     --pmin <p>         chance of any false alarm between samples of
+//                        the same distributions (default 0.01); each
+//                        test is at p/(number of tests)
+//     --maxSlowdown <f>  fail if events/s is lower than the reference's
+//                        by more than this fraction (default 0.1);
+//                        negative to compare physics only
+//
+// Returns 0 if all is well, 1 if not, 2 on errors.  The physics
+// references are committed in regression/ (see regression/README.txt
+// for how they were made from the baseline); the speed reference is a
+// run directory kept from a trusted build on the same machine as the
+// tests (cmake targets regression_reference and regression, see
+// CMakeLists.txt).
+
+#include "Tangle2Process.hh"
+#include "Tangle2Statistics.hh"
+#include "Tangle2Histogram.hh"
+#include "Tangle2RecordReader.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+  const char* const kLogName   = "tangle2.log";
+  const char* const kMacroName = "regression.mac";
+
+  struct Configuration
+  {
+    const char* name;
+    const char* settings;  // /tangle2/config/ commands
+  };
+
+  const Configuration kConfigurations[] = {
+    {"positrons", ""},
+    {"fixedAxis", "positrons false\nfixedAxis true\n"},
+    {"perpPol",   "positrons false\nfixedAxis true\nperpPol true\n"},
+    {"polYZ",     "positrons false\nfixedAxis true\npolYZ true\n"},
+    {"fullPET",   "fullPET true\n"}
+  };
+  const int kNConfigurations
+    = sizeof(kConfigurations)/sizeof(kConfigurations[0]);
+
+  struct Binning
+  {
+    std::string name, column;
+    int         nBins;
+    double      min, max;
+  };
+
+  // angles in degrees, energies in MeV
+  std::vector<Binning> Histograms()
+  {
+    std::vector<Binning> histograms;
+    Binning dphi   = {"dphi",   "dPhi_1st",   36, 0., 360.};
+    Binning thetaA = {"thetaA", "ThetaA_1st", 36, 0., 180.};
+    Binning thetaB = {"thetaB", "ThetaB_1st", 36, 0., 180.};
+    histograms.push_back(dphi);
+    histograms.push_back(thetaA);
+    histograms.push_back(thetaB);
+    for (int i = 0; i < 18; i++) {
+      std::ostringstream name;
+      name << "edep" << i;
+      Binning edep = {name.str(), name.str(), 55, 0., 0.55};
+      histograms.push_back(edep);
+    }
+    return histograms;
+  }
+
+  void Usage()
+  {
+    std::fprintf(stderr,
+      "Usage: tangle2_regression run [-d dir] [-n events] [-s seed]"
+      " [-t threads]\n"
+      "                              tangle2 [tangle2 options]\n"
+      "       tangle2_regression histogram -d dir ntuple.csv...\n"
+      "       tangle2_regression check reference_dir\n"
+      "       tangle2_regression compare [--speed dir] [--pmin p]"
+      " [--maxSlowdown f]\n"
+      "                              reference_dir test_dir\n");
+  }
+
+  std::string HistogramFile(const std::string& directory,
+			    const Binning& binning)
+  {
+    return directory + "/Tangle2_hist_" + binning.name + ".txt";
+  }
+
+  bool WriteMacro(const std::string& fileName,
+		  const Configuration& configuration)
+  {
+    std::ofstream macro(fileName.c_str());
+    std::istringstream settings(configuration.settings);
+    std::string setting;
+    while (std::getline(settings, setting))
+      macro << "/tangle2/config/" << setting << "\n";
+    
+    const std::vector<Binning> histograms = Histograms();
+    for (std::size_t i = 0; i < histograms.size(); i++) {
+      const Binning& h = histograms[i];
+      macro << "/tangle2/hist/h1 " << h.name << " " << h.column << " "
+	    << h.nBins << " " << h.min << " " << h.max << "\n";
+    }
+    macro << "/tangle2/hist/ntupleOutput false\n"
+	  << "/run/initialize\n"
+	  << "/run/beamOn {nEvents}\n";
+    return bool(macro);
+  }
+
+  int Run(int argc, char** argv)
+  {
+    std::string dir = "tangle2_regression";
+    std::string nEvents = "20000", seed = "12345", threads = "2";
+    
+    int i = 0;
+    for (; i < argc; i++) {
+      const std::string arg = argv[i];
+      const bool hasValue = i + 1 < argc;
+      if      (arg == "-d" && hasValue) dir = argv[++i];
+      else if (arg == "-n" && hasValue) nEvents = argv[++i];
+      else if (arg == "-s" && hasValue) seed = argv[++i];
+      else if (arg == "-t" && hasValue) threads = argv[++i];
+      else if (!arg.empty() && arg[0] == '-') {
+	Usage();
+	return 2;
+      }
+      else break;
+    }
+    if (i >= argc) {
+      Usage();
+      return 2;
+    }
+    
+    // the child runs elsewhere
+    std::string tangle2 = argv[i];
+    if (tangle2.find('/') != std::string::npos)
+      tangle2 = Tangle2Process::AbsolutePath(tangle2);
+    if (!Tangle2Process::MakeDirectory(dir)) {
+      std::fprintf(stderr, "Can not create %s\n", dir.c_str());
+      return 2;
+    }
+    
+    int status = 0;
+    for (int c = 0; c < kNConfigurations; c++) {
+      const Configuration& configuration = kConfigurations[c];
+      const std::string directory = dir + "/" + configuration.name;
+      const std::string macro = directory + "/" + kMacroName;
+      if (!Tangle2Process::MakeDirectory(directory) ||
+	  !WriteMacro(macro, configuration)) {
+	std::fprintf(stderr, "Can not write %s\n", macro.c_str());
+	return 2;
+      }
+      
+      std::vector<std::string> args;
+      args.push_back(tangle2);
+      args.insert(args.end(), argv + i + 1, argv + argc);
+      args.push_back("-m"); args.push_back(kMacroName);
+      args.push_back("-t"); args.push_back(threads);
+      args.push_back("-n"); args.push_back(nEvents);
+      args.push_back("-s"); args.push_back(seed);
+      
+      std::printf(" %-10s ", configuration.name);
+      std::fflush(stdout);
+      const Tangle2ProcessResult result
+	= Tangle2Process::Run(args, directory, kLogName);
+      if (!result.ok) {
+	std::printf("failed (status %d), see %s/%s\n",
+		    result.status, directory.c_str(), kLogName);
+	status = 2;
+	continue;
+      }
+      const Tangle2RunLog log
+	= Tangle2Process::ReadLog(directory + "/" + kLogName);
+      std::printf("%ld events, %ld selected, %.3g events/s\n",
+		  log.nEvents, log.nSelected,
+		  log.loopSeconds > 0. ? log.nEvents/log.loopSeconds : 0.);
+    }
+    return status;
+  }
+
+  int Histogram(int argc, char** argv)
+  {
+    std::string dir;
+    std::vector<std::string> files;
+    for (int i = 0; i < argc; i++) {
+      const std::string arg = argv[i];
+      if (arg == "-d" && i + 1 < argc) dir = argv[++i];
+      else if (!arg.empty() && arg[0] == '-') {
+	Usage();
+	return 2;
+      }
+      else files.push_back(arg);
+    }
+    if (dir.empty() || files.empty()) {
+      Usage();
+      return 2;
+    }
+    // e.g. regression/positrons, with the parents
+    for (std::size_t slash = dir.find('/', 1); ;
+	 slash = dir.find('/', slash + 1)) {
+      if (!Tangle2Process::MakeDirectory(dir.substr(0, slash))) {
+	std::fprintf(stderr, "Can not create %s\n", dir.c_str());
+	return 2;
+      }
+      if (slash == std::string::npos) break;
+    }
+    
+    const std::vector<Binning> binnings = Histograms();
+    std::vector<Tangle2Histogram> histograms;
+    for (std::size_t h = 0; h < binnings.size(); h++) {
+      const Binning& b = binnings[h];
+      histograms.push_back(Tangle2Histogram(b.name, b.column,
+					    b.nBins, b.min, b.max));
+    }
+    
+    long nRows = 0;
+    for (std::size_t f = 0; f < files.size(); f++) {
+      std::string error;
+      std::unique_ptr<Tangle2RecordReader>
+	reader(Tangle2RecordReader::Open(files[f], error));
+      if (!reader) {
+	std::fprintf(stderr, "%s\n", error.c_str());
+	return 2;
+      }
+      // older ntuples are unweighted
+      const bool weighted = reader->HasColumn("weight");
+      Tangle2EventRecord record;
+      while (reader->Next(record)) {
+	if (!weighted) record.weight = 1.;
+	for (std::size_t h = 0; h < histograms.size(); h++)
+	  histograms[h].Fill(record);
+	nRows++;
+      }
+      if (!reader->GetError().empty()) {
+	std::fprintf(stderr, "%s\n", reader->GetError().c_str());
+	return 2;
+      }
+    }
+    
+    for (std::size_t h = 0; h < histograms.size(); h++) {
+      const std::string file = HistogramFile(dir, binnings[h]);
+      if (!histograms[h].Write(file)) {
+	std::fprintf(stderr, "Can not write %s\n", file.c_str());
+	return 2;
+      }
+    }
+    std::printf("%ld rows from %d files to %s\n",
+		nRows, int(files.size()), dir.c_str());
+    return 0;
+  }
+
+  // As written by Tangle2Histogram::Write; false if it can not be read
+  bool ReadHistogram(const std::string& fileName,
+		     std::vector<double>& contents, double& entries)
+  {
+    std::ifstream file(fileName.c_str());
+    if (!file) return false;
+    contents.clear();
+    entries = 0.;
+    std::string line;
+    while (std::getline(file, line)) {
+      if (line.empty()) continue;
+      double xLow, xHigh, sum, error;
+      if (line[0] == '#')
+	std::sscanf(line.c_str(), "# entries %lf", &entries);
+      else if (std::sscanf(line.c_str(), "%lf %lf %lf %lf",
+			   &xLow, &xHigh, &sum, &error) == 4)
+	contents.push_back(sum);
+    }
+    return true;
+  }
+
+  // False, loudly, unless every reference histogram is there
+  bool CheckReferences(const std::string& dir)
+  {
+    const std::vector<Binning> histograms = Histograms();
+    int nMissing = 0;
+    for (int c = 0; c < kNConfigurations; c++)
+      for (std::size_t h = 0; h < histograms.size(); h++) {
+	const std::string file
+	  = HistogramFile(dir + "/" + kConfigurations[c].name, histograms[h]);
+	if (!std::ifstream(file.c_str())) {
+	  if (nMissing < 5)
+	    std::fprintf(stderr, "Missing %s\n", file.c_str());
+	  nMissing++;
+	}
+      }
+    if (nMissing) {
+      std::fprintf(stderr,
+		   "\n*** %d reference histograms missing in %s - nothing to"
+		   " compare against.\n*** See regression/README.txt for how"
+		   " to make them from the baseline.\n\n",
+		   nMissing, dir.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  // Before the test run, so that missing references are not found
+  // out only at the end of it
+  int Check(int argc, char** argv)
+  {
+    if (argc != 1) {
+      Usage();
+      return 2;
+    }
+    return CheckReferences(argv[0]) ? 0 : 2;
+  }
+
+  double EventsPerSecond(const std::string& directory)
+  {
+    const Tangle2RunLog log
+      = Tangle2Process::ReadLog(directory + "/" + kLogName);
+    return log.loopSeconds > 0. && log.nEvents > 0 ?
+      log.nEvents/log.loopSeconds : 0.;
+  }
+
+  int Compare(int argc, char** argv)
+  {
+    double pMin = 0.01, maxSlowdown = 0.1;
+    std::string speedDir;
+    std::vector<std::string> dirs;
+    for (int i = 0; i < argc; i++) {
+      const std::string arg = argv[i];
+      const bool hasValue = i + 1 < argc;
+      if      (arg == "--speed" && hasValue) speedDir = argv[++i];
+      else if (arg == "--pmin" && hasValue) pMin = std::atof(argv[++i]);
+      else if (arg == "--maxSlowdown" && hasValue)
+	maxSlowdown = std::atof(argv[++i]);
+      else if (!arg.empty() && arg[0] == '-') {
+	Usage();
+	return 2;
+      }
+      else dirs.push_back(arg);
+    }
+    if (dirs.size() != 2) {
+      Usage();
+      return 2;
+    }
+    if (!CheckReferences(dirs[0]))
+      return 2;
+    
+    const std::vector<Binning> histograms = Histograms();
+    int nFailed = 0, nMissing = 0;
+    // chi2 and KS of every histogram (Bonferroni)
+    const double pTest = pMin/(2.*kNConfigurations*histograms.size());
+    
+    std::printf("%-10s %-8s %9s %9s %9s %5s %9s %9s %9s\n",
+		"config", "hist", "ref", "test", "chi2", "ndf", "p chi2",
+		"KS", "p KS");
+    for (int c = 0; c < kNConfigurations; c++) {
+      const std::string name = kConfigurations[c].name;
+      const std::string refDir  = dirs[0] + "/" + name;
+      const std::string testDir = dirs[1] + "/" + name;
+      
+      for (std::size_t h = 0; h < histograms.size(); h++) {
+	std::vector<double> a, b;
+	double nA, nB;
+	if (!ReadHistogram(HistogramFile(refDir, histograms[h]), a, nA) ||
+	    !ReadHistogram(HistogramFile(testDir, histograms[h]), b, nB) ||
+	    a.size() != b.size()) {
+	  std::printf("%-10s %-8s missing or different binning\n",
+		      name.c_str(), histograms[h].name.c_str());
+	  nMissing++;
+	  continue;
+	}
+	
+	int ndf;
+	const double chi2 = Tangle2Statistics::ChiSquare(a, b, ndf);
+	const double pChi2 = Tangle2Statistics::ChiSquareProbability(chi2, ndf);
+	const double ks = Tangle2Statistics::KolmogorovDistance(a, b);
+	const double pKS = Tangle2Statistics::KolmogorovProbability(ks, nA, nB);
+	// both empty is a match, one empty is not
+	const bool ok = (nA > 0.) == (nB > 0.) && pChi2 >= pTest && pKS >= pTest;
+	if (!ok) nFailed++;
+	
+	std::printf("%-10s %-8s %9.0f %9.0f %9.2f %5d %9.3g %9.4f %9.3g%s\n",
+		    name.c_str(), histograms[h].name.c_str(), nA, nB,
+		    chi2, ndf, pChi2, ks, pKS, ok ? "" : "  <-- differs");
+      }
+    }
+    
+    // The physics references are shared, the speed is per machine
+    if (speedDir.empty()) maxSlowdown = -1.;
+    int nSlower = 0, nNoSpeed = 0;
+    std::printf("\n%-10s %12s %12s %8s\n",
+		"config", "ref ev/s", "test ev/s", "ratio");
+    for (int c = 0; c < kNConfigurations; c++) {
+      const std::string name = kConfigurations[c].name;
+      const double ref  = speedDir.empty() ? 0. :
+	EventsPerSecond(speedDir + "/" + name);
+      const double test = EventsPerSecond(dirs[1] + "/" + name);
+      const double ratio = ref > 0. ? test/ref : 0.;
+      const bool slower = maxSlowdown >= 0. && ref > 0. &&
+	ratio < 1. - maxSlowdown;
+      if (slower) nSlower++;
+      if (!(ref > 0.)) nNoSpeed++;
+      std::printf("%-10s %12.4g %12.4g %8.3f%s\n",
+		  name.c_str(), ref, test, ratio,
+		  slower ? "  <-- slower" : "");
+    }
+    
+    std::printf("\n%d histograms differ, %d missing (p-value threshold %.3g);"
+		" %d configurations slower", nFailed, nMissing, pTest, nSlower);
+    if (maxSlowdown >= 0.)
+      std::printf(" (by more than %g%%)\n", 100.*maxSlowdown);
+    else
+      std::printf(" (not checked)\n");
+    if (maxSlowdown >= 0. && nNoSpeed)
+      std::printf("No speed reference for %d configurations in %s"
+		  " (make regression_reference on this machine)\n",
+		  nNoSpeed, speedDir.c_str());
+    
+    if (nMissing) return 2;
+    return (nFailed || nSlower) ? 1 : 0;
+  }
+
+}
+
+int main(int argc, char** argv)
+{
+  if (argc >= 2 && std::string(argv[1]) == "run")
+    return Run(argc - 2, argv + 2);
+  if (argc >= 2 && std::string(argv[1]) == "histogram")
+    return Histogram(argc - 2, argv + 2);
+  if (argc >= 2 && std::string(argv[1]) == "check")
+    return Check(argc - 2, argv + 2);
+  if (argc >= 2 && std::string(argv[1]) == "compare")
+    return Compare(argc - 2, argv + 2);
+  Usage();
+  return 2;
+}
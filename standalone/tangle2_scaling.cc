@@ -0,0 +1,277 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Thread scaling of tangle2: runs the same macro, seed and number of
+// events at 1, 2, 4, ... threads, each in a process of its own (the
+// number of threads of a Geant4 session is fixed once it has started)
+// and in a directory of its own, <dir>/t<threads>, so that the outputs
+// do not clash.  For each it records
+//
+//   wall       seconds from fork to exit, including initialisation
+//   loop       the event loop, "Event loop <s> s" of Tangle2RunAction
+//   events/s   and selected events/s over the event loop
+//   peak RSS   of the tangle2 process (wait4)
+//   output     bytes of the files it wrote, all but its log
+//
+// and prints the speedup and efficiency (speedup/threads) relative to
+// the smallest thread count, with all of it written as csv as well.
+// The number of events is the same at every thread count.
+//
+//   tangle2_scaling [options] <tangle2> [tangle2 options]
+//     -n <events>        per run (default 100000)
+//     -s <seed>          seed of every run (default 12345)
+//     -m <macro>         (default visNoGraph.mac), run from <dir>/t<n>,
+//                        so macros it executes need absolute paths
+//     --max <n>          1, 2, 4, ... up to and including n
+//                        (default: all cores)
+//     --threads <list>   instead, e.g. 1,8,32,64
+//     -d <dir>           (default tangle2_scaling)
+//     -o <csv>           (default <dir>/scaling.csv)
+//
+// e.g. tangle2_scaling -n 1000000 --max 128 ./tangle2
+//
+// Linux and macOS only, see Tangle2Process.
+
+#include "Tangle2Process.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  const char* const kLogName = "tangle2.log";
+
+  struct Options
+  {
+    long        nEvents;
+    std::string seed;
+    std::string macro;
+    std::vector<int> threads;
+    std::string dir;
+    std::string csvFile;
+    std::string tangle2;
+    std::vector<std::string> tangle2Options;
+
+    Options()
+    : nEvents(100000), seed("12345"), macro("visNoGraph.mac"),
+      dir("tangle2_scaling") {}
+  };
+
+  struct Measurement
+  {
+    int    threads;
+    bool   ok;
+    double wallSeconds;
+    double loopSeconds;
+    long   nSelected;
+    long   peakRSSBytes;
+    long   outputBytes;
+  };
+
+  void Usage()
+  {
+    std::fprintf(stderr,
+      "Usage: tangle2_scaling [-n events] [-s seed] [-m macro]"
+      " [--max n | --threads list]\n"
+      "                       [-d dir] [-o csv] tangle2 [tangle2 options]\n");
+  }
+
+  Measurement Run(const Options& options, int nThreads)
+  {
+    Measurement m;
+    m.threads = nThreads;
+    m.ok = false;
+    m.wallSeconds = m.loopSeconds = 0.;
+    m.nSelected = -1;
+    m.peakRSSBytes = m.outputBytes = 0;
+    
+    char name[32];
+    std::snprintf(name, sizeof(name), "/t%d", nThreads);
+    const std::string directory = options.dir + name;
+    if (!Tangle2Process::MakeDirectory(directory)) {
+      std::fprintf(stderr, "Can not create %s\n", directory.c_str());
+      return m;
+    }
+    
+    char threads[16], events[32];
+    std::snprintf(threads, sizeof(threads), "%d", nThreads);
+    std::snprintf(events, sizeof(events), "%ld", options.nEvents);
+    std::vector<std::string> args;
+    args.push_back(options.tangle2);
+    args.insert(args.end(), options.tangle2Options.begin(),
+		options.tangle2Options.end());
+    args.push_back("-m"); args.push_back(options.macro);
+    args.push_back("-t"); args.push_back(threads);
+    args.push_back("-n"); args.push_back(events);
+    args.push_back("-s"); args.push_back(options.seed);
+    
+    const Tangle2ProcessResult result
+      = Tangle2Process::Run(args, directory, kLogName);
+    const Tangle2RunLog log
+      = Tangle2Process::ReadLog(directory + "/" + kLogName);
+    m.ok = result.ok;
+    m.wallSeconds = result.wallSeconds;
+    m.peakRSSBytes = result.peakRSSBytes;
+    m.loopSeconds = log.loopSeconds > 0. ? log.loopSeconds : 0.;
+    m.nSelected = log.nSelected;
+    m.outputBytes = Tangle2Process::DirectoryBytes(directory, kLogName);
+    
+    if (!m.ok)
+      std::fprintf(stderr, "%s failed (status %d), see %s/%s\n",
+		   options.tangle2.c_str(), result.status,
+		   directory.c_str(), kLogName);
+    return m;
+  }
+
+  // Over the event loop, or the wall time if the log had no loop time
+  double Seconds(const Measurement& m)
+  { return m.loopSeconds > 0. ? m.loopSeconds : m.wallSeconds; }
+
+  void Report(const Options& options, const std::vector<Measurement>& ms)
+  {
+    const Measurement* base = 0;
+    for (std::size_t i = 0; i < ms.size() && !base; i++)
+      if (ms[i].ok) base = &ms[i];
+    
+    std::FILE* csv = std::fopen(options.csvFile.c_str(), "w");
+    if (!csv)
+      std::fprintf(stderr, "Can not write %s\n", options.csvFile.c_str());
+    else
+      std::fprintf(csv, "threads,events,wall_s,loop_s,events_per_s,"
+		   "selected,selected_per_s,speedup,efficiency,"
+		   "peak_rss_bytes,output_bytes\n");
+    
+    std::printf(" ------------------------------------------ \n");
+    std::printf(" tangle2 thread scaling, %ld events, seed %s\n",
+		options.nEvents, options.seed.c_str());
+    std::printf(" %7s %9s %9s %11s %11s %8s %6s %10s %10s\n",
+		"threads", "wall [s]", "loop [s]", "events/s", "selected/s",
+		"speedup", "eff.", "RSS [MB]", "out [MB]");
+    
+    for (std::size_t i = 0; i < ms.size(); i++) {
+      const Measurement& m = ms[i];
+      if (!m.ok) {
+	std::printf(" %7d failed\n", m.threads);
+	continue;
+      }
+      const double rate = options.nEvents/Seconds(m);
+      const double selectedRate = m.nSelected >= 0 ?
+	m.nSelected/Seconds(m) : 0.;
+      const double speedup = Seconds(*base)/Seconds(m);
+      const double efficiency = speedup*base->threads/m.threads;
+      std::printf(" %7d %9.2f %9.2f %11.4g %11.4g %8.2f %5.0f%% %10.1f"
+		  " %10.1f\n",
+		  m.threads, m.wallSeconds, m.loopSeconds, rate, selectedRate,
+		  speedup, 100.*efficiency, m.peakRSSBytes/1.e6,
+		  m.outputBytes/1.e6);
+      if (csv)
+	std::fprintf(csv, "%d,%ld,%.6g,%.6g,%.6g,%ld,%.6g,%.6g,%.6g,%ld,%ld\n",
+		     m.threads, options.nEvents, m.wallSeconds, m.loopSeconds,
+		     rate, m.nSelected, selectedRate, speedup, efficiency,
+		     m.peakRSSBytes, m.outputBytes);
+    }
+    std::printf(" ------------------------------------------ \n");
+    
+    if (csv) {
+      std::fclose(csv);
+      std::printf(" written to %s\n", options.csvFile.c_str());
+    }
+  }
+
+  bool ParseThreads(const std::string& list, std::vector<int>& threads)
+  {
+    const char* p = list.c_str();
+    while (*p) {
+      char* end;
+      const long n = std::strtol(p, &end, 10);
+      if (end == p || n < 1) return false;
+      threads.push_back(int(n));
+      p = end;
+      if (*p == ',') p++;
+      else if (*p) return false;
+    }
+    return !threads.empty();
+  }
+
+}
+
+int main(int argc, char** argv)
+{
+  Options options;
+  int maxThreads = std::thread::hardware_concurrency();
+  if (maxThreads < 1) maxThreads = 1;
+  
+  int i = 1;
+  for (; i < argc; i++) {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if      (arg == "-n" && hasValue) options.nEvents = std::atol(argv[++i]);
+    else if (arg == "-s" && hasValue) options.seed = argv[++i];
+    else if (arg == "-m" && hasValue) options.macro = argv[++i];
+    else if (arg == "--max" && hasValue) maxThreads = std::atoi(argv[++i]);
+    else if (arg == "--threads" && hasValue) {
+      if (!ParseThreads(argv[++i], options.threads)) {
+	Usage();
+	return 2;
+      }
+    }
+    else if (arg == "-d" && hasValue) options.dir = argv[++i];
+    else if (arg == "-o" && hasValue) options.csvFile = argv[++i];
+    else if (arg == "--") { i++; break; }
+    else if (!arg.empty() && arg[0] == '-') {
+      Usage();
+      return 2;
+    }
+    else break;
+  }
+  if (i >= argc || options.nEvents < 1 || maxThreads < 1) {
+    Usage();
+    return 2;
+  }
+  
+  // the child runs elsewhere
+  options.tangle2 = argv[i];
+  if (options.tangle2.find('/') != std::string::npos)
+    options.tangle2 = Tangle2Process::AbsolutePath(options.tangle2);
+  options.tangle2Options.assign(argv + i + 1, argv + argc);
+  options.macro = Tangle2Process::AbsolutePath(options.macro);
+  
+  if (options.threads.empty()) {
+    for (int n = 1; n < maxThreads; n *= 2)
+      options.threads.push_back(n);
+    options.threads.push_back(maxThreads);
+  }
+  if (options.csvFile.empty())
+    options.csvFile = options.dir + "/scaling.csv";
+  if (!Tangle2Process::MakeDirectory(options.dir)) {
+    std::fprintf(stderr, "Can not create %s\n", options.dir.c_str());
+    return 2;
+  }
+  
+  std::vector<Measurement> measurements;
+  bool ok = true;
+  for (std::size_t t = 0; t < options.threads.size(); t++) {
+    std::printf(" %d threads ...\n", options.threads[t]);
+    std::fflush(stdout);
+    measurements.push_back(Run(options, options.threads[t]));
+    ok = ok && measurements.back().ok;
+  }
+  
+  Report(options, measurements);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,438 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Checks and merges the shards of a campaign, run on several nodes with
+// tangle2 --shard i/N -s <campaign seed> (see Tangle2Shard.hh):
+//
+//   tangle2_shards [options] <manifest> ...
+//     -o <output>        merge to <output>, without extension; without
+//                        -o the shards are only checked
+//     --format <f>       csv or hdf5 (default: that of the first file)
+//     -j <threads>       groups merged in parallel (default: all cores)
+//     -v                 report each merge
+//
+// e.g. tangle2_shards -o Tangle2_campaign node*/Tangle2_s*_shard.txt
+//
+// The manifests, <name>_s<i>_shard.txt, must be of the same campaign
+// seed, number of shards and events per shard, with every shard there
+// exactly once and complete; otherwise nothing is merged.  The files a
+// manifest lists are looked for next to it, so a shard's directory can
+// be copied anywhere.
+//
+// The ntuple files of all shards are merged in event order as by
+// tangle2_merge (event IDs are global over the shards) to
+// <output>.csv or .h5, and the histograms of the same name added up to
+// <output>_hist_<name>.txt.  g4root files can not be read here (use
+// ROOT's hadd).  Exit status 1 if the campaign is incomplete or a merge
+// fails, 2 for a usage error.
+
+#include "Tangle2Merge.hh"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  void Usage()
+  {
+    std::fprintf(stderr,
+      "Usage: tangle2_shards [-o output] [--format csv|hdf5] [-j threads]"
+      " [-v]\n"
+      "                      manifest...\n");
+  }
+
+  // As written by Tangle2Shard::EndOfRun
+  struct Manifest
+  {
+    Manifest()
+    : campaignSeed(0), shard(-1), nShards(0), runEvents(0),
+      eventIDOffset(0), nEvents(0), nRows(0), resumes(0), complete(false)
+    {}
+    std::string fileName;
+    long campaignSeed;
+    int  shard;
+    int  nShards;
+    long runEvents;
+    long eventIDOffset;
+    long nEvents;
+    long nRows;
+    int  resumes;
+    bool complete;
+    std::vector<std::string> files;       // next to the manifest
+    std::vector<std::string> histograms;
+  };
+
+  std::string Directory(const std::string& path)
+  {
+    const std::string::size_type slash = path.rfind('/');
+    return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+  }
+
+  std::string BaseName(const std::string& path)
+  {
+    const std::string::size_type slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+  }
+
+  bool EndsWith(const std::string& s, const std::string& end)
+  {
+    return s.size() >= end.size() &&
+      s.compare(s.size() - end.size(), end.size(), end) == 0;
+  }
+
+  bool ReadManifest(const std::string& fileName, Manifest& manifest)
+  {
+    std::ifstream file(fileName.c_str());
+    if (!file) return false;
+    
+    manifest = Manifest();
+    manifest.fileName = fileName;
+    const std::string directory = Directory(fileName);
+    std::string line;
+    while (std::getline(file, line)) {
+      std::istringstream fields(line);
+      std::string key, value;
+      fields >> key;
+      std::getline(fields >> std::ws, value);
+      const char* v = value.c_str();
+      if      (key == "campaignSeed")  manifest.campaignSeed = std::atol(v);
+      else if (key == "shard")         manifest.shard = std::atoi(v);
+      else if (key == "shards")        manifest.nShards = std::atoi(v);
+      else if (key == "runEvents")     manifest.runEvents = std::atol(v);
+      else if (key == "eventIDOffset") manifest.eventIDOffset = std::atol(v);
+      else if (key == "events")        manifest.nEvents = std::atol(v);
+      else if (key == "rows")          manifest.nRows = std::atol(v);
+      else if (key == "resumes")       manifest.resumes = std::atoi(v);
+      else if (key == "complete")      manifest.complete = value == "1";
+      else if (key == "file")
+	manifest.files.push_back(directory + BaseName(value));
+      else if (key == "histogram")
+	manifest.histograms.push_back(directory + BaseName(value));
+    }
+    return manifest.nShards > 0;
+  }
+
+  // Every shard once, all of one campaign and complete; prints what is
+  // wrong and returns the number of problems
+  int CheckCampaign(const std::vector<Manifest>& manifests)
+  {
+    int nProblems = 0;
+    const Manifest& first = manifests[0];
+    std::vector<std::vector<const Manifest*> > byShard(first.nShards);
+    for (std::size_t i = 0; i < manifests.size(); i++) {
+      const Manifest& m = manifests[i];
+      if (m.campaignSeed != first.campaignSeed ||
+	  m.nShards != first.nShards || m.runEvents != first.runEvents) {
+	std::printf(" %s: campaign seed %ld, %d shards of %ld events,"
+		    " not %ld, %d of %ld as %s\n", m.fileName.c_str(),
+		    m.campaignSeed, m.nShards, m.runEvents,
+		    first.campaignSeed, first.nShards, first.runEvents,
+		    first.fileName.c_str());
+	nProblems++;
+	continue;
+      }
+      if (m.shard < 0 || m.shard >= m.nShards) {
+	std::printf(" %s: shard %d out of range\n",
+		    m.fileName.c_str(), m.shard);
+	nProblems++;
+	continue;
+      }
+      byShard[m.shard].push_back(&m);
+      if (!m.complete) {
+	std::printf(" %s: shard %d incomplete, %ld of %ld events\n",
+		    m.fileName.c_str(), m.shard, m.nEvents, m.runEvents);
+	nProblems++;
+      }
+      for (std::size_t f = 0; f < m.files.size(); f++)
+	if (!std::ifstream(m.files[f].c_str())) {
+	  std::printf(" %s: no %s\n", m.fileName.c_str(),
+		      m.files[f].c_str());
+	  nProblems++;
+	}
+      if (m.resumes > 0 && !m.histograms.empty())
+	std::printf(" Warning: shard %d was resumed, its histograms only"
+		    " cover the last part\n", m.shard);
+    }
+    for (int s = 0; s < first.nShards; s++) {
+      if (byShard[s].empty()) {
+	std::printf(" Shard %d missing\n", s);
+	nProblems++;
+      }
+      else if (byShard[s].size() > 1) {
+	std::printf(" Shard %d %zu times:", s, byShard[s].size());
+	for (std::size_t i = 0; i < byShard[s].size(); i++)
+	  std::printf(" %s", byShard[s][i]->fileName.c_str());
+	std::printf("\n");
+	nProblems++;
+      }
+    }
+    return nProblems;
+  }
+
+  // A Tangle2Histogram::Write file: header lines, then per bin
+  // "xLow xHigh sum error" (1D) or "x y sum" (2D, a blank line after
+  // each x)
+  struct HistogramFile
+  {
+    std::string title;
+    long   entries;
+    double inRange;
+    double underflow, overflow;
+    bool   hasFlows;
+    std::vector<std::string> bins;   // the x (and y) columns, "" blank
+    std::vector<double> sums;
+    std::vector<double> errors2;
+  };
+
+  bool ReadHistogram(const std::string& fileName, HistogramFile& h)
+  {
+    std::ifstream file(fileName.c_str());
+    if (!file) return false;
+    h = HistogramFile();
+    h.entries = 0;
+    h.inRange = h.underflow = h.overflow = 0.;
+    h.hasFlows = false;
+    std::string line;
+    while (std::getline(file, line)) {
+      if (line.empty()) {
+	h.bins.push_back("");
+	h.sums.push_back(0.);
+	h.errors2.push_back(0.);
+	continue;
+      }
+      if (line[0] == '#') {
+	if (std::sscanf(line.c_str(), "# entries %ld, in range %lf",
+			&h.entries, &h.inRange) == 2) continue;
+	if (std::sscanf(line.c_str(), "# underflow %lf overflow %lf",
+			&h.underflow, &h.overflow) == 2) {
+	  h.hasFlows = true;
+	  continue;
+	}
+	if (h.title.empty()) h.title = line;
+	continue;
+      }
+      std::istringstream fields(line);
+      std::vector<std::string> columns;
+      std::string column;
+      while (fields >> column) columns.push_back(column);
+      if (columns.size() == 4) {
+	h.bins.push_back(columns[0] + " " + columns[1]);
+	h.sums.push_back(std::atof(columns[2].c_str()));
+	const double error = std::atof(columns[3].c_str());
+	h.errors2.push_back(error*error);
+      }
+      else if (columns.size() == 3) {
+	h.bins.push_back(columns[0] + " " + columns[1]);
+	h.sums.push_back(std::atof(columns[2].c_str()));
+	h.errors2.push_back(-1.);   // none
+      }
+      else
+	return false;
+    }
+    return true;
+  }
+
+  // Adds up the files, which must have the same bins, and writes the
+  // sum in the same format; empty if it succeeded
+  std::string AddHistograms(const std::vector<std::string>& inputs,
+			    const std::string& output)
+  {
+    HistogramFile sum;
+    for (std::size_t i = 0; i < inputs.size(); i++) {
+      HistogramFile h;
+      if (!ReadHistogram(inputs[i], h))
+	return "can not read " + inputs[i];
+      if (i == 0) {
+	sum = h;
+	continue;
+      }
+      if (h.bins != sum.bins)
+	return "the bins of " + inputs[i] + " differ from " + inputs[0];
+      sum.entries   += h.entries;
+      sum.inRange   += h.inRange;
+      sum.underflow += h.underflow;
+      sum.overflow  += h.overflow;
+      for (std::size_t b = 0; b < sum.bins.size(); b++) {
+	sum.sums[b] += h.sums[b];
+	if (sum.errors2[b] >= 0.) sum.errors2[b] += h.errors2[b];
+      }
+    }
+    
+    std::FILE* file = std::fopen(output.c_str(), "w");
+    if (!file) return "can not write " + output;
+    std::fprintf(file, "%s\n# entries %ld, in range %.15g\n",
+		 sum.title.c_str(), sum.entries, sum.inRange);
+    if (sum.hasFlows)
+      std::fprintf(file, "# underflow %.15g overflow %.15g\n",
+		   sum.underflow, sum.overflow);
+    for (std::size_t b = 0; b < sum.bins.size(); b++) {
+      if (sum.bins[b].empty())
+	std::fprintf(file, "\n");
+      else if (sum.errors2[b] >= 0.)
+	std::fprintf(file, "%s %.15g %.15g\n", sum.bins[b].c_str(),
+		     sum.sums[b], std::sqrt(sum.errors2[b]));
+      else
+	std::fprintf(file, "%s %.15g\n", sum.bins[b].c_str(), sum.sums[b]);
+    }
+    if (std::fclose(file) != 0) return "can not write " + output;
+    return "";
+  }
+
+  // "<name>_hist_<histogram>.txt" to "<histogram>"
+  std::string HistogramName(const std::string& fileName)
+  {
+    const std::string base = BaseName(fileName);
+    const std::string::size_type hist = base.rfind("_hist_");
+    if (hist == std::string::npos) return base;
+    std::string name = base.substr(hist + 6);
+    if (EndsWith(name, ".txt")) name.resize(name.size() - 4);
+    return name;
+  }
+
+}
+
+int main(int argc, char** argv)
+{
+  Tangle2MergeOptions options;
+  options.nThreads = std::thread::hardware_concurrency();
+  if (options.nThreads == 0) options.nThreads = 1;
+  
+  std::string output, format;
+  std::vector<std::string> manifestFiles;
+  
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if      (arg == "-o" && hasValue) output = argv[++i];
+    else if (arg == "--format" && hasValue) format = argv[++i];
+    else if (arg == "-j" && hasValue) options.nThreads = std::atoi(argv[++i]);
+    else if (arg == "-v") options.verbose = true;
+    else if (!arg.empty() && arg[0] == '-') {
+      Usage();
+      return 2;
+    }
+    else manifestFiles.push_back(arg);
+  }
+  if (manifestFiles.empty()) {
+    Usage();
+    return 2;
+  }
+  
+  std::vector<Manifest> manifests(manifestFiles.size());
+  for (std::size_t i = 0; i < manifestFiles.size(); i++)
+    if (!ReadManifest(manifestFiles[i], manifests[i])) {
+      std::fprintf(stderr, "tangle2_shards: can not read %s\n",
+		   manifestFiles[i].c_str());
+      return 1;
+    }
+  
+  const Manifest& first = manifests[0];
+  long nEvents = 0, nRows = 0;
+  for (std::size_t i = 0; i < manifests.size(); i++) {
+    nEvents += manifests[i].nEvents;
+    nRows   += manifests[i].nRows;
+  }
+  std::printf(" Campaign %ld: %zu of %d shards, %ld events, %ld rows\n",
+	      first.campaignSeed, manifests.size(), first.nShards,
+	      nEvents, nRows);
+  const int nProblems = CheckCampaign(manifests);
+  if (nProblems > 0) {
+    std::printf(" %d problems, not merged\n", nProblems);
+    return 1;
+  }
+  std::printf(" Every shard once and complete\n");
+  if (output.empty()) return 0;
+  
+  // In shard order, so the histogram sums do not depend on the order
+  // the manifests are given in
+  std::vector<const Manifest*> byShard(first.nShards);
+  for (std::size_t i = 0; i < manifests.size(); i++)
+    byShard[manifests[i].shard] = &manifests[i];
+  
+  std::vector<std::string> inputs;
+  std::map<std::string, std::vector<std::string> > histograms;
+  int nG4Root = 0;
+  for (int s = 0; s < first.nShards; s++) {
+    const Manifest& m = *byShard[s];
+    for (std::size_t f = 0; f < m.files.size(); f++) {
+      if (EndsWith(m.files[f], ".root")) nG4Root++;
+      else inputs.push_back(m.files[f]);
+    }
+    for (std::size_t h = 0; h < m.histograms.size(); h++)
+      histograms[HistogramName(m.histograms[h])].push_back(m.histograms[h]);
+  }
+  
+  int status = 0;
+  if (nG4Root > 0)
+    std::printf(" %d g4root files not merged, use hadd\n", nG4Root);
+  if (!inputs.empty()) {
+    if (!format.empty())
+      options.format = format;
+    else if (EndsWith(inputs[0], ".h5"))
+      options.format = "hdf5";
+    else
+      options.format = "csv";
+    
+    std::chrono::steady_clock::time_point start
+      = std::chrono::steady_clock::now();
+    const Tangle2MergeResult result
+      = Tangle2MergeFiles(inputs, output, options);
+    const double seconds = std::chrono::duration<double>
+      (std::chrono::steady_clock::now() - start).count();
+    
+    if (!result.error.empty()) {
+      std::fprintf(stderr, "tangle2_shards: %s\n", result.error.c_str());
+      status = 1;
+    }
+    else {
+      std::printf(" %zu files, %ld rows merged to %s in %.3f s\n",
+		  inputs.size(), result.nRows, result.outputFile.c_str(),
+		  seconds);
+      if (result.nRows != nRows && nG4Root == 0) {
+	std::printf(" Rows merged differ from the %ld in the manifests\n",
+		    nRows);
+	status = 1;
+      }
+    }
+  }
+  
+  for (std::map<std::string, std::vector<std::string> >::const_iterator
+	 h = histograms.begin(); h != histograms.end(); ++h) {
+    const std::string fileName = output + "_hist_" + h->first + ".txt";
+    if (h->second.size() != std::size_t(first.nShards)) {
+      std::printf(" Histogram %s in %zu of %d shards, not added\n",
+		  h->first.c_str(), h->second.size(), first.nShards);
+      status = 1;
+      continue;
+    }
+    const std::string error = AddHistograms(h->second, fileName);
+    if (!error.empty()) {
+      std::fprintf(stderr, "tangle2_shards: %s\n", error.c_str());
+      status = 1;
+    }
+    else
+      std::printf(" Histogram %s of %d shards added to %s\n",
+		  h->first.c_str(), first.nShards, fileName.c_str());
+  }
+  return status;
+}
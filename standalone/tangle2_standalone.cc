@@ -0,0 +1,306 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Standalone polarised-photon transport for quick geometry and
+// polarisation studies, without Geant4.  Generates photon pairs as
+// Tangle2PrimaryGeneratorAction does, transports them through the
+// crystals of Tangle2Geometry with Tangle2PhotonTransport and writes
+// the Tangle2 ntuple, same columns and selection, through one of the
+// Tangle2OutputBackends.
+//
+//   tangle2_standalone [options]
+//     -n <events>        number of events (default 1000000)
+//     -s <seed>          random seed (default 12345)
+//     -o <file>          output, without extension (default
+//                        Tangle2_standalone, as csv that is
+//                        Tangle2_standalone_nt_Tangle2.csv)
+//     --format <f>       csv (default), hdf5 or rntuple, if built with it
+//     --async            write from a separate thread, see Tangle2AsyncOutput
+//     -x <file>          attenuation table, see Tangle2PhotonCrossSections
+//     --gammas           back to back gammas instead of positrons
+//     --fixedAxis --perpPol --polYZ --fullPET --acceptanceSampling
+//                        as the Tangle2:: flags in tangle2.cc
+//
+//   tangle2_standalone --compare <reference.csv> <test.csv> [--pmin <p>]
+//     compares two Tangle2 ntuples, e.g. tangle2 built with g4csv
+//     against this engine, see Tangle2NtupleComparison
+
+#include "Tangle2PhotonTransport.hh"
+#include "Tangle2StandaloneEvent.hh"
+#include "Tangle2CsvNtuple.hh"
+#include "Tangle2NtupleComparison.hh"
+#include "Tangle2DirectionSampler.hh"
+#include "Tangle2Hdf5Output.hh"
+#include "Tangle2RNTupleOutput.hh"
+#include "Tangle2AsyncOutput.hh"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace {
+
+  const double kPi = 3.14159265358979323846;
+
+  struct Options
+  {
+    long        nEvents;
+    unsigned long long seed;
+    std::string outputFile;
+    std::string format;
+    std::string crossSectionFile;
+    bool positrons, fixedAxis, perpPol, polYZ, fullPET;
+    bool acceptanceSampling;
+    bool asyncOutput;
+
+    Options()
+    : nEvents(1000000), seed(12345),
+      outputFile("Tangle2_standalone"), format("csv"),
+      positrons(true), fixedAxis(false), perpPol(false),
+      polYZ(false), fullPET(false), acceptanceSampling(false),
+      asyncOutput(false) {}
+  };
+
+  void Usage()
+  {
+    std::fprintf(stderr,
+      "Usage: tangle2_standalone [-n events] [-s seed] [-o file]"
+      " [-x table]\n"
+      "                          [--format csv|hdf5|rntuple] [--async]\n"
+      "                          [--gammas] [--fixedAxis] [--perpPol]"
+      " [--polYZ] [--fullPET]\n"
+      "                          [--acceptanceSampling]\n"
+      "       tangle2_standalone --compare reference.csv test.csv"
+      " [--pmin p]\n");
+  }
+
+  // The two annihilation photons, in the order Geant4 tracks
+  // them (last in, first out), as Tangle2PrimaryGeneratorAction
+  void GeneratePhotons(const Options& options,
+		       const Tangle2DirectionSampler& sampler,
+		       Tangle2PhotonTransport& transport,
+		       Tangle2Photon photons[2],
+		       int& sndGammaTrackID,
+		       double& weight)
+  {
+    Tangle2Vector axis, pol1, pol2;
+    int id1, id2;
+    weight = 1.;
+    
+    if (!options.positrons) {
+      
+      if (options.fixedAxis)
+	axis = Tangle2Vector(1., 0., 0.);
+      else {
+	// isotropic over theta = [0,thetaMax] about x
+	double a[3];
+	do {
+	  sampler.SampleCone(transport.Uniform(), transport.Uniform(), a);
+	} while (options.acceptanceSampling && !sampler.HitsArrays(a));
+	axis = Tangle2Vector(a[0], a[1], a[2]);
+	if (options.acceptanceSampling)
+	  weight = sampler.Acceptance();
+      }
+      
+      pol1 = options.polYZ ? Tangle2Vector(0., 1., 0.)
+	: transport.RandomDirection().Cross(axis).Unit();
+      
+      if (!options.perpPol)
+	pol2 = transport.RandomDirection().Cross(axis).Unit();
+      else if (options.polYZ)
+	pol2 = Tangle2Vector(0., 0., 1.);
+      else
+	pol2 = axis.Cross(pol1).Unit();
+      
+      id1 = 1;
+      id2 = 2;
+      sndGammaTrackID = 1;
+    }
+    else {
+      // e+ at rest: back to back in any direction with perpendicular
+      // polarisations, as G4eeToTwoGammaModel
+      axis = transport.RandomDirection();
+      const Tangle2Vector a = axis.Orthogonal().Unit();
+      const Tangle2Vector b = axis.Cross(a);
+      const double phi = 2.*kPi*transport.Uniform();
+      pol1 = a*std::cos(phi) + b*std::sin(phi);
+      pol2 = axis.Cross(pol1);
+      
+      id1 = 2;
+      id2 = 3;
+      sndGammaTrackID = 2;
+    }
+    
+    const Tangle2Vector origin(0., 0., 0.);
+    Tangle2Photon first  = {id2, 0.511, origin, -axis, pol2};
+    Tangle2Photon second = {id1, 0.511, origin,  axis, pol1};
+    photons[0] = first;
+    photons[1] = second;
+  }
+
+  // Null if the format is unknown or not built in
+  Tangle2OutputBackend* CreateOutput(const std::string& format)
+  {
+    if (format == "csv")
+      return new Tangle2CsvOutput;
+    if (format == "hdf5" && Tangle2Hdf5Output::IsAvailable())
+      return new Tangle2Hdf5Output;
+    if (format == "rntuple" && Tangle2RNTupleOutput::IsAvailable())
+      return new Tangle2RNTupleOutput;
+    return 0;
+  }
+
+  int Run(const Options& options)
+  {
+    Tangle2PhotonCrossSections crossSections;
+    if (!options.crossSectionFile.empty() &&
+	!crossSections.Load(options.crossSectionFile)) {
+      std::fprintf(stderr, "Can not read attenuation table %s\n",
+		   options.crossSectionFile.c_str());
+      return 2;
+    }
+    
+    std::mt19937_64 engine(options.seed);
+    Tangle2PhotonTransport transport(crossSections, options.fullPET, engine);
+    Tangle2StandaloneEvent event;
+    Tangle2DirectionSampler sampler(options.fullPET);
+    
+    std::unique_ptr<Tangle2OutputBackend>
+      output(CreateOutput(options.format));
+    if (!output) {
+      std::fprintf(stderr, "Output format %s not available\n",
+		   options.format.c_str());
+      return 2;
+    }
+    if (options.asyncOutput)
+      output.reset(new Tangle2AsyncOutput(output.release()));
+    if (!output->Open(options.outputFile)) {
+      std::fprintf(stderr, "Can not open %s\n", options.outputFile.c_str());
+      return 2;
+    }
+    
+    long nEventsPh = 0;
+    std::chrono::steady_clock::time_point start
+      = std::chrono::steady_clock::now();
+    
+    for (long i = 0; i < options.nEvents; i++) {
+      Tangle2Photon photons[2];
+      int sndGammaTrackID;
+      double weight;
+      GeneratePhotons(options, sampler, transport, photons,
+		      sndGammaTrackID, weight);
+      
+      event.Begin(i + 1, sndGammaTrackID, weight);
+      for (int j = 0; j < 2; j++) {
+	event.StartTrack(photons[j].trackID);
+	transport.Transport(photons[j], event);
+      }
+      
+      if (event.End())
+	output->Write(event.Record());
+      if (event.CentralHits())
+	nEventsPh++;
+    }
+    
+    output->Close();
+    
+    const double seconds = std::chrono::duration<double>
+      (std::chrono::steady_clock::now() - start).count();
+    
+    std::printf(" ------------------------------------------ \n");
+    std::printf(" QETlab standalone photon transport \n");
+    std::printf(" %s, %s\n",
+		options.fullPET ? "Human PET diameter" : "Lab experiment diameter",
+		options.positrons ? "positrons" : "back to back gammas");
+    std::printf(" %ld events, %ld QET events, %ld rows written to %s (%s)\n",
+		options.nEvents, nEventsPh, output->GetNRows(),
+		options.outputFile.c_str(), output->GetName());
+    std::printf(" %.3f s, %.3g events/s\n",
+		seconds, seconds > 0. ? options.nEvents/seconds : 0.);
+    if (output->GetNRows() > 0)
+      std::printf(" %ld bytes, %.1f bytes/event, %.3f s writing, %.1f MB/s\n",
+		  output->GetNBytes(),
+		  double(output->GetNBytes())/output->GetNRows(),
+		  output->GetSeconds(),
+		  output->GetSeconds() > 0. ?
+		  output->GetNBytes()/1.e6/output->GetSeconds() : 0.);
+    const Tangle2AsyncOutput* async
+      = dynamic_cast<const Tangle2AsyncOutput*>(output.get());
+    if (async && output->GetNRows() > 0) {
+      const Tangle2AsyncOutput::Statistics& s = async->GetStatistics();
+      std::printf(" async: occupancy mean %.1f, max %zu of %zu; %ld stalls"
+		  " (%.3f s); lag mean %.3f ms, max %.3f ms; %ld batches,"
+		  " %.3f s writing\n",
+		  s.meanOccupancy, s.maxOccupancy, s.capacity,
+		  s.nStalls, s.stallSeconds,
+		  s.meanLagSeconds*1.e3, s.maxLagSeconds*1.e3,
+		  s.nBatches, s.writerSeconds);
+    }
+    std::printf(" ------------------------------------------ \n");
+    return 0;
+  }
+
+}
+
+int main(int argc, char** argv)
+{
+  Options options;
+  
+  if (argc >= 2 && std::strcmp(argv[1], "--compare") == 0) {
+    if (argc != 4 && !(argc == 6 && std::strcmp(argv[4], "--pmin") == 0)) {
+      Usage();
+      return 2;
+    }
+    const double pMin = (argc == 6) ? std::atof(argv[5]) : 0.001;
+    return Tangle2CompareNtuples(argv[2], argv[3], pMin);
+  }
+  
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if      (arg == "-n" && hasValue) options.nEvents = std::atol(argv[++i]);
+    else if (arg == "-s" && hasValue) options.seed = std::strtoull(argv[++i], 0, 10);
+    else if (arg == "-o" && hasValue) options.outputFile = argv[++i];
+    else if (arg == "-x" && hasValue) options.crossSectionFile = argv[++i];
+    else if (arg == "--format" && hasValue) options.format = argv[++i];
+    else if (arg == "--async")     options.asyncOutput = true;
+    else if (arg == "--gammas")    options.positrons = false;
+    else if (arg == "--fixedAxis") options.fixedAxis = true;
+    else if (arg == "--perpPol")   options.perpPol   = true;
+    else if (arg == "--polYZ")     options.polYZ     = true;
+    else if (arg == "--fullPET")   options.fullPET   = true;
+    else if (arg == "--acceptanceSampling")
+      options.acceptanceSampling = true;
+    else {
+      Usage();
+      return 2;
+    }
+  }
+  
+  // as Tangle2PrimaryGeneratorAction and tangle2.cc
+  if (options.positrons && (options.fixedAxis || options.perpPol)) {
+    std::fprintf(stderr, " Invalid choice: positrons with fixed axis"
+		 " or perp pol, use --gammas\n");
+    return 2;
+  }
+  if (options.polYZ)
+    options.perpPol = true;
+  
+  return Run(options);
+}
@@ -0,0 +1,62 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Checks for the unit tests of standalone/test: each test is a main
+// that returns the number of failed checks, run by ctest.
+
+#ifndef Tangle2Test_hh
+#define Tangle2Test_hh 1
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace Tangle2Test {
+
+  inline int& Failures()
+  {
+    static int n = 0;
+    return n;
+  }
+
+  inline void Check(bool ok, const char* what, const char* file, int line)
+  {
+    if (ok) return;
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+    ++Failures();
+  }
+
+  inline bool Near(double a, double b, double tolerance = 1e-12)
+  {
+    return std::fabs(a - b) <= tolerance*(1. + std::fabs(b));
+  }
+
+  // A fresh directory under TMPDIR or /tmp
+  inline std::string TemporaryDirectory()
+  {
+    const char* tmp = std::getenv("TMPDIR");
+    std::string pattern = std::string(tmp && *tmp ? tmp : "/tmp")
+      + "/tangle2_test_XXXXXX";
+    if (!mkdtemp(&pattern[0])) return "";
+    return pattern;
+  }
+
+}
+
+#define TANGLE2_CHECK(condition) \
+  Tangle2Test::Check((condition), #condition, __FILE__, __LINE__)
+
+#endif
@@ -0,0 +1,147 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Tangle2AsyncOutput: every record reaches the wrapped backend once
+// and in order, on the writer thread, with several producers and a
+// ring small enough to fill (back-pressure), and again after reopening
+
+#include "Tangle2AsyncOutput.hh"
+#include "Tangle2Test.hh"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  // Keeps the event IDs written, and the thread that wrote them
+  class MemoryOutput : public Tangle2OutputBackend
+  {
+  public:
+    MemoryOutput(std::vector<long long>& ids, bool& otherThread,
+		 bool& closed)
+    : fIds(ids), fOtherThread(otherThread), fClosed(closed),
+      fOpener(std::this_thread::get_id()) {}
+    virtual ~MemoryOutput() { Close(); }
+
+    virtual const char* GetName() const { return "memory"; }
+
+  protected:
+    virtual std::string DoOpen(const std::string& fileName)
+    {
+      fIds.clear();
+      fClosed = false;
+      fOpener = std::this_thread::get_id();
+      return fileName + ".memory";
+    }
+    virtual void DoWrite(const Tangle2EventRecord& record)
+    {
+      fIds.push_back(record.eventID);
+      if (std::this_thread::get_id() != fOpener) fOtherThread = true;
+    }
+    virtual void DoClose() { fClosed = true; }
+
+  private:
+    std::vector<long long>& fIds;
+    bool& fOtherThread;
+    bool& fClosed;
+    std::thread::id fOpener;
+  };
+
+  struct Producer
+  {
+    std::vector<long long> ids;
+    bool otherThread;
+    bool closed;
+    Producer() : otherThread(false), closed(false) {}
+  };
+
+  void Produce(Tangle2AsyncOutput& output, long long first, long n)
+  {
+    Tangle2EventRecord record;
+    std::memset(&record, 0, sizeof(record));
+    for (long i = 0; i < n; i++) {
+      record.eventID = first + i;
+      output.Write(record);
+    }
+  }
+
+  bool InOrder(const std::vector<long long>& ids, long long first, long n)
+  {
+    if (long(ids.size()) != n) return false;
+    for (long i = 0; i < n; i++)
+      if (ids[i] != first + i) return false;
+    return true;
+  }
+
+  void TestCapacity()
+  {
+    std::vector<long long> ids;
+    bool otherThread = false, closed = false;
+    Tangle2AsyncOutput five(new MemoryOutput(ids, otherThread, closed), 5);
+    TANGLE2_CHECK(five.GetStatistics().capacity == 8);
+    Tangle2AsyncOutput one(new MemoryOutput(ids, otherThread, closed), 1);
+    TANGLE2_CHECK(one.GetStatistics().capacity == 2);
+  }
+
+  void TestProducers()
+  {
+    const int  kNProducers = 4;
+    const long kNRecords   = 20000;
+    
+    std::vector<Producer> producers(kNProducers);
+    std::vector<Tangle2AsyncOutput*> outputs;
+    for (int p = 0; p < kNProducers; p++)
+      outputs.push_back
+	(new Tangle2AsyncOutput(new MemoryOutput(producers[p].ids,
+						 producers[p].otherThread,
+						 producers[p].closed), 8));
+    
+    for (int run = 0; run < 2; run++) {
+      std::vector<std::thread> threads;
+      for (int p = 0; p < kNProducers; p++)
+	threads.push_back(std::thread([&outputs, p, run, kNRecords]() {
+	      outputs[p]->Open("producer");
+	      Produce(*outputs[p], (p + 10*run)*kNRecords, kNRecords);
+	      outputs[p]->Close();
+	    }));
+      for (std::size_t t = 0; t < threads.size(); t++)
+	threads[t].join();
+      
+      for (int p = 0; p < kNProducers; p++) {
+	const Tangle2AsyncOutput& output = *outputs[p];
+	TANGLE2_CHECK(producers[p].closed);
+	TANGLE2_CHECK(producers[p].otherThread);
+	TANGLE2_CHECK(InOrder(producers[p].ids, (p + 10*run)*kNRecords,
+			      kNRecords));
+	TANGLE2_CHECK(output.GetNRows() == kNRecords);
+	TANGLE2_CHECK(output.GetFileName() == "producer.memory");
+	TANGLE2_CHECK(output.GetStatistics().maxOccupancy <= 8);
+	TANGLE2_CHECK(output.GetStatistics().maxOccupancy > 0);
+      }
+    }
+    
+    for (int p = 0; p < kNProducers; p++)
+      delete outputs[p];
+  }
+
+}
+
+int main()
+{
+  TestCapacity();
+  TestProducers();
+  return Tangle2Test::Failures();
+}
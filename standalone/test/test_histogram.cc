@@ -0,0 +1,150 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Tangle2Histogram: binning, weights, the theta window, and the merge
+// of per-thread copies (Add) and of processes (WriteContents,
+// ReadContents), which must give the same bins as one histogram
+// filled with all the events
+
+#include "Tangle2Histogram.hh"
+#include "Tangle2Test.hh"
+
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+
+  Tangle2EventRecord Record(double dphi, double weight,
+			    double thetaA = 90., double thetaB = 90.)
+  {
+    Tangle2EventRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.dphi   = float(dphi);
+    record.phiA   = float(dphi/2.);
+    record.weight = float(weight);
+    record.thetaA = float(thetaA);
+    record.thetaB = float(thetaB);
+    return record;
+  }
+
+  std::string Contents(const Tangle2Histogram& histogram)
+  {
+    std::FILE* file = std::tmpfile();
+    histogram.WriteContents(file);
+    std::string contents(std::size_t(std::ftell(file)), '\0');
+    std::rewind(file);
+    const std::size_t n = std::fread(&contents[0], 1, contents.size(), file);
+    std::fclose(file);
+    contents.resize(n);
+    return contents;
+  }
+
+  void TestBinning()
+  {
+    Tangle2Histogram h("dphi", "dPhi_1st", 36, 0., 360.);
+    TANGLE2_CHECK(h.IsValid());
+    h.Fill(Record(5., 1.));
+    h.Fill(Record(355., 2.));
+    h.Fill(Record(360., 4.));   // overflow
+    h.Fill(Record(-1., 8.));    // underflow
+    h.Fill(Record(std::numeric_limits<double>::quiet_NaN(), 16.));
+    TANGLE2_CHECK(h.GetEntries() == 5);
+    TANGLE2_CHECK(h.GetSum() == 3.);
+    
+    Tangle2Histogram unknown("x", "noSuchColumn", 10, 0., 1.);
+    TANGLE2_CHECK(!unknown.IsValid());
+    Tangle2Histogram unknownY("x", "dPhi_1st", 10, 0., 1.,
+			      "noSuchColumn", 10, 0., 1.);
+    TANGLE2_CHECK(!unknownY.IsValid());
+    Tangle2Histogram empty("x", "dPhi_1st", 10, 1., 1.);
+    TANGLE2_CHECK(!empty.IsValid());
+  }
+
+  void TestWindowAnd2D()
+  {
+    Tangle2Histogram window("dphi80", "dPhi_1st", 36, 0., 360.);
+    window.SetThetaWindow(80., 100.);
+    window.Fill(Record(10., 1., 90., 90.));
+    window.Fill(Record(10., 1., 70., 90.));
+    window.Fill(Record(10., 1., 90., 100.));  // open window
+    TANGLE2_CHECK(window.GetEntries() == 1);
+    
+    Tangle2Histogram h2("phi", "PhiA_1st", 4, 0., 360.,
+			"dPhi_1st", 4, 0., 360.);
+    TANGLE2_CHECK(h2.IsValid());
+    h2.Fill(Record(100., 0.5));
+    h2.Fill(Record(400., 0.5));  // in x, overflow in y
+    TANGLE2_CHECK(h2.GetEntries() == 2);
+    TANGLE2_CHECK(h2.GetSum() == 0.5);
+  }
+
+  void TestMerge()
+  {
+    const Tangle2Histogram booking("dphi", "dPhi_1st", 36, 0., 360.,
+				   "PhiA_1st", 6, 0., 180.);
+    // weights exact in binary, so any order of the sums is exact
+    std::vector<Tangle2EventRecord> events;
+    for (int i = 0; i < 1000; i++)
+      events.push_back(Record((i*37)%370 - 5., 0.25*(1 + i%3)));
+    
+    Tangle2Histogram all = booking;
+    for (std::size_t i = 0; i < events.size(); i++)
+      all.Fill(events[i]);
+    
+    // three threads, added in thread order as by the master
+    std::vector<Tangle2Histogram> threads(3, booking);
+    for (std::size_t i = 0; i < events.size(); i++)
+      threads[i%3].Fill(events[i]);
+    Tangle2Histogram merged = booking;
+    for (std::size_t t = 0; t < threads.size(); t++)
+      merged.Add(threads[t]);
+    TANGLE2_CHECK(merged.GetEntries() == all.GetEntries());
+    TANGLE2_CHECK(Contents(merged) == Contents(all));
+    
+    // through the files of forked processes
+    std::FILE* file = std::tmpfile();
+    threads[0].WriteContents(file);
+    threads[1].WriteContents(file);
+    std::rewind(file);
+    Tangle2Histogram read0 = booking, read1 = booking;
+    TANGLE2_CHECK(read0.ReadContents(file));
+    TANGLE2_CHECK(read1.ReadContents(file));
+    std::fclose(file);
+    read0.Add(read1);
+    read0.Add(threads[2]);
+    TANGLE2_CHECK(Contents(read0) == Contents(all));
+    
+    // another booking is refused
+    file = std::tmpfile();
+    all.WriteContents(file);
+    std::rewind(file);
+    Tangle2Histogram other("dphi", "dPhi_1st", 72, 0., 360.);
+    TANGLE2_CHECK(!other.ReadContents(file));
+    std::fclose(file);
+    
+    merged.Reset();
+    TANGLE2_CHECK(merged.GetEntries() == 0 && merged.GetSum() == 0.);
+  }
+
+}
+
+int main()
+{
+  TestBinning();
+  TestWindowAnd2D();
+  TestMerge();
+  return Tangle2Test::Failures();
+}
@@ -0,0 +1,154 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Tangle2MergeFiles: per-thread csv files back in event order, directly
+// and in groups (fanIn) on several threads, the columns kept, and the
+// errors for inputs that can not be merged
+
+#include "Tangle2Merge.hh"
+#include "Tangle2CsvNtuple.hh"
+#include "Tangle2RecordReader.hh"
+#include "Tangle2Test.hh"
+
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+  const int kNThreads = 5;
+  const int kNEvents  = 500;
+
+  // Thread t has the events i with i%kNThreads == t, as if each took
+  // events from a shared queue; dphi and nb_Compt0 identify the event
+  std::vector<std::string> WriteThreads(const std::string& directory)
+  {
+    std::vector<std::string> files;
+    for (int t = 0; t < kNThreads; t++) {
+      std::ostringstream name;
+      name << directory << "/Tangle2_t" << t;
+      Tangle2CsvOutput output;
+      if (!output.Open(name.str())) return std::vector<std::string>();
+      for (int i = t; i < kNEvents; i += kNThreads) {
+	Tangle2EventRecord record;
+	std::memset(&record, 0, sizeof(record));
+	record.eventID  = i;
+	record.threadID = int16_t(t);
+	record.dphi     = float(0.5*i);
+	record.nb_Compt[0] = int16_t(i%7);
+	record.weight   = 1.f;
+	output.Write(record);
+      }
+      output.Close();
+      files.push_back(output.GetFileName());
+    }
+    return files;
+  }
+
+  void CheckMerged(const Tangle2MergeResult& result)
+  {
+    TANGLE2_CHECK(result.error.empty());
+    TANGLE2_CHECK(result.nRows == kNEvents);
+    TANGLE2_CHECK(result.nOutOfOrder == 0);
+    
+    std::string error;
+    std::unique_ptr<Tangle2RecordReader> reader
+      (Tangle2RecordReader::Open(result.outputFile, error));
+    TANGLE2_CHECK(reader.get() != 0);
+    if (!reader) return;
+    
+    Tangle2EventRecord record;
+    int n = 0;
+    bool inOrder = true, intact = true;
+    while (reader->Next(record)) {
+      inOrder = inOrder && record.eventID == n &&
+	record.threadID == n%kNThreads;
+      intact = intact && record.dphi == float(0.5*n) &&
+	record.nb_Compt[0] == n%7;
+      ++n;
+    }
+    TANGLE2_CHECK(reader->GetError().empty());
+    TANGLE2_CHECK(n == kNEvents);
+    TANGLE2_CHECK(inOrder);
+    TANGLE2_CHECK(intact);
+    std::remove(result.outputFile.c_str());
+  }
+
+  void TestMerge(const std::string& directory,
+		 const std::vector<std::string>& inputs)
+  {
+    Tangle2MergeOptions options;
+    CheckMerged(Tangle2MergeFiles(inputs, directory + "/direct", options));
+    
+    // groups of 2, merged on 3 threads, then the groups merged
+    options.fanIn = 2;
+    options.nThreads = 3;
+    CheckMerged(Tangle2MergeFiles(inputs, directory + "/grouped", options));
+    
+    // the input order does not matter
+    std::vector<std::string> reversed(inputs.rbegin(), inputs.rend());
+    CheckMerged(Tangle2MergeFiles(reversed, directory + "/reversed",
+				  options));
+  }
+
+  void TestErrors(const std::string& directory,
+		  const std::vector<std::string>& inputs)
+  {
+    Tangle2MergeOptions options;
+    
+    std::vector<std::string> missing(inputs);
+    missing.push_back(directory + "/none_nt_Tangle2.csv");
+    TANGLE2_CHECK(!Tangle2MergeFiles(missing, directory + "/m", options)
+		  .error.empty());
+    
+    // no eventID and threadID, as from a baseline g4csv run
+    const std::string old = directory + "/old.csv";
+    std::FILE* file = std::fopen(old.c_str(), "w");
+    std::fprintf(file, "edep0,dPhi_1st\n0.5,90\n");
+    std::fclose(file);
+    std::vector<std::string> unordered(1, old);
+    const Tangle2MergeResult result
+      = Tangle2MergeFiles(unordered, directory + "/u", options);
+    TANGLE2_CHECK(result.error.find("eventID") != std::string::npos);
+    std::remove(old.c_str());
+    
+    options.format = "parquet";
+    TANGLE2_CHECK(!Tangle2MergeFiles(inputs, directory + "/f", options)
+		  .error.empty());
+  }
+
+}
+
+int main()
+{
+  const std::string directory = Tangle2Test::TemporaryDirectory();
+  TANGLE2_CHECK(!directory.empty());
+  if (directory.empty()) return Tangle2Test::Failures();
+  
+  const std::vector<std::string> inputs = WriteThreads(directory);
+  TANGLE2_CHECK(inputs.size() == std::size_t(kNThreads));
+  if (inputs.size() == std::size_t(kNThreads)) {
+    TestMerge(directory, inputs);
+    TestErrors(directory, inputs);
+  }
+  
+  for (std::size_t i = 0; i < inputs.size(); i++)
+    std::remove(inputs[i].c_str());
+  rmdir(directory.c_str());
+  return Tangle2Test::Failures();
+}
@@ -0,0 +1,179 @@
+// *******************************************************************
+// * License and Disclaimer                                          *
+// *                                                                 *
+// * This software is copyright of Geant4 Associates International   *
+// * Ltd (hereafter 'G4AI'). It is provided under the terms and      *
+// * conditions described in the file 'LICENSE' included in the      *
+// * software system.                                                *
+// * Neither the authors of this software system nor G4AI make any   *
+// * representation or warranty, express or implied, regarding this  *
+// * software system or assume any liability for its use.            *
+// * Please see the file 'LICENSE' for full disclaimer and the       *
+// * limitation of liability.                                        *
+// *******************************************************************
+// $Id$
+
+// Tangle2Selection: the default cut, the two phases, the cut order and
+// counts, crystal lists and NeedsScatter (fastReject)
+
+#include "Tangle2Selection.hh"
+#include "Tangle2Test.hh"
+
+namespace {
+
+  // Not copied: selectionEvent points into it
+  struct Event
+  {
+    double eDep[18];
+    int    nbCompt[18];
+    Tangle2SelectionEvent selectionEvent;
+
+    Event()
+    {
+      for (int i = 0; i < 18; i++) {
+	eDep[i] = 0.;
+	nbCompt[i] = 0;
+      }
+      Tangle2SelectionEvent e = {eDep, nbCompt, 0., 0.};
+      selectionEvent = e;
+    }
+  };
+
+  bool SelectBoth(Tangle2Selection& selection, Event& event,
+		  double thetaA, double thetaB)
+  {
+    if (!selection.Select(Tangle2Selection::kBeforeAngles,
+			  event.selectionEvent))
+      return false;
+    event.selectionEvent.thetaA = thetaA;
+    event.selectionEvent.thetaB = thetaB;
+    return selection.Select(Tangle2Selection::kAfterAngles,
+			    event.selectionEvent);
+  }
+
+  void TestDefault()
+  {
+    Tangle2Selection selection;
+    TANGLE2_CHECK(Tangle2Test::Near(selection.GetThreshold(4), 0.005));
+    
+    Event qet;
+    qet.eDep[4]  = 0.2;
+    qet.eDep[13] = 0.3;
+    TANGLE2_CHECK(SelectBoth(selection, qet, 80., 90.));
+    
+    // not scattered in B
+    Event unscattered;
+    unscattered.eDep[4]  = 0.2;
+    unscattered.eDep[13] = 0.3;
+    TANGLE2_CHECK(!SelectBoth(selection, unscattered, 80., 0.));
+    
+    // 13 below threshold
+    Event below;
+    below.eDep[4]  = 0.2;
+    below.eDep[13] = 0.004;
+    TANGLE2_CHECK(!selection.Select(Tangle2Selection::kBeforeAngles,
+				    below.selectionEvent));
+    
+    // the hits cut was tested 3 times, the angle cut twice
+    const std::string report = selection.Report();
+    TANGLE2_CHECK(report.find("hits >= 2 of 4 13: 2 of 3 passed")
+		  != std::string::npos);
+    TANGLE2_CHECK(report.find("2 angle calculations") != std::string::npos);
+    TANGLE2_CHECK(report.find("thetaA, thetaB != 0: 1 of 2 passed")
+		  != std::string::npos);
+    
+    // counts added over threads, zeroed by Compile
+    Tangle2Selection other = selection;
+    selection.AddCounts(other);
+    TANGLE2_CHECK(selection.Report().find("hits >= 2 of 4 13: 4 of 6 passed")
+		  != std::string::npos);
+    selection.Compile();
+    TANGLE2_CHECK(selection.Report().find("0 of 0 passed")
+		  != std::string::npos);
+  }
+
+  void TestCuts()
+  {
+    Tangle2Selection selection;
+    selection.Clear();
+    selection.SetThreshold(0.01);
+    // given angle cut first: Compile moves it after the others
+    selection.AddTheta(10., 170.);
+    selection.AddCompton(1, 1);
+    selection.AddEnergy((1u << 0) | (1u << 1), 0.4, 0.6);
+    selection.Compile();
+    
+    const std::string list = selection.List();
+    const std::size_t compton = list.find("compton A1B1");
+    const std::size_t energy  = list.find("energy of 0 1");
+    const std::size_t angles  = list.find("(angles calculated)");
+    const std::size_t theta   = list.find("10 < thetaA, thetaB < 170");
+    TANGLE2_CHECK(compton < energy && energy < angles && angles < theta &&
+		  theta != std::string::npos);
+    
+    Event event;
+    event.eDep[0] = 0.3;
+    event.eDep[1] = 0.2;
+    event.eDep[2] = 0.5;    // not in the energy cut
+    event.nbCompt[2]  = 1;  // A
+    event.nbCompt[11] = 2;  // B
+    TANGLE2_CHECK(SelectBoth(selection, event, 20., 160.));
+    TANGLE2_CHECK(!SelectBoth(selection, event, 5., 160.));
+    
+    // below threshold, so not in the sum
+    event.eDep[1] = 0.009;
+    TANGLE2_CHECK(!SelectBoth(selection, event, 20., 160.));
+    event.eDep[1] = 0.2;
+    
+    event.nbCompt[11] = 0;
+    TANGLE2_CHECK(!SelectBoth(selection, event, 20., 160.));
+  }
+
+  void TestCrystals()
+  {
+    bool ok = false;
+    TANGLE2_CHECK(Tangle2Selection::ParseCrystals("4 13", ok)
+		  == ((1u << 4) | (1u << 13)) && ok);
+    TANGLE2_CHECK(Tangle2Selection::ParseCrystals("A", ok) == 0x1FFu && ok);
+    TANGLE2_CHECK(Tangle2Selection::ParseCrystals("B 0", ok)
+		  == ((0x1FFu << 9) | 1u) && ok);
+    Tangle2Selection::ParseCrystals("18", ok);
+    TANGLE2_CHECK(!ok);
+    Tangle2Selection::ParseCrystals("4 x", ok);
+    TANGLE2_CHECK(!ok);
+    Tangle2Selection::ParseCrystals("", ok);
+    TANGLE2_CHECK(!ok);
+  }
+
+  void TestNeedsScatter()
+  {
+    Tangle2Selection selection;
+    TANGLE2_CHECK(selection.NeedsScatter());
+    
+    selection.Clear();
+    selection.AddHits(0x1FFu, 1);
+    selection.AddEnergy(0x1FFu, 0.4, 0.6);
+    TANGLE2_CHECK(!selection.NeedsScatter());
+    selection.AddTheta(-1., 180.);
+    TANGLE2_CHECK(!selection.NeedsScatter());
+    selection.AddCompton(0, 0);
+    TANGLE2_CHECK(!selection.NeedsScatter());
+    
+    selection.AddTheta(0., 180.);
+    TANGLE2_CHECK(selection.NeedsScatter());
+    
+    selection.Clear();
+    selection.AddCompton(0, 1);
+    TANGLE2_CHECK(selection.NeedsScatter());
+  }
+
+}
+
+int main()
+{
+  TestDefault();
+  TestCuts();
+  TestCrystals();
+  TestNeedsScatter();
+  return Tangle2Test::Failures();
+}
@@ -17,52 +17,155 @@
 
 #ifdef G4MULTITHREADED
 #include "G4MTRunManager.hh"
+#include "Tangle2MTRunManager.hh"
+#include "Tangle2WorkerInitialization.hh"
+#include "G4Version.hh"
+#if G4VERSION_NUMBER >= 1070
+#include "G4TaskRunManager.hh"
+#endif
 #else
 #include "G4RunManager.hh"
 #endif
+#include "Tangle2ForkRunManager.hh"
 #include "G4PhysListFactory.hh"
 #include "Tangle2DetectorConstruction.hh"
-#include "G4EmLivermorePolarizedPhysics.hh"
-#include "G4EmLivermorePhysics.hh"
+#include "G4FastSimulationPhysics.hh"
 #include "Tangle2ActionInitialization.hh"
 #include "G4UIExecutive.hh"
 #include "G4UImanager.hh"
+#include "G4UIcommand.hh"
 #include "G4VisExecutive.hh"
+#include "Randomize.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
 
 #include "Tangle2Data.hh"
+#include "Tangle2Topology.hh"
+#include "Tangle2Shard.hh"
+#include "Tangle2CheckpointMessenger.hh"
+#include "Tangle2ConfigMessenger.hh"
+#include "Tangle2FastSimMessenger.hh"
+#include "Tangle2HistogramMessenger.hh"
+#include "Tangle2SelectionMessenger.hh"
+#include "Tangle2SweepMessenger.hh"
+#include "Tangle2TelemetryMessenger.hh"
+#include "Tangle2ProfileMessenger.hh"
+
+namespace {
+
+  void PrintUsage()
+  {
+    G4cerr << " Usage: " << G4endl;
+    G4cerr << " tangle2 [-m macro] [-g] [-t nThreads] [-n nEvents]"
+	   << " [-s seed1[,seed2]]" << G4endl
+	   << "         [-r mt|adaptive|tasking] [-p none|compact|scatter]"
+	   << " [--shard i/N]" << G4endl
+	   << "         [-f nProcesses]" << G4endl;
+    G4cerr << "   -m  macro to execute (default visNoGraph.mac,"
+	   << " or visGraph.mac with -g)" << G4endl;
+    G4cerr << "   -g  graphics, the macro is followed by a UI session"
+	   << G4endl;
+    G4cerr << "   -t  number of threads, overrides /run/numberOfThreads"
+	   << G4endl
+	   << "       (default: the CPUs available, see Tangle2Topology;"
+	   << " -t macro keeps" << G4endl
+	   << "       the macro's)" << G4endl;
+    G4cerr << "   -n  events, as {nEvents} in the macro (default 50)"
+	   << G4endl;
+    G4cerr << "   -s  random seeds (default from the time), the campaign"
+	   << " seed with --shard" << G4endl;
+    G4cerr << "   -r  run manager: mt, fixed chunks of events (default);"
+	   << G4endl
+	   << "       adaptive, chunks sized by the measured cost per event"
+	   << G4endl
+	   << "       (Tangle2MTRunManager); tasking, G4TaskRunManager"
+	   << " (Geant4 10.7 or later)" << G4endl;
+    G4cerr << "   -p  worker placement: none (default), compact (physical"
+	   << G4endl
+	   << "       cores node after node, then hardware threads) or"
+	   << " scatter (round robin" << G4endl
+	   << "       over nodes)"
+	   << G4endl;
+    G4cerr << "   --shard  shard i of N of a campaign (see Tangle2Shard):"
+	   << " the MixMaxRng stream" << G4endl
+	   << "       of -s, the campaign seed, and i; output names"
+	   << " <name>_s<i>" << G4endl;
+    G4cerr << "   -f  processes: each /run/beamOn is run by nProcesses"
+	   << " processes forked" << G4endl
+	   << "       after initialisation, sharing the physics tables"
+	   << " (Tangle2ForkRunManager;" << G4endl
+	   << "       -t and -r do not apply, -p places the processes;"
+	   << " not with -g)" << G4endl;
+  }
+
+}
 
 int main(int argc,char** argv)
 {
+  // The run configuration (beam, detector, physics, output) is set
+  // with /tangle2/config/ before /run/initialize, see Tangle2Config.
   
   //------------------------
-  // Graphics
-  G4bool  useGraphics = false;
-  
-  //--------------------------
-  // Beam
-
-  // A - axis
-  Tangle2::fixedAxis = false;
+  // Command line
+  G4String macro;
+  G4bool   useGraphics = false;
+  G4String nThreads;
+  G4String nEvents = "50";
+  G4String seedList;
+  G4String runManagerType = "mt";
+  G4String pinPolicyName = "none";
+  G4String shard;
+  G4int    nProcesses = 0;
   
-  // B - beam particle
-  Tangle2::positrons = true;
-  
-  // polarisation direction
-  Tangle2::perpPol   = false;
-  Tangle2::polYZ     = false;
-
-  // safety
-  if(Tangle2::polYZ)
-    Tangle2::perpPol   = true;
-
-  // C - polarised/unpolarised Compton scattering
-  G4bool  usePolarisedCompton = true;
-
-  //--------------------------
-  // Detector 
-  // True: arrays 90 cm apart (45 cm from source)  
-  // False: arrays 6 cm apart (3 cm from source)  
-  Tangle2::fullPET   = false;
+  for (G4int i = 1; i < argc; i++) {
+    const G4String option = argv[i];
+    if (option == "-g") {
+      useGraphics = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      PrintUsage();
+      return 1;
+    }
+    if      (option == "-m") macro    = argv[++i];
+    else if (option == "-t") nThreads = argv[++i];
+    else if (option == "-n") nEvents  = argv[++i];
+    else if (option == "-s") seedList = argv[++i];
+    else if (option == "-r") runManagerType = argv[++i];
+    else if (option == "-p") pinPolicyName = argv[++i];
+    else if (option == "--shard") shard = argv[++i];
+    else if (option == "-f") nProcesses = std::atoi(argv[++i]);
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+  if (macro.empty())
+    macro = useGraphics ? "visGraph.mac" : "visNoGraph.mac";
+  if (runManagerType != "mt" && runManagerType != "adaptive" &&
+      runManagerType != "tasking") {
+    PrintUsage();
+    return 1;
+  }
+  Tangle2Topology::Policy pinPolicy;
+  if (!Tangle2Topology::ParsePolicy(pinPolicyName, pinPolicy)) {
+    PrintUsage();
+    return 1;
+  }
+  // a graphics session has threads, which fork does not copy
+  if (nProcesses < 0 || (nProcesses > 0 && useGraphics)) {
+    PrintUsage();
+    return 1;
+  }
+  // a shard's seeds must come from the campaign, not the time
+  if (!shard.empty() &&
+      (seedList.empty() ||
+       !Tangle2Shard::Parse(shard, Tangle2::shardIndex, Tangle2::nShards))) {
+    PrintUsage();
+    return 1;
+  }
 
   // Do this first to capture all output
   G4UIExecutive* ui = nullptr;
@@ -70,21 +173,101 @@ int main(int argc,char** argv)
   if(useGraphics)
     ui = new G4UIExecutive(argc, argv);
   
-  // Choose the Random engine
-  G4Random::setTheEngine(new CLHEP::RanecuEngine);
+  // Choose the Random engine; shards need the independent streams of
+  // MixMaxRng, see Tangle2Shard
+  if (!shard.empty())
+    G4Random::setTheEngine(new CLHEP::MixMaxRng);
+  else
+    G4Random::setTheEngine(new CLHEP::RanecuEngine);
   
-  // Set seed using system time
+  // Set seed from the command line or using system time
   G4long seeds[2];
-  time_t systime = time(NULL);
-  seeds[0] = (long) systime;
-  seeds[1] = (long) (systime*G4UniformRand());
-  G4Random::setTheSeeds(seeds);
+  if (!seedList.empty()) {
+    G4int nSeeds = std::sscanf(seedList.c_str(), "%ld,%ld",
+			       &seeds[0], &seeds[1]);
+    if (nSeeds < 1) {
+      PrintUsage();
+      return 1;
+    }
+    if (nSeeds == 1)
+      seeds[1] = seeds[0];
+  }
+  else {
+    time_t systime = time(NULL);
+    seeds[0] = (long) systime;
+    seeds[1] = (long) (systime*G4UniformRand());
+  }
+  if (Tangle2::nShards > 0) {
+    Tangle2::campaignSeed = seeds[0];
+    Tangle2Shard::SeedStream(0);
+    Tangle2::outputName += "_s" + G4UIcommand::ConvertToString
+      (Tangle2::shardIndex);
+    G4cout << " Shard " << Tangle2::shardIndex << "/" << Tangle2::nShards
+	   << " of campaign " << Tangle2::campaignSeed
+	   << ", MixMaxRng stream " << Tangle2::shardIndex << G4endl;
+  }
+  else
+    G4Random::setTheSeeds(seeds);
   
+  G4RunManager* runManager = 0;
+  if (nProcesses > 0) {
+    // Sequential, each /run/beamOn forked into nProcesses processes
+    // after initialisation, see Tangle2ForkRunManager
+    if (!nThreads.empty())
+      G4cout << " -f " << nProcesses << ", -t " << nThreads << " ignored"
+	     << G4endl;
+    Tangle2ForkRunManager* forkRunManager
+      = new Tangle2ForkRunManager(nProcesses);
+    forkRunManager->SetPlacement(pinPolicy);
+    runManager = forkRunManager;
+  }
+  else {
 #ifdef G4MULTITHREADED
-  G4MTRunManager* runManager = new G4MTRunManager;
+    // Cores from the affinity mask and cgroup quota, unless given
+    // with -t or G4FORCENUMBEROFTHREADS
+    Tangle2Topology topology;
+    topology.Print(G4cout);
+    if (nThreads.empty() && !std::getenv("G4FORCENUMBEROFTHREADS"))
+      nThreads
+	= G4UIcommand::ConvertToString(topology.GetDefaultNThreads());
+    if (nThreads == "macro")
+      nThreads = "";
+    
+    // Takes precedence over SetNumberOfThreads and /run/numberOfThreads
+    if (!nThreads.empty())
+      setenv("G4FORCENUMBEROFTHREADS", nThreads.c_str(), 1);
+    G4MTRunManager* mtRunManager = 0;
+    if (runManagerType == "adaptive")
+      mtRunManager = new Tangle2MTRunManager;
+    else if (runManagerType == "tasking") {
+#if G4VERSION_NUMBER >= 1070
+      mtRunManager = new G4TaskRunManager;
+#else
+      G4cout << " G4TaskRunManager needs Geant4 10.7 or later,"
+	     << " using the adaptive run manager" << G4endl;
+      mtRunManager = new Tangle2MTRunManager;
+#endif
+    }
+    else
+      mtRunManager = new G4MTRunManager;
+    
+    if (pinPolicy != Tangle2Topology::kNone)
+      mtRunManager->SetUserInitialization
+	(new Tangle2WorkerInitialization(topology, pinPolicy));
+    runManager = mtRunManager;
 #else
-  G4RunManager* runManager = new G4RunManager;
+    if (!nThreads.empty())
+      G4cout << " Sequential build, -t " << nThreads << " ignored"
+	     << G4endl;
+    if (runManagerType != "mt")
+      G4cout << " Sequential build, -r " << runManagerType << " ignored"
+	     << G4endl;
+    if (pinPolicy != Tangle2Topology::kNone)
+      G4cout << " Sequential build, -p " << pinPolicyName << " ignored"
+	     << G4endl;
+    runManager = new G4RunManager;
 #endif
+  }
  
   runManager->SetUserInitialization(new Tangle2DetectorConstruction);
     
@@ -94,10 +277,17 @@ int main(int argc,char** argv)
   G4VModularPhysicsList* physList = factory.GetReferencePhysList("FTFP_BERT");
   physList->SetVerboseLevel(verbose = 1);
   
-  if(usePolarisedCompton)
-    physList->ReplacePhysics(new G4EmLivermorePolarizedPhysics);
-  else
-    physList->ReplacePhysics(new G4EmLivermorePhysics); 
+  // Polarised or unpolarised Compton scattering, changed with
+  // /tangle2/config/polarisedCompton
+  Tangle2ConfigMessenger* configMessenger
+    = new Tangle2ConfigMessenger(physList);
+  configMessenger->SetEmPhysics();
+
+  // Attach fast simulation to gammas so that the crystal
+  // model can be triggered (it only is if fastSimMode is set)
+  G4FastSimulationPhysics* fastSimPhysics = new G4FastSimulationPhysics;
+  fastSimPhysics->ActivateFastSimulation("gamma");
+  physList->RegisterPhysics(fastSimPhysics);
 
   runManager->SetUserInitialization(physList);
 
@@ -106,52 +296,35 @@ int main(int argc,char** argv)
   G4VisManager* visManager = new G4VisExecutive;
   visManager->Initialize();
 
-  G4UImanager* UImanager = G4UImanager::GetUIpointer();
-  
-  if(useGraphics)
-    UImanager->ApplyCommand("/control/execute visGraph.mac");
-  else
-    UImanager->ApplyCommand("/control/execute visNoGraph.mac");
-  
-  G4cout << " ------------------------------------------ " << G4endl;
-  G4cout << " QETlab simulation " << G4endl;
-  G4cout <<  G4endl;
+  Tangle2FastSimMessenger* fastSimMessenger = new Tangle2FastSimMessenger;
+  Tangle2HistogramMessenger* histogramMessenger
+    = new Tangle2HistogramMessenger;
+  Tangle2SelectionMessenger* selectionMessenger
+    = new Tangle2SelectionMessenger;
+  Tangle2SweepMessenger* sweepMessenger = new Tangle2SweepMessenger;
+  Tangle2CheckpointMessenger* checkpointMessenger
+    = new Tangle2CheckpointMessenger;
+  Tangle2TelemetryMessenger* telemetryMessenger
+    = new Tangle2TelemetryMessenger;
+  Tangle2ProfileMessenger* profileMessenger = new Tangle2ProfileMessenger;
 
-  if(Tangle2::fullPET){
-    G4cout << " Human PET diameter " << G4endl;
-  }
-  else{
-    G4cout << " Lab experiment diameter " << G4endl;
-  }
-    
-  G4cout <<  G4endl;
-  G4cout << " Generated : " << G4endl;
+  G4UImanager* UImanager = G4UImanager::GetUIpointer();
   
-  // Print beam choices to screen
-  if(Tangle2::positrons)
-    G4cout << " Positrons " << G4endl;
-  else{
-    G4cout << " Back to back gammas. " << G4endl;
-    if(Tangle2::fixedAxis)
-      G4cout << " On a fixed axis, " << G4endl;
-    else
-      G4cout << " Covering detector area, " << G4endl;
-    if(Tangle2::perpPol)
-      G4cout << " with perpendicular polarisation. " << G4endl;
-    else
-      G4cout << " with random relative polarisation. " << G4endl;
-  }
-  if(usePolarisedCompton)
-    G4cout << " Polarized Compton scattering " << G4endl;
-  else
-    G4cout << " UnPolarized Compton scattering " << G4endl;
-     
-  G4cout << " ------------------------------------------ " << G4endl;
+  UImanager->ApplyCommand("/control/alias nEvents " + nEvents);
+  UImanager->ApplyCommand("/control/execute " + macro);
   
      if(useGraphics)
        ui->SessionStart();
   
   delete ui;
+  delete profileMessenger;
+  delete telemetryMessenger;
+  delete checkpointMessenger;
+  delete sweepMessenger;
+  delete selectionMessenger;
+  delete histogramMessenger;
+  delete fastSimMessenger;
+  delete configMessenger;
   delete visManager;
   delete runManager;
 }